@@ -58,7 +58,7 @@ static const String md2_frame_names[EMAT_MAX_ANIMATIONS] =
 AnimatedMeshMD2::AnimatedMeshMD2()
 	: mNumFrames(0), mNumVerticesPerFrame(0),
 	  mVertices(0), mInterpolationBuffer(0), mIndices(0),
-	  mBoundingBoxes(0)
+	  mMaterial(MaterialRegistry::Register(Material())), mBoundingBoxes(0)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::AnimatedMeshMD2");
@@ -67,7 +67,7 @@ AnimatedMeshMD2::AnimatedMeshMD2()
 }
 
 AnimatedMeshMD2::AnimatedMeshMD2(const String& name, s32 num_frames, s32 vertices_per_frame,
-	Vertex3 * vertices, Array<u32> * indices, ITexture * texture)
+	Vertex3 * vertices, IndexBuffer * indices, ITexture * texture)
 	: mNumFrames(num_frames), mNumVerticesPerFrame(vertices_per_frame),
 	  mVertices(vertices), mInterpolationBuffer(0), mIndices(indices),
 	  mBoundingBoxes(0)
@@ -86,7 +86,9 @@ AnimatedMeshMD2::AnimatedMeshMD2(const String& name, s32 num_frames, s32 vertice
 		for (s32 j = 0; j < vertices_per_frame; j++)
 			mBoundingBoxes[i].addInternalPoint(frameVertices[j].getPosition());
 	}
-	Mat.setTexture(0, texture);
+	Material material;
+	material.setTexture(0, texture);
+	mMaterial = MaterialRegistry::Register(material);
 }
 
 AnimatedMeshMD2::~AnimatedMeshMD2()
@@ -97,6 +99,7 @@ AnimatedMeshMD2::~AnimatedMeshMD2()
 		delete [] mInterpolationBuffer;
 	if (mIndices)
 		delete mIndices;
+	MaterialRegistry::Drop(mMaterial);
 }
 
 void AnimatedMeshMD2::animate(s32 first, s32 second, f32 ipol)
@@ -159,4 +162,14 @@ aabboxf AnimatedMeshMD2::getBoundingBox(s32 first, s32 second, f32 ipol) const
 	return mBoundingBoxes[first].getInterpolate(mBoundingBoxes[second], ipol);
 }
 
+u32 AnimatedMeshMD2::getResidentBytes() const
+{
+	// The frames, and the interpolation buffer
+	u32 bytes = sizeof(AnimatedMeshMD2) + (mNumFrames+1)*mNumVerticesPerFrame*sizeof(Vertex3);
+	bytes += mNumFrames*sizeof(aabboxf);
+	if (mIndices != nullptr)
+		bytes += mIndices->getDataSize();
+	return bytes;
+}
+
 }
@@ -18,7 +18,7 @@
 #include "Object.h"
 #include "Vertex3.h"
 #include "AnimatedModel.h"
-#include "Material.h"
+#include "MaterialRegistry.h"
 #include "aabbox.h"
 
 namespace fire_engine
@@ -67,10 +67,10 @@ public:
 	 \param num_frames The total number of frames.
 	 \param vertices_per_frame The number of vertices in each frame
 	 \param vertices   The vertices.
-	 \param indices    The indices to the vertices.
+	 \param indices    The indices to the vertices, which are deleted with the mesh.
 	 \param texture    The texture to use for the model */
 	AnimatedMeshMD2(const String& name, s32 num_frames, s32 vertices_per_frame,
-		Vertex3 * vertices, Array<u32> * indices, ITexture * texture);
+		Vertex3 * vertices, IndexBuffer * indices, ITexture * texture);
 
 	//! Dtor
 	virtual ~AnimatedMeshMD2();
@@ -95,7 +95,7 @@ public:
 	virtual inline s32 _getOriginalVertexCount();
 	virtual inline const Vertex3 * getVertices() const;
 	virtual inline s32 getVertexCount() const;
-	virtual inline const Array<u32> * getIndices() const;
+	virtual inline const IndexBuffer * getIndices() const;
 
 	/** Set the frame loop for an MD2 model. Use this instead of the other
 	 setFrameLoop() function, as the frame start and ends are pre-defined
@@ -108,24 +108,26 @@ public:
 	 different QII animations, an average fps number is calculated. */
 	virtual s32 getFPS(s32 frameStart, s32 frameEnd) const;
 
-	/** Returns the material used by this AnimatedMeshMD2. */
-	virtual inline Material getMaterial() const;
+	/** Returns the handle of the material used by this AnimatedMeshMD2. */
+	virtual inline material_handle_t getMaterialHandle() const;
 
 	virtual const aabboxf& getBoundingBox() const;
 
 	virtual aabboxf getBoundingBox(s32 first, s32 second, f32 ipol) const;
 
+	/** Returns the memory used by the mesh: its frames, indices and boxes. */
+	u32 getResidentBytes() const;
+
 private:
 	String                 m_mesh_name;
 	s32                    mNumFrames;
 	s32                    mNumVerticesPerFrame;
 	Vertex3 *              mVertices;
 	Vertex3 *              mInterpolationBuffer;
-	Array<u32> *           mIndices;
-	Material               mMaterial;
+	IndexBuffer *          mIndices;
+	material_handle_t      mMaterial;
 	aabboxf *       mBoundingBoxes;
 	aabboxf         mCurrentBoundingBox;
-	Material Mat;
 
 	/** Update the interpolation buffer, based on the interpolation between two
 	 frames. */
@@ -187,12 +189,12 @@ inline EPOLYGON_TYPE AnimatedMeshMD2::getPolygonType() const
 	return EPT_TRIANGLES;
 }
 
-inline const Array<u32> * AnimatedMeshMD2::getIndices() const
+inline const IndexBuffer * AnimatedMeshMD2::getIndices() const
 {
 	return mIndices;
 }
 
-inline Material AnimatedMeshMD2::getMaterial() const
+inline material_handle_t AnimatedMeshMD2::getMaterialHandle() const
 {
 	return mMaterial;
 }
@@ -11,6 +11,7 @@
 #include "String.h"
 #include "IFile.h"
 #include "FileSystem.h"
+#include "MeshOptimizer.h"
 #include <stdio.h>
 
 #define MD2_MAGIC          0x32504449 // 'IDP2'
@@ -311,7 +312,7 @@ AnimatedMeshMD2 * AnimatedMeshMD2Loader::load(const String& filename, io::IFileP
 		amesh = 0x00;
 	}
 	else
-		amesh = fromMD2Structures(md2h, skins, triangles, tex_coords, frames);
+		amesh = fromMD2Structures(filename, md2h, skins, triangles, tex_coords, frames);
 
 	// Clean-up, and return
 	delete [] skins;
@@ -325,7 +326,69 @@ AnimatedMeshMD2 * AnimatedMeshMD2Loader::load(const String& filename, io::IFileP
 	return amesh;
 }
 
-AnimatedMeshMD2 * AnimatedMeshMD2Loader::fromMD2Structures(MD2Header md2h, md2_skin_t * skins,
+//! The header of a cooked MD2 mesh, followed by its vertices then its indices
+struct cooked_md2_t
+{
+	s32 NumFrames;
+	s32 NumVerticesPerFrame;
+	s32 NumIndices;
+	//! The vertices are written as they are in memory
+	u32 VertexSize;
+	//! The indices too, in 16 or 32 bits
+	u32 IndexSize;
+};
+
+u32 AnimatedMeshMD2Loader::getCookedVersion() const
+{
+	// 2: Vertex3 stores its normal in bytes
+	// 3: the triangles are ordered for the vertex cache
+	// 4: the indices can be 16 bits
+	return 4;
+}
+
+bool AnimatedMeshMD2Loader::cook(const AnimatedMeshMD2 * mesh, io::IFile * file) const
+{
+	// The original vertices are not changed, there is just no const accessor for them
+	AnimatedMeshMD2 * md2 = const_cast<AnimatedMeshMD2 *>(mesh);
+	cooked_md2_t header;
+	header.NumFrames           = md2->getFrameCount();
+	header.NumVerticesPerFrame = md2->_getOriginalVertexCount() / header.NumFrames;
+	header.NumIndices          = md2->getIndices()->getCount();
+	header.VertexSize          = sizeof(Vertex3);
+	header.IndexSize           = IndexBuffer::GetSize(md2->getIndices()->getType());
+	return file->write(&header, sizeof(cooked_md2_t)) &&
+		file->write(md2->_getOriginalVertices(), md2->_getOriginalVertexCount() * sizeof(Vertex3)) &&
+		file->write(md2->getIndices()->getData(), md2->getIndices()->getDataSize());
+}
+
+AnimatedMeshMD2 * AnimatedMeshMD2Loader::loadCooked(io::IFile * file) const
+{
+	cooked_md2_t header;
+	if (!file->read(&header, sizeof(cooked_md2_t)) || header.VertexSize != sizeof(Vertex3) ||
+		header.NumFrames <= 0 || header.NumVerticesPerFrame <= 0 || header.NumIndices < 0 ||
+		(header.IndexSize != sizeof(u16) && header.IndexSize != sizeof(u32)))
+	{
+		return 0;
+	}
+
+	const s32 num_vertices = header.NumFrames * header.NumVerticesPerFrame;
+	Vertex3 * vertices = new Vertex3[num_vertices];
+	u8 * indices       = new u8[header.NumIndices > 0 ? header.NumIndices * header.IndexSize : 1];
+	if (!file->read(vertices, num_vertices * sizeof(Vertex3)) ||
+		!file->read(indices, header.NumIndices * header.IndexSize))
+	{
+		delete [] vertices;
+		delete [] indices;
+		return 0;
+	}
+	IndexBuffer * buffer = new IndexBuffer(indices, header.NumIndices,
+		header.IndexSize == sizeof(u16) ? EIT_16BIT : EIT_32BIT);
+	delete [] indices;
+	return new AnimatedMeshMD2("default md2 mesh", header.NumFrames, header.NumVerticesPerFrame,
+		vertices, buffer, 0);
+}
+
+AnimatedMeshMD2 * AnimatedMeshMD2Loader::fromMD2Structures(const String& filename, MD2Header md2h, md2_skin_t * skins,
     md2_triangle_t * triangles, md2_tex_coords_t * tex_coords, md2_frame_t * frames) const
 {
 	Array<u32> * mesh_triangles  = new Array<u32>(md2h.num_triangles*3);
@@ -364,8 +427,13 @@ AnimatedMeshMD2 * AnimatedMeshMD2Loader::fromMD2Structures(MD2Header md2h, md2_s
 		}
 	}
 
+	MeshOptimizer::Optimize(filename, *mesh_triangles, vertices, md2h.num_vertices,
+		md2h.num_frames, true);
+
+	IndexBuffer * indices = new IndexBuffer(mesh_triangles->const_pointer(), mesh_triangles->size());
+	delete mesh_triangles;
 	AnimatedMeshMD2 * ammd2 = new AnimatedMeshMD2("default md2 mesh", md2h.num_frames,
-		md2h.num_vertices, vertices, mesh_triangles, 0);
+		md2h.num_vertices, vertices, indices, 0);
 
 	return ammd2;
 }
@@ -95,10 +95,18 @@ public:
 	//! Implementation for ILoader
 	virtual AnimatedMeshMD2 * load(const String& filename, io::IFileProvider * fileProvider) const;
 
+	/** The cooked format holds the decoded vertices of every frame, and the indices, so
+	 that loading it back does not decompress the frames again. */
+	virtual u32 getCookedVersion() const;
+
+	virtual bool cook(const AnimatedMeshMD2 * mesh, io::IFile * file) const;
+
+	virtual AnimatedMeshMD2 * loadCooked(io::IFile * file) const;
+
 private:
 	static vector3f m_normal_list[__FIRE_ENGINE_MAX_MD2_NORMALS];
 
-	AnimatedMeshMD2 * fromMD2Structures(MD2Header md2h, md2_skin_t * skins,
+	AnimatedMeshMD2 * fromMD2Structures(const String& filename, MD2Header md2h, md2_skin_t * skins,
 		md2_triangle_t * triangles, md2_tex_coords_t * tex_coords, md2_frame_t * frames) const;
 };
 
@@ -12,7 +12,7 @@
 namespace fire_engine
 {
 
-MeshBufferMD3::MeshBufferMD3(Vertex3 * vertices, Array<u32> * indices, ITexture * texture,
+MeshBufferMD3::MeshBufferMD3(Vertex3 * vertices, IndexBuffer * indices, ITexture * texture,
 	s32 verts_per_frame, s32 num_frames)
 	: mVertices(vertices), mIndices(indices),
 	  mVerticesPerFrame(verts_per_frame), mNumFrames(num_frames)
@@ -23,7 +23,9 @@ MeshBufferMD3::MeshBufferMD3(Vertex3 * vertices, Array<u32> * indices, ITexture
 	mBoundingBoxes = new aabboxf[mNumFrames];
 	calculateBoundingBoxes();
 	mInterpolationBuffer = new Vertex3[verts_per_frame];
-	Mat.setTexture(0, texture);
+	Material material;
+	material.setTexture(0, texture);
+	mMaterial = MaterialRegistry::Register(material);
 }
 
 MeshBufferMD3::~MeshBufferMD3()
@@ -34,6 +36,7 @@ MeshBufferMD3::~MeshBufferMD3()
 		delete mIndices;
 	delete [] mInterpolationBuffer;
 	delete [] mBoundingBoxes;
+	MaterialRegistry::Drop(mMaterial);
 }
 
 EPOLYGON_TYPE MeshBufferMD3::getPolygonType() const
@@ -51,14 +54,14 @@ s32 MeshBufferMD3::getVertexCount() const
 	return mVerticesPerFrame;
 }
 
-const Array<u32> * MeshBufferMD3::getIndices() const
+const IndexBuffer * MeshBufferMD3::getIndices() const
 {
 	return mIndices;
 }
 
-Material MeshBufferMD3::getMaterial() const
+material_handle_t MeshBufferMD3::getMaterialHandle() const
 {
-	return Mat;
+	return mMaterial;
 }
 
 const aabboxf& MeshBufferMD3::getBoundingBox() const
@@ -66,6 +69,16 @@ const aabboxf& MeshBufferMD3::getBoundingBox() const
 	return mInterpolationBoundingBox;
 }
 
+u32 MeshBufferMD3::getResidentBytes() const
+{
+	// The frames, and the interpolation buffer
+	u32 bytes = sizeof(MeshBufferMD3) + (mNumFrames+1)*mVerticesPerFrame*sizeof(Vertex3);
+	bytes += mNumFrames*sizeof(aabboxf);
+	if (mIndices != nullptr)
+		bytes += mIndices->getDataSize();
+	return bytes;
+}
+
 void MeshBufferMD3::updateInterpolationBuffer(s32 first, s32 second, f32 time)
 {
 	const Vertex3 * fVerts = &mVertices[first*mVerticesPerFrame];
@@ -147,6 +160,14 @@ const aabboxf& AnimatedMeshMD3::getBoundingBox() const
 	return mInterpolationBoundingBox;
 }
 
+u32 AnimatedMeshMD3::getResidentBytes() const
+{
+	u32 bytes = sizeof(AnimatedMeshMD3) + mTags->size()*mFrameCount*sizeof(MD3QuaternionTag);
+	for (s32 i = 0; i < mBufferCount; i++)
+		bytes += mBuffers[i]->getResidentBytes();
+	return bytes;
+}
+
 aabboxf AnimatedMeshMD3::getBoundingBox(s32 first, s32 second, f32 ipol) const
 {
 	aabboxf box;
@@ -161,6 +182,20 @@ s32 AnimatedMeshMD3::getNumTags() const
 }
 
 s32 AnimatedMeshMD3::getTagIndex(const String& tagname) const
+{
+	InternedString name;
+	if (!InternedString::Find(tagname, name))
+		return -1;
+	return getTagIndex(name);
+}
+
+s32 AnimatedMeshMD3::getTagIndex(const c8 * tagname) const
+{
+	// Through the String overload, so that unknown names are not interned
+	return getTagIndex(String(tagname));
+}
+
+s32 AnimatedMeshMD3::getTagIndex(const InternedString& tagname) const
 {
 	for (s32 i = 0; i < mTags->size(); i++)
 		if (mTags->at(i)[0].Name == tagname)
@@ -173,5 +208,30 @@ MD3QuaternionTag AnimatedMeshMD3::getTagTransform(s32 tagIndex, s32 cur, s32 nex
 	return mTags->at(tagIndex)[cur].interpolate(mTags->at(tagIndex)[next], time);
 }
 
+void AnimatedMeshMD3::getTagTransforms(s32 cur, s32 next, f32 time, MD3QuaternionTag * tags) const
+{
+	// The rotations are interpolated together, some tags at a time
+	quaternionf from[16], to[16], rotations[16];
+	for (s32 first = 0; first < mTags->size(); first += 16)
+	{
+		const s32 count = (mTags->size() - first < 16) ? mTags->size() - first : 16;
+		for (s32 i = 0; i < count; i++)
+		{
+			const MD3QuaternionTag * frames = mTags->at(first + i);
+			from[i] = frames[cur].Rotation;
+			to[i]   = frames[next].Rotation;
+		}
+		quaternionf::Slerp(from, to, time, rotations, count);
+		for (s32 i = 0; i < count; i++)
+		{
+			const MD3QuaternionTag * frames = mTags->at(first + i);
+			MD3QuaternionTag& tag = tags[first + i];
+			tag.Name     = frames[cur].Name;
+			tag.Rotation = rotations[i];
+			tag.Position = frames[cur].Position*(1-time)+frames[next].Position*time;
+		}
+	}
+}
+
 
 } // namespace fire_engine
@@ -17,8 +17,9 @@
 #include "Array.h"
 #include "matrix4.h"
 #include "quaternion.h"
-#include "Material.h"
+#include "MaterialRegistry.h"
 #include "List.h"
+#include "InternedString.h"
 
 namespace fire_engine
 {
@@ -29,14 +30,14 @@ class IRenderer;
 
 struct _FIRE_ENGINE_API_ MD3QuaternionTag
 {
-	String      Name;
-	quaternionf Rotation;
-	vector3f    Position;
+	InternedString Name;
+	quaternionf    Rotation;
+	vector3f       Position;
 
 	MD3QuaternionTag interpolate(const MD3QuaternionTag& tag, f32 time) const
 	{
 		MD3QuaternionTag newtag;
-		newtag.Name = "";
+		newtag.Name = Name;
 		newtag.Rotation = Rotation.slerp(tag.Rotation, time);
 		newtag.Position = Position*(1-time)+tag.Position*time;
 		return newtag;
@@ -50,7 +51,7 @@ class _FIRE_ENGINE_API_ MeshBufferMD3 : public IMeshBuffer
 {
 public:
 	/** Constructor. */
-	MeshBufferMD3(Vertex3 * vertices, Array<u32> * indices, ITexture * texture,
+	MeshBufferMD3(Vertex3 * vertices, IndexBuffer * indices, ITexture * texture,
 		s32 verts_per_frame, s32 num_frames);
 
 	/** Destructor. */
@@ -66,17 +67,20 @@ public:
 
 	virtual s32 getVertexCount() const;
 
-	virtual const Array<u32> * getIndices() const;
+	virtual const IndexBuffer * getIndices() const;
 
-	virtual Material getMaterial() const;
+	virtual material_handle_t getMaterialHandle() const;
 
 	/** Returns the BoundingBox for the current interpolation. */
 	virtual const aabboxf& getBoundingBox() const;
 
+	/** Returns the memory used by the mesh buffer: its frames, indices and boxes. */
+	u32 getResidentBytes() const;
+
 private:
 	Vertex3 *         mVertices;
-	Array<u32> *      mIndices;
-	Material          Mat;
+	IndexBuffer *     mIndices;
+	material_handle_t mMaterial;
 	aabboxf *  mBoundingBoxes;
 	s32               mVerticesPerFrame;
 	s32               mNumFrames;
@@ -128,12 +132,21 @@ public:
 
 	virtual aabboxf getBoundingBox(s32 first, s32 second, f32 ipol) const;
 
+	/** Returns the memory used by the mesh: its mesh buffers and tags. */
+	u32 getResidentBytes() const;
+
 	/** Returns the number of tags. */
 	s32 getNumTags() const;
 
 	/** Returns the index of the tag in the tag Array, or -1 if it doesn't exist. */
 	s32 getTagIndex(const String& tagname) const;
 
+	/** Returns the index of the tag in the tag Array, or -1 if it doesn't exist. */
+	s32 getTagIndex(const InternedString& tagname) const;
+
+	/** Returns the index of the tag in the tag Array, or -1 if it doesn't exist. */
+	s32 getTagIndex(const c8 * tagname) const;
+
 	/** Returns the interpolated quaternion transform for a given tag, between two given frames.
 	 \param tagIndex The Index of the tag, as returned by getTagIndex().
 	 \param cur      The current frame.
@@ -141,6 +154,13 @@ public:
 	 \param time     The current time, must be between 0.0 and 1.0. */
 	MD3QuaternionTag getTagTransform(s32 tagIndex, s32 cur, s32 next, f32 time) const;
 
+	/** Interpolates all the tags between two given frames, as getTagTransform() does.
+	 \param cur  The current frame.
+	 \param next The next frame.
+	 \param time The current time, must be between 0.0 and 1.0.
+	 \param tags A place to store the getNumTags() interpolated tags. */
+	void getTagTransforms(s32 cur, s32 next, f32 time, MD3QuaternionTag * tags) const;
+
 private:
 	MeshBufferMD3 **           mBuffers;
 	s32                        mBufferCount;
@@ -12,6 +12,7 @@
 #include "String.h"
 #include "IFile.h"
 #include "FileSystem.h"
+#include "MeshOptimizer.h"
 #include "Array.h"
 #include "Vertex3.h"
 #include "Device.h"
@@ -236,6 +237,8 @@ AnimatedMeshMD3 * AnimatedMeshMD3Loader::load(const String& filename, io::IFileP
 			indices->push_back(triangles[j][1]);
 			indices->push_back(triangles[j][0]);
 		}
+		MeshOptimizer::Optimize(mesh_headers[i].name, *indices, vertices, mesh_headers[i].num_verts,
+			mesh_headers[i].num_frames, true);
 
 		// We need the IRenderer to create the textures for us
 		if (strlen(shaders[0].name) > 0)
@@ -246,7 +249,9 @@ AnimatedMeshMD3 * AnimatedMeshMD3Loader::load(const String& filename, io::IFileP
 		{
 			tex = nullptr;
 		}
-		meshes[i] = new MeshBufferMD3(vertices, indices, tex, mesh_headers[i].num_verts, mesh_headers[i].num_frames);
+		meshes[i] = new MeshBufferMD3(vertices, new IndexBuffer(indices->const_pointer(), indices->size()),
+			tex, mesh_headers[i].num_verts, mesh_headers[i].num_frames);
+		delete indices;
 		if (tex)
 		{
 			tex->drop();
@@ -31,13 +31,18 @@ AnimatedModel::AnimatedModel(INode * parent, IAnimatedMesh * mesh)
 		mMesh->grab();
 		for (s32 i = 0; i < mMesh->getMeshBufferCount(); i++)
 		{
-			mMaterials.push_back(mMesh->getMeshBuffer(i)->getMaterial());
+			mMaterials.push_back(mMesh->getMeshBuffer(i)->getMaterialHandle());
+			MaterialRegistry::Grab(mMaterials[i]);
 		}
 	}
 }
 
 AnimatedModel::~AnimatedModel()
 {
+	for (s32 i = 0; i < mMaterials.size(); i++)
+	{
+		MaterialRegistry::Drop(mMaterials[i]);
+	}
 	if (mMesh)
 	{
 		mMesh->drop();
@@ -102,14 +107,23 @@ s32 AnimatedModel::render(IRenderer * rd)
 		IMesh * mesh = mMesh->getMesh(mAnimInfo.mFrameCur, mAnimInfo.mFrameNext, mAnimInfo.mIpolTime);
 		if (mesh != nullptr)
 		{
+			// The boxes of the mesh buffers are transformed together
+			mMeshBufferBoxes.clear();
+			for (s32 i = 0; i < mesh->getMeshBufferCount(); i++)
+				mMeshBufferBoxes.push_back(mesh->getMeshBuffer(i)->getBoundingBox());
+			mWorldTransform.transform(mMeshBufferBoxes.pointer(), mMeshBufferBoxes.size());
+
 			IMeshBuffer * imb = nullptr;
 			for (s32 i = 0; i < mesh->getMeshBufferCount(); i++)
 			{
 				imb = mesh->getMeshBuffer(i);
 				// Check whether mesh buffer is in frustum
-				if (camera->calculateIntersection(mWorldTransform.applyTransformation(imb->getBoundingBox())) != EFIT_OUTSIDE)
+				if (camera->calculateIntersection(mMeshBufferBoxes[i]) != EFIT_OUTSIDE)
 				{
-					rd->drawMeshBuffer(imb);
+					if (i < mMaterials.size())
+						rd->drawMeshBuffer(imb, mMaterials[i]);
+					else
+						rd->drawMeshBuffer(imb);
 					polyCount += imb->getVertexCount();
 					if (mShowDebugInformation)
 					{
@@ -124,9 +138,16 @@ s32 AnimatedModel::render(IRenderer * rd)
 	return polyCount;
 }
 
-Material& AnimatedModel::getMaterial(s32 nr)
+const Material& AnimatedModel::getMaterial(s32 nr) const
+{
+	return MaterialRegistry::Get(mMaterials[nr]);
+}
+
+void AnimatedModel::setMaterial(s32 nr, const Material& material)
 {
-	return mMaterials[nr];
+	const material_handle_t handle = MaterialRegistry::Register(material);
+	MaterialRegistry::Drop(mMaterials[nr]);
+	mMaterials[nr] = handle;
 }
 
 void AnimatedModel::setFrameLoop(s32 start, s32 end, bool loop)
@@ -166,13 +187,17 @@ void AnimatedModel::setMaterialProperty(EMATERIAL_PROPERTY prop, bool isset)
 {
 	for (s32 i = 0; i < mMaterials.size(); i++)
 	{
-		mMaterials[i].setMaterialProperty(prop, isset);
+		Material material(MaterialRegistry::Get(mMaterials[i]));
+		material.setMaterialProperty(prop, isset);
+		const material_handle_t handle = MaterialRegistry::Register(material);
+		MaterialRegistry::Drop(mMaterials[i]);
+		mMaterials[i] = handle;
 	}
 }
 
 void AnimatedModel::recalculateBoundingBox()
 {
-	mBoundingBox = mMesh->getBoundingBox(mAnimInfo.mFrameCur, mAnimInfo.mFrameNext, mAnimInfo.mIpolTime);
+	setBoundingVolume(mMesh->getBoundingBox(mAnimInfo.mFrameCur, mAnimInfo.mFrameNext, mAnimInfo.mIpolTime));
 }
 
 }
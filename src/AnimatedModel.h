@@ -13,7 +13,7 @@
 #include "CompileConfig.h"
 #include "IModel.h"
 #include "Array.h"
-#include "Material.h"
+#include "MaterialRegistry.h"
 
 namespace fire_engine
 {
@@ -50,17 +50,24 @@ public:
 	virtual void preRender(f64 time);
 	virtual s32 render(IRenderer * rd);
 
-	/** Returns the Material based on the 0-indexed nr.
+	/** Returns the Material based on the 0-indexed nr. Materials cannot be modified,
+	 use setMaterial() to replace one.
 	 \param nr The index of the Material. */
-	virtual Material& getMaterial(s32 nr);
+	virtual const Material& getMaterial(s32 nr) const;
+
+	/** Replaces the Material based on the 0-indexed nr. */
+	virtual void setMaterial(s32 nr, const Material& material);
 
 	/** Set a certain material property for all the IMeshBuffers contained within
 	 the IAnimatedMesh. */
 	virtual void setMaterialProperty(EMATERIAL_PROPERTY prop, bool isset);
 
 protected:
-	IAnimatedMesh *  mMesh;
-	Array<Material>  mMaterials;
+	IAnimatedMesh *          mMesh;
+	//! The materials of the mesh buffers, in the MaterialRegistry, grabbed
+	Array<material_handle_t> mMaterials;
+	//! The boxes of the mesh buffers in world space, while rendering
+	Array<aabboxf>           mMeshBufferBoxes;
 
 	/** Contains information about the current rendering state of the model. */
 	typedef struct
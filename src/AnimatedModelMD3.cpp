@@ -48,9 +48,8 @@ bool AnimatedModelMD3::attach(AnimatedModelMD3 * parent, const String& tagname)
 void AnimatedModelMD3::preRender(f64 time)
 {
 	updateAnimationInfo(time);
-	for (s32 i = 0; i < getMD3Mesh()->getNumTags(); i++)
-		mInterpolatedTags[i] = getMD3Mesh()->getTagTransform(i, mAnimInfo.mFrameCur,
-			mAnimInfo.mFrameNext, mAnimInfo.mIpolTime);
+	getMD3Mesh()->getTagTransforms(mAnimInfo.mFrameCur, mAnimInfo.mFrameNext,
+		mAnimInfo.mIpolTime, mInterpolatedTags);
 	ISpaceNode::preRender(time);
 	recalculateBoundingBox();
 }
@@ -0,0 +1,283 @@
+/**
+ * FILE:    AssetCache.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A cache of loaded assets, keyed by their path, so that an asset used in several
+ *          places is only loaded once.
+**/
+
+#ifndef ASSETCACHE_H_INCLUDED
+#define ASSETCACHE_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "String.h"
+#include "InternedString.h"
+#include "HashTable.h"
+#include "FileUtils.h"
+#include "Mutex.h"
+#include <stdio.h>
+
+namespace fire_engine
+{
+
+namespace io
+{
+class IFileProvider;
+}
+
+//! Statistics kept by an AssetCache
+struct asset_cache_stats_t
+{
+	//! Number of lookups that found the asset in the cache
+	u32 Hits;
+	//! Number of lookups that did not
+	u32 Misses;
+	//! Number of assets evicted to stay within the budget
+	u32 Evictions;
+	//! Number of assets in the cache
+	s32 Count;
+	//! Estimated memory used by the assets in the cache, in bytes
+	u32 ResidentBytes;
+};
+
+/** A cache of loaded assets, keyed by the normalised path they were loaded from, so that
+ loading the same file twice returns the same object. The cache holds a reference to
+ every asset in it, and keeps an estimate of the memory they use. When that goes over the
+ budget, the least recently used assets that nothing else references are evicted, until
+ the cache fits in the budget again. Assets still in use are never evicted, so the cache
+ can go over the budget.
+ Keys are interned, so looking an asset up hashes its path once, and compares pointers.
+ The cache can be used from several threads at once.
+ T must derive Object. */
+template <class T>
+class AssetCache
+{
+public:
+	/** Constructor.
+	 \param budget The memory the cache may use, in bytes. */
+	AssetCache(u32 budget = 64 * 1024 * 1024)
+		: mHead(0), mTail(0), mBudget(budget)
+	{
+		resetStats();
+		mStats.Count         = 0;
+		mStats.ResidentBytes = 0;
+	}
+
+	/** Destructor. Drops all the assets in the cache. */
+	~AssetCache()
+	{
+		clear();
+	}
+
+	/** Returns the key of the asset loaded from a file.
+	 \param filename     The name of the file.
+	 \param fileProvider The file provider the file is loaded from first, or nullptr: the
+	                     same path may be a different file in another provider. The key
+	                     holds the number of the provider (see IFileProvider::getId()),
+	                     which is never given to another provider. */
+	static InternedString MakeKey(const String& filename, const io::IFileProvider * fileProvider)
+	{
+		String key = io::FileUtils::MakeLookupKey(filename);
+		if (fileProvider != 0)
+		{
+			c8 prefix[32];
+			sprintf(prefix, "%u:", fileProvider->getId());
+			key = String(prefix) + key;
+		}
+		return InternedString(key);
+	}
+
+	/** Looks an asset up, and counts a hit or a miss.
+	 \return The asset, grabbed for the caller, or nullptr if it is not in the cache. */
+	T * find(const InternedString& key)
+	{
+		sys::MutexLock lock(mLock);
+		cache_entry_t ** found = mEntries.find(key);
+		if (found == 0)
+		{
+			mStats.Misses++;
+			return 0;
+		}
+		mStats.Hits++;
+		cache_entry_t * entry = *found;
+		unlink(entry);
+		linkFront(entry);
+		entry->Asset->grab();
+		return entry->Asset;
+	}
+
+	/** Adds an asset to the cache, and evicts unused assets if the cache is then over the
+	 budget. If another asset was added with the same key meanwhile (by another thread),
+	 asset is dropped and the cached one is returned instead.
+	 \param key   The key of the asset, see MakeKey().
+	 \param asset The asset. The reference of the caller is kept by the caller, and the
+	              cache grabs one of its own.
+	 \param bytes The estimated memory used by the asset.
+	 \return The asset the caller should use, with the caller's reference. */
+	T * insert(const InternedString& key, T * asset, u32 bytes)
+	{
+		sys::MutexLock lock(mLock);
+		cache_entry_t ** found = mEntries.find(key);
+		if (found != 0)
+		{
+			cache_entry_t * entry = *found;
+			if (entry->Asset != asset)
+			{
+				entry->Asset->grab();
+				asset->drop();
+			}
+			unlink(entry);
+			linkFront(entry);
+			return entry->Asset;
+		}
+
+		cache_entry_t * entry = new cache_entry_t;
+		entry->Key   = key;
+		entry->Asset = asset;
+		entry->Bytes = bytes;
+		asset->grab();
+		mEntries.insert(key, entry);
+		linkFront(entry);
+		mStats.Count++;
+		mStats.ResidentBytes += bytes;
+		evict(mBudget);
+		return asset;
+	}
+
+	/** Removes an asset from the cache, whether it is in use or not.
+	 \return true if the asset was in the cache. */
+	bool remove(const InternedString& key)
+	{
+		sys::MutexLock lock(mLock);
+		cache_entry_t ** found = mEntries.find(key);
+		if (found == 0)
+			return false;
+		release(*found);
+		return true;
+	}
+
+	/** Evicts the unused assets, least recently used first, until the cache uses at most
+	 a given amount of memory. trim(0) evicts every unused asset. */
+	void trim(u32 bytes)
+	{
+		sys::MutexLock lock(mLock);
+		evict(bytes);
+	}
+
+	/** Removes all the assets from the cache. */
+	void clear()
+	{
+		sys::MutexLock lock(mLock);
+		while (mHead != 0)
+			release(mHead);
+	}
+
+	/** Sets the memory the cache may use, in bytes, and evicts unused assets if it is
+	 now over it. */
+	void setBudget(u32 bytes)
+	{
+		sys::MutexLock lock(mLock);
+		mBudget = bytes;
+		evict(mBudget);
+	}
+
+	/** Returns the memory the cache may use, in bytes. */
+	u32 getBudget() const
+	{
+		return mBudget;
+	}
+
+	/** Returns the statistics of the cache. */
+	asset_cache_stats_t getStats() const
+	{
+		sys::MutexLock lock(mLock);
+		return mStats;
+	}
+
+	/** Resets the hit, miss and eviction counts. */
+	void resetStats()
+	{
+		sys::MutexLock lock(mLock);
+		mStats.Hits      = 0;
+		mStats.Misses    = 0;
+		mStats.Evictions = 0;
+	}
+
+private:
+	//! An asset in the cache, in the list of assets from the most to the least recently used
+	struct cache_entry_t
+	{
+		InternedString  Key;
+		T *             Asset;
+		u32             Bytes;
+		cache_entry_t * Previous;
+		cache_entry_t * Next;
+	};
+
+	HashTable<InternedString, cache_entry_t *> mEntries;
+	cache_entry_t *                            mHead;
+	cache_entry_t *                            mTail;
+	u32                                        mBudget;
+	asset_cache_stats_t                        mStats;
+	mutable sys::Mutex                         mLock;
+
+	//! Evicts unused assets, least recently used first, while the cache uses more than bytes
+	void evict(u32 bytes)
+	{
+		cache_entry_t * entry = mTail;
+		while (entry != 0 && mStats.ResidentBytes > bytes)
+		{
+			cache_entry_t * previous = entry->Previous;
+			// Only the cache references the asset, and only the cache can hand it out
+			if (entry->Asset->getReferenceCount() == 1)
+			{
+				release(entry);
+				mStats.Evictions++;
+			}
+			entry = previous;
+		}
+	}
+
+	//! Removes an entry from the cache, and drops its asset
+	void release(cache_entry_t * entry)
+	{
+		unlink(entry);
+		mEntries.remove(entry->Key);
+		mStats.Count--;
+		mStats.ResidentBytes -= entry->Bytes;
+		entry->Asset->drop();
+		delete entry;
+	}
+
+	void linkFront(cache_entry_t * entry)
+	{
+		entry->Previous = 0;
+		entry->Next     = mHead;
+		if (mHead != 0)
+			mHead->Previous = entry;
+		else
+			mTail = entry;
+		mHead = entry;
+	}
+
+	void unlink(cache_entry_t * entry)
+	{
+		if (entry->Previous != 0)
+			entry->Previous->Next = entry->Next;
+		else
+			mHead = entry->Next;
+		if (entry->Next != 0)
+			entry->Next->Previous = entry->Previous;
+		else
+			mTail = entry->Previous;
+	}
+
+	// Copying is not supported
+	AssetCache(const AssetCache&);
+	AssetCache& operator=(const AssetCache&);
+};
+
+} // namespace fire_engine
+
+#endif // ASSETCACHE_H_INCLUDED
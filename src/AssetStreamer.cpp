@@ -0,0 +1,239 @@
+/**
+ * FILE:    AssetStreamer.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the AssetStreamer class.
+**/
+
+#include "AssetStreamer.h"
+#include "AsyncLoad.h"
+#include "Thread.h"
+#include "HighResolutionTimer.h"
+#include "Device.h"
+#include "IRenderer.h"
+
+namespace fire_engine
+{
+
+//! A worker thread of the AssetStreamer
+class AssetStreamer::Worker : public sys::Thread
+{
+public:
+	Worker(AssetStreamer * streamer)
+		: mStreamer(streamer)
+	{
+	}
+
+protected:
+	virtual void run()
+	{
+		while (mStreamer->work())
+		{
+			;
+		}
+	}
+
+private:
+	AssetStreamer * mStreamer;
+};
+
+AssetStreamer::AssetStreamer(s32 threads)
+	: mLoadingCount(0), mStopping(false), mViewPosition(0.0f, 0.0f, 0.0f),
+	mCancelDistance(-1.0f), mFrameBudget(0.002)
+{
+	for (s32 i = 0; i < threads; i++)
+	{
+		Worker * worker = new Worker(this);
+		if (worker->start())
+			mWorkers.push_back(worker);
+		else
+			delete worker;
+	}
+}
+
+AssetStreamer::~AssetStreamer()
+{
+	{
+		sys::MutexLock lock(mLock);
+		mStopping = true;
+	}
+	for (s32 i = 0; i < mWorkers.size(); i++)
+		mWork.post();
+	for (s32 i = 0; i < mWorkers.size(); i++)
+	{
+		mWorkers[i]->join();
+		delete mWorkers[i];
+	}
+
+	for (s32 i = 0; i < mQueue.size(); i++)
+	{
+		mQueue[i]->cancel();
+		mQueue[i]->drop();
+	}
+	for (s32 i = 0; i < mLoaded.size(); i++)
+	{
+		mLoaded[i]->cancel();
+		mLoaded[i]->drop();
+	}
+}
+
+void AssetStreamer::stream(IAsyncLoad * request)
+{
+	request->grab();
+	{
+		sys::MutexLock lock(mLock);
+		mQueue.push_back(request);
+		mDistances.push_back(distanceOf(request));
+	}
+	mWork.post();
+}
+
+void AssetStreamer::setViewPosition(const vector3f& position)
+{
+	sys::MutexLock lock(mLock);
+	mViewPosition = position;
+	s32 i = 0;
+	while (i < mQueue.size())
+	{
+		IAsyncLoad * request = mQueue[i];
+		f32 distance = distanceOf(request);
+		if (mCancelDistance >= 0.0f && distance > mCancelDistance)
+			request->cancel();
+
+		if (request->getState() == EALS_CANCELLED)
+		{
+			// Remove the request by moving the last one in its place
+			s32 last = mQueue.size() - 1;
+			mQueue[i]     = mQueue[last];
+			mDistances[i] = mDistances[last];
+			mQueue.remove(last);
+			mDistances.remove(last);
+			request->drop();
+		}
+		else
+		{
+			mDistances[i] = distance;
+			i++;
+		}
+	}
+}
+
+void AssetStreamer::setCancelDistance(f32 distance)
+{
+	mCancelDistance = distance;
+}
+
+void AssetStreamer::setFrameBudget(f64 seconds)
+{
+	mFrameBudget = seconds;
+}
+
+void AssetStreamer::update()
+{
+	sys::HighResolutionTimer timer;
+	timer.start();
+
+	f64 elapsed = 0.0;
+	for (;;)
+	{
+		IAsyncLoad * request;
+		{
+			sys::MutexLock lock(mLock);
+			if (mLoaded.size() == 0)
+				break;
+			// Finish the requests in the order they were loaded in
+			request = mLoaded[0];
+			for (s32 i = 1; i < mLoaded.size(); i++)
+				mLoaded[i-1] = mLoaded[i];
+			mLoaded.remove(mLoaded.size() - 1);
+		}
+
+		if (request->getState() == EALS_LOADED)
+		{
+			// The state only becomes ready once finished, so that get() never returns
+			// an object that is not finished. The request may be cancelled meanwhile.
+			if (request->finish())
+				request->_changeState(EALS_LOADED, EALS_READY);
+			else
+				request->_changeState(EALS_LOADED, EALS_FAILED);
+		}
+		request->drop();
+
+		elapsed = timer.getElapsedTimeSeconds();
+		if (elapsed >= mFrameBudget)
+			break;
+	}
+
+	// Spend what is left of the budget uploading the textures created by the workers
+	if (Device::Get() != nullptr && Device::Get()->getRenderer() != nullptr)
+	{
+		f64 remaining = mFrameBudget - elapsed;
+		Device::Get()->getRenderer()->uploadPendingTextures(remaining > 0.0 ? remaining : 0.0);
+	}
+}
+
+s32 AssetStreamer::getPendingCount()
+{
+	sys::MutexLock lock(mLock);
+	return mQueue.size() + mLoadingCount;
+}
+
+bool AssetStreamer::work()
+{
+	mWork.wait();
+
+	IAsyncLoad * request;
+	{
+		sys::MutexLock lock(mLock);
+		if (mStopping)
+			return false;
+
+		// Take the closest request. Requests without a position have a distance of -1,
+		// and are taken first.
+		s32 best = -1;
+		for (s32 i = 0; i < mQueue.size(); i++)
+		{
+			if (best < 0 || mDistances[i] < mDistances[best])
+				best = i;
+		}
+		if (best < 0)
+			return true; // The request was cancelled
+		request = mQueue[best];
+		s32 last = mQueue.size() - 1;
+		mQueue[best]     = mQueue[last];
+		mDistances[best] = mDistances[last];
+		mQueue.remove(last);
+		mDistances.remove(last);
+
+		if (!request->_changeState(EALS_QUEUED, EALS_LOADING))
+		{
+			request->drop();
+			return true;
+		}
+		mLoadingCount++;
+	}
+
+	bool loaded = request->load();
+
+	sys::MutexLock lock(mLock);
+	mLoadingCount--;
+	if (loaded && request->_changeState(EALS_LOADING, EALS_LOADED))
+	{
+		mLoaded.push_back(request);
+	}
+	else
+	{
+		request->_changeState(EALS_LOADING, EALS_FAILED);
+		request->drop();
+	}
+	return true;
+}
+
+f32 AssetStreamer::distanceOf(const IAsyncLoad * request) const
+{
+	if (!request->hasPosition())
+		return -1.0f;
+	return request->getPosition().distance(mViewPosition);
+}
+
+} // namespace fire_engine
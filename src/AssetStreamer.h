@@ -0,0 +1,99 @@
+/**
+ * FILE:    AssetStreamer.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A pool of worker threads that load assets in the background.
+**/
+
+#ifndef ASSETSTREAMER_H_INCLUDED
+#define ASSETSTREAMER_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "Array.h"
+#include "vector3.h"
+#include "Mutex.h"
+#include "Semaphore.h"
+
+namespace fire_engine
+{
+
+class IAsyncLoad;
+
+/** Loads assets in the background, with a pool of worker threads. Requests (see
+ IAsyncLoad) are queued with stream(), and the workers load the queued request that is the
+ closest to the viewer first. Requests that end up further from the viewer than the cancel
+ distance are cancelled before they are loaded.
+ Once a request has been loaded, it is finished on the main thread by update(), which
+ should be called once per frame (the SceneManager does so). update() also uploads the
+ textures that were created by the worker threads, and spends at most a given budget of
+ time doing both, so that streaming does not stall the frame. */
+class _FIRE_ENGINE_API_ AssetStreamer
+{
+public:
+	/** Constructor. Starts the worker threads.
+	 \param threads The number of worker threads. */
+	AssetStreamer(s32 threads = 2);
+
+	/** Destructor. Waits for the requests being loaded, and cancels the others. */
+	~AssetStreamer();
+
+	/** Queues a request. The request is grabbed until it is over. */
+	void stream(IAsyncLoad * request);
+
+	/** Sets the position of the viewer, which is used to prioritise the queued requests,
+	 and cancels the queued requests that are now too far away. Call this from the main
+	 thread. */
+	void setViewPosition(const vector3f& position);
+
+	/** Sets the distance beyond which queued requests are cancelled.
+	 \param distance The distance, or a negative value (the default) to never cancel
+	                 requests because of their distance. */
+	void setCancelDistance(f32 distance);
+
+	/** Sets the time update() may spend each frame.
+	 \param seconds The budget, in seconds. At least one request is always finished. */
+	void setFrameBudget(f64 seconds);
+
+	/** Finishes the requests loaded by the worker threads, then uploads the pending
+	 textures, within the frame budget. Call this once per frame, from the main thread. */
+	void update();
+
+	/** Returns the number of requests that are queued or being loaded. */
+	s32 getPendingCount();
+
+private:
+	class Worker;
+
+	Array<Worker*>      mWorkers;
+	//! The requests waiting for a worker
+	Array<IAsyncLoad*>  mQueue;
+	//! The distance of each queued request to the viewer, -1 for those without a position
+	Array<f32>          mDistances;
+	//! The requests loaded by the workers, waiting to be finished
+	Array<IAsyncLoad*>  mLoaded;
+	//! The number of requests being loaded by the workers
+	s32                 mLoadingCount;
+	sys::Mutex          mLock;
+	//! Counts the queued requests, plus one for each worker when stopping
+	sys::Semaphore      mWork;
+	bool                mStopping;
+	vector3f            mViewPosition;
+	f32                 mCancelDistance;
+	f64                 mFrameBudget;
+
+	/** Called by the worker threads: takes the best queued request, loads it, and gives it
+	 to the main thread. Returns false when the streamer is being destroyed. */
+	bool work();
+
+	/** Returns the distance from the viewer used to prioritise a request. */
+	f32 distanceOf(const IAsyncLoad * request) const;
+
+	// Copying is not supported
+	AssetStreamer(const AssetStreamer&);
+	AssetStreamer& operator=(const AssetStreamer&);
+};
+
+} // namespace fire_engine
+
+#endif // ASSETSTREAMER_H_INCLUDED
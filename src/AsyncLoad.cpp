@@ -0,0 +1,85 @@
+/**
+ * FILE:    AsyncLoad.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the non-templated methods of the asynchronous loads.
+**/
+
+#include "AsyncLoad.h"
+#include "Atomic.h"
+#include "IFileProvider.h"
+
+namespace fire_engine
+{
+
+IAsyncLoad::IAsyncLoad(const String& filename, io::IFileProvider * fileProvider)
+	: mFileProvider(fileProvider), mFilename(filename), mState(EALS_QUEUED),
+	mHasPosition(false)
+{
+#if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
+	setDebugName("fire_engine::IAsyncLoad");
+#endif
+	if (mFileProvider != nullptr)
+		mFileProvider->grab();
+}
+
+IAsyncLoad::~IAsyncLoad()
+{
+	if (mFileProvider != nullptr)
+		mFileProvider->drop();
+}
+
+E_ASYNC_LOAD_STATE IAsyncLoad::getState() const
+{
+	return (E_ASYNC_LOAD_STATE)AtomicLoadAcquire(&mState);
+}
+
+bool IAsyncLoad::isDone() const
+{
+	E_ASYNC_LOAD_STATE state = getState();
+	return state == EALS_READY || state == EALS_FAILED || state == EALS_CANCELLED;
+}
+
+void IAsyncLoad::cancel()
+{
+	// The state may be changed by a worker thread at the same time, so try each of the
+	// states that can still be cancelled
+	if (!_changeState(EALS_QUEUED, EALS_CANCELLED) &&
+		!_changeState(EALS_LOADING, EALS_CANCELLED))
+	{
+		_changeState(EALS_LOADED, EALS_CANCELLED);
+	}
+}
+
+const String& IAsyncLoad::getFilename() const
+{
+	return mFilename;
+}
+
+void IAsyncLoad::setPosition(const vector3f& position)
+{
+	mPosition    = position;
+	mHasPosition = true;
+}
+
+bool IAsyncLoad::hasPosition() const
+{
+	return mHasPosition;
+}
+
+const vector3f& IAsyncLoad::getPosition() const
+{
+	return mPosition;
+}
+
+bool IAsyncLoad::finish()
+{
+	return true;
+}
+
+bool IAsyncLoad::_changeState(E_ASYNC_LOAD_STATE from, E_ASYNC_LOAD_STATE to)
+{
+	return AtomicCompareExchange(&mState, to, from) == from;
+}
+
+} // namespace fire_engine
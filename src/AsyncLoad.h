@@ -0,0 +1,143 @@
+/**
+ * FILE:    AsyncLoad.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A handle on an object that is being loaded in the background.
+**/
+
+#ifndef ASYNCLOAD_H_INCLUDED
+#define ASYNCLOAD_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "Object.h"
+#include "String.h"
+#include "ILoader.h"
+#include "vector3.h"
+
+namespace fire_engine
+{
+
+namespace io
+{
+class IFileProvider;
+}
+
+//! The states an asynchronous load goes through
+enum E_ASYNC_LOAD_STATE
+{
+	EALS_QUEUED,    // Waiting for a worker thread
+	EALS_LOADING,   // Being loaded by a worker thread
+	EALS_LOADED,    // Loaded, waiting to be finished on the main thread
+	EALS_READY,     // Loaded and finished, the object can be used
+	EALS_FAILED,    // The object could not be loaded
+	EALS_CANCELLED  // The load was cancelled before it completed
+};
+
+/** A request to load something in the background, which is also the handle used to follow
+ the load. Requests are given to the AssetStreamer of the MediaManager: load() is called
+ by a worker thread, then finish() by the main thread, in AssetStreamer::update().
+ Requests that have a position are loaded closest to the viewer first, and those without
+ one before all others. */
+class _FIRE_ENGINE_API_ IAsyncLoad : public Object
+{
+public:
+	/** Constructor.
+	 \param filename     The name of the file to load.
+	 \param fileProvider A file provider to use first, or nullptr. It is grabbed until the
+	                     request is destroyed. */
+	IAsyncLoad(const String& filename, io::IFileProvider * fileProvider);
+
+	/** Destructor. */
+	virtual ~IAsyncLoad();
+
+	/** Returns the state of the load. */
+	E_ASYNC_LOAD_STATE getState() const;
+
+	/** Returns whether the load is over, whether it succeeded or not. */
+	bool isDone() const;
+
+	/** Cancels the load, if it is not over yet. Whatever was loaded is thrown away. */
+	void cancel();
+
+	/** Returns the name of the file to load. */
+	const String& getFilename() const;
+
+	/** Sets the position of the object in the world, which is used to load the closest
+	 objects first, and to cancel those that are too far away. Call this from the main
+	 thread only. */
+	void setPosition(const vector3f& position);
+
+	/** Returns whether a position was given with setPosition(). */
+	bool hasPosition() const;
+
+	/** Returns the position given with setPosition(). */
+	const vector3f& getPosition() const;
+
+	/** Loads the object. Called by a worker thread.
+	 \return true if the object was loaded, false otherwise. */
+	virtual bool load() = 0;
+
+	/** Finishes loading the object, with whatever must be done on the main thread (such as
+	 creating GPU resources). Called by the main thread once load() has succeeded.
+	 \return true if the object is ready, false otherwise. */
+	virtual bool finish();
+
+	/** Changes the state from one value to another, if it still has the first value.
+	 Internal function, used by the AssetStreamer - do not use.
+	 \return true if the state was changed, false otherwise. */
+	bool _changeState(E_ASYNC_LOAD_STATE from, E_ASYNC_LOAD_STATE to);
+
+protected:
+	io::IFileProvider * mFileProvider;
+
+private:
+	String       mFilename;
+	volatile s32 mState;
+	vector3f     mPosition;
+	bool         mHasPosition;
+};
+
+/** A request to load an object with one of the loaders of the MediaManager. The object is
+ available with get() once the request is ready. */
+template <class T>
+class AsyncLoad : public IAsyncLoad
+{
+public:
+	/** Constructor.
+	 \param loader       The loader to use. It must exist until the request is over.
+	 \param filename     The name of the file to load.
+	 \param fileProvider A file provider to use first, or nullptr. */
+	AsyncLoad(const ILoader<T> * loader, const String& filename, io::IFileProvider * fileProvider)
+		: IAsyncLoad(filename, fileProvider), mLoader(loader), mResult(0)
+	{
+	}
+
+	/** Destructor. Drops the loaded object. */
+	virtual ~AsyncLoad()
+	{
+		if (mResult != 0)
+			mResult->drop();
+	}
+
+	/** Returns the loaded object if the request is ready, 0 otherwise. The object is owned
+	 by the request: grab it to keep it once the request is dropped. */
+	T * get() const
+	{
+		return getState() == EALS_READY ? mResult : 0;
+	}
+
+	virtual bool load()
+	{
+		mResult = mLoader->load(getFilename(), mFileProvider);
+		return mResult != 0;
+	}
+
+protected:
+	const ILoader<T> * mLoader;
+	T *                mResult;
+};
+
+} // namespace fire_engine
+
+#endif // ASYNCLOAD_H_INCLUDED
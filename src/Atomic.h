@@ -0,0 +1,90 @@
+/**
+ * FILE:    Atomic.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Atomic operations on 32 bit integers, implemented with the compiler's
+ *          intrinsics.
+**/
+
+#ifndef ATOMIC_H_INCLUDED
+#define ATOMIC_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#	pragma intrinsic(_InterlockedIncrement, _InterlockedDecrement, _InterlockedExchangeAdd, _InterlockedCompareExchange)
+#endif
+
+namespace fire_engine
+{
+
+/** Atomically increments value, and returns the new value. No ordering with respect to
+ other memory operations is guaranteed. */
+inline s32 AtomicIncrementRelaxed(volatile s32 * value)
+{
+#if defined(_MSC_VER)
+	return _InterlockedIncrement((volatile long *)value);
+#elif defined(__ATOMIC_RELAXED)
+	return __atomic_add_fetch(value, 1, __ATOMIC_RELAXED);
+#else
+	return __sync_add_and_fetch(value, 1);
+#endif
+}
+
+/** Atomically decrements value, and returns the new value. Memory operations before the
+ decrement are visible to the thread that observes the result reach zero. */
+inline s32 AtomicDecrementAcqRel(volatile s32 * value)
+{
+#if defined(_MSC_VER)
+	return _InterlockedDecrement((volatile long *)value);
+#elif defined(__ATOMIC_ACQ_REL)
+	return __atomic_sub_fetch(value, 1, __ATOMIC_ACQ_REL);
+#else
+	return __sync_sub_and_fetch(value, 1);
+#endif
+}
+
+/** Atomically adds amount to value, and returns the previous value. Acts as a full
+ memory barrier. */
+inline s32 AtomicFetchAdd(volatile s32 * value, s32 amount)
+{
+#if defined(_MSC_VER)
+	return _InterlockedExchangeAdd((volatile long *)value, amount);
+#elif defined(__ATOMIC_SEQ_CST)
+	return __atomic_fetch_add(value, amount, __ATOMIC_SEQ_CST);
+#else
+	return __sync_fetch_and_add(value, amount);
+#endif
+}
+
+/** Atomically sets value to exchange if it is equal to comparand.
+ \return The value before the operation. */
+inline s32 AtomicCompareExchange(volatile s32 * value, s32 exchange, s32 comparand)
+{
+#if defined(_MSC_VER)
+	return _InterlockedCompareExchange((volatile long *)value, exchange, comparand);
+#else
+	return __sync_val_compare_and_swap(value, comparand, exchange);
+#endif
+}
+
+/** Reads value, so that memory operations made before another thread last wrote it
+ are visible. */
+inline s32 AtomicLoadAcquire(const volatile s32 * value)
+{
+#if defined(_MSC_VER)
+	// volatile reads have acquire semantics with VC++
+	return *value;
+#elif defined(__ATOMIC_ACQUIRE)
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#else
+	__sync_synchronize();
+	return *value;
+#endif
+}
+
+} // namespace fire_engine
+
+#endif // ATOMIC_H_INCLUDED
@@ -0,0 +1,450 @@
+/**
+ * FILE:    BlockCompressor.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the BlockCompressor class.
+**/
+
+#include "BlockCompressor.h"
+#include "CPUInfo.h"
+#include "ColorConverter.h"
+#include "Math.h"
+#include <string.h>
+
+#ifdef _FIRE_ENGINE_SSE_
+#	include <emmintrin.h>
+#endif
+
+namespace fire_engine
+{
+
+//! The index of the colour picked by a pixel, from the number of halfway points between
+//! the colours that it is past, going from the second end point to the first one
+static const u32 ColorIndexOfStep[4] = { 1, 3, 2, 0 };
+
+//! The weight of the first end point in the colour of each index
+static const f32 ColorWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+static s32 ClampByte(s32 value)
+{
+	return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static u16 PackR5G6B5(const s32 * rgb)
+{
+	return (u16)((((rgb[0] * 31 + 127) / 255) << 11) | (((rgb[1] * 63 + 127) / 255) << 5) |
+		((rgb[2] * 31 + 127) / 255));
+}
+
+static void UnpackR5G6B5(u16 color, s32 * rgb)
+{
+	const s32 r = (color >> 11) & 0x1F;
+	const s32 g = (color >> 5) & 0x3F;
+	const s32 b = color & 0x1F;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+//! Converts a row of pixels to R, G, B and A bytes
+static void ToRGBA8(const u8 * in, Image::EIMAGE_DATA_TYPE type, s32 count, u8 * out)
+{
+	if (type == Image::EIDT_A1R5G5B5)
+	{
+		// Expanded with the row kernel of ColorConverter, a part of the row at a time. The
+		// top bits of each field are then copied into the bits it leaves empty, and the
+		// alpha bit becomes 0 or 255.
+		u32 expanded[256];
+		for (s32 start = 0; start < count; start += 256)
+		{
+			const s32 n = (count - start < 256) ? count - start : 256;
+			ColorConverter::A1R5G5B5toA8R8G8B8((const u16 *)in + start, expanded, n);
+			for (s32 i = 0; i < n; i++, out += 4)
+			{
+				const u32 texel = expanded[i] | ((expanded[i] >> 5) & 0x00070707);
+				out[0] = (u8)(texel >> 16);
+				out[1] = (u8)(texel >> 8);
+				out[2] = (u8)texel;
+				out[3] = (texel & 0x80000000) != 0 ? 255 : 0;
+			}
+		}
+		return;
+	}
+
+	for (s32 i = 0; i < count; i++, out += 4)
+	{
+		switch (type)
+		{
+		case Image::EIDT_A8R8G8B8:
+			// A8R8G8B8 in a little endian u32: B, G, R and A bytes
+			out[0] = in[i*4+2];
+			out[1] = in[i*4+1];
+			out[2] = in[i*4+0];
+			out[3] = in[i*4+3];
+			break;
+		case Image::EIDT_R8G8B8:
+			out[0] = in[i*3+0];
+			out[1] = in[i*3+1];
+			out[2] = in[i*3+2];
+			out[3] = 255;
+			break;
+		case Image::EIDT_R5G6B5:
+		{
+			s32 rgb[3];
+			UnpackR5G6B5(((const u16 *)in)[i], rgb);
+			out[0] = (u8)rgb[0];
+			out[1] = (u8)rgb[1];
+			out[2] = (u8)rgb[2];
+			out[3] = 255;
+			break;
+		}
+		default:
+			memset(out, 0, 4);
+		}
+	}
+}
+
+/** Finds the end points of a block from the bounding box of its colours, using the
+ diagonal along which the colours are spread (green and blue go down as red goes up if
+ they are anti-correlated), inset by 1/16 of the box: the end points are rarely used as is. */
+static void FindEndPointsBox(const u8 * block, s32 * high, s32 * low)
+{
+	s32 minimum[3] = { 255, 255, 255 };
+	s32 maximum[3] = { 0, 0, 0 };
+	for (s32 i = 0; i < 16; i++)
+	{
+		for (s32 k = 0; k < 3; k++)
+		{
+			minimum[k] = block[i*4+k] < minimum[k] ? block[i*4+k] : minimum[k];
+			maximum[k] = block[i*4+k] > maximum[k] ? block[i*4+k] : maximum[k];
+		}
+	}
+
+	s32 covariance[3] = { 0, 0, 0 };
+	for (s32 i = 0; i < 16; i++)
+	{
+		const s32 r = 2*block[i*4] - minimum[0] - maximum[0];
+		covariance[1] += r * (2*block[i*4+1] - minimum[1] - maximum[1]);
+		covariance[2] += r * (2*block[i*4+2] - minimum[2] - maximum[2]);
+	}
+	for (s32 k = 0; k < 3; k++)
+	{
+		high[k] = maximum[k];
+		low[k]  = minimum[k];
+		if (covariance[k] < 0)
+		{
+			high[k] = minimum[k];
+			low[k]  = maximum[k];
+		}
+		const s32 inset = (high[k] - low[k]) / 16;
+		high[k] -= inset;
+		low[k]  += inset;
+	}
+}
+
+/** Finds the end points of a block from the extremes of its colours along their principal
+ axis: the eigenvector of their covariance matrix with the largest eigenvalue, found by
+ power iteration. */
+static void FindEndPointsPCA(const u8 * block, s32 * high, s32 * low)
+{
+	f32 mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (s32 i = 0; i < 16; i++)
+		for (s32 k = 0; k < 3; k++)
+			mean[k] += block[i*4+k];
+	for (s32 k = 0; k < 3; k++)
+		mean[k] /= 16.0f;
+
+	// rr, rg, rb, gg, gb, bb
+	f32 cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for (s32 i = 0; i < 16; i++)
+	{
+		const f32 r = block[i*4]   - mean[0];
+		const f32 g = block[i*4+1] - mean[1];
+		const f32 b = block[i*4+2] - mean[2];
+		cov[0] += r*r; cov[1] += r*g; cov[2] += r*b;
+		cov[3] += g*g; cov[4] += g*b; cov[5] += b*b;
+	}
+
+	// Start from the column of the channel that varies most
+	f32 axis[3];
+	if (cov[0] >= cov[3] && cov[0] >= cov[5])
+		{ axis[0] = cov[0]; axis[1] = cov[1]; axis[2] = cov[2]; }
+	else if (cov[3] >= cov[5])
+		{ axis[0] = cov[1]; axis[1] = cov[3]; axis[2] = cov[4]; }
+	else
+		{ axis[0] = cov[2]; axis[1] = cov[4]; axis[2] = cov[5]; }
+	for (s32 iteration = 0; iteration < 8; iteration++)
+	{
+		const f32 x = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2];
+		const f32 y = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+		const f32 z = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+		f32 largest = Math32::Abs(x) > Math32::Abs(y) ? Math32::Abs(x) : Math32::Abs(y);
+		largest = Math32::Abs(z) > largest ? Math32::Abs(z) : largest;
+		if (largest < 1e-6f)
+			break;
+		axis[0] = x / largest;
+		axis[1] = y / largest;
+		axis[2] = z / largest;
+	}
+
+	const f32 length2 = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+	f32 tmin = 0.0f, tmax = 0.0f;
+	if (length2 > 1e-6f)
+	{
+		tmin = 1e30f;
+		tmax = -1e30f;
+		for (s32 i = 0; i < 16; i++)
+		{
+			const f32 t = ((block[i*4] - mean[0])*axis[0] + (block[i*4+1] - mean[1])*axis[1] +
+				(block[i*4+2] - mean[2])*axis[2]) / length2;
+			tmin = t < tmin ? t : tmin;
+			tmax = t > tmax ? t : tmax;
+		}
+	}
+	for (s32 k = 0; k < 3; k++)
+	{
+		high[k] = ClampByte((s32)(mean[k] + axis[k]*tmax + 0.5f));
+		low[k]  = ClampByte((s32)(mean[k] + axis[k]*tmin + 0.5f));
+	}
+}
+
+/** Finds the end points that best fit the colours picked by the pixels of a block, in the
+ least squares sense.
+ \return false if the pixels all picked the same end point. */
+static bool FitEndPoints(const u8 * block, u32 indices, s32 * high, s32 * low)
+{
+	f32 aa = 0.0f, bb = 0.0f, ab = 0.0f;
+	f32 ax[3] = { 0.0f, 0.0f, 0.0f };
+	f32 bx[3] = { 0.0f, 0.0f, 0.0f };
+	for (s32 i = 0; i < 16; i++)
+	{
+		const f32 a = ColorWeights[(indices >> (2*i)) & 3];
+		const f32 b = 1.0f - a;
+		aa += a*a;
+		bb += b*b;
+		ab += a*b;
+		for (s32 k = 0; k < 3; k++)
+		{
+			ax[k] += a*block[i*4+k];
+			bx[k] += b*block[i*4+k];
+		}
+	}
+	const f32 det = aa*bb - ab*ab;
+	if (Math32::Abs(det) < 1e-4f)
+		return false;
+	for (s32 k = 0; k < 3; k++)
+	{
+		high[k] = ClampByte((s32)((ax[k]*bb - bx[k]*ab) / det + 0.5f));
+		low[k]  = ClampByte((s32)((bx[k]*aa - ax[k]*ab) / det + 0.5f));
+	}
+	return true;
+}
+
+/** Picks the colour of each pixel by projecting it on the line between the end points.
+ \param axis  The first end point minus the second one.
+ \param steps Twice the projections of the halfway points between the 4 colours. */
+static u32 SelectColorIndices(const u8 * block, const s32 * axis, const s32 * steps)
+{
+	u32 indices = 0;
+	for (s32 i = 0; i < 16; i++)
+	{
+		const s32 d = 2 * (block[i*4]*axis[0] + block[i*4+1]*axis[1] + block[i*4+2]*axis[2]);
+		const s32 n = (d > steps[0]) + (d > steps[1]) + (d > steps[2]);
+		indices |= ColorIndexOfStep[n] << (2*i);
+	}
+	return indices;
+}
+
+#ifdef _FIRE_ENGINE_SSE_
+
+//! SelectColorIndices(), 4 pixels at a time
+static u32 SelectColorIndicesSSE2(const u8 * block, const s32 * axis, const s32 * steps)
+{
+	const __m128i zero  = _mm_setzero_si128();
+	const __m128i dir   = _mm_setr_epi16((s16)axis[0], (s16)axis[1], (s16)axis[2], 0,
+		(s16)axis[0], (s16)axis[1], (s16)axis[2], 0);
+	const __m128i step0 = _mm_set1_epi32(steps[0]);
+	const __m128i step1 = _mm_set1_epi32(steps[1]);
+	const __m128i step2 = _mm_set1_epi32(steps[2]);
+	u32 indices = 0;
+	for (s32 i = 0; i < 16; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128((const __m128i *)(block + i*4));
+		// r*x + g*y and b*z + 0 for 2 pixels in each
+		const __m128 lo = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), dir));
+		const __m128 hi = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), dir));
+		__m128i d = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))),
+			_mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))));
+		d = _mm_slli_epi32(d, 1);
+		// Comparisons give -1 when true
+		const __m128i n = _mm_sub_epi32(zero, _mm_add_epi32(_mm_add_epi32(
+			_mm_cmpgt_epi32(d, step0), _mm_cmpgt_epi32(d, step1)), _mm_cmpgt_epi32(d, step2)));
+		s32 counts[4];
+		_mm_storeu_si128((__m128i *)counts, n);
+		for (s32 j = 0; j < 4; j++)
+			indices |= ColorIndexOfStep[counts[j]] << (2*(i+j));
+	}
+	return indices;
+}
+
+#endif // _FIRE_ENGINE_SSE_
+
+/** Encodes the colours of a block with the given end points.
+ \return The squared error of the block. */
+static u32 EncodeColorBlock(const u8 * block, const s32 * high, const s32 * low, u8 * out)
+{
+	u16 c0 = PackR5G6B5(high);
+	u16 c1 = PackR5G6B5(low);
+	// The first end point must be the larger, or the block has 3 colours and transparency
+	if (c0 < c1)
+	{
+		const u16 swap = c0;
+		c0 = c1;
+		c1 = swap;
+	}
+
+	s32 palette[4][3];
+	UnpackR5G6B5(c0, palette[0]);
+	UnpackR5G6B5(c1, palette[1]);
+	u32 indices = 0;
+	if (c0 != c1)
+	{
+		s32 axis[3];
+		for (s32 k = 0; k < 3; k++)
+		{
+			palette[2][k] = (2*palette[0][k] + palette[1][k]) / 3;
+			palette[3][k] = (palette[0][k] + 2*palette[1][k]) / 3;
+			axis[k]       = palette[0][k] - palette[1][k];
+		}
+		s32 stops[4];
+		for (s32 j = 0; j < 4; j++)
+			stops[j] = palette[j][0]*axis[0] + palette[j][1]*axis[1] + palette[j][2]*axis[2];
+		// From the second end point to the first one: 1, 3, 2, 0
+		const s32 steps[3] = { stops[1] + stops[3], stops[3] + stops[2], stops[2] + stops[0] };
+#ifdef _FIRE_ENGINE_SSE_
+		if (sys::CPUInfo::HasSSE2())
+			indices = SelectColorIndicesSSE2(block, axis, steps);
+		else
+#endif
+			indices = SelectColorIndices(block, axis, steps);
+	}
+
+	out[0] = (u8)(c0 & 0xFF);
+	out[1] = (u8)(c0 >> 8);
+	out[2] = (u8)(c1 & 0xFF);
+	out[3] = (u8)(c1 >> 8);
+	for (s32 i = 0; i < 4; i++)
+		out[4+i] = (u8)(indices >> (8*i));
+
+	u32 error = 0;
+	for (s32 i = 0; i < 16; i++)
+	{
+		const s32 * color = palette[(indices >> (2*i)) & 3];
+		for (s32 k = 0; k < 3; k++)
+		{
+			const s32 d = block[i*4+k] - color[k];
+			error += d*d;
+		}
+	}
+	return error;
+}
+
+s32 BlockCompressor::GetBlockSize(EBLOCK_FORMAT format)
+{
+	return format == EBF_DXT1 ? 8 : 16;
+}
+
+u32 BlockCompressor::GetCompressedSize(EBLOCK_FORMAT format, const dimension2i& dim)
+{
+	return ((dim.getWidth() + 3) / 4) * ((dim.getHeight() + 3) / 4) * GetBlockSize(format);
+}
+
+void BlockCompressor::Compress(const void * pixels, Image::EIMAGE_DATA_TYPE type,
+	const dimension2i& dim, EBLOCK_FORMAT format, ECOMPRESSION_QUALITY quality, u8 * out)
+{
+	const s32 width     = dim.getWidth();
+	const s32 height    = dim.getHeight();
+	const s32 texelsize = type == Image::EIDT_R8G8B8 ? 3 : (type == Image::EIDT_A8R8G8B8 ? 4 : 2);
+	// The 4 rows of pixels of a row of blocks, as R, G, B and A bytes
+	u8 * rows = new u8[width*4*4];
+	u8   block[64];
+	for (s32 by = 0; by < height; by += 4)
+	{
+		// Blocks past the bottom or right edge repeat the last row or column
+		for (s32 r = 0; r < 4; r++)
+		{
+			const s32 y = by + r < height ? by + r : height - 1;
+			ToRGBA8((const u8 *)pixels + y*width*texelsize, type, width, rows + r*width*4);
+		}
+		for (s32 bx = 0; bx < width; bx += 4)
+		{
+			for (s32 r = 0; r < 4; r++)
+			{
+				for (s32 c = 0; c < 4; c++)
+				{
+					const s32 x = bx + c < width ? bx + c : width - 1;
+					memcpy(&block[(r*4+c)*4], &rows[(r*width+x)*4], 4);
+				}
+			}
+			if (format == EBF_DXT5)
+			{
+				CompressAlphaBlock(block, out);
+				out += 8;
+			}
+			CompressColorBlock(block, quality, out);
+			out += 8;
+		}
+	}
+	delete [] rows;
+}
+
+void BlockCompressor::CompressColorBlock(const u8 * block, ECOMPRESSION_QUALITY quality, u8 * out)
+{
+	s32 high[3], low[3];
+	if (quality == ECQ_FAST)
+		FindEndPointsBox(block, high, low);
+	else
+		FindEndPointsPCA(block, high, low);
+
+	const u32 error = EncodeColorBlock(block, high, low, out);
+	if (quality == ECQ_HIGH && error > 0)
+	{
+		const u32 indices = out[4] | (out[5] << 8) | (out[6] << 16) | ((u32)out[7] << 24);
+		u8 refined[8];
+		if (FitEndPoints(block, indices, high, low) &&
+			EncodeColorBlock(block, high, low, refined) < error)
+		{
+			memcpy(out, refined, 8);
+		}
+	}
+}
+
+void BlockCompressor::CompressAlphaBlock(const u8 * block, u8 * out)
+{
+	s32 minimum = 255, maximum = 0;
+	for (s32 i = 0; i < 16; i++)
+	{
+		minimum = block[i*4+3] < minimum ? block[i*4+3] : minimum;
+		maximum = block[i*4+3] > maximum ? block[i*4+3] : maximum;
+	}
+	// With the first value larger, the block has 8 values: the end points, and 6 between
+	out[0] = (u8)maximum;
+	out[1] = (u8)minimum;
+
+	u64 indices = 0;
+	const s32 range = maximum - minimum;
+	if (range > 0)
+	{
+		for (s32 i = 0; i < 16; i++)
+		{
+			// The step from the minimum (0) to the maximum (7), and its index
+			const s32 step = ((block[i*4+3] - minimum)*7 + range/2) / range;
+			const u64 index = step == 7 ? 0 : (step == 0 ? 1 : 8 - step);
+			indices |= index << (3*i);
+		}
+	}
+	for (s32 i = 0; i < 6; i++)
+		out[2+i] = (u8)(indices >> (8*i));
+}
+
+} // namespace fire_engine
@@ -0,0 +1,77 @@
+/**
+ * FILE:    BlockCompressor.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: An encoder for the DXT1 and DXT5 block compressed texture formats.
+**/
+
+#ifndef BLOCKCOMPRESSOR_H_INCLUDED
+#define BLOCKCOMPRESSOR_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "dimension2.h"
+#include "Image.h"
+
+namespace fire_engine
+{
+
+/** Encodes images in the block compressed formats understood by graphics cards
+ (S3TC, also known as DXT or BC). Images are cut into blocks of 4x4 pixels, and each block
+ is stored in 8 bytes (DXT1: opaque colours, 4 bits per pixel) or 16 bytes (DXT5: colours
+ and alpha, 8 bits per pixel). The colours of a block are two end points in R5G6B5 and
+ two colours in between them, and each pixel picks the closest of the four.
+ The projection of the pixels on the line between the end points, which picks their
+ colour, is done with SSE2 when the processor has it. */
+class _FIRE_ENGINE_API_ BlockCompressor
+{
+public:
+	enum EBLOCK_FORMAT
+	{
+		EBF_DXT1, // opaque colours, 8 bytes per block
+		EBF_DXT5  // colours and interpolated alpha, 16 bytes per block
+	};
+
+	//! How hard to look for the best end points of the colours of each block
+	enum ECOMPRESSION_QUALITY
+	{
+		//! The corners of the bounding box of the colours. Fastest.
+		ECQ_FAST,
+		//! The extremes of the colours along their principal axis.
+		ECQ_NORMAL,
+		//! ECQ_NORMAL, then the end points that best fit the colours picked by the pixels,
+		//! if they are closer. About twice as slow.
+		ECQ_HIGH
+	};
+
+	/** Returns the size of a block, in bytes. */
+	static s32 GetBlockSize(EBLOCK_FORMAT format);
+
+	/** Returns the size of an image once compressed, in bytes. Images that are not a
+	 multiple of 4 pixels wide or high are padded to whole blocks. */
+	static u32 GetCompressedSize(EBLOCK_FORMAT format, const dimension2i& dim);
+
+	/** Compresses an image.
+	 \param pixels  The pixels of the image, in any format of Image. Rows are not padded.
+	 \param type    The format of the pixels.
+	 \param dim     The size of the image.
+	 \param format  The format to compress to. Alpha is ignored for EBF_DXT1.
+	 \param quality How hard to look for the best colours.
+	 \param out     A place to store GetCompressedSize(format, dim) bytes. */
+	static void Compress(const void * pixels, Image::EIMAGE_DATA_TYPE type, const dimension2i& dim,
+		EBLOCK_FORMAT format, ECOMPRESSION_QUALITY quality, u8 * out);
+
+	/** Compresses the colours of a block of 4x4 pixels, in DXT1.
+	 \param block The 16 pixels, row after row, as R, G, B and A bytes.
+	 \param out   A place to store the 8 bytes of the block. */
+	static void CompressColorBlock(const u8 * block, ECOMPRESSION_QUALITY quality, u8 * out);
+
+	/** Compresses the alpha of a block of 4x4 pixels, as in DXT5.
+	 \param block The 16 pixels, row after row, as R, G, B and A bytes.
+	 \param out   A place to store the 8 bytes of the block. */
+	static void CompressAlphaBlock(const u8 * block, u8 * out);
+};
+
+} // namespace fire_engine
+
+#endif // BLOCKCOMPRESSOR_H_INCLUDED
@@ -6,7 +6,7 @@
 #include "CompileConfig.h"
 #include "IMeshBuffer.h"
 #include "aabbox.h"
-#include "Material.h"
+#include "MaterialRegistry.h"
 
 namespace fire_engine
 {
@@ -16,24 +16,26 @@ class _FIRE_ENGINE_API_ CMeshBuffer : public virtual IMeshBuffer
 {
 public:
 	CMeshBuffer(Vertex3 * vertices, s32 vertexCount, u32 * indices, s32 indexCount, 
-		EPOLYGON_TYPE polygonType, Material mat, bool sharedVertexData, bool sharedIndexData)
+		EPOLYGON_TYPE polygonType, const Material& mat, bool sharedVertexData, bool sharedIndexData)
 		: Vertices(vertices, vertexCount), 
 		  Indices(indices, indexCount), 
 		  PolygonType(polygonType),
-		  Mat(mat)
+		  MaterialHandle(MaterialRegistry::Register(mat))
 	{
 		if (sharedVertexData)
 		{
 			Vertices.setFreeWhenDestroyed(false);
 		}
-		if (sharedIndexData)
+		// The indices are copied, in 16 bits if they can be
+		if (!sharedIndexData)
 		{
-			Indices.setFreeWhenDestroyed(false);
+			delete [] indices;
 		}
 	}
 
 	virtual ~CMeshBuffer()
 	{
+		MaterialRegistry::Drop(MaterialHandle);
 	}
 
 	virtual EPOLYGON_TYPE getPolygonType() const
@@ -61,14 +63,14 @@ public:
 		return Vertices.getCount();
 	}
 
-	virtual const Array<u32> * getIndices() const
+	virtual const IndexBuffer * getIndices() const
 	{
 		return &Indices;
 	}
 
-	virtual Material getMaterial() const
+	virtual material_handle_t getMaterialHandle() const
 	{
-		return Mat;
+		return MaterialHandle;
 	}
 
 	virtual const aabboxf& getBoundingBox() const
@@ -77,11 +79,11 @@ public:
 	}
 
 protected:
-	Array<Vertex3> Vertices;
-	Array<u32>     Indices;
-	EPOLYGON_TYPE  PolygonType;
-	Material       Mat;
-	aabboxf        BoundingBox;
+	Array<Vertex3>    Vertices;
+	IndexBuffer       Indices;
+	EPOLYGON_TYPE     PolygonType;
+	material_handle_t MaterialHandle;
+	aabboxf           BoundingBox;
 };
 
 }
@@ -0,0 +1,83 @@
+/**
+ * FILE:    CPUInfo.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the CPUInfo class.
+**/
+
+#include "CPUInfo.h"
+
+#if defined(_FIRE_ENGINE_SSE_)
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
+namespace fire_engine
+{
+namespace sys
+{
+
+//! The features found, 0 until they have been detected
+static volatile u32 s_features = 0;
+
+u32 CPUInfo::GetFeatures()
+{
+	// Detecting twice from two threads is harmless, the result is the same
+	if (s_features != 0)
+		return s_features;
+
+	u32 features = ECF_DETECTED;
+#if defined(_FIRE_ENGINE_SSE_)
+	u32 ecx, edx;
+#	if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	ecx = info[2];
+	edx = info[3];
+#	else
+	u32 eax, ebx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		ecx = edx = 0;
+#	endif
+	if (edx & (1 << 26))
+		features |= ECF_SSE2;
+	if (ecx & (1 << 9))
+		features |= ECF_SSSE3;
+	if (ecx & (1 << 19))
+		features |= ECF_SSE41;
+#endif
+	s_features = features;
+	return features;
+}
+
+bool CPUInfo::HasSSE2()
+{
+	return (GetFeatures() & ECF_SSE2) != 0;
+}
+
+bool CPUInfo::HasSSSE3()
+{
+	return (GetFeatures() & ECF_SSSE3) != 0;
+}
+
+bool CPUInfo::HasSSE41()
+{
+	return (GetFeatures() & ECF_SSE41) != 0;
+}
+
+const c8 * CPUInfo::GetDescription()
+{
+	if (HasSSE41())
+		return "SSE2 SSSE3 SSE4.1";
+	if (HasSSSE3())
+		return "SSE2 SSSE3";
+	if (HasSSE2())
+		return "SSE2";
+	return "none";
+}
+
+} // namespace sys
+} // namespace fire_engine
@@ -0,0 +1,54 @@
+/**
+ * FILE:    CPUInfo.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Detection of the instruction sets supported by the processor.
+**/
+
+#ifndef CPUINFO_H_INCLUDED
+#define CPUINFO_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+
+namespace fire_engine
+{
+namespace sys
+{
+
+/** Tells which optional instruction sets the processor supports, so that code can choose
+ the fastest implementation of something at run time. The processor is only queried
+ once. On processors that are not x86, and when _FIRE_ENGINE_SSE_ is not defined, every
+ function returns false. */
+class _FIRE_ENGINE_API_ CPUInfo
+{
+public:
+	/** Returns whether the processor supports SSE2. */
+	static bool HasSSE2();
+
+	/** Returns whether the processor supports SSSE3 (byte shuffles). */
+	static bool HasSSSE3();
+
+	/** Returns whether the processor supports SSE4.1. */
+	static bool HasSSE41();
+
+	/** Returns a description of the supported instruction sets, for logs. */
+	static const c8 * GetDescription();
+
+private:
+	enum ECPU_FEATURE
+	{
+		ECF_DETECTED = 0x01,
+		ECF_SSE2     = 0x02,
+		ECF_SSSE3    = 0x04,
+		ECF_SSE41    = 0x08
+	};
+
+	/** Returns the ECPU_FEATURE flags of the processor. */
+	static u32 GetFeatures();
+};
+
+} // namespace sys
+} // namespace fire_engine
+
+#endif // CPUINFO_H_INCLUDED
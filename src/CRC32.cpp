@@ -0,0 +1,73 @@
+/**
+ * FILE:    CRC32.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the slicing-by-8 CRC-32.
+**/
+
+#include "CRC32.h"
+#include <stddef.h>
+
+namespace fire_engine
+{
+
+//! The lookup tables, built when the program starts so that any thread can read them
+struct crc32_tables_t
+{
+	u32 Table[8][256];
+
+	crc32_tables_t()
+	{
+		for (u32 i = 0; i < 256; i++)
+		{
+			u32 c = i;
+			for (s32 k = 0; k < 8; k++)
+				c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+			Table[0][i] = c;
+		}
+		// Table[k][i] is the CRC of byte i followed by k zero bytes
+		for (u32 i = 0; i < 256; i++)
+			for (s32 k = 1; k < 8; k++)
+				Table[k][i] = (Table[k-1][i] >> 8) ^ Table[0][Table[k-1][i] & 0xFF];
+	}
+};
+
+static const crc32_tables_t CRC32Tables;
+
+u32 CRC32::Compute(const void * data, s32 size, u32 crc)
+{
+	const u32 (* Table)[256] = CRC32Tables.Table;
+	const u8 * p = (const u8 *)data;
+	crc = ~crc;
+
+	// Checksum single bytes until p is 4-byte aligned
+	while (size > 0 && ((size_t)p & 3) != 0)
+	{
+		crc = Table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+		size--;
+	}
+
+	while (size >= 8)
+	{
+		u32 one = *(const u32 *)p;
+		u32 two = *(const u32 *)(p + 4);
+#if defined(_FIRE_ENGINE_BIG_ENDIAN_)
+		one = ((one >> 24) | ((one >> 8) & 0xFF00) | ((one << 8) & 0xFF0000) | (one << 24));
+		two = ((two >> 24) | ((two >> 8) & 0xFF00) | ((two << 8) & 0xFF0000) | (two << 24));
+#endif
+		one ^= crc;
+		crc = Table[7][ one        & 0xFF] ^ Table[6][(one >>  8) & 0xFF] ^
+		      Table[5][(one >> 16) & 0xFF] ^ Table[4][ one >> 24        ] ^
+		      Table[3][ two        & 0xFF] ^ Table[2][(two >>  8) & 0xFF] ^
+		      Table[1][(two >> 16) & 0xFF] ^ Table[0][ two >> 24        ];
+		p    += 8;
+		size -= 8;
+	}
+
+	while (size-- > 0)
+		crc = Table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+} // namespace fire_engine
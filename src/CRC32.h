@@ -0,0 +1,33 @@
+/**
+ * FILE:    CRC32.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Computes the CRC-32 checksum used by ZIP archives and PNG images.
+**/
+
+#ifndef CRC32_H_INCLUDED
+#define CRC32_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+
+namespace fire_engine
+{
+
+/** Computes CRC-32 checksums (polynomial 0xEDB88320, as used by ZIP), using the
+ slicing-by-8 algorithm, which processes 8 bytes per step with 8 lookup tables. */
+class _FIRE_ENGINE_API_ CRC32
+{
+public:
+	/** Computes the checksum of a block of data.
+	 \param data The data to checksum.
+	 \param size The number of bytes in data.
+	 \param crc  The checksum of the data preceding this block, so that the checksum of a
+	             stream can be computed one block at a time. Use 0 for the first block.
+	 \return     The checksum of all the data so far. */
+	static u32 Compute(const void * data, s32 size, u32 crc = 0);
+};
+
+} // namespace fire_engine
+
+#endif // CRC32_H_INCLUDED
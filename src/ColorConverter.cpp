@@ -7,14 +7,121 @@
 
 #include "ColorConverter.h"
 #include "ByteConverter.h"
+#include "CPUInfo.h"
+#include "HighResolutionTimer.h"
+#include "Logger.h"
 #include <stdio.h>
 #include <String.h>
 
+#ifdef _FIRE_ENGINE_SSE_
+#	include <emmintrin.h>
+#	include <tmmintrin.h>
+	// GCC only compiles SSSE3 intrinsics in functions built for it; MSVC always does
+#	if defined(__GNUC__) && !defined(__SSSE3__)
+#		define _FIRE_ENGINE_TARGET_SSSE3_ __attribute__((target("ssse3")))
+#	else
+#		define _FIRE_ENGINE_TARGET_SSSE3_
+#	endif
+#endif
+
 namespace fire_engine
 {
 
 u8 * ColorConverter::m_buffer = new u8[4];
 
+//! Converts a row of pixels one pixel at a time
+static void SwapRedBlue24(const u8 * in, u8 * out, s32 count)
+{
+	for (s32 i = 0; i < count; i++, in += 3, out += 3)
+	{
+		// in may be out
+		const u8 red = in[0];
+		out[0] = in[2];
+		out[1] = in[1];
+		out[2] = red;
+	}
+}
+
+static void ExpandA1R5G5B5(const u16 * in, u32 * out, s32 count)
+{
+	for (s32 i = 0; i < count; i++)
+		out[i] = ColorConverter::A1R5G5B5toA8R8G8B8(in[i]);
+}
+
+#ifdef _FIRE_ENGINE_SSE_
+
+//! Swaps red and blue with byte shuffles, 16 pixels (3 registers) at a time. Pixels cross
+//! the registers, so each output register is put together from the bytes shuffled out of
+//! two or three input registers: -1 zeroes the byte.
+_FIRE_ENGINE_TARGET_SSSE3_ static void SwapRedBlue24SSSE3(const u8 * in, u8 * out, s32 count)
+{
+	const __m128i m00 = _mm_setr_epi8( 2,  1,  0,  5,  4,  3,  8,  7,  6, 11, 10,  9, 14, 13, 12, -1);
+	const __m128i m01 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  1);
+	const __m128i m10 = _mm_setr_epi8(-1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i m11 = _mm_setr_epi8( 0, -1,  4,  3,  2,  7,  6,  5, 10,  9,  8, 13, 12, 11, -1, 15);
+	const __m128i m12 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0, -1);
+	const __m128i m21 = _mm_setr_epi8(14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i m22 = _mm_setr_epi8(-1,  3,  2,  1,  6,  5,  4,  9,  8,  7, 12, 11, 10, 15, 14, 13);
+	for (; count >= 16; count -= 16, in += 48, out += 48)
+	{
+		// Load everything before storing anything, as in may be out
+		const __m128i a = _mm_loadu_si128((const __m128i *)in);
+		const __m128i b = _mm_loadu_si128((const __m128i *)(in + 16));
+		const __m128i c = _mm_loadu_si128((const __m128i *)(in + 32));
+		_mm_storeu_si128((__m128i *)out,
+			_mm_or_si128(_mm_shuffle_epi8(a, m00), _mm_shuffle_epi8(b, m01)));
+		_mm_storeu_si128((__m128i *)(out + 16),
+			_mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m10), _mm_shuffle_epi8(b, m11)),
+			_mm_shuffle_epi8(c, m12)));
+		_mm_storeu_si128((__m128i *)(out + 32),
+			_mm_or_si128(_mm_shuffle_epi8(b, m21), _mm_shuffle_epi8(c, m22)));
+	}
+	SwapRedBlue24(in, out, count);
+}
+
+//! Expands 4 A1R5G5B5 pixels, zero extended to 32 bits
+static inline __m128i ExpandA1R5G5B5x4(__m128i pixels)
+{
+	const __m128i alpha = _mm_slli_epi32(_mm_and_si128(pixels, _mm_set1_epi32(0x8000)), 16);
+	const __m128i red   = _mm_slli_epi32(_mm_and_si128(pixels, _mm_set1_epi32(0x7C00)), 9);
+	const __m128i green = _mm_slli_epi32(_mm_and_si128(pixels, _mm_set1_epi32(0x03E0)), 6);
+	const __m128i blue  = _mm_slli_epi32(_mm_and_si128(pixels, _mm_set1_epi32(0x001F)), 3);
+	return _mm_or_si128(_mm_or_si128(alpha, red), _mm_or_si128(green, blue));
+}
+
+static void ExpandA1R5G5B5SSE2(const u16 * in, u32 * out, s32 count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	for (; count >= 8; count -= 8, in += 8, out += 8)
+	{
+		const __m128i pixels = _mm_loadu_si128((const __m128i *)in);
+		_mm_storeu_si128((__m128i *)out, ExpandA1R5G5B5x4(_mm_unpacklo_epi16(pixels, zero)));
+		_mm_storeu_si128((__m128i *)(out + 4), ExpandA1R5G5B5x4(_mm_unpackhi_epi16(pixels, zero)));
+	}
+	ExpandA1R5G5B5(in, out, count);
+}
+
+#endif // _FIRE_ENGINE_SSE_
+
+//! The row conversions used, chosen the first time one is needed. Several threads may
+//! choose them at once: they all choose the same ones.
+static void (* volatile s_swap24)(const u8 *, u8 *, s32)     = 0;
+static void (* volatile s_expand16)(const u16 *, u32 *, s32) = 0;
+
+static void SelectKernels()
+{
+	void (* swap24)(const u8 *, u8 *, s32)     = SwapRedBlue24;
+	void (* expand16)(const u16 *, u32 *, s32) = ExpandA1R5G5B5;
+#ifdef _FIRE_ENGINE_SSE_
+	if (sys::CPUInfo::HasSSSE3())
+		swap24 = SwapRedBlue24SSSE3;
+	if (sys::CPUInfo::HasSSE2())
+		expand16 = ExpandA1R5G5B5SSE2;
+#endif
+	s_swap24   = swap24;
+	s_expand16 = expand16;
+}
+
 const u8 * ColorConverter::RGB16(u8 r, u8 g, u8 b)
 {
 	m_buffer[0] = (r & 0xF8) | ((g & 0xF8) >> 5);
@@ -143,22 +250,13 @@ void ColorConverter::convert8BitTo24Bit(const u8 * in, u8 * out, const dimension
 										const u8 * cmap, bool cmap_bgr, s32 cmap_texelsize,
 										u8 padding, bool flip)
 {
-	if (flip)
-		out += dim.getWidth()*dim.getHeight()*3;
+	u32 table[256];
+	buildPalette24(cmap, cmap_bgr, cmap_texelsize, table);
 	for (s32 i = 0; i < dim.getHeight(); i++)
 	{
-		if (flip)
-			out -= dim.getWidth()*3;
-		for (s32 j = 0; j < dim.getWidth(); j++, in++)
-		{
-			if (!cmap_bgr)
-				memcpy((void *)&out[j*3], (const void *)&cmap[*in*cmap_texelsize], 3);
-			else
-				B8G8R8toR8G8B8(&cmap[*in*cmap_texelsize], &out[j*3]);
-		}
-		in += padding;
-		if (!flip)
-			out += dim.getWidth()*3;
+		const s32 row = flip ? dim.getHeight()-1-i : i;
+		expandPalette24(in, out + row*dim.getWidth()*3, dim.getWidth(), table);
+		in += dim.getWidth() + padding;
 	}
 }
 
@@ -181,59 +279,137 @@ void ColorConverter::convert8BitTo32Bit(const u8 * data, u32 * out, const dimens
 
 void ColorConverter::convert16BitTo16Bit(const u16 * in, u16 * out, const dimension2i& dim, u8 padding, bool flip)
 {
-	if (flip)
-		out += dim.getWidth()*dim.getHeight();
-	for (s32 i = 0; i < dim.getHeight()-1; i++)
+	for (s32 i = 0; i < dim.getHeight(); i++)
 	{
-		if (flip)
-			out -= dim.getWidth();
-		memcpy((void*)out, (const void*)in, dim.getWidth()*sizeof(s16));
-		in += dim.getWidth();
-		in += padding;
-		if (!flip)
-			out += dim.getWidth();
+		const s32 row = flip ? dim.getHeight()-1-i : i;
+		memcpy((void *)(out + row*dim.getWidth()), (const void *)in, dim.getWidth()*sizeof(u16));
+		in += dim.getWidth() + padding;
 	}
 }
 
 void ColorConverter::convert24BitTo24Bit(const u8 * in, u8 * out, const dimension2i& dim, u8 padding,
 										 bool is_bgr, bool flip)
 {
-	if (flip)
-		out += dim.getHeight()*dim.getWidth()*3;
 	for (s32 i = 0; i < dim.getHeight(); i++)
 	{
-		if (flip)
-			out -= dim.getWidth()*3;
+		u8 * dest = out + (flip ? dim.getHeight()-1-i : i)*dim.getWidth()*3;
 		if (is_bgr)
-			for (s32 j = 0; j < dim.getWidth(); j++)
-			{
-				out[j*3+0] = in[j*3+2];
-				out[j*3+1] = in[j*3+1];
-				out[j*3+2] = in[j*3+0];
-			}
+			R8G8B8toB8G8R8(in, dest, dim.getWidth());
 		else
-			memcpy((void *)out, (const void *)in, 3*dim.getWidth());
-		if (!flip)
-			out += dim.getWidth()*3;
-		in += dim.getWidth()*3;
-		in += padding;
+			memcpy((void *)dest, (const void *)in, 3*dim.getWidth());
+		in += dim.getWidth()*3 + padding;
 	}
 }
 
 void ColorConverter::convert32BitTo32Bit(const s32 * in, s32 * out, const dimension2i& dim, u8 padding, bool flip)
 {
-	if (flip)
-		out += dim.getWidth()*dim.getHeight();
 	for (s32 i = 0; i < dim.getHeight(); i++)
 	{
-		if (flip)
-			out -= dim.getWidth();
-		memcpy((void *)out, (const void *)in, dim.getWidth()*sizeof(s32));
-		if (!flip)
-			out += dim.getWidth();
-		in += dim.getWidth();
-		in += padding;
+		const s32 row = flip ? dim.getHeight()-1-i : i;
+		memcpy((void *)(out + row*dim.getWidth()), (const void *)in, dim.getWidth()*sizeof(s32));
+		in += dim.getWidth() + padding;
+	}
+}
+
+void ColorConverter::R8G8B8toB8G8R8(const u8 * in, u8 * out, s32 count)
+{
+	if (s_swap24 == 0)
+		SelectKernels();
+	s_swap24(in, out, count);
+}
+
+void ColorConverter::A1R5G5B5toA8R8G8B8(const u16 * in, u32 * out, s32 count)
+{
+	if (s_expand16 == 0)
+		SelectKernels();
+	s_expand16(in, out, count);
+}
+
+void ColorConverter::buildPalette24(const u8 * cmap, bool cmap_bgr, s32 cmap_texelsize, u32 * table)
+{
+	for (s32 i = 0; i < 256; i++)
+	{
+		const u8 * entry = &cmap[i*cmap_texelsize];
+		u8 texel[4] = { entry[0], entry[1], entry[2], 0 };
+		if (cmap_bgr)
+			B8G8R8toR8G8B8(entry, texel);
+		memcpy(&table[i], texel, 4);
 	}
 }
 
+void ColorConverter::expandPalette24(const u8 * in, u8 * out, s32 count, const u32 * table)
+{
+	if (count <= 0)
+		return;
+	// Write whole table entries, each overwriting the padding byte of the one before: there
+	// is no gather to vectorise this with, but it avoids splitting every pixel into bytes
+	for (s32 i = 0; i < count-1; i++, out += 3)
+		memcpy(out, &table[in[i]], 4);
+	memcpy(out, &table[in[count-1]], 3);
+}
+
+static void KeepFastest(f64& fastest, f64 time)
+{
+	if (time < fastest)
+		fastest = time;
+}
+
+void ColorConverter::Benchmark(const dimension2i& dim)
+{
+	const s32 count = dim.getWidth()*dim.getHeight();
+	if (count <= 0)
+		return;
+	SelectKernels();
+
+	u8 *  bytes  = new u8[count*4];
+	u32 * pixels = new u32[count];
+	u8    cmap[256*3];
+	for (s32 i = 0; i < count*4; i++)
+		bytes[i] = (u8)(i*7);
+	for (s32 i = 0; i < 256*3; i++)
+		cmap[i] = (u8)i;
+
+	Logger::Get()->log(ES_LOW, "ColorConverter", "Benchmarking %dx%d pixels, processor: %s",
+		dim.getWidth(), dim.getHeight(), sys::CPUInfo::GetDescription());
+
+	// Keep the fastest of several passes, so that the first one does not pay for the
+	// cache misses of the others
+	const s32 passes = 8;
+	const f64 mpixels = count / 1000000.0;
+	f64 swap[2]   = { 1e9, 1e9 };
+	f64 expand[2] = { 1e9, 1e9 };
+	f64 palette   = 1e9;
+	sys::HighResolutionTimer timer;
+	for (s32 pass = 0; pass < passes; pass++)
+	{
+		timer.start();
+		SwapRedBlue24(bytes, bytes, count);
+		KeepFastest(swap[0], timer.getElapsedTimeSeconds());
+		timer.start();
+		R8G8B8toB8G8R8(bytes, bytes, count);
+		KeepFastest(swap[1], timer.getElapsedTimeSeconds());
+
+		timer.start();
+		ExpandA1R5G5B5(reinterpret_cast<const u16 *>(bytes), pixels, count);
+		KeepFastest(expand[0], timer.getElapsedTimeSeconds());
+		timer.start();
+		A1R5G5B5toA8R8G8B8(reinterpret_cast<const u16 *>(bytes), pixels, count);
+		KeepFastest(expand[1], timer.getElapsedTimeSeconds());
+
+		timer.start();
+		convert8BitTo24Bit(bytes, bytes + count, dim, cmap, true, 3, 0, false);
+		KeepFastest(palette, timer.getElapsedTimeSeconds());
+	}
+
+	Logger::Get()->log(ES_LOW, "ColorConverter", "R8G8B8 to B8G8R8: %.1f MPixels/s, %.1f with SSE",
+		mpixels/swap[0], mpixels/swap[1]);
+	Logger::Get()->log(ES_LOW, "ColorConverter", "A1R5G5B5 to A8R8G8B8: %.1f MPixels/s, %.1f with SSE",
+		mpixels/expand[0], mpixels/expand[1]);
+	Logger::Get()->log(ES_LOW, "ColorConverter", "8 bit indexed to R8G8B8: %.1f MPixels/s",
+		mpixels/palette);
+
+	delete [] bytes;
+	delete [] pixels;
+}
+
 } // namespace fe
@@ -48,6 +48,13 @@ public:
 	**/
 	static void B8G8R8toR8G8B8(const u8 * in, u8 * out);
 
+	/** Converts a row of 24 bit R8G8B8 pixels to B8G8R8 (or B8G8R8 to R8G8B8, which is the
+	 same swap). This and the other row conversions use SSE when the processor has it.
+	 \param in    The pixels to convert.
+	 \param out   A place to store the converted pixels. It can be the same as in.
+	 \param count The number of pixels. */
+	static void R8G8B8toB8G8R8(const u8 * in, u8 * out, s32 count);
+
 	/**
 	 *	Convert a 32 bit A8R8G8B8 entry to an B8G8R8A8 entry
 	 *	@param	in	The A8R8G8B8 entry
@@ -92,6 +99,12 @@ public:
 	**/
 	static u32 A1R5G5B5toA8R8G8B8(u16 in);
 
+	/** Converts a row of 16 bit A1R5G5B5 pixels to 32 bit A8R8G8B8 pixels.
+	 \param in    The pixels to convert.
+	 \param out   A place to store the converted pixels.
+	 \param count The number of pixels. */
+	static void A1R5G5B5toA8R8G8B8(const u16 * in, u32 * out, s32 count);
+
 	/**
 	 *	Convert an 8 bit image with a 16 bit color map to 16 bit data
 	 *	image
@@ -140,8 +153,22 @@ public:
 
 	static void convert32BitTo32Bit(const s32 * in, s32 * out, const dimension2i& dim, u8 padding, bool flip);
 
+	/** Measures the speed of the row conversions, with and without SSE, and logs it in
+	 millions of pixels per second.
+	 \param dim The size of the image to convert. */
+	static void Benchmark(const dimension2i& dim = dimension2i(1024, 1024));
+
 private:
 	static u8 * m_buffer;
+
+	/** Builds the table used to expand 8 bit indexed pixels to 24 bits: each entry holds
+	 the 3 bytes of an output pixel, in memory order, followed by a byte of padding.
+	 \param table A place to store the 256 entries of the table. */
+	static void buildPalette24(const u8 * cmap, bool cmap_bgr, s32 cmap_texelsize, u32 * table);
+
+	/** Expands a row of 8 bit indexed pixels to 24 bit pixels, with a table built by
+	 buildPalette24(). */
+	static void expandPalette24(const u8 * in, u8 * out, s32 count, const u32 * table);
 };
 
 } // namespace fire_engine
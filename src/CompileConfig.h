@@ -38,6 +38,14 @@
 #	define _FIRE_ENGINE_LITTLE_ENDIAN_
 #endif
 
+/** SSE2 is part of every x86-64 processor, and of every x86 processor the engine runs on.
+ Code using SSE instructions beyond SSE2 must check that the processor has them at run time
+ (see sys::CPUInfo). Define _FIRE_ENGINE_NO_SIMD_ to only use portable code. */
+#if !defined(_FIRE_ENGINE_NO_SIMD_) && \
+	(defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__))
+#	define _FIRE_ENGINE_SSE_
+#endif
+
 /** Mouse events are generated very often, especially the mouse dragged event. Uncomment
  this to enable the generation of mouse dragged events. */
 //#define _FIRE_ENGINE_GENERATE_MOUSE_MOVED_EVENTS_
@@ -55,8 +63,12 @@
  *      _FIRE_ENGINE_DEBUG_OBJECT_:  Add a debug name to fire engine's base objects
  *      _FIRE_ENGINE_DEBUG_ZIP_:     Activate debugging information when loading ZIP files
  *      _FIRE_ENGINE_DEBUG_MEMORY_:  Debug memory - check for memory leaks and so on.
+ *      _FIRE_ENGINE_DEBUG_REFCOUNT_: Record where each Object was last grabbed and dropped.
  *
  *  _FIRE_ENGINE_COMPILE_WITH_OPENGL_:       Compile using the OpenGL library
+ *  _FIRE_ENGINE_SINGLE_THREADED_:           Use plain, non-atomic reference counts in Object.
+ *                                           Objects must then never be shared between threads.
+ *  _FIRE_ENGINE_NO_SIMD_:                   Do not use SSE instructions.
 **/
 #define	_FIRE_ENGINE_COMPILE_WITH_OPENGL_
 
@@ -0,0 +1,100 @@
+/**
+ * FILE:    CompressedImage.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the CompressedImage class.
+**/
+
+#include "CompressedImage.h"
+#include "Image.h"
+
+namespace fire_engine
+{
+
+CompressedImage::CompressedImage(BlockCompressor::EBLOCK_FORMAT format, const dimension2i& dim,
+	s32 levelCount)
+	: mFormat(format), mLevelCount(levelCount), mData(0)
+{
+#if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
+	setDebugName("fire_engine::CompressedImage");
+#endif
+	mOffsets[0] = 0;
+	dimension2i level = dim;
+	for (s32 i = 0; i < mLevelCount; i++)
+	{
+		mDimensions[i] = level;
+		mOffsets[i+1]  = mOffsets[i] + BlockCompressor::GetCompressedSize(mFormat, level);
+		level = dimension2i(level.getWidth() > 1 ? level.getWidth() / 2 : 1,
+			level.getHeight() > 1 ? level.getHeight() / 2 : 1);
+	}
+	mData = new u8[mOffsets[mLevelCount]];
+}
+
+CompressedImage::~CompressedImage()
+{
+	delete [] mData;
+}
+
+CompressedImage * CompressedImage::Compress(const Image& image,
+	BlockCompressor::ECOMPRESSION_QUALITY quality, bool sRGB, bool mipmaps)
+{
+	const bool alpha = image.useAlphaChanel() &&
+		(image.type() == Image::EIDT_A8R8G8B8 || image.type() == Image::EIDT_A1R5G5B5);
+	const BlockCompressor::EBLOCK_FORMAT format =
+		alpha ? BlockCompressor::EBF_DXT5 : BlockCompressor::EBF_DXT1;
+
+	if (!mipmaps)
+	{
+		CompressedImage * compressed = new CompressedImage(format, image.dim(), 1);
+		BlockCompressor::Compress(image.data(), image.type(), image.dim(), format, quality,
+			compressed->getLevelData(0));
+		return compressed;
+	}
+
+	MipmapChain * chain = new MipmapChain(image, sRGB);
+	CompressedImage * compressed = new CompressedImage(format, image.dim(), chain->getLevelCount());
+	for (s32 i = 0; i < chain->getLevelCount(); i++)
+	{
+		BlockCompressor::Compress(chain->getLevelData(i), chain->getType(),
+			chain->getLevelDimension(i), format, quality, compressed->getLevelData(i));
+	}
+	chain->drop();
+	return compressed;
+}
+
+BlockCompressor::EBLOCK_FORMAT CompressedImage::getFormat() const
+{
+	return mFormat;
+}
+
+s32 CompressedImage::getLevelCount() const
+{
+	return mLevelCount;
+}
+
+const dimension2i& CompressedImage::getLevelDimension(s32 level) const
+{
+	return mDimensions[level];
+}
+
+const u8 * CompressedImage::getLevelData(s32 level) const
+{
+	return mData + mOffsets[level];
+}
+
+u8 * CompressedImage::getLevelData(s32 level)
+{
+	return mData + mOffsets[level];
+}
+
+u32 CompressedImage::getLevelSize(s32 level) const
+{
+	return mOffsets[level+1] - mOffsets[level];
+}
+
+u32 CompressedImage::getSize() const
+{
+	return mOffsets[mLevelCount];
+}
+
+} // namespace fire_engine
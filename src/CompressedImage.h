@@ -0,0 +1,76 @@
+/**
+ * FILE:    CompressedImage.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: An image and its mipmaps in a block compressed format, ready to be uploaded.
+**/
+
+#ifndef COMPRESSEDIMAGE_H_INCLUDED
+#define COMPRESSEDIMAGE_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "dimension2.h"
+#include "Object.h"
+#include "BlockCompressor.h"
+#include "MipmapChain.h"
+
+namespace fire_engine
+{
+
+class Image;
+
+/** An image compressed in DXT1 or DXT5 (see BlockCompressor), with its mipmaps. All the
+ levels are kept one after the other in a single allocation, in the layout graphics cards
+ use, so that each can be uploaded as is. */
+class _FIRE_ENGINE_API_ CompressedImage : public virtual Object
+{
+public:
+	/** Creates an empty compressed image, to be filled through getLevelData().
+	 \param levelCount The number of levels: 1, or the complete chain of mipmaps (see
+	                   MipmapChain::GetLevelCount()). */
+	CompressedImage(BlockCompressor::EBLOCK_FORMAT format, const dimension2i& dim, s32 levelCount);
+
+	virtual ~CompressedImage();
+
+	/** Compresses an image, and its mipmaps. Images that use their alpha chanel are
+	 compressed in DXT5, other images in DXT1.
+	 \param sRGB    Whether the colours of the image are in sRGB, for the mipmaps.
+	 \param mipmaps Whether to compress the mipmaps too. */
+	static CompressedImage * Compress(const Image& image, BlockCompressor::ECOMPRESSION_QUALITY quality,
+		bool sRGB = true, bool mipmaps = true);
+
+	BlockCompressor::EBLOCK_FORMAT getFormat() const;
+
+	/** Returns the number of levels, including the image itself. */
+	s32 getLevelCount() const;
+
+	/** Returns the size of a level, in pixels. Level 0 is the image itself. */
+	const dimension2i& getLevelDimension(s32 level) const;
+
+	/** Returns the blocks of a level. */
+	const u8 * getLevelData(s32 level) const;
+	u8 * getLevelData(s32 level);
+
+	/** Returns the size of the blocks of a level, in bytes. */
+	u32 getLevelSize(s32 level) const;
+
+	/** Returns the size of all the levels, in bytes. */
+	u32 getSize() const;
+
+private:
+	BlockCompressor::EBLOCK_FORMAT mFormat;
+	s32                            mLevelCount;
+	dimension2i                    mDimensions[MipmapChain::MAX_LEVELS];
+	//! Where each level starts in mData
+	u32                            mOffsets[MipmapChain::MAX_LEVELS+1];
+	u8 *                           mData;
+
+	// Copying is not supported
+	CompressedImage(const CompressedImage&);
+	CompressedImage& operator=(const CompressedImage&);
+};
+
+} // namespace fire_engine
+
+#endif // COMPRESSEDIMAGE_H_INCLUDED
@@ -0,0 +1,89 @@
+/**
+ * FILE:    CompressedImageLoader.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the CompressedImageLoader class.
+**/
+
+#include "CompressedImageLoader.h"
+#include "CompressedImage.h"
+#include "MediaManager.h"
+#include "Image.h"
+#include "IFile.h"
+
+namespace fire_engine
+{
+
+//! The header of a cooked CompressedImage, followed by the blocks of all its levels
+struct cooked_compressed_image_t
+{
+	u32 Format;
+	s32 Width;
+	s32 Height;
+	s32 LevelCount;
+};
+
+CompressedImageLoader::CompressedImageLoader(BlockCompressor::ECOMPRESSION_QUALITY quality)
+	: mQuality(quality)
+{
+}
+
+CompressedImage * CompressedImageLoader::load(const String& filename, io::IFileProvider * fileProvider) const
+{
+	Image * image = MediaManager::Get()->load<Image>(filename, fileProvider);
+	if (image == 0)
+		return 0;
+	CompressedImage * compressed = CompressedImage::Compress(*image, mQuality);
+	image->drop();
+	return compressed;
+}
+
+void CompressedImageLoader::setQuality(BlockCompressor::ECOMPRESSION_QUALITY quality)
+{
+	mQuality = quality;
+}
+
+BlockCompressor::ECOMPRESSION_QUALITY CompressedImageLoader::getQuality() const
+{
+	return mQuality;
+}
+
+u32 CompressedImageLoader::getCookedVersion() const
+{
+	// 'DXT', then the version of the format and the quality
+	return 0x44585400 | (1 << 4) | mQuality;
+}
+
+bool CompressedImageLoader::cook(const CompressedImage * image, io::IFile * file) const
+{
+	cooked_compressed_image_t header;
+	header.Format     = image->getFormat();
+	header.Width      = image->getLevelDimension(0).getWidth();
+	header.Height     = image->getLevelDimension(0).getHeight();
+	header.LevelCount = image->getLevelCount();
+	return file->write(&header, sizeof(cooked_compressed_image_t)) &&
+		file->write(image->getLevelData(0), image->getSize());
+}
+
+CompressedImage * CompressedImageLoader::loadCooked(io::IFile * file) const
+{
+	cooked_compressed_image_t header;
+	if (!file->read(&header, sizeof(cooked_compressed_image_t)) ||
+		header.Format > BlockCompressor::EBF_DXT5 || header.Width <= 0 || header.Height <= 0 ||
+		(header.LevelCount != 1 &&
+		 header.LevelCount != MipmapChain::GetLevelCount(dimension2i(header.Width, header.Height))))
+	{
+		return 0;
+	}
+
+	CompressedImage * image = new CompressedImage((BlockCompressor::EBLOCK_FORMAT)header.Format,
+		dimension2i(header.Width, header.Height), header.LevelCount);
+	if (!file->read(image->getLevelData(0), image->getSize()))
+	{
+		image->drop();
+		return 0;
+	}
+	return image;
+}
+
+} // namespace fire_engine
@@ -0,0 +1,50 @@
+/**
+ * FILE:    CompressedImageLoader.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A loader that compresses images, so that the CookedCache can keep them compressed.
+**/
+
+#ifndef COMPRESSEDIMAGELOADER_H_INCLUDED
+#define COMPRESSEDIMAGELOADER_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "ILoader.h"
+#include "BlockCompressor.h"
+
+namespace fire_engine
+{
+
+class CompressedImage;
+
+/** Loads a CompressedImage from any image file the MediaManager can load an Image from:
+ the image is loaded, and compressed with its mipmaps. The colours of images are taken to
+ be in sRGB. Compressing is slow, so the compressed image is cooked: with a CookedCache, an
+ image is only compressed the first time it is loaded. */
+class _FIRE_ENGINE_API_ CompressedImageLoader : public ILoader<CompressedImage>
+{
+public:
+	CompressedImageLoader(BlockCompressor::ECOMPRESSION_QUALITY quality = BlockCompressor::ECQ_NORMAL);
+
+	virtual CompressedImage * load(const String& filename, io::IFileProvider * fileProvider) const;
+
+	/** Sets the quality images are compressed with. Images cooked with another quality are
+	 compressed again. This must not be called while images are being loaded. */
+	void setQuality(BlockCompressor::ECOMPRESSION_QUALITY quality);
+
+	BlockCompressor::ECOMPRESSION_QUALITY getQuality() const;
+
+	virtual u32 getCookedVersion() const;
+
+	virtual bool cook(const CompressedImage * image, io::IFile * file) const;
+
+	virtual CompressedImage * loadCooked(io::IFile * file) const;
+
+private:
+	BlockCompressor::ECOMPRESSION_QUALITY mQuality;
+};
+
+} // namespace fire_engine
+
+#endif // COMPRESSEDIMAGELOADER_H_INCLUDED
@@ -0,0 +1,203 @@
+/**
+ * FILE:    CookedCache.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the CookedCache class.
+**/
+
+#include "CookedCache.h"
+#include "Atomic.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "FileUtils.h"
+#include "HashTable.h"
+#include "Logger.h"
+#include "MMapFile.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _FIRE_ENGINE_WIN32_
+#	include <direct.h>
+#else
+#	include <sys/stat.h>
+#	include <sys/types.h>
+#endif
+
+#define COOKED_MAGIC   0x4B434546 // 'FECK'
+#define COOKED_VERSION 0x00000001
+
+namespace fire_engine
+{
+
+//! The header of a cooked file. It is followed by the key of the asset, then by the data
+//! written by the loader, which starts on a 16 byte boundary.
+struct cooked_header_t
+{
+	u32 Magic;
+	u32 Version;
+	u32 LoaderVersion;
+	s32 SourceSize;
+	u32 SourceTime;
+	u32 KeyLength;
+	u32 DataOffset;
+	u32 DataSize;
+};
+
+CookedCache::CookedCache(const String& directory)
+	: mDirectory(directory), mHits(0), mMisses(0), mNextTemporary(0)
+{
+	io::FileUtils::ConvertPath(mDirectory);
+	if (mDirectory.length() == 0 || mDirectory.c_str()[mDirectory.length()-1] != '/')
+	{
+		mDirectory += "/";
+	}
+	// Fails harmlessly if the directory exists
+#ifdef _FIRE_ENGINE_WIN32_
+	_mkdir(mDirectory.c_str());
+#else
+	mkdir(mDirectory.c_str(), 0755);
+#endif
+}
+
+const String& CookedCache::getDirectory() const
+{
+	return mDirectory;
+}
+
+bool CookedCache::GetSourceStat(const String& filename, io::IFileProvider * fileProvider,
+	io::file_stat_t& source)
+{
+	io::FileSystem * fs = io::FileSystem::Get();
+	return fs != nullptr && fs->getFileStat(filename, false, source, fileProvider);
+}
+
+u32 CookedCache::getHitCount() const
+{
+	return (u32)AtomicLoadAcquire(&mHits);
+}
+
+u32 CookedCache::getMissCount() const
+{
+	return (u32)AtomicLoadAcquire(&mMisses);
+}
+
+String CookedCache::MakeKey(const String& filename, u32 version)
+{
+	c8 suffix[16];
+	sprintf(suffix, ":%08x", version);
+	return io::FileUtils::MakeLookupKey(filename) + suffix;
+}
+
+String CookedCache::getBlobPath(const String& key) const
+{
+	c8 name[16];
+	sprintf(name, "%08x.fec", Hash<String>::hash_function(key));
+	return mDirectory + name;
+}
+
+io::IFile * CookedCache::openBlob(const String& filename, const io::file_stat_t& source, u32 version)
+{
+	const String key = MakeKey(filename, version);
+	io::IFile * blob = new io::MMapFile(getBlobPath(key));
+	if (!blob->isOpen())
+	{
+		delete blob;
+		countLoad(false);
+		return nullptr;
+	}
+
+	const u8 * data = (const u8 *)blob->getData();
+	const s32 size = blob->getSize();
+	cooked_header_t header;
+	bool valid = size >= (s32)sizeof(cooked_header_t);
+	if (valid)
+	{
+		memcpy(&header, data, sizeof(cooked_header_t));
+		// The cooked file must be for this very asset: the file name is only a hash of the key
+		valid = header.Magic == COOKED_MAGIC && header.Version == COOKED_VERSION &&
+			header.LoaderVersion == version && header.SourceSize == source.Size &&
+			header.SourceTime == source.ModificationTime &&
+			header.KeyLength == (u32)key.length() &&
+			sizeof(cooked_header_t) + header.KeyLength <= header.DataOffset &&
+			(u64)header.DataOffset + header.DataSize <= (u64)size &&
+			memcmp(data + sizeof(cooked_header_t), key.c_str(), header.KeyLength) == 0;
+	}
+	if (!valid || !blob->seek(io::EFSP_START, header.DataOffset))
+	{
+		delete blob;
+		countLoad(false);
+		return nullptr;
+	}
+	return blob;
+}
+
+io::IFile * CookedCache::createBlob(const String& filename, const io::file_stat_t& source, u32 version,
+	String& temporary)
+{
+	const String key = MakeKey(filename, version);
+	c8 suffix[16];
+	sprintf(suffix, ".%d.tmp", AtomicFetchAdd(&mNextTemporary, 1));
+	temporary = getBlobPath(key) + suffix;
+
+	io::IFile * blob = new io::File(temporary,
+		io::EFOF_WRITE|io::EFOF_CREATE|io::EFOF_TRUNCATE|io::EFOF_BINARY);
+	if (!blob->isOpen())
+	{
+		Logger::Get()->log(ES_DEBUG, "CookedCache", "Could not create %s", temporary.c_str());
+		delete blob;
+		return nullptr;
+	}
+
+	cooked_header_t header;
+	header.Magic         = COOKED_MAGIC;
+	header.Version       = COOKED_VERSION;
+	header.LoaderVersion = version;
+	header.SourceSize    = source.Size;
+	header.SourceTime    = source.ModificationTime;
+	header.KeyLength     = key.length();
+	header.DataOffset    = (sizeof(cooked_header_t) + header.KeyLength + 15) & ~15;
+	header.DataSize      = 0; // Set by finishBlob()
+
+	static const u8 padding[16] = {0};
+	blob->write(&header, sizeof(cooked_header_t));
+	blob->write(key.c_str(), header.KeyLength);
+	blob->write(padding, header.DataOffset - sizeof(cooked_header_t) - header.KeyLength);
+	return blob;
+}
+
+bool CookedCache::finishBlob(io::IFile * blob, const String& filename, u32 version,
+	const String& temporary, bool cooked)
+{
+	const String key = MakeKey(filename, version);
+	if (cooked)
+	{
+		// Now that the size of the data is known, write it in the header
+		const u32 offset = (sizeof(cooked_header_t) + key.length() + 15) & ~15;
+		const u32 size   = blob->getCurrentPosition() - offset;
+		cooked = blob->seek(io::EFSP_START, offsetof(cooked_header_t, DataSize)) &&
+			blob->write(&size, sizeof(size));
+	}
+	blob->close();
+	delete blob;
+
+	if (cooked)
+	{
+		// Replace the cooked file in one go, so that it is never seen half written
+		const String path = getBlobPath(key);
+		::remove(path.c_str());
+		cooked = ::rename(temporary.c_str(), path.c_str()) == 0;
+	}
+	if (!cooked)
+	{
+		::remove(temporary.c_str());
+	}
+	return cooked;
+}
+
+void CookedCache::countLoad(bool loaded)
+{
+	AtomicFetchAdd(loaded ? &mHits : &mMisses, 1);
+}
+
+} // namespace fire_engine
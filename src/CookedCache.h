@@ -0,0 +1,126 @@
+/**
+ * FILE:    CookedCache.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: An on-disk cache of assets saved in the native format of the engine, so that
+ *          they load without being parsed again.
+**/
+
+#ifndef COOKEDCACHE_H_INCLUDED
+#define COOKEDCACHE_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "String.h"
+#include "ILoader.h"
+#include "IFile.h"
+#include "IFileProvider.h"
+
+namespace fire_engine
+{
+
+/** An on-disk cache of 'cooked' assets: assets saved by their loader in the native format
+ of the engine (see ILoader::cook()), which can be loaded back by mapping the file and
+ copying the data out of it, without parsing the original file again.
+ Each cooked file is keyed by the path of the original file and the version of the
+ cooked format of the loader, and records the size and modification time of the original
+ file: when they change, the cooked file is ignored and written again the next time the
+ asset is loaded. Loaders of different types of asset from the same file must use
+ different versions (see ILoader::getCookedVersion()).
+ Cooked files are only meant to be read by the machine that wrote them, so they are in its
+ byte order. The cache can be used from several threads at once. */
+class _FIRE_ENGINE_API_ CookedCache
+{
+public:
+	/** Constructor.
+	 \param directory The directory to keep the cooked files in. It is created if it does
+	                  not exist. */
+	CookedCache(const String& directory);
+
+	/** Returns the directory the cooked files are kept in, ending with a '/'. */
+	const String& getDirectory() const;
+
+	/** Returns the size and modification time of the original file of an asset.
+	 \return true if they are known, false if the asset cannot be cooked. */
+	static bool GetSourceStat(const String& filename, io::IFileProvider * fileProvider,
+		io::file_stat_t& source);
+
+	/** Loads an asset from its cooked file.
+	 \param filename The name of the original file.
+	 \param source   The size and modification time of the original file.
+	 \param loader   The loader of the asset.
+	 \return The asset, or 0 if there is no valid cooked file for it. */
+	template <class T>
+	T * load(const String& filename, const io::file_stat_t& source, const ILoader<T> * loader)
+	{
+		io::IFile * blob = openBlob(filename, source, loader->getCookedVersion());
+		if (blob == 0)
+			return 0;
+		T * object = loader->loadCooked(blob);
+		delete blob;
+		countLoad(object != 0);
+		return object;
+	}
+
+	/** Writes the cooked file of an asset.
+	 \param filename The name of the original file.
+	 \param source   The size and modification time of the original file.
+	 \param loader   The loader of the asset.
+	 \param object   The asset, created by loader.
+	 \return true if the cooked file was written, false otherwise. */
+	template <class T>
+	bool store(const String& filename, const io::file_stat_t& source, const ILoader<T> * loader,
+		const T * object)
+	{
+		String temporary;
+		io::IFile * blob = createBlob(filename, source, loader->getCookedVersion(), temporary);
+		if (blob == 0)
+			return false;
+		return finishBlob(blob, filename, loader->getCookedVersion(), temporary,
+			loader->cook(object, blob));
+	}
+
+	/** Returns the number of assets loaded from their cooked file. */
+	u32 getHitCount() const;
+
+	/** Returns the number of assets that had no valid cooked file. */
+	u32 getMissCount() const;
+
+private:
+	//! The directory of the cooked files, ending with a '/'
+	String       mDirectory;
+	volatile s32 mHits;
+	volatile s32 mMisses;
+	//! Used to give every temporary file a different name
+	volatile s32 mNextTemporary;
+
+	/** Returns the key of the cooked file of an asset. It includes the version of the
+	 loader, so that different loaders of the same file have different cooked files. */
+	static String MakeKey(const String& filename, u32 version);
+
+	/** Returns the path of the cooked file for an asset. */
+	String getBlobPath(const String& key) const;
+
+	/** Opens the cooked file of an asset, if it is valid.
+	 \return The file, positioned at the start of the data written by the loader, or 0. */
+	io::IFile * openBlob(const String& filename, const io::file_stat_t& source, u32 version);
+
+	/** Creates a temporary file to cook an asset into, and writes its header.
+	 \param temporary Set to the name of the temporary file.
+	 \return The file, positioned where the loader should start writing, or 0. */
+	io::IFile * createBlob(const String& filename, const io::file_stat_t& source, u32 version,
+		String& temporary);
+
+	/** Closes a file created by createBlob(), and replaces the cooked file of the asset
+	 with it if it was cooked successfully. Deletes blob.
+	 \return cooked, if the cooked file could be replaced. */
+	bool finishBlob(io::IFile * blob, const String& filename, u32 version,
+		const String& temporary, bool cooked);
+
+	/** Counts a hit if loaded, a miss otherwise. */
+	void countLoad(bool loaded);
+};
+
+} // namespace fire_engine
+
+#endif // COOKEDCACHE_H_INCLUDED
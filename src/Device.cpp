@@ -17,6 +17,7 @@
 #include "IEventReceiver.h"
 #include "IWindowManager.h"
 #include "FileSystem.h"
+#include "MaterialRegistry.h"
 #if defined(_FIRE_ENGINE_WIN32_)
 #	include "WindowManagerWin32.h"
 #endif
@@ -135,6 +136,8 @@ Device::~Device(void)
 {
 	if (mSceneManager)
 		mSceneManager->drop();
+	// The materials hold on to textures of the renderer
+	MaterialRegistry::Clear();
 	if (mWindowManager)
 		mWindowManager->drop();
 	if (mRenderer)
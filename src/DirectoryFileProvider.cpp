@@ -8,10 +8,19 @@
 #include "DirectoryFileProvider.h"
 #include "stdio.h"
 #include "File.h"
+#include "MMapFile.h"
+#include "FileUtils.h"
+#include <stdlib.h>
 
 #ifdef _FIRE_ENGINE_WIN32_
 #	include <io.h>
-#	include <direct.h>
+#	include <sys/types.h>
+#	include <sys/stat.h>
+#else
+#	include <dirent.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#	include <limits.h>
 #endif
 
 namespace fire_engine
@@ -19,54 +28,259 @@ namespace fire_engine
 namespace io
 {
 
-DirectoryFileProvider::DirectoryFileProvider(const String& directory)
-	: DirectoryName(directory)
+DirectoryFileProvider::DirectoryFileProvider(const String& directory, bool cacheListing)
+	: CacheListing(cacheListing)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::io::DirectoryFileProvider");
 #endif
+	// Work out the full path once, so that the current directory can change afterwards
+#ifdef _FIRE_ENGINE_WIN32_
+	c8 fullPath[_MAX_PATH];
+	if (_fullpath(fullPath, directory.c_str(), sizeof(fullPath)) != nullptr)
+#else
+	c8 fullPath[PATH_MAX];
+	if (realpath(directory.c_str(), fullPath) != nullptr)
+#endif
+	{
+		DirectoryName = fullPath;
+	}
+	else
+	{
+		DirectoryName = directory;
+	}
+	FileUtils::ConvertPath(DirectoryName);
+	if (DirectoryName.length() == 0 || DirectoryName.c_str()[DirectoryName.length()-1] != '/')
+	{
+		DirectoryName += "/";
+	}
+
+	if (CacheListing)
+	{
+		scan("");
+	}
 }
 
 DirectoryFileProvider::~DirectoryFileProvider()
 {
+	clearListing();
 }
 
 IFile * DirectoryFileProvider::openFile(const String& filename, bool ignoreCase, u32 flags)
 {
-	c8 currentDirectory[FILENAME_MAX];
-	_getcwd(currentDirectory, sizeof(currentDirectory));
+	if (CacheListing)
+	{
+		// Open the file by its name on disk, which may differ by case
+		s32 entry = findEntry(filename, ignoreCase);
+		return entry >= 0 ? openEntry(entry, flags) : nullptr;
+	}
 
-	_chdir(DirectoryName.c_str());
+	return OpenPath(getFullPath(filename), flags);
+}
 
-	IFile * file = new File(filename.c_str(), flags);
-	if (!file->isOpen())
+bool DirectoryFileProvider::contains(const String& filename, bool ignoreCase)
+{
+	if (CacheListing)
 	{
-		delete file;
-		file = nullptr;
+		return findEntry(filename, ignoreCase) >= 0;
 	}
+#ifdef _FIRE_ENGINE_WIN32_
+	return _access_s(getFullPath(filename).c_str(), 0) == 0;
+#else
+	return access(getFullPath(filename).c_str(), F_OK) == 0;
+#endif
+}
+
+bool DirectoryFileProvider::isReady() const
+{
+	return true;
+}
 
-	_chdir(currentDirectory);
+s32 DirectoryFileProvider::getEntryCount() const
+{
+	return CacheListing ? Entries.size() : -1;
+}
 
-	return file;
+const String& DirectoryFileProvider::getEntryName(s32 entry) const
+{
+	return *(Entries.const_pointer()[entry]);
 }
 
-bool DirectoryFileProvider::contains(const String& filename, bool ignoreCase)
+IFile * DirectoryFileProvider::openEntry(s32 entry, u32 flags)
+{
+	return OpenPath(DirectoryName + getEntryName(entry), flags);
+}
+
+bool DirectoryFileProvider::getFileStat(const String& filename, bool ignoreCase, file_stat_t& status)
 {
-	bool fileExists = false;
-	c8 currentDirectory[FILENAME_MAX];
+	if (CacheListing)
+	{
+		s32 entry = findEntry(filename, ignoreCase);
+		return entry >= 0 && getEntryStat(entry, status);
+	}
 
-	_getcwd(currentDirectory, sizeof(currentDirectory));
-	_chdir(DirectoryName.c_str());
-	fileExists = _access_s(filename.c_str(), 0) == 0;
-	_chdir(currentDirectory);
+	return StatPath(getFullPath(filename), status);
+}
 
-	return fileExists;
+bool DirectoryFileProvider::getEntryStat(s32 entry, file_stat_t& status)
+{
+	return StatPath(DirectoryName + getEntryName(entry), status);
 }
 
-bool DirectoryFileProvider::isReady() const
+void DirectoryFileProvider::refresh()
+{
+	if (CacheListing)
+	{
+		clearListing();
+		scan("");
+	}
+}
+
+String DirectoryFileProvider::getFullPath(const String& filename) const
+{
+	const c8 * name = filename.c_str();
+	if (name[0] == '/' || name[0] == '\\' || (name[0] != '\0' && name[1] == ':'))
+	{
+		return filename;
+	}
+	return DirectoryName + filename;
+}
+
+s32 DirectoryFileProvider::findEntry(const String& filename, bool ignoreCase) const
+{
+	s32 * found = EntryIndex.find(FileUtils::MakeLookupKey(filename));
+	if (found == nullptr)
+	{
+		return -1;
+	}
+	if (ignoreCase)
+	{
+		return *found;
+	}
+
+	// The index ignores case, so look for the file with the exact same name among the
+	// files with the same key
+	String name(filename);
+	FileUtils::ConvertPath(name);
+	for (s32 i = *found; i != -1; i = NextSameKey.const_pointer()[i])
+	{
+		if (String::equals(name, *(Entries.const_pointer()[i])))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+void DirectoryFileProvider::scan(const String& subdirectory)
+{
+#ifdef _FIRE_ENGINE_WIN32_
+	_finddata_t found;
+	intptr_t handle = _findfirst((DirectoryName + subdirectory + "*").c_str(), &found);
+	if (handle == -1)
+	{
+		return;
+	}
+	do
+	{
+		const c8 * name = found.name;
+		const bool isDirectory = (found.attrib & _A_SUBDIR) != 0;
+#else
+	DIR * handle = opendir((DirectoryName + subdirectory).c_str());
+	if (handle == nullptr)
+	{
+		return;
+	}
+	dirent * found;
+	while ((found = readdir(handle)) != nullptr)
+	{
+		const c8 * name = found->d_name;
+		struct stat status;
+		const bool isDirectory = stat((DirectoryName + subdirectory + name).c_str(), &status) == 0 &&
+			S_ISDIR(status.st_mode);
+#endif
+		if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+		{
+			continue;
+		}
+		String path = subdirectory + name;
+		if (isDirectory)
+		{
+			scan(path + "/");
+		}
+		else
+		{
+			// Names that only differ by case keep the index of the first one, and the
+			// others are chained to it
+			const String key = FileUtils::MakeLookupKey(path);
+			if (!EntryIndex.insert(key, Entries.size()))
+			{
+				s32 last = *EntryIndex.find(key);
+				while (NextSameKey[last] != -1)
+					last = NextSameKey[last];
+				NextSameKey[last] = Entries.size();
+			}
+			Entries.push_back(new String(path));
+			NextSameKey.push_back(-1);
+		}
+#ifdef _FIRE_ENGINE_WIN32_
+	} while (_findnext(handle, &found) == 0);
+	_findclose(handle);
+#else
+	}
+	closedir(handle);
+#endif
+}
+
+bool DirectoryFileProvider::StatPath(const String& path, file_stat_t& status)
 {
+#ifdef _FIRE_ENGINE_WIN32_
+	struct _stat info;
+	if (_stat(path.c_str(), &info) != 0 || (info.st_mode & _S_IFDIR) != 0)
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0 || S_ISDIR(info.st_mode))
+#endif
+	{
+		return false;
+	}
+	status.Size             = (s32)info.st_size;
+	status.ModificationTime = (u32)info.st_mtime;
 	return true;
 }
 
+IFile * DirectoryFileProvider::OpenPath(const String& path, u32 flags)
+{
+	if ((flags & EFOF_MAP) != 0)
+	{
+		IFile * mapped = new MMapFile(path);
+		if (mapped->isOpen())
+		{
+			return mapped;
+		}
+		// Fall back to reading the file normally
+		delete mapped;
+	}
+
+	IFile * file = new File(path, flags);
+	if (!file->isOpen())
+	{
+		delete file;
+		file = nullptr;
+	}
+	return file;
+}
+
+void DirectoryFileProvider::clearListing()
+{
+	for (s32 i = 0; i < Entries.size(); i++)
+	{
+		delete Entries[i];
+	}
+	Entries.clear();
+	EntryIndex.clear();
+	NextSameKey.clear();
+}
+
+}
 }
-}
\ No newline at end of file
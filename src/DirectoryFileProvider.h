@@ -5,9 +5,14 @@
  * PURPOSE: A file provider for directories.
 **/
 
+#ifndef DIRECTORYFILEPROVIDER_H_INCLUDED
+#define DIRECTORYFILEPROVIDER_H_INCLUDED
+
 #include "Types.h"
 #include "CompileConfig.h"
 #include "String.h"
+#include "Array.h"
+#include "HashTable.h"
 #include "IFileProvider.h"
 
 namespace fire_engine
@@ -17,13 +22,24 @@ namespace io
 
 class IFile;
 
-/** A class that provides files from a specified directory. */
+/** A class that provides files from a specified directory.
+ The full path of the directory is worked out once, when the provider is created, and files
+ are opened relative to it: the current directory of the process is never changed, so
+ several threads can open files from the same provider at once.
+ The provider can optionally scan the directory and its sub-directories once, and keep a
+ listing of the files. Looking a file up then costs no system call, case-insensitive
+ lookups find files whatever their case on disk, and the files are added to the index of
+ the FileSystem. The listing is not updated when files are created or deleted: call
+ refresh() (and FileSystem::refreshIndex()) when it should be. */
 class _FIRE_ENGINE_API_ DirectoryFileProvider : public IFileProvider
 {
 public:
-	/** Construct a file provider from a given directory name, which 
-	 can be either a full path or a relative path. */
-	DirectoryFileProvider(const String& directory);
+	/** Construct a file provider from a given directory name, which
+	 can be either a full path or a relative path.
+	 \param directory    The directory to provide files from.
+	 \param cacheListing Whether to scan the directory once and keep a listing of its
+	                     files. */
+	DirectoryFileProvider(const String& directory, bool cacheListing = false);
 
 	virtual ~DirectoryFileProvider();
 
@@ -33,10 +49,61 @@ public:
 
 	virtual bool isReady() const;
 
+	/** Returns the number of files in the listing, or -1 if the listing is not cached. */
+	virtual s32 getEntryCount() const;
+
+	virtual const String& getEntryName(s32 entry) const;
+
+	virtual IFile * openEntry(s32 entry, u32 flags);
+
+	/** Returns the size of a file, and its time of modification in seconds since the
+	 epoch. */
+	virtual bool getFileStat(const String& filename, bool ignoreCase, file_stat_t& status);
+
+	virtual bool getEntryStat(s32 entry, file_stat_t& status);
+
+	/** Scans the directory again, if the listing is cached. This must not be called while
+	 other threads are opening files from the provider. */
+	void refresh();
+
 private:
+	//! The full path of the directory, ending with a '/'
 	String DirectoryName;
+	bool   CacheListing;
+	//! The files found in the directory, relative to it
+	Array<String*> Entries;
+	//! Index of the listed files, keyed by their lower case path. When several files have
+	//! the same key, the first one found is indexed.
+	HashTable<String, s32> EntryIndex;
+	//! For each file, the next file found with the same key, or -1
+	Array<s32> NextSameKey;
+
+	/** Returns the path of a file within the directory, or the file name itself if it is
+	 an absolute path. */
+	String getFullPath(const String& filename) const;
+
+	/** Returns the index of a file in the listing, or -1 if it is not there. */
+	s32 findEntry(const String& filename, bool ignoreCase) const;
+
+	/** Adds the files of a sub-directory to the listing, and scans its own
+	 sub-directories.
+	 \param subdirectory The path of the sub-directory, relative to the directory and
+	                     ending with a '/', or empty for the directory itself. */
+	void scan(const String& subdirectory);
+
+	/** Removes all the files from the listing. */
+	void clearListing();
+
+	/** Returns the size and modification time of a file from its full path. */
+	static bool StatPath(const String& path, file_stat_t& status);
+
+	/** Opens a file from its full path, mapping it if EFOF_MAP is in flags.
+	 \return A pointer to the file if it could be opened, nullptr otherwise. */
+	static IFile * OpenPath(const String& path, u32 flags);
 };
 
 
 }
-}
\ No newline at end of file
+}
+
+#endif // DIRECTORYFILEPROVIDER_H_INCLUDED
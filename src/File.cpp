@@ -31,7 +31,7 @@ File::File(const String& filename, u32 flags)
 {
 	Filename = filename;
 	// Open the file, and if created, allow read/write access
-	mFD = _open(filename.c_str(), flags, _S_IREAD | _S_IWRITE);
+	mFD = _open(filename.c_str(), flags & ~EFOF_MAP, _S_IREAD | _S_IWRITE);
 	ErrorOccured = mFD < 0;
 	if (!ErrorOccured)
 	{
@@ -91,6 +91,11 @@ s32 File::getCurrentPosition() const
 	return _tell(mFD);
 }
 
+s32 File::getSize() const
+{
+	return mSize;
+}
+
 bool File::remove(void)
 {
 	if (mFD > 0)
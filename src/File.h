@@ -41,6 +41,8 @@ public:
 
 	virtual s32 getCurrentPosition() const;
 
+	virtual s32 getSize() const;
+
 	virtual bool remove(void);
 
 	virtual bool close(void);
@@ -47,9 +47,9 @@ FileSystem * FileSystem::Get()
 FileSystem::~FileSystem()
 {
 	Instance = 0;
-	for (List<IFileProvider*>::iterator it = FileProviders.begin(); it != FileProviders.end(); it++)
+	for (s32 i = 0; i < MountPoints.size(); i++)
 	{
-		it->drop();
+		MountPoints[i].Provider->drop();
 	}
 }
 
@@ -66,33 +66,70 @@ IFile * FileSystem::openReadFile(const String& filename, bool ignoreCase, u32 fl
 		Logger::Get()->log(ES_DEBUG, "FileSystem", 
 			"Warning: Could not load %s in specified file provider", filenamePathFixed.c_str());
 	}
-	for (List<IFileProvider*>::iterator it = FileProviders.begin(); it != FileProviders.end(); it++)
+
+	IFileProvider * provider;
+	s32 entry;
+	if (!lookup(filenamePathFixed, ignoreCase, provider, entry))
 	{
-		if (it->contains(filenamePathFixed, ignoreCase))
-		{
-			return it->openFile(filenamePathFixed, ignoreCase, flags);
-		}
+		return nullptr;
 	}
-	return nullptr;
+	if (entry >= 0)
+	{
+		return provider->openEntry(entry, flags);
+	}
+	return provider->openFile(filenamePathFixed, ignoreCase, flags);
+}
+
+bool FileSystem::getFileStat(const String& filename, bool ignoreCase, file_stat_t& status,
+	IFileProvider * preferedFileProvider)
+{
+	String filenamePathFixed = filename;
+	FileUtils::ConvertPath(filenamePathFixed);
+	if (preferedFileProvider != nullptr &&
+		preferedFileProvider->contains(filenamePathFixed, ignoreCase))
+	{
+		return preferedFileProvider->getFileStat(filenamePathFixed, ignoreCase, status);
+	}
+
+	IFileProvider * provider;
+	s32 entry;
+	if (!lookup(filenamePathFixed, ignoreCase, provider, entry))
+	{
+		return false;
+	}
+	if (entry >= 0)
+	{
+		return provider->getEntryStat(entry, status);
+	}
+	return provider->getFileStat(filenamePathFixed, ignoreCase, status);
 }
 
 bool FileSystem::exists(const String& filename) const
 {
 	String filenamePathFixed = filename;
 	FileUtils::ConvertPath(filenamePathFixed);
-	bool fileExists = false;
-	for (List<IFileProvider*>::iterator it = FileProviders.begin(); it != FileProviders.end(); it++)
+	IFileProvider * provider;
+	s32 entry;
+	return lookup(filenamePathFixed, false, provider, entry);
+}
+
+s32 FileSystem::resolve(const String * filenames, s32 count, bool ignoreCase) const
+{
+	IFileProvider * provider;
+	s32 entry;
+	for (s32 i = 0; i < count; i++)
 	{
-		if (it->contains(filenamePathFixed, false))
+		String filenamePathFixed = filenames[i];
+		FileUtils::ConvertPath(filenamePathFixed);
+		if (lookup(filenamePathFixed, ignoreCase, provider, entry))
 		{
-			fileExists = true;
-			break;
+			return i;
 		}
 	}
-	return fileExists;
+	return -1;
 }
 
-IFileProvider * FileSystem::addArchive(const String& filename)
+IFileProvider * FileSystem::addArchive(const String& filename, s32 priority)
 {
 	IFileProvider * zip_reader = new ZipFileReader(filename);
 	if (!zip_reader->isReady())
@@ -102,16 +139,111 @@ IFileProvider * FileSystem::addArchive(const String& filename)
 		delete zip_reader;
 		return nullptr;
 	}
-	FileProviders.push_back(zip_reader);
+	mount(zip_reader, priority);
 	return zip_reader;
 }
 
-IFileProvider * FileSystem::addDirectory(const String& directoryName)
+IFileProvider * FileSystem::addDirectory(const String& directoryName, s32 priority, bool cacheListing)
 {
-	IFileProvider * directoryReader = new DirectoryFileProvider(directoryName);
-	FileProviders.push_back(directoryReader);
+	IFileProvider * directoryReader = new DirectoryFileProvider(directoryName, cacheListing);
+	mount(directoryReader, priority);
 	return directoryReader;
 }
 
+void FileSystem::refreshIndex()
+{
+	Index.clear();
+	for (s32 i = 0; i < MountPoints.size(); i++)
+	{
+		mount_point_t& mount_point = MountPoints[i];
+		mount_point.Indexed = mount_point.Provider->getEntryCount() >= 0;
+		if (mount_point.Indexed)
+		{
+			indexProvider(mount_point.Provider, mount_point.Priority);
+		}
+	}
+}
+
+void FileSystem::mount(IFileProvider * provider, s32 priority)
+{
+	mount_point_t mount_point;
+	mount_point.Provider = provider;
+	mount_point.Priority = priority;
+	mount_point.Indexed  = provider->getEntryCount() >= 0;
+
+	// Keep the mount points sorted: the new one goes after every mount point with
+	// the same or a higher priority
+	s32 position = MountPoints.size();
+	while (position > 0 && MountPoints[position-1].Priority < priority)
+	{
+		position--;
+	}
+	MountPoints.push_back(mount_point);
+	for (s32 i = MountPoints.size() - 1; i > position; i--)
+	{
+		MountPoints[i] = MountPoints[i-1];
+	}
+	MountPoints[position] = mount_point;
+
+	if (mount_point.Indexed)
+	{
+		indexProvider(provider, priority);
+	}
+}
+
+void FileSystem::indexProvider(IFileProvider * provider, s32 priority)
+{
+	const s32 count = provider->getEntryCount();
+	for (s32 i = 0; i < count; i++)
+	{
+		String key = FileUtils::MakeLookupKey(provider->getEntryName(i));
+		index_entry_t * existing = Index.find(key);
+		if (existing == nullptr)
+		{
+			index_entry_t entry;
+			entry.Provider = provider;
+			entry.Entry    = i;
+			entry.Priority = priority;
+			Index.insert(key, entry);
+		}
+		else if (existing->Priority < priority)
+		{
+			// Overlay the file provided with a lower priority
+			existing->Provider = provider;
+			existing->Entry    = i;
+			existing->Priority = priority;
+		}
+	}
+}
+
+bool FileSystem::lookup(const String& filename, bool ignoreCase, IFileProvider *& provider, s32& entry) const
+{
+	const index_entry_t * found = Index.find(FileUtils::MakeLookupKey(filename));
+	// The index ignores case, so the indexed file may not be the one asked for
+	const bool exact = found != nullptr &&
+		(ignoreCase || String::equals(filename, found->Provider->getEntryName(found->Entry)));
+
+	for (s32 i = 0; i < MountPoints.size(); i++)
+	{
+		const mount_point_t mount_point = MountPoints[i];
+		if (exact && mount_point.Provider == found->Provider)
+		{
+			provider = found->Provider;
+			entry    = found->Entry;
+			return true;
+		}
+		// Providers that come before the indexed one only need to be asked if they are
+		// not indexed, or if the indexed file only matched because case was ignored.
+		if ((!mount_point.Indexed || (found != nullptr && !exact)) &&
+			mount_point.Provider->contains(filename, ignoreCase))
+		{
+			provider = mount_point.Provider;
+			entry    = -1;
+			return true;
+		}
+	}
+	return false;
+}
+
 } // namespace io
 } // namespace fire_engine
@@ -12,7 +12,7 @@
 #include "Object.h"
 #include "Array.h"
 #include "String.h"
-#include "List.h"
+#include "HashTable.h"
 #include "IFile.h"
 #include "IFileProvider.h"
 #include <String.h>
@@ -46,7 +46,13 @@ struct _FIRE_ENGINE_API_ FileInfo
 };
 
 /** A virtual file system, where file archives can be added, providing easy access
- to files. */
+ to files.
+ Each archive or directory is added with a priority: when a file exists in several of them,
+ it is opened from the one with the highest priority, and from the one that was added first
+ when priorities are equal.
+ The files of every provider that can list them (such as .ZIP archives) are merged into a
+ single index when the provider is added, so that looking a file up does not depend on the
+ number of archives. Providers that cannot list their files are asked directly. */
 class _FIRE_ENGINE_API_ FileSystem : public Object
 {
 public:
@@ -77,22 +83,85 @@ public:
 		u32 flags = EFOF_READ|EFOF_BINARY, 
 		IFileProvider * preferedFileProvider = nullptr);
 
+	/** Returns the size and modification time of a file, without opening it. The file is
+	 looked for like openReadFile() would.
+	 \param filename    The name of the file.
+	 \param ignoreCase  Whether to ignore the case when looking for the file.
+	 \param status      Set to the information about the file.
+	 \param preferedFileProvider This file provider will be used first when looking for the file.
+	 \return true if the file was found and its provider knows about it, false otherwise. */
+	bool getFileStat(const String& filename, bool ignoreCase, file_stat_t& status,
+		IFileProvider * preferedFileProvider = nullptr);
+
     /** Checks whether a file exists within the file system.
      \param filename The name of the file to look for.
      \return true if the file exists somewhere in the file system, false otherwise. */
     bool exists(const String& filename) const;
 
+	/** Looks up several files at once, and returns the first one that exists. This is
+	 meant for loaders that try a list of names, such as the same file with several
+	 extensions.
+	 \param filenames  The names of the files to look for, in order of preference.
+	 \param count      The number of names in filenames.
+	 \param ignoreCase Whether to ignore the case when looking for the files.
+	 \return The index in filenames of the first file that exists, or -1 if none do. */
+	s32 resolve(const String * filenames, s32 count, bool ignoreCase = false) const;
+
 	/** Adds a .ZIP archive to the file system.
+	 \param priority The priority of the archive over the other archives and directories.
 	 \return A pointer to the IFileProvider created for the .ZIP file. */
-	IFileProvider * addArchive(const String& filename);
+	IFileProvider * addArchive(const String& filename, s32 priority = 0);
 
 	/** Adds a directory to the file system.
+	 \param priority     The priority of the directory over the archives and other directories.
+	 \param cacheListing Whether to scan the directory once, and add its files to the index
+	                     (see DirectoryFileProvider).
 	 \return A pointer to the IFileProvider created for the directory. */
-	IFileProvider * addDirectory(const String& directoryName);
+	IFileProvider * addDirectory(const String& directoryName, s32 priority = 0,
+		bool cacheListing = false);
+
+	/** Rebuilds the index of all the files, for when the files listed by a provider have
+	 changed since it was added. */
+	void refreshIndex();
 
 private:
+	//! A file provider, with its priority
+	struct mount_point_t
+	{
+		IFileProvider * Provider;
+		s32             Priority;
+		//! Whether the files of the provider are in the index
+		bool            Indexed;
+	};
+
+	//! Where a file of the index can be found
+	struct index_entry_t
+	{
+		IFileProvider * Provider;
+		s32             Entry;
+		s32             Priority;
+	};
+
 	static FileSystem * Instance;
-	List<IFileProvider*> FileProviders;
+	//! The file providers, sorted by decreasing priority then by the order they were added in
+	Array<mount_point_t> MountPoints;
+	//! The files of all the indexed providers, keyed by their normalised lower case path
+	HashTable<String, index_entry_t> Index;
+
+	/** Adds a file provider to the mount points and its files to the index. */
+	void mount(IFileProvider * provider, s32 priority);
+
+	/** Adds the files of a provider to the index, unless a provider with a higher
+	 priority already has them. */
+	void indexProvider(IFileProvider * provider, s32 priority);
+
+	/** Finds which provider a file should be opened from.
+	 \param filename The name of the file, with its path converted.
+	 \param provider Set to the provider that has the file.
+	 \param entry    Set to the index of the file in the provider, or -1 if the provider
+	                 should be asked to open the file by name.
+	 \return true if the file was found, false otherwise. */
+	bool lookup(const String& filename, bool ignoreCase, IFileProvider *& provider, s32& entry) const;
 
 	/** Constructor - made private to ensure only a singleton instance of the class is
 	 ever created. */
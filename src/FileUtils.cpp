@@ -36,10 +36,7 @@ String FileUtils::StripExtension(const fire_engine::String &filename)
 	const c8 * dotOffset;
 	if ((dotOffset = strrchr(fn, '.')) != nullptr)
 	{
-		c8 * stripped = new c8[dotOffset-fn+1];
-		memcpy(stripped, fn, dotOffset-fn);
-		stripped[dotOffset-fn] = '\0';
-		return String(stripped, true);
+		return String(fn, dotOffset-fn);
 	}
 	return filename;
 }
@@ -59,5 +56,13 @@ void FileUtils::ConvertPath(String& path)
 	path.replaceAll('\\', '/');
 }
 
+String FileUtils::MakeLookupKey(const String& path)
+{
+	String key(path);
+	ConvertPath(key);
+	key.makeLower();
+	return key;
+}
+
 } //namespace io
 } //namespace fire_engine
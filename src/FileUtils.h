@@ -41,6 +41,12 @@ public:
 	/** Fixes a given path so that directory delimiters are consistent.
 	 \param path The path to modify. This will be done in place. */
 	static void ConvertPath(String& path);
+
+	/** Returns the key used to look a path up in the indices of the file system: directory
+	 delimiters are converted, and the path is made lower case.
+	 \param path The path of a file.
+	 \return     The normalised, lower case path. */
+	static String MakeLookupKey(const String& path);
 };
 
 } //namespace io
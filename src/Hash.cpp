@@ -7,6 +7,7 @@
 
 #include "HashTable.h"
 #include "String.h"
+#include "InternedString.h"
 #include "KeyEvent.h"
 #include <String.h>
 #include <ctype.h>
@@ -159,6 +160,16 @@ template <> u32 Hash<String>::hash_function(const String& key)
 	return hash_string(key);
 }
 
+template <> u32 Hash<InternedString>::hash_function(const InternedString& key)
+{
+	return key.getHash();
+}
+
+template <> bool Hash<InternedString>::equal(const InternedString& a, const InternedString& b)
+{
+	return a == b;
+}
+
 u32 StringHashIgnoreCase::hash_function(const String& key)
 {
 	u32 h = 5381;
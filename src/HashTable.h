@@ -3,10 +3,11 @@
  * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
  * RCS ID:  $Id: HashTable.h 116 2007-10-05 13:22:45Z jpaterso $
  * PURPOSE: An implementation of a Hash table, which stores key-pair values using a hash on the
- *          key. A 'load' factor determines the values/storage factor, and when it reaches a
- *          certain threshold (set at 0.75f by default), the table is re-hashed. A HashTable
- *          with a well-set load factor provides very good insertion/searching times, close to
- *          O(1).
+ *          key. Entries are stored inline in a single power-of-two sized table, using open
+ *          addressing with Robin Hood linear probing, and backward-shift deletion so that no
+ *          tombstones are ever left behind. A 'load' factor determines the values/storage
+ *          factor, and when it reaches a certain threshold (set at 0.75f by default), the
+ *          table is re-hashed. Searching and insertion are close to O(1).
 **/
 
 #ifndef HASHTABLE_H_INCLUDED
@@ -47,10 +48,14 @@ public:
 };
 
 /** An implementation of a Hash table, which stores key-pair values using a hash on the
- key. A 'load' factor determines the values/storage factor, and when it reaches a
- certain threshold (set at 0.75f by default), the table is re-hashed. A HashTable
- with a well-set load factor provides very good insertion/searching times, close to
- O(1). */
+ key. Key-value pairs live directly in the table (there is no allocation per insertion),
+ and collisions are resolved with Robin Hood linear probing: an entry that is further
+ away from its home slot takes the place of one that is closer to it, which keeps probe
+ sequences short and lets unsuccessful searches stop early. Removal shifts the following
+ entries back by one slot instead of leaving a tombstone.
+ The full hash of every entry is kept alongside it, so that re-hashing never calls the
+ hash function again, and key comparisons are only made when the hashes match.
+ Key and Value must be default constructible and assignable. */
 template <class Key, class Value, class HashClass = Hash<Key>, class CompareClass = Hash<Key> >
 class _FIRE_ENGINE_API_ HashTable : public IMap<Key, Value>
 {
@@ -63,36 +68,74 @@ private:
 	};
 
 public:
-	/** Constructor. */
+	/** An iterator over all the key-value pairs in the table. Iterating does not allocate,
+	 and the iterator is invalidated by any insertion or removal. */
+	class iterator
+	{
+	public:
+		inline iterator& operator++()
+		{
+			m_index = m_table->next_used(m_index + 1);
+			return *this;
+		}
+
+		inline const Key& getKey() const
+		{
+			return m_table->m_entries[m_index].key;
+		}
+
+		inline Value& getValue() const
+		{
+			return m_table->m_entries[m_index].value;
+		}
+
+		inline bool operator!=(const iterator& it) const
+		{
+			return m_index != it.m_index;
+		}
+
+		inline bool operator==(const iterator& it) const
+		{
+			return m_index == it.m_index;
+		}
+
+	private:
+		// HashTable needs to access the private constructor, so make it a friend!
+		friend class HashTable<Key, Value, HashClass, CompareClass>;
+
+		const HashTable * m_table;
+		u32               m_index;
+
+		/** Private constructor so that only HashTable can create an iterator. */
+		iterator(const HashTable * table, u32 index) : m_table(table), m_index(index) {}
+	};
+
+	/** Constructor.
+	 \param initial_capacity The initial number of slots, rounded up to a power of two.
+	 \param load The maximum ratio of elements to slots before the table grows, which is
+	             clamped between 0.1 and 1. */
 	HashTable(u32 initial_capacity = 128, f32 load = 0.75f)
-		: m_table_size(initial_capacity),
-		m_max_load(load),
-		m_current_load(0.0f)
+		: m_entries(0),
+		m_hashes(0),
+		m_capacity(0),
+		m_mask(0),
+		m_max_load(load >= 0.1f ? (load <= 1.0f ? load : 1.0f) : 0.1f),
+		m_grow_at(0)
 	{
-		m_table = new ht_entry_t*[m_table_size];
-		memset((void *)m_table, 0, m_table_size * sizeof(ht_entry_t*));
+		allocate(round_capacity(initial_capacity));
 	}
 
 	/** Destructor. */
 	virtual ~HashTable()
 	{
-		for (u32 i = 0; i < m_table_size; i++)
-			if (m_table[i] != 0)
-				delete m_table[i];
-		delete [] m_table;
+		delete [] m_entries;
+		delete [] m_hashes;
 	}
 
 	/** Returns whether the hash table contains a specified key. */
 	virtual bool contains(const Key& key) const
 	{
-		u32 h = hash(key, m_table_size);
-		while (m_table[h] != 0)
-		{
-			if (CompareClass::equal(m_table[h]->key, key))
-				return true;
-			h = (h+1)%(m_table_size-1);
-		}
-		return false;
+		return find_slot(key) != m_capacity;
 	}
 
 	/** Inserts a key-value pair in the hash table.
@@ -100,20 +143,12 @@ public:
 	         already exists. */
 	virtual bool insert(const Key& key, const Value& val)
 	{
-		u32 h = hash(key, m_table_size);
+		if (find_slot(key) != m_capacity)
+			return false;
+		if ((u32)this->getCount() + 1 > m_grow_at)
+			re_hash(m_capacity * 2);
+		place(hash(key), key, val);
 		this->incrementCount();
-		m_current_load = (f32)this->getCount() / m_table_size;
-		if (m_current_load > m_max_load)
-			re_hash();
-		while (m_table[h] != 0)
-		{
-			if (CompareClass::equal(m_table[h]->key, key))
-				return false;
-			h = (h+1)%(m_table_size-1);
-		}
-		m_table[h] = new ht_entry_t;
-		m_table[h]->key = key;
-		m_table[h]->value = val;
 		return true;
 	}
 
@@ -121,39 +156,62 @@ public:
 	 successful or not. */
 	virtual bool remove(const Key& key)
 	{
-		u32 h = hash(key, m_table_size);
-		while (m_table[h] != 0)
+		u32 slot = find_slot(key);
+		if (slot == m_capacity)
+			return false;
+
+		// Shift back every following entry that is not in its home slot, so that
+		// there is never a hole in the middle of a probe sequence.
+		u32 next = (slot + 1) & m_mask;
+		while (m_hashes[next] != 0 && probe_distance(m_hashes[next], next) != 0)
 		{
-			if (CompareClass::equal(m_table[h]->key, key))
-			{
-				delete m_table[h];
-				m_table[h] = 0;
-				this->decrementCount();
-				m_current_load = (f32)this->getCount() / m_table_size;
-				return true;
-			}
-			h = (h == m_table_size - 1) ? 0 : (h + 1);
+			m_hashes[slot]  = m_hashes[next];
+			m_entries[slot] = m_entries[next];
+			slot = next;
+			next = (next + 1) & m_mask;
 		}
-		return false;
+		m_hashes[slot]  = 0;
+		m_entries[slot] = ht_entry_t();
+		this->decrementCount();
+		return true;
 	}
 
 	/** Attempts to find the value associated with a given key.
 	 \return A pointer to the key, or 0 the key was not in the table. */
 	virtual Value * find(const Key& key) const
 	{
-		u32 h = hash(key, m_table_size);
-		while (m_table[h] != 0)
-		{
-			if (CompareClass::equal(m_table[h]->key, key))
-				return &(m_table[h]->value);
-			h = (h+1) % (m_table_size-1);
-		}
-		return 0;
+		u32 slot = find_slot(key);
+		if (slot == m_capacity)
+			return 0;
+		return &(m_entries[slot].value);
 	}
 
+	/** Returns the value associated with a key, inserting a default-constructed value
+	 if the key was not in the table yet. */
 	Value& operator[](const Key& key)
 	{
-		return insert(key);
+		u32 slot = find_slot(key);
+		if (slot != m_capacity)
+			return m_entries[slot].value;
+		if ((u32)this->getCount() + 1 > m_grow_at)
+			re_hash(m_capacity * 2);
+		slot = place(hash(key), key, Value());
+		this->incrementCount();
+		return m_entries[slot].value;
+	}
+
+	/** Removes all the key-value pairs, keeping the current capacity. */
+	void clear()
+	{
+		for (u32 i = 0; i < m_capacity; i++)
+		{
+			if (m_hashes[i] != 0)
+			{
+				m_hashes[i]  = 0;
+				m_entries[i] = ht_entry_t();
+			}
+		}
+		this->resetCount();
 	}
 
 	/** Returns whether the hash table is empty. */
@@ -162,41 +220,51 @@ public:
 		return this->getCount() == 0;
 	}
 
-	/** Returns an array containing all the keys of the hash table. */
+	/** Returns an iterator to the first key-value pair of the table. */
+	inline iterator begin() const
+	{
+		return iterator(this, next_used(0));
+	}
+
+	/** Returns an iterator past the last key-value pair of the table. */
+	inline iterator end() const
+	{
+		return iterator(this, m_capacity);
+	}
+
+	/** Returns a newly allocated array containing all the keys of the hash table, that the
+	 caller must delete. Use begin()/end() to visit the keys without allocating. */
 	virtual const Array<Key> * keys() const
 	{
-		Array<Key> * k = new Array<Key>(this->getCount());
-		for (u32 i = 0; i < m_table_size; i++)
-			if (m_table[i] != 0)
-				k->push_back(m_table[i]->key);
+		Array<Key> * k = new Array<Key>(this->getCount() > 0 ? this->getCount() : 1);
+		for (iterator it = begin(); it != end(); ++it)
+			k->push_back(it.getKey());
 		return k;
 	}
 
 	virtual Array<Key> * keys()
 	{
-		Array<Key> * k = new Array<Key>(this->getCount());
-		for (u32 i = 0; i < m_table_size; i++)
-			if (m_table[i] != 0)
-				k->push_back(m_table[i]->key);
+		Array<Key> * k = new Array<Key>(this->getCount() > 0 ? this->getCount() : 1);
+		for (iterator it = begin(); it != end(); ++it)
+			k->push_back(it.getKey());
 		return k;
 	}
 
-	/** Returns an array containing all the values of the hash table. */
+	/** Returns a newly allocated array containing all the values of the hash table, that
+	 the caller must delete. Use begin()/end() to visit the values without allocating. */
 	virtual const Array<Value> * values() const
 	{
-		Array<Value> * v = new Array<Value>(this->getCount());
-		for (u32 i = 0; i < m_table_size; i++)
-			if (m_table[i] != 0)
-				v->push_back(m_table[i]->value);
+		Array<Value> * v = new Array<Value>(this->getCount() > 0 ? this->getCount() : 1);
+		for (iterator it = begin(); it != end(); ++it)
+			v->push_back(it.getValue());
 		return v;
 	}
 
 	virtual Array<Value> * values()
 	{
-		Array<Value> * v = new Array<Value>(this->getCount());
-		for (u32 i = 0; i < m_table_size; i++)
-			if (m_table[i] != 0)
-				v->push_back(m_table[i]->value);
+		Array<Value> * v = new Array<Value>(this->getCount() > 0 ? this->getCount() : 1);
+		for (iterator it = begin(); it != end(); ++it)
+			v->push_back(it.getValue());
 		return v;
 	}
 
@@ -206,64 +274,142 @@ public:
 		return this->getCount();
 	}
 
+	/** Returns the number of slots in the table. */
+	inline u32 capacity() const
+	{
+		return m_capacity;
+	}
+
 private:
-	ht_entry_t ** m_table;
-	u32           m_table_size;
-	f32           m_max_load;
-	f32           m_current_load;
+	ht_entry_t * m_entries;
+	//! The full hash of the entry in each slot, 0 for an empty slot
+	u32 *        m_hashes;
+	u32          m_capacity;
+	u32          m_mask;
+	f32          m_max_load;
+	//! Number of elements at which the table grows
+	u32          m_grow_at;
+
+	//! Hashes a key. 0 is reserved to mark empty slots, so it is never returned.
+	static inline u32 hash(const Key& key)
+	{
+		u32 h = HashClass::hash_function(key);
+		return h != 0 ? h : 1;
+	}
+
+	//! Rounds a capacity up to a power of two, no smaller than 8.
+	static u32 round_capacity(u32 capacity)
+	{
+		u32 c = 8;
+		while (c < capacity)
+			c <<= 1;
+		return c;
+	}
 
-	//! Hash function - implements the Jenkin-one-at-a-time JOAAT algorithm
-	static u32 hash(const Key& key, s32 tbl_size)
+	//! How far the entry with hash h, stored in slot, is from its home slot.
+	inline u32 probe_distance(u32 h, u32 slot) const
 	{
-		return HashClass::hash_function(key) % tbl_size;
+		return (slot + m_capacity - (h & m_mask)) & m_mask;
 	}
 
-	//! Re-hash the table
-	void re_hash()
+	//! Returns the first used slot at or after index, or m_capacity if there is none.
+	inline u32 next_used(u32 index) const
 	{
-		ht_entry_t ** new_table = new ht_entry_t*[2 * m_table_size];
-		memset((void *)new_table, 0, 2*m_table_size*sizeof(ht_entry_t)); // set them to 0 just in case
-		s32 last = 2*m_table_size-1;
-		u32 h;
-		for (u32 i = 0; i < m_table_size; i++)
+		while (index < m_capacity && m_hashes[index] == 0)
+			index++;
+		return index;
+	}
+
+	//! Returns the slot holding key, or m_capacity if key is not in the table.
+	u32 find_slot(const Key& key) const
+	{
+		u32 h    = hash(key);
+		u32 slot = h & m_mask;
+		for (u32 dist = 0; m_hashes[slot] != 0; dist++)
 		{
-			if (m_table[i] != 0)
-			{
-				h = hash(m_table[i]->key, m_table_size);
-				while (new_table[h] != 0)
-					h = (h+1)%(last);
-				new_table[i] = m_table[i];
-			}
+			// Robin Hood invariant: had the key been here, it would have displaced
+			// any entry closer to its home slot than we are to ours.
+			if (dist > probe_distance(m_hashes[slot], slot))
+				break;
+			if (m_hashes[slot] == h && CompareClass::equal(m_entries[slot].key, key))
+				return slot;
+			slot = (slot + 1) & m_mask;
 		}
-		delete [] m_table;
-		m_table        = new_table;
-		m_table_size   = last+1;
-		m_current_load = (f32)this->getCount() / m_table_size;
+		return m_capacity;
 	}
 
-	Value& insert(const Key& key)
+	//! Places a key-value pair that is known not to be in the table, and returns its slot.
+	u32 place(u32 h, const Key& key, const Value& val)
 	{
-		u32 h = hash(key, m_table_size);
-		
-		while (m_table[h] != nullptr)
+		ht_entry_t entry;
+		entry.key   = key;
+		entry.value = val;
+
+		u32 slot   = h & m_mask;
+		u32 dist   = 0;
+		u32 placed = m_capacity;
+		while (m_hashes[slot] != 0)
 		{
-			if (CompareClass::equal(m_table[h]->key, key))
+			u32 existing = probe_distance(m_hashes[slot], slot);
+			if (existing < dist)
 			{
-				return m_table[h]->value;
+				// Take from the rich: swap with the entry closer to its home
+				u32 th = m_hashes[slot];
+				m_hashes[slot] = h;
+				h = th;
+				ht_entry_t te = m_entries[slot];
+				m_entries[slot] = entry;
+				entry = te;
+				if (placed == m_capacity)
+					placed = slot;
+				dist = existing;
 			}
-			h = (h+1)%(m_table_size-1);
-		}
-		m_table[h] = new ht_entry_t;
-		m_table[h]->key = key;
-		incrementCount();
-		m_current_load = (f32)this->getCount() / m_table_size;
-		if (m_current_load > m_max_load)
-		{
-			re_hash();
+			slot = (slot + 1) & m_mask;
+			dist++;
 		}
+		m_hashes[slot]  = h;
+		m_entries[slot] = entry;
+		return placed == m_capacity ? slot : placed;
+	}
+
+	//! Allocates an empty table of the given (power of two) capacity
+	void allocate(u32 capacity)
+	{
+		m_entries  = new ht_entry_t[capacity];
+		m_hashes   = new u32[capacity];
+		memset((void *)m_hashes, 0, capacity * sizeof(u32));
+		m_capacity = capacity;
+		m_mask     = capacity - 1;
+		// At least one entry fits before growing, whatever the load, and one slot is
+		// always left empty
+		const f32 grow_at = m_max_load * capacity;
+		if (!(grow_at >= 1.0f))
+			m_grow_at = 1;
+		else if (grow_at >= (f32)(capacity - 1))
+			m_grow_at = capacity - 1;
+		else
+			m_grow_at = (u32)grow_at;
+	}
 
-		return m_table[h]->value;
+	//! Re-hash the table into a table of new_capacity slots
+	void re_hash(u32 new_capacity)
+	{
+		ht_entry_t * old_entries  = m_entries;
+		u32 *        old_hashes   = m_hashes;
+		u32          old_capacity = m_capacity;
+
+		allocate(new_capacity);
+		for (u32 i = 0; i < old_capacity; i++)
+			if (old_hashes[i] != 0)
+				place(old_hashes[i], old_entries[i].key, old_entries[i].value);
+
+		delete [] old_entries;
+		delete [] old_hashes;
 	}
+
+	// Copying is not supported
+	HashTable(const HashTable&);
+	HashTable& operator=(const HashTable&);
 };
 
 }
@@ -41,7 +41,8 @@ enum EFILE_OPEN_FLAGS
 	EFOF_CREATE   = _O_CREAT,   // Create the file if it does not exist
 	EFOF_APPEND   = _O_APPEND,  // If the file exists, append to it instead of truncating it
 	EFOF_TRUNCATE = _O_TRUNC,   // If the file exists, truncate it
-	EFOF_BINARY   = _O_BINARY   // Open the file in binary
+	EFOF_BINARY   = _O_BINARY,  // Open the file in binary
+	EFOF_MAP      = 0x10000000  // Map the file into memory for reading, if it is on disk
 };
 
 /** An interface for some sort of file: something that can be read or written
@@ -84,6 +85,20 @@ public:
 	/** Returns the current seeking position. */
 	virtual s32 getCurrentPosition() const = 0;
 
+	/** Returns the whole content of the file, if it is in memory, so that it can be
+	 parsed in place instead of being copied with read(). The data must not be modified.
+	 \return A pointer to getSize() bytes, or nullptr if the content is not in memory. */
+	virtual const void * getData() const
+	{
+		return nullptr;
+	}
+
+	/** Returns the size of the file in bytes, or -1 if it is not known. */
+	virtual s32 getSize() const
+	{
+		return -1;
+	}
+
 	/** Remove the file.
 	 \return true if the file was correctly removed, false otherwise. */
 	virtual bool remove() = 0;
@@ -0,0 +1,24 @@
+/**
+ * FILE:    IFileProvider.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the IFileProvider class.
+**/
+
+#include "IFileProvider.h"
+#include "Atomic.h"
+
+namespace fire_engine
+{
+namespace io
+{
+
+volatile s32 IFileProvider::NextId = 0;
+
+IFileProvider::IFileProvider()
+	: mId((u32)AtomicIncrementRelaxed(&NextId))
+{
+}
+
+}
+}
@@ -19,6 +19,16 @@ namespace io
 {
 class IFile;
 
+//! Information about a file, used to find out whether it has changed
+struct file_stat_t
+{
+	//! The size of the file, in bytes
+	s32 Size;
+	//! When the file was last modified. The unit depends on the provider: only compare
+	//! times given by the same provider.
+	u32 ModificationTime;
+};
+
 /** An interface for something that can provide files when given a filename 
  (which will include the path). 
  An example of this is a directory on the user's machine.*/
@@ -46,6 +56,66 @@ public:
 	 or for example if a Zip Archive was properly opened.
 	 \return Whether the file provider is 'ready' to provide files. */
 	virtual bool isReady() const = 0;
+
+	/** Returns the number of files the provider can list, so that they can be added to
+	 the index of the FileSystem. Providers that cannot list their files return -1 (the
+	 default), and are asked with contains() whenever a file is looked up. */
+	virtual s32 getEntryCount() const
+	{
+		return -1;
+	}
+
+	/** Returns the full path of a listed file.
+	 \param entry The index of the file, between 0 and getEntryCount(). */
+	virtual const String& getEntryName(s32 entry) const
+	{
+		static const String none;
+		return none;
+	}
+
+	/** Opens a listed file.
+	 \param entry The index of the file, between 0 and getEntryCount().
+	 \param flags The flags to open the file with.
+	 \return A pointer to the file if it could be opened, nullptr otherwise. */
+	virtual IFile * openEntry(s32 entry, u32 flags)
+	{
+		return nullptr;
+	}
+
+	/** Returns the size and modification time of a file, without opening it.
+	 \param filename   The full path of the file.
+	 \param ignoreCase Whether to ignore case when searching for the file.
+	 \param status     Set to the information about the file.
+	 \return true if the file was found and the provider knows about it, false (the
+	         default) otherwise. */
+	virtual bool getFileStat(const String& filename, bool ignoreCase, file_stat_t& status)
+	{
+		return false;
+	}
+
+	/** Returns the size and modification time of a listed file, without opening it.
+	 \param entry  The index of the file, between 0 and getEntryCount().
+	 \param status Set to the information about the file.
+	 \return true if the provider knows about the file, false (the default) otherwise. */
+	virtual bool getEntryStat(s32 entry, file_stat_t& status)
+	{
+		return false;
+	}
+
+	/** Returns a number that identifies the provider. No other provider is given the same
+	 number while the program runs, even once this one has been deleted. */
+	u32 getId() const
+	{
+		return mId;
+	}
+
+protected:
+	/** Constructor. Gives the provider its number. */
+	IFileProvider();
+
+private:
+	u32                 mId;
+	static volatile s32 NextId;
 };
 
 }
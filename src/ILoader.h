@@ -18,6 +18,7 @@ namespace fire_engine
 
 namespace io
 {
+class IFile;
 class IFileProvider;
 }
 
@@ -40,6 +41,36 @@ public:
 	 \param fileProvider A file provider to use first. Useful if loading from within some archive.
 	 \return A pointer to the object created. */
 	virtual Obj * load(const String& filename, io::IFileProvider * fileProvider) const = 0;
+
+	/** Returns the version of the cooked format of the loader, or 0 (the default) if the
+	 loader has none. Loaders that have one can save what they loaded in the CookedCache
+	 with cook(), and load it back with loadCooked() much faster than from the original
+	 file. The version must change whenever the cooked format, or what load() creates,
+	 changes, so that older cooked files are not used. Loaders of different types of object
+	 from the same kind of file must not use the same versions, as the version is part of
+	 the key of a cooked file. */
+	virtual u32 getCookedVersion() const
+	{
+		return 0;
+	}
+
+	/** Writes an object in the cooked format.
+	 \param object The object, created by load().
+	 \param file   The file to write to.
+	 \return true if the object was written, false otherwise. */
+	virtual bool cook(const Obj * object, io::IFile * file) const
+	{
+		return false;
+	}
+
+	/** Creates an object from the cooked format.
+	 \param file The file to read from, which is a mapped file: IFile::getData() gives
+	             access to its content without copying it.
+	 \return A pointer to the object created, or 0 if the file is invalid. */
+	virtual Obj * loadCooked(io::IFile * file) const
+	{
+		return 0;
+	}
 };
 
 }
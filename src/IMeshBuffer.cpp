@@ -6,6 +6,7 @@
 **/
 
 #include "IMeshBuffer.h"
+#include "Vertex3.h"
 #include "Logger.h"
 
 namespace fire_engine
@@ -15,7 +16,7 @@ s32 IMeshBuffer::getPolygonCount() const
 {
 	int polygonCount = 0;
 	int numVertices = getVertexCount();
-	int numIndices = getIndices()->size();
+	int numIndices = getIndices()->getCount();
 	switch (getPolygonType())
 	{
 	case EPT_POINTS:
@@ -52,4 +53,19 @@ s32 IMeshBuffer::getPolygonCount() const
 	return polygonCount;
 }
 
+const VertexFormat& IMeshBuffer::getVertexFormat() const
+{
+	return Vertex3::GetFormat();
+}
+
+const void * IMeshBuffer::getVertexData() const
+{
+	return getVertices();
+}
+
+const Material& IMeshBuffer::getMaterial() const
+{
+	return MaterialRegistry::Get(getMaterialHandle());
+}
+
 }
@@ -14,6 +14,8 @@
 #include "Array.h"
 #include "Object.h"
 #include "aabbox.h"
+#include "MaterialRegistry.h"
+#include "IndexBuffer.h"
 
 namespace fire_engine
 {
@@ -48,6 +50,7 @@ enum EPOLYGON_TYPE
 // Forward declarations
 class ITexture;
 class Vertex3;
+class VertexFormat;
 
 /** A class containing information about some mesh, with a single texture.
  The vertex data contained can represent various polygonal types */
@@ -76,17 +79,31 @@ public:
 	 use the indices obtained via getIndices() */
 	virtual const Vertex3 * getVertices() const = 0;
 
+	/** Returns the layout of the vertices returned by getVertexData(). By default, they
+	 are the Vertex3 objects returned by getVertices(). */
+	virtual const VertexFormat& getVertexFormat() const;
+
+	/** Returns the vertices, laid out as getVertexFormat() describes. A mesh buffer whose
+	 vertices are not Vertex3 objects overrides both. */
+	virtual const void * getVertexData() const;
+
 	/** Get the number of vertices contained within the IMeshBuffer. This will
 	 be a number per frame! If the Model contains more than one frame, then the
 	 total number will be the number of vertices times the number of frames.*/
 	virtual s32 getVertexCount() const = 0;
 
 	/** Get the indices, which can be used to access the vertices, in order
-	 to display proper polygons, as described by the getPolygonType() method */
-	virtual const Array<u32> * getIndices() const = 0;
+	 to display proper polygons, as described by the getPolygonType() method.
+	 They are 16 bits when there are few enough vertices. */
+	virtual const IndexBuffer * getIndices() const = 0;
+
+	/** Returns the handle of the Material that the IMeshBuffer was created with, in the
+	 MaterialRegistry. The IMeshBuffer drops it when it is destroyed, so it must be
+	 grabbed to be kept for longer. */
+	virtual material_handle_t getMaterialHandle() const = 0;
 
 	/** Returns the Material that the IMeshBuffer was created with. */
-	virtual Material getMaterial() const = 0;
+	const Material& getMaterial() const;
 
 	/** Inherited from IRenderable. Render the IMeshBuffer, worrying just about
 	 the vertex data, no Materials or anything. */
@@ -38,9 +38,31 @@ public:
 		return mWorldTransform.applyTransformation(mBoundingBox);
 	}
 
+	/** Inherited from ISpaceNode: the box of a model is the one returned by
+	 getTransformedBoundingVolume(). */
+	virtual bool getNodeBoundingVolume(aabboxf& box) const
+	{
+		box = getTransformedBoundingVolume();
+		return true;
+	}
+
 protected:
 	aabboxf mBoundingBox;
 
+	/** Sets the box of the model, in model coordinates. Derived classes should use this
+	 rather than changing mBoundingBox, so that the boxes of the subtrees above the model
+	 are refit. */
+	void setBoundingVolume(const aabboxf& box)
+	{
+		if (box.getMinPoint() == mBoundingBox.getMinPoint() &&
+			box.getMaxPoint() == mBoundingBox.getMaxPoint())
+		{
+			return;
+		}
+		mBoundingBox = box;
+		invalidateSubtreeBoundingVolume();
+	}
+
 	/** Constructor - made protected so that it can't be accessed directly. */
 	IModel(INode * parent) : ISpaceNode(parent)
 	{
@@ -6,7 +6,6 @@
 **/
 
 #include "INode.h"
-#include "List.h"
 #include <stdio.h>
 
 namespace fire_engine
@@ -15,7 +14,6 @@ namespace fire_engine
 INode::INode(INode * parent)
 	: mParent(0)
 {
-	mChildren = new List<INode*>();
 	this->setParent(parent);
 }
 
@@ -23,35 +21,43 @@ INode::~INode()
 {
 	if (mParent)
 	{
-		mParent->mChildren->removeElement(this);
+		mParent->mChildren.removeElement(this);
+		mParent->childrenChanged();
 		mParent->drop();
 	}
 	this->removeAllChildren();
-	delete mChildren;
 }
 
 void INode::setParent(INode * parent)
 {
 	if (mParent)
 	{
-		mParent->mChildren->removeElement(this);
+		mParent->mChildren.removeElement(this);
+		mParent->childrenChanged();
 		mParent->drop();
 	}
 	mParent = parent;
 	if (mParent)
 	{
-		mParent->mChildren->push_back(this);
+		mParent->mChildren.push_back(this);
+		mParent->childrenChanged();
 		mParent->grab();
 	}
 }
 
+INode * INode::getParent() const
+{
+	return mParent;
+}
+
 bool INode::removeChild(INode * child)
 {
-	if (mChildren->contains(child))
+	if (mChildren.contains(child))
 	{
 		child->mParent = 0;
 		child->drop();
-		mChildren->removeElement(child);
+		mChildren.removeElement(child);
+		this->childrenChanged();
 		this->drop();
 		return true;
 	}
@@ -60,27 +66,30 @@ bool INode::removeChild(INode * child)
 
 void INode::addChild(INode * child)
 {
-	if (!mChildren->contains(child))
+	if (!mChildren.contains(child))
 	{
-		mChildren->push_back(child);
+		mChildren.push_back(child);
 		child->grab();
+		this->childrenChanged();
 	}
 }
 
 bool INode::containsChild(INode * child) const
 {
-	return mChildren->contains(child);
+	return mChildren.contains(child);
 }
 
 void INode::removeAllChildren()
 {
-	for (List<INode*>::iterator it = mChildren->begin(); it != mChildren->end(); it++)
+	// Called first, as dropping the children may release the INode
+	this->childrenChanged();
+	for (ChildArray::iterator it = mChildren.begin(); it != mChildren.end(); ++it)
 	{
-		it->mParent = 0;
-		it->drop();
+		(*it)->mParent = 0;
+		(*it)->drop();
 		this->drop();
 	}
-	mChildren->clear();
+	mChildren.clear();
 }
 
 INode * INode::createAndAddChild()
@@ -90,10 +99,14 @@ INode * INode::createAndAddChild()
 	return child;
 }
 
+void INode::childrenChanged()
+{
+}
+
 void INode::releaseTree()
 {
-	for (List<INode*>::iterator it = mChildren->begin(); it != mChildren->end(); it++)
-		it->releaseTree();
+	for (ChildArray::iterator it = mChildren.begin(); it != mChildren.end(); ++it)
+		(*it)->releaseTree();
 	this->removeAllChildren();
 }
 
@@ -9,7 +9,7 @@
 
 #include "Types.h"
 #include "CompileConfig.h"
-#include "List.h"
+#include "SmallArray.h"
 #include "Object.h"
 
 namespace fire_engine
@@ -28,6 +28,9 @@ public:
 	/** Set the parent for the INode. */
 	void setParent(INode * parent);
 
+	/** Returns the parent of the INode, or 0 if it has none. */
+	INode * getParent() const;
+
 	//! Add a child to the list of children
 	void addChild(INode * child);
 
@@ -50,11 +53,19 @@ public:
 	virtual bool removeChild(INode * child);
 
 protected:
+	/** The children of a node, stored contiguously. Most nodes have very few children,
+	 so these do not need an allocation. */
+	typedef SmallArray<INode*, 4> ChildArray;
+
 	INode *         mParent;
-	List<INode*> *  mChildren;
+	ChildArray      mChildren;
 
 	//! Constructor made private to ensure it stays an interface
 	INode(INode * parent = 0);
+
+	/** Called when a child is added to the INode or removed from it. Does nothing by
+	 default. */
+	virtual void childrenChanged();
 };
 
 }
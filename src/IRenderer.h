@@ -30,6 +30,8 @@ class Material;
 class IndexedTriangle;
 class ITexture;
 class Light;
+class VertexFormat;
+template <class T> class AssetCache;
 class Device;
 
 namespace io
@@ -56,6 +58,16 @@ enum EMATRIX_MODE
 	EMM_MATRIX_MODE_COUNT
 };
 
+/** How lit materials are lit. */
+enum ELIGHTING_MODE
+{
+	/** Each object is lit by the few lights given by setDynamicLights(), by vertex. */
+	ELM_FIXED_FUNCTION = 0x00,
+	/** Each pixel is lit by the lights whose range reaches it, from all the lights given by
+	 setSceneLights(). The lights are sorted into clusters of the view frustum once a frame. */
+	ELM_CLUSTERED
+};
+
 class _FIRE_ENGINE_API_ IRenderer : public virtual Object
 {
 public:
@@ -117,10 +129,27 @@ public:
 	virtual void drawIndexedPrimitiveList(EPOLYGON_TYPE primitiveType,
 		s32 numIndices, const Vertex3 * vertices, const u32 * indices) = 0;
 
-	/** Draws a mesh buffer to the screen. 
+	/** Draw a list of indexed primitives, whose vertices have any layout. The attributes
+	 whose type the renderer does not support are not drawn.
+	 \param primitiveType The type of primitive to draw.
+	 \param numIndices The number of indices in the index buffer.
+	 \param vertices A pointer to the vertex buffer.
+	 \param format The layout of the vertices.
+	 \param indices A pointer to the index buffer.
+	 \param indexType The type of the indices. */
+	virtual void drawIndexedPrimitiveList(EPOLYGON_TYPE primitiveType, s32 numIndices,
+		const void * vertices, const VertexFormat& format, const void * indices,
+		EINDEX_TYPE indexType) = 0;
+
+	/** Draws a mesh buffer to the screen, with its own material.
 	 \param mb A pointer to the IMeshBuffer object to draw. */
 	virtual void drawMeshBuffer(const IMeshBuffer * mb) = 0;
 
+	/** Draws a mesh buffer to the screen, with another material.
+	 \param mb       A pointer to the IMeshBuffer object to draw.
+	 \param material The material to draw it with. */
+	virtual void drawMeshBuffer(const IMeshBuffer * mb, material_handle_t material) = 0;
+
 	/** Returns a screenshot, in R8G8B8 color format. */
 	virtual Image * screenshot(void) const = 0;
 
@@ -130,6 +159,31 @@ public:
 	/** Remove all the dynamic lights from the scene. */
 	virtual void removeAllDynamicLights() = 0;
 
+	/** Sets the lights that light what is drawn next, in place of all the dynamic lights.
+	 Lights that are set already are not set again, so the same lights can be set for
+	 each object at little cost. Lights are only remembered until the end of the scene, as
+	 they may move from one scene to the next.
+	 \param lights The lights, in world space, the most important first.
+	 \param count  The number of lights. Only the first getMaxDynamicLights() are used. */
+	virtual void setDynamicLights(const Light * const * lights, s32 count) = 0;
+
+	/** Returns the number of dynamic lights that can be used at once. */
+	virtual s32 getMaxDynamicLights() const = 0;
+
+	/** Sets all the lights of the scene, once a frame, after the camera. With
+	 ELM_CLUSTERED lighting, this is what lights the scene, and setDynamicLights() does
+	 nothing. With ELM_FIXED_FUNCTION lighting, this does nothing.
+	 \param lights The lights, in world space.
+	 \param count  The number of lights. */
+	virtual void setSceneLights(const Light * const * lights, s32 count) = 0;
+
+	/** Sets how lit materials are lit.
+	 \return Whether the mode is supported. When it is not, the mode does not change. */
+	virtual bool setLightingMode(ELIGHTING_MODE mode) = 0;
+
+	/** Returns how lit materials are lit. */
+	virtual ELIGHTING_MODE getLightingMode() const = 0;
+
 	/** Set an ambient light to the entire scene. */
 	virtual void setAmbientLight(Color32 ambient) = 0;
 
@@ -142,12 +196,27 @@ public:
 	 \param mmode The desired transform. */
 	virtual matrix4f getTransform(EMATRIX_MODE mmode) const = 0;
 
-	/** Sets the material that should be used when rendering. */
+	/** Sets the material that should be used when rendering. It is registered each time,
+	 so materials set often should be registered once and set by their handle. */
 	virtual void setMaterial(const Material& mat) = 0;
 
-	/** Asks the IRenderer to create a texture from a given file. */
+	/** Sets the material that should be used when rendering, from the MaterialRegistry.
+	 Nothing is done when the material is the one used already. */
+	virtual void setMaterial(material_handle_t material) = 0;
+
+	/** Asks the IRenderer to create a texture from a given file. Textures are cached, so
+	 creating a texture from the same file twice returns the same texture.
+	 \return The texture, which the caller must drop, or nullptr. */
 	virtual ITexture * createTexture(const String& filename, io::IFileProvider * fileProvider) const = 0;
 
+	/** Returns the cache of the textures created with createTexture(). */
+	virtual AssetCache<ITexture>& getTextureCache() = 0;
+
+	/** Uploads the textures that were created by worker threads, and could not be uploaded
+	 then. This must be called from the main thread.
+	 \param budget The time to spend, in seconds. */
+	virtual void uploadPendingTextures(f64 budget) = 0;
+
 protected:
 	static IRenderer * mInstance; //! Singleton instance of the IRenderer
 	dimension2i        mViewport; //! The current viewport
@@ -6,6 +6,8 @@
 **/
 
 #include "ISpaceNode.h"
+#include "ViewFrustum.h"
+#include <string.h>
 
 namespace fire_engine
 {
@@ -14,7 +16,8 @@ ISpaceNode::ISpaceNode(INode * parent)
 	: INode(parent), mWorldTransform(matrix4f::IDENTITY_MATRIX),
 	  mRelativeTransform(matrix4f::IDENTITY_MATRIX), mRelativeScale(1.0f, 1.0f, 1.0f),
 	  mRelativePosition(0.0f, 0.0f, 0.0f), mRelativeOrientation(matrix4f::IDENTITY_MATRIX),
-	  m_animator(0), mShowDebugInformation(false), mVisible(true)
+	  m_animator(0), mShowDebugInformation(false), mVisible(true), mSubtreeBoxDirty(true),
+	  mSubtreeBoxEmpty(true)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::ISpaceNode");
@@ -49,8 +52,13 @@ ISpaceNodeAnimator * ISpaceNode::getAnimator()
 
 void ISpaceNode::preRender(f64 time)
 {
+	// Nodes that have not moved keep the box of their subtree
+	const matrix4f previous(mWorldTransform);
 	updateTransforms();
-	for (List<INode*>::iterator it = mChildren->begin(); it != mChildren->end(); it++)
+	if (memcmp(previous.v(), mWorldTransform.v(), 16*sizeof(f32)) != 0)
+		invalidateSubtreeBoundingVolume();
+
+	for (ChildArray::iterator it = mChildren.begin(); it != mChildren.end(); ++it)
 		dynamic_cast<ISpaceNode*>(*it)->preRender(time);
 }
 
@@ -140,4 +148,76 @@ void ISpaceNode::rotate(const matrix4f& rotation)
 	mRelativeOrientation = mRelativeOrientation*rotation;
 }
 
+bool ISpaceNode::getNodeBoundingVolume(aabboxf& box) const
+{
+	return false;
+}
+
+bool ISpaceNode::getSubtreeBoundingVolume(aabboxf& box) const
+{
+	if (mSubtreeBoxDirty)
+	{
+		mSubtreeBoxEmpty = !getNodeBoundingVolume(mSubtreeBox);
+		for (ChildArray::const_iterator it = mChildren.begin(); it != mChildren.end(); ++it)
+		{
+			const ISpaceNode * child = dynamic_cast<const ISpaceNode*>(*it);
+			aabboxf childBox;
+			if (child == 0 || !child->getSubtreeBoundingVolume(childBox))
+				continue;
+			if (mSubtreeBoxEmpty)
+				mSubtreeBox = childBox;
+			else
+				mSubtreeBox.addInternalBoundingBox(childBox);
+			mSubtreeBoxEmpty = false;
+		}
+		mSubtreeBoxDirty = false;
+	}
+	box = mSubtreeBox;
+	return !mSubtreeBoxEmpty;
+}
+
+void ISpaceNode::invalidateSubtreeBoundingVolume()
+{
+	// The nodes above a node already out of date are out of date too
+	ISpaceNode * node = this;
+	while (node != 0 && !node->mSubtreeBoxDirty)
+	{
+		node->mSubtreeBoxDirty = true;
+		node = dynamic_cast<ISpaceNode*>(node->mParent);
+	}
+}
+
+void ISpaceNode::childrenChanged()
+{
+	invalidateSubtreeBoundingVolume();
+}
+
+void ISpaceNode::getVisibleNodes(const ViewFrustum& frustum, Array<ISpaceNode*>& nodes)
+{
+	getVisibleNodes(frustum, nodes, false);
+}
+
+void ISpaceNode::getVisibleNodes(const ViewFrustum& frustum, Array<ISpaceNode*>& nodes, bool inside)
+{
+	aabboxf box;
+	if (!getSubtreeBoundingVolume(box))
+		return;
+	if (!inside)
+	{
+		const EFRUSTUM_INTERSECTION_TYPE result = frustum.calculateIntersection(box);
+		if (result == EFIT_OUTSIDE)
+			return;
+		inside = (result == EFIT_INSIDE);
+	}
+
+	if (getNodeBoundingVolume(box))
+		nodes.push_back(this);
+	for (ChildArray::iterator it = mChildren.begin(); it != mChildren.end(); ++it)
+	{
+		ISpaceNode * child = dynamic_cast<ISpaceNode*>(*it);
+		if (child != 0)
+			child->getVisibleNodes(frustum, nodes, inside);
+	}
+}
+
 }
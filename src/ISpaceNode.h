@@ -13,11 +13,14 @@
 #include "matrix4.h"
 #include "vector3.h"
 #include "IRenderable.h"
+#include "aabbox.h"
+#include "Array.h"
 
 namespace fire_engine
 {
 
 class ISpaceNodeAnimator;
+class ViewFrustum;
 
 /** A class representing a Node in 3-dimensional space, and in a hierarchy.
  With this class, Nodes can be represented hierarchically, with parents and
@@ -101,6 +104,31 @@ public:
 	 a new one. */
 	void rotate(const matrix4f& rotation);
 
+	/** Gets the box of the ISpaceNode alone, in world space. An ISpaceNode has none, but
+	 derived classes with a shape (see IModel) override this.
+	 \param box Where to store the box.
+	 \return Whether the ISpaceNode has a box. */
+	virtual bool getNodeBoundingVolume(aabboxf& box) const;
+
+	/** Gets a box, in world space, that encloses the ISpaceNode and all the nodes below it.
+	 It is only recalculated for the nodes that moved, changed shape or gained or lost
+	 children since it was last asked for, and the nodes above them.
+	 \param box Where to store the box.
+	 \return false if neither the ISpaceNode nor the nodes below it have a box. */
+	bool getSubtreeBoundingVolume(aabboxf& box) const;
+
+	/** Marks the box returned by getSubtreeBoundingVolume() as out of date, along with
+	 those of the nodes above the ISpaceNode. This is done by preRender() when the world
+	 transform changes, and must be done by derived classes when the box returned by
+	 getNodeBoundingVolume() changes otherwise. */
+	void invalidateSubtreeBoundingVolume();
+
+	/** Adds the nodes with a box below the ISpaceNode, and the ISpaceNode itself, to an
+	 array when the box of their subtree is in a frustum, or partly in it. A subtree outside
+	 of the frustum is rejected with a single test, and the nodes of a subtree entirely
+	 inside of it are added without being tested. */
+	void getVisibleNodes(const ViewFrustum& frustum, Array<ISpaceNode*>& nodes);
+
 protected:
 	/** The full transform that the ISpaceNode must undertake. */
 	matrix4f mWorldTransform;
@@ -129,9 +157,23 @@ protected:
 	/** A flag to set if the ISpaceNode is to be rendered. */
 	bool mVisible;
 
+	/** The box of the ISpaceNode and the nodes below it, in world space, when
+	 mSubtreeBoxDirty is false. The nodes above a node whose box is out of date are always
+	 out of date too. */
+	mutable aabboxf mSubtreeBox;
+	mutable bool    mSubtreeBoxDirty;
+	mutable bool    mSubtreeBoxEmpty;
+
 	/** Sets the correct local transform (mLocalTransform), according to the
 	 local scale, the relative position, and the orientation of the ISpaceNode. */
 	virtual void updateTransforms();
+
+	/** Inherited from INode: the box of the subtree is out of date. */
+	virtual void childrenChanged();
+
+	/** See getVisibleNodes(). inside is whether the subtree is known to be entirely in the
+	 frustum. */
+	void getVisibleNodes(const ViewFrustum& frustum, Array<ISpaceNode*>& nodes, bool inside);
 };
 
 }
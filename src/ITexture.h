@@ -21,7 +21,9 @@ namespace fire_engine
 enum ETEXTURE_CREATION_FLAGS
 {
 	ETCF_HAS_MIPMAPS = 0x01,
-	ETCF_AUTO_GENERATE_MIPMAPS = 0x02
+	ETCF_AUTO_GENERATE_MIPMAPS = 0x02,
+	//! The colours of the image are in sRGB: its mipmaps are averaged in linear space
+	ETCF_SRGB = 0x04
 };
 
 class _FIRE_ENGINE_API_ ITexture : public virtual Object
@@ -9,6 +9,7 @@
 #include "Math.h"
 #include "Color.h"
 #include "ColorConverter.h"
+#include "MipmapChain.h"
 #include <String.h>
 
 namespace fire_engine
@@ -135,6 +136,43 @@ void Image::resize_nearest_neighbour(const dimension2i& new_dimension)
 
 void Image::resize_bilinear16(const dimension2i& newdim)
 {
+	// The fields of the pixels are interpolated in place, without shifting them down
+	static const u32 a1r5g5b5_fields[4] = { 0x8000, 0x7C00, 0x03E0, 0x001F };
+	static const u32 r5g6b5_fields[4]   = { 0xF800, 0x07E0, 0x001F, 0x0000 };
+	const u32 * fields = (m_type == EIDT_R5G6B5) ? r5g6b5_fields : a1r5g5b5_fields;
+	// Allocated as bytes, like all image data, so that it is deleted the same way
+	u16 * data = reinterpret_cast<u16 *>(new u8[newdim.getWidth()*newdim.getHeight()*2]);
+	const u16 * original_data = static_cast<const u16 *>(m_data);
+	f32 height_ratio = static_cast<f32>(m_dim.getHeight()) / newdim.getHeight();
+	f32 width_ratio  = static_cast<f32>(m_dim.getWidth()) / newdim.getWidth();
+	for (s32 i = 0; i < newdim.getHeight(); i++)
+	{
+		const s32 texel_h = static_cast<s32>(i*height_ratio);
+		const s32 next_h  = (texel_h < m_dim.getHeight()-1) ? texel_h+1 : texel_h;
+		const f32 u       = i*height_ratio - texel_h;
+		for (s32 j = 0; j < newdim.getWidth(); j++)
+		{
+			const s32 texel_w = static_cast<s32>(j*width_ratio);
+			const s32 next_w  = (texel_w < m_dim.getWidth()-1) ? texel_w+1 : texel_w;
+			const f32 v       = j*width_ratio - texel_w;
+			const u16 p00 = original_data[texel_h*m_dim.getWidth()+texel_w];
+			const u16 p01 = original_data[texel_h*m_dim.getWidth()+next_w];
+			const u16 p10 = original_data[next_h*m_dim.getWidth()+texel_w];
+			const u16 p11 = original_data[next_h*m_dim.getWidth()+next_w];
+			u32 pixel = 0;
+			for (s32 f = 0; f < 4; f++)
+			{
+				const u32 m = fields[f];
+				const f32 value = (1.0f-u)*(1.0f-v)*(p00 & m) + (1.0f-u)*v*(p01 & m) +
+					u*(1.0f-v)*(p10 & m) + u*v*(p11 & m);
+				pixel |= static_cast<u32>(value + 0.5f) & m;
+			}
+			data[i*newdim.getWidth()+j] = static_cast<u16>(pixel);
+		}
+	}
+	delete [] (u8*)m_data;
+	m_data = data;
+	m_dim  = newdim;
 }
 
 void Image::resize_bilinear24_32(const dimension2i& newdim)
@@ -240,17 +278,15 @@ void Image::setTexelSize(void)
 
 Array<Image *> * Image::generateMipmaps() const
 {
-	s32 weakest_link         = (m_dim.getWidth() > m_dim.getHeight()) ?
-		m_dim.getHeight() : m_dim.getWidth(); // the weakest (ie. smallest) dimension
-	s32 num_mipmaps          = 1;
-	Array<Image *> * mipmaps = 0;
-	while ((weakest_link >>= 1) > 0)
-		num_mipmaps++;
-	mipmaps = new Array<Image *>(num_mipmaps);
-	mipmaps->push_back(new Image(*this));
-	for (s32 i = 1; i < num_mipmaps; i++)
-		mipmaps->push_back(mipmaps->at(i-1)->generateNextMipmap());
-	mipmaps->reverse();
+	MipmapChain chain(*this);
+	Array<Image *> * mipmaps = new Array<Image *>(chain.getLevelCount());
+	for (s32 i = 0; i < chain.getLevelCount(); i++)
+	{
+		const dimension2i& dim = chain.getLevelDimension(i);
+		Image * level = new Image(m_type, dim, m_use_alpha_chanel);
+		memcpy(level->data(), chain.getLevelData(i), dim.getWidth()*dim.getHeight()*m_texelsize);
+		mipmaps->push_back(level);
+	}
 	return mipmaps;
 }
 
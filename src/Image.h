@@ -121,9 +121,9 @@ public:
 	void resize(const dimension2i& newdim, EIMAGE_RESIZE_ALGORITHM mode = EIRA_NEAREST_NEIGHBOUR);
 
 	/** Generate the Array of mipmaps for the image. The first element of the
-	 Array will be the original Image, and each subsequent Image will have
-	 both its dimensions divided by two. The last Image will have at least
-	 one of its dimensions equal to 1 */
+	 Array will be a copy of the original Image, and each subsequent Image will have
+	 both its dimensions divided by two (but not below 1). The last Image is 1x1.
+	 Use a MipmapChain to get all the mipmaps in one block of memory instead. */
 	Array<Image *> * generateMipmaps() const;
 
 	bool isPowerOfTwo() const;
@@ -0,0 +1,59 @@
+/**
+ * FILE:    ImageLoader.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the cooked format of images.
+**/
+
+#include "ImageLoader.h"
+#include "Image.h"
+#include "IFile.h"
+
+namespace fire_engine
+{
+
+//! The header of a cooked Image, followed by its pixels
+struct cooked_image_t
+{
+	u32 Type;
+	s32 Width;
+	s32 Height;
+	u32 UseAlphaChanel;
+};
+
+u32 ImageLoader::getCookedVersion() const
+{
+	return 1;
+}
+
+bool ImageLoader::cook(const Image * image, io::IFile * file) const
+{
+	cooked_image_t header;
+	header.Type           = image->type();
+	header.Width          = image->width();
+	header.Height         = image->height();
+	header.UseAlphaChanel = image->useAlphaChanel() ? 1 : 0;
+	return file->write(&header, sizeof(cooked_image_t)) &&
+		file->write(image->data(), header.Width * header.Height * image->getBytesPerPixel());
+}
+
+Image * ImageLoader::loadCooked(io::IFile * file) const
+{
+	cooked_image_t header;
+	if (!file->read(&header, sizeof(cooked_image_t)) || header.Type == Image::EIDT_NONE ||
+		header.Type > Image::EIDT_A8R8G8B8 || header.Width <= 0 || header.Height <= 0)
+	{
+		return 0;
+	}
+
+	Image * image = new Image((Image::EIMAGE_DATA_TYPE)header.Type,
+		dimension2i(header.Width, header.Height), header.UseAlphaChanel != 0);
+	if (!file->read(image->data(), header.Width * header.Height * image->getBytesPerPixel()))
+	{
+		image->drop();
+		return 0;
+	}
+	return image;
+}
+
+} // namespace fire_engine
@@ -0,0 +1,35 @@
+/**
+ * FILE:    ImageLoader.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Base class of the image loaders, which gives them a common cooked format.
+**/
+
+#ifndef IMAGELOADER_H_INCLUDED
+#define IMAGELOADER_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "ILoader.h"
+
+namespace fire_engine
+{
+
+class Image;
+
+/** Base class of the image loaders. Whatever the format of the original file, an Image is
+ cooked as its header followed by its pixels, so that loading it back from the CookedCache
+ is a single copy, with no decompression or palette conversion. */
+class _FIRE_ENGINE_API_ ImageLoader : public ILoader<Image>
+{
+public:
+	virtual u32 getCookedVersion() const;
+
+	virtual bool cook(const Image * image, io::IFile * file) const;
+
+	virtual Image * loadCooked(io::IFile * file) const;
+};
+
+} // namespace fire_engine
+
+#endif // IMAGELOADER_H_INCLUDED
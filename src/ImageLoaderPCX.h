@@ -10,7 +10,7 @@
 
 #include "Types.h"
 #include "CompileConfig.h"
-#include "ILoader.h"
+#include "ImageLoader.h"
 #include "IWriter.h"
 #include "dimension2.h"
 #include <stdio.h>
@@ -27,7 +27,7 @@ class IFile;
 class IFileProvider;
 }
 
-class _FIRE_ENGINE_API_ ImageLoaderPCX : public ILoader<Image>, public IWriter<Image>
+class _FIRE_ENGINE_API_ ImageLoaderPCX : public ImageLoader, public IWriter<Image>
 {
 private:
 #pragma pack(push, 4)
@@ -169,8 +169,8 @@ bool ImageLoaderTGA::write(const String& filename, const Image * image) const
 	}
 
 	// TGA uses BGR, not RGB, so flip the data first
-	for (s32 i = 0; i < size-3; i += 3)
-		ColorConverter::R8G8B8toB8G8R8(&(static_cast<const u8*>(image->data())[i]), &data[i]);
+	ColorConverter::R8G8B8toB8G8R8(static_cast<const u8*>(image->data()), data,
+		image->width()*image->height());
 
 	tga_rle_data_t t = compressRLE(data, 3, image->dim());
 	delete [] data;
@@ -14,7 +14,7 @@
 #include "CompileConfig.h"
 #include "dimension2.h"
 #include "String.h"
-#include "ILoader.h"
+#include "ImageLoader.h"
 #include "IWriter.h"
 
 namespace fire_engine
@@ -37,7 +37,7 @@ class IFileProvider;
  Image * file = tga_loader->load("filename.tga");
  </code>
  It is in little endian format. */
-class _FIRE_ENGINE_API_ ImageLoaderTGA : public ILoader<Image>, public IWriter<Image>
+class _FIRE_ENGINE_API_ ImageLoaderTGA : public ImageLoader, public IWriter<Image>
 {
 private:
 #pragma pack(push, 1) // Structs need to be 1-byte aligned
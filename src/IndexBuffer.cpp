@@ -0,0 +1,94 @@
+/**
+ * FILE:    IndexBuffer.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the IndexBuffer class.
+**/
+
+#include "IndexBuffer.h"
+#include <string.h>
+
+namespace fire_engine
+{
+
+IndexBuffer::IndexBuffer()
+	: mData(0), mCount(0), mType(EIT_16BIT)
+{
+}
+
+IndexBuffer::IndexBuffer(const u32 * indices, s32 count)
+	: mData(0), mCount(0), mType(EIT_16BIT)
+{
+	set(indices, count);
+}
+
+IndexBuffer::IndexBuffer(const void * data, s32 count, EINDEX_TYPE type)
+	: mData(0), mCount(count), mType(type)
+{
+	mData = new u8[getDataSize() > 0 ? getDataSize() : 1];
+	memcpy(mData, data, getDataSize());
+}
+
+IndexBuffer::~IndexBuffer()
+{
+	delete [] static_cast<u8 *>(mData);
+}
+
+void IndexBuffer::set(const u32 * indices, s32 count)
+{
+	u32 largest = 0;
+	for (s32 i = 0; i < count; i++)
+	{
+		if (indices[i] > largest)
+			largest = indices[i];
+	}
+
+	delete [] static_cast<u8 *>(mData);
+	mCount = count;
+	mType  = GetType(largest);
+	mData  = new u8[getDataSize() > 0 ? getDataSize() : 1];
+	if (mType == EIT_16BIT)
+	{
+		u16 * data = static_cast<u16 *>(mData);
+		for (s32 i = 0; i < count; i++)
+			data[i] = (u16)indices[i];
+	}
+	else
+	{
+		u32 * data = static_cast<u32 *>(mData);
+		for (s32 i = 0; i < count; i++)
+			data[i] = indices[i];
+	}
+}
+
+EINDEX_TYPE IndexBuffer::getType() const
+{
+	return mType;
+}
+
+s32 IndexBuffer::getCount() const
+{
+	return mCount;
+}
+
+const void * IndexBuffer::getData() const
+{
+	return mData;
+}
+
+s32 IndexBuffer::getDataSize() const
+{
+	return mCount * GetSize(mType);
+}
+
+EINDEX_TYPE IndexBuffer::GetType(u32 maxIndex)
+{
+	return maxIndex <= 0xFFFF ? EIT_16BIT : EIT_32BIT;
+}
+
+s32 IndexBuffer::GetSize(EINDEX_TYPE type)
+{
+	return type == EIT_16BIT ? sizeof(u16) : sizeof(u32);
+}
+
+} // namespace fire_engine
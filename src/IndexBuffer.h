@@ -0,0 +1,89 @@
+/**
+ * FILE:    IndexBuffer.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Indices of vertices, stored in 16 bits when they are small enough.
+**/
+
+#ifndef INDEXBUFFER_H_INCLUDED
+#define INDEXBUFFER_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+
+namespace fire_engine
+{
+
+/** The size of each index of an IndexBuffer. */
+enum EINDEX_TYPE
+{
+	EIT_16BIT = 0,
+	EIT_32BIT
+};
+
+/** The indices of a mesh buffer. They are given as u32, and stored as u16 when none of
+ them is larger than 0xFFFF, which halves their size for most meshes. */
+class _FIRE_ENGINE_API_ IndexBuffer
+{
+public:
+	/** Constructor. The buffer does not have any index. */
+	IndexBuffer();
+
+	/** Constructor. See set(). */
+	IndexBuffer(const u32 * indices, s32 count);
+
+	/** Constructor, from indices already of a type, as returned by getData().
+	 \param data  The indices.
+	 \param count The number of indices.
+	 \param type  Their type. */
+	IndexBuffer(const void * data, s32 count, EINDEX_TYPE type);
+
+	/** Destructor. */
+	~IndexBuffer();
+
+	/** Sets the indices, in the smallest type they fit in.
+	 \param indices The indices.
+	 \param count   The number of indices. */
+	void set(const u32 * indices, s32 count);
+
+	/** Returns the type of the indices. */
+	EINDEX_TYPE getType() const;
+
+	/** Returns the number of indices. */
+	s32 getCount() const;
+
+	/** Returns an index. */
+	inline u32 at(s32 index) const;
+
+	/** Returns the indices, as an array of u16 or u32 depending on getType(). */
+	const void * getData() const;
+
+	/** Returns the size of the indices, in bytes. */
+	s32 getDataSize() const;
+
+	/** Returns the smallest type that indices up to a value fit in. */
+	static EINDEX_TYPE GetType(u32 maxIndex);
+
+	/** Returns the size of an index of a type, in bytes. */
+	static s32 GetSize(EINDEX_TYPE type);
+
+private:
+	void *      mData;
+	s32         mCount;
+	EINDEX_TYPE mType;
+
+	// Copying is not supported
+	IndexBuffer(const IndexBuffer&);
+	IndexBuffer& operator=(const IndexBuffer&);
+};
+
+inline u32 IndexBuffer::at(s32 index) const
+{
+	if (mType == EIT_16BIT)
+		return static_cast<const u16 *>(mData)[index];
+	return static_cast<const u32 *>(mData)[index];
+}
+
+} // namespace fire_engine
+
+#endif // INDEXBUFFER_H_INCLUDED
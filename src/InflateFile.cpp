@@ -0,0 +1,147 @@
+/**
+ * FILE:    InflateFile.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the InflateFile class.
+**/
+
+#include "InflateFile.h"
+#include "Object.h"
+#include "CRC32.h"
+#include "Logger.h"
+
+namespace fire_engine
+{
+namespace io
+{
+
+InflateFile::InflateFile(const String& name, IFile * source, Object * owner, s32 offset,
+						 s32 compressed_size, s32 uncompressed_size, u32 crc, sys::Mutex * lock)
+	: mOwner(owner), mSize(uncompressed_size), mPosition(0), mExpectedCRC(crc), mCRC(0)
+{
+	Filename     = name;
+	ErrorOccured = false;
+	mInflater    = new Inflater(source, offset, compressed_size, lock);
+	if (mOwner != 0)
+		mOwner->grab();
+}
+
+InflateFile::~InflateFile()
+{
+	close();
+}
+
+bool InflateFile::isOpen() const
+{
+	return mInflater != 0;
+}
+
+bool InflateFile::read(void * out, s32 size)
+{
+	if (mInflater == 0 || size < 0 || mPosition + size > mSize)
+	{
+		ErrorOccured = true;
+		return false;
+	}
+	s32 n = mInflater->inflate(out, size);
+	mCRC = CRC32::Compute(out, n, mCRC);
+	mPosition += n;
+	if (n != size)
+	{
+		Logger::Get()->log(ES_HIGH, "io::InflateFile", "%s: corrupt compressed data",
+			Filename.c_str());
+		ErrorOccured = true;
+		return false;
+	}
+	if (mPosition == mSize && mCRC != mExpectedCRC)
+	{
+		Logger::Get()->log(ES_HIGH, "io::InflateFile", "%s: CRC mismatch", Filename.c_str());
+		ErrorOccured = true;
+		return false;
+	}
+	return true;
+}
+
+bool InflateFile::write(const void * data, s32 size)
+{
+	ErrorOccured = true;
+	return false;
+}
+
+bool InflateFile::skip(s32 count)
+{
+	u8 scratch[4096];
+	while (count > 0)
+	{
+		s32 n = count < (s32)sizeof(scratch) ? count : (s32)sizeof(scratch);
+		if (!read(scratch, n))
+			return false;
+		count -= n;
+	}
+	return true;
+}
+
+bool InflateFile::seek(EFILE_SEEK_POSITION from, s32 offset)
+{
+	if (mInflater == 0)
+		return false;
+	s32 target;
+	switch (from)
+	{
+	case EFSP_START:
+		target = offset;
+		break;
+	case EFSP_CURRENT:
+		target = mPosition + offset;
+		break;
+	case EFSP_END:
+	default:
+		target = mSize - offset;
+		break;
+	}
+	if (target < 0 || target > mSize)
+		return false;
+	if (target < mPosition)
+	{
+		mInflater->reset();
+		mPosition = 0;
+		mCRC      = 0;
+	}
+	return skip(target - mPosition);
+}
+
+s32 InflateFile::getCurrentPosition() const
+{
+	return mPosition;
+}
+
+s32 InflateFile::getSize() const
+{
+	return mSize;
+}
+
+bool InflateFile::remove()
+{
+	ErrorOccured = true;
+	return false;
+}
+
+bool InflateFile::close()
+{
+	delete mInflater;
+	mInflater = 0;
+	if (mOwner != 0)
+	{
+		mOwner->drop();
+		mOwner = 0;
+	}
+	return true;
+}
+
+String InflateFile::toString() const
+{
+	return String("InflateFile[ ") + Filename + ", size = " + mSize + " ]";
+}
+
+} // namespace io
+} // namespace fire_engine
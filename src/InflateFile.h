@@ -0,0 +1,82 @@
+/**
+ * FILE:    InflateFile.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A read-only file whose content is decompressed from DEFLATE data as it is read.
+**/
+
+#ifndef INFLATEFILE_H_INCLUDED
+#define INFLATEFILE_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "IFile.h"
+#include "Inflater.h"
+
+namespace fire_engine
+{
+
+class Object;
+
+namespace io
+{
+
+/** A file that decompresses a deflated region of another file on the fly, each time
+ it is read. It is used for large compressed entries of ZIP archives, so that they never
+ need to be decompressed into memory all at once.
+ Seeking forward decompresses and discards the data in between, and seeking backwards
+ restarts decompression from the start, so the file is best read sequentially.
+ The CRC-32 of the data is checked once the end of the file has been read. */
+class _FIRE_ENGINE_API_ InflateFile : public IFile
+{
+public:
+	/** Constructor.
+	 \param name              The name of the file.
+	 \param source            The file containing the compressed data.
+	 \param owner             An object that owns source. It is grabbed for as long as this
+	                          file exists, so that source stays open. Can be 0.
+	 \param offset            The position of the compressed data in source.
+	 \param compressed_size   The size of the compressed data.
+	 \param uncompressed_size The size of the decompressed data.
+	 \param crc               The expected CRC-32 of the decompressed data.
+	 \param lock              A lock held around each seek and read of source, when
+	                          it is shared with other threads. Can be 0. */
+	InflateFile(const String& name, IFile * source, Object * owner, s32 offset,
+		s32 compressed_size, s32 uncompressed_size, u32 crc, sys::Mutex * lock = 0);
+
+	virtual ~InflateFile();
+
+	virtual bool isOpen() const;
+
+	virtual bool read(void * out, s32 size);
+
+	virtual bool write(const void * data, s32 size);
+
+	virtual bool seek(EFILE_SEEK_POSITION from, s32 offset);
+
+	virtual s32 getCurrentPosition() const;
+
+	virtual s32 getSize() const;
+
+	virtual bool remove();
+
+	virtual bool close();
+
+	virtual String toString() const;
+
+private:
+	Inflater * mInflater;
+	Object *   mOwner;
+	s32        mSize;
+	s32        mPosition;
+	u32        mExpectedCRC;
+	u32        mCRC;
+
+	/** Decompresses and discards count bytes. */
+	bool skip(s32 count);
+};
+
+} // namespace io
+} // namespace fire_engine
+
+#endif // INFLATEFILE_H_INCLUDED
@@ -0,0 +1,388 @@
+/**
+ * FILE:    Inflater.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the Inflater class.
+**/
+
+#include "Inflater.h"
+#include "IFile.h"
+#include "Mutex.h"
+#include <String.h>
+
+namespace fire_engine
+{
+namespace io
+{
+
+//! Base lengths for length symbols 257..285
+static const u16 LENGTH_BASE[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+
+//! Extra bits for length symbols 257..285
+static const u8 LENGTH_EXTRA[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+//! Base distances for distance symbols 0..29
+static const u16 DISTANCE_BASE[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+
+//! Extra bits for distance symbols 0..29
+static const u8 DISTANCE_EXTRA[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+//! The order in which code length code lengths are stored
+static const u8 CODE_LENGTH_ORDER[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+//! Reverses the lowest bits bits of code
+static inline u32 reverseBits(u32 code, s32 bits)
+{
+	code = ((code & 0xAAAA) >> 1) | ((code & 0x5555) << 1);
+	code = ((code & 0xCCCC) >> 2) | ((code & 0x3333) << 2);
+	code = ((code & 0xF0F0) >> 4) | ((code & 0x0F0F) << 4);
+	code = ((code & 0xFF00) >> 8) | ((code & 0x00FF) << 8);
+	return code >> (16 - bits);
+}
+
+bool Inflater::huffman_t::build(const u8 * lengths, s32 count)
+{
+	s32 sizes[17];
+	s32 next_code[16];
+	memset(sizes, 0, sizeof(sizes));
+	memset(Fast, 0, sizeof(Fast));
+	for (s32 i = 0; i < count; i++)
+		sizes[lengths[i]]++;
+	sizes[0] = 0;
+	for (s32 i = 1; i < 16; i++)
+		if (sizes[i] > (1 << i))
+			return false;
+
+	s32 code   = 0;
+	s32 symbol = 0;
+	for (s32 i = 1; i < 16; i++)
+	{
+		next_code[i]   = code;
+		FirstCode[i]   = (u16)code;
+		FirstSymbol[i] = (u16)symbol;
+		code = code + sizes[i];
+		if (sizes[i] != 0 && code - 1 >= (1 << i))
+			return false; // over-subscribed
+		MaxCode[i] = code << (16 - i);
+		code   <<= 1;
+		symbol  += sizes[i];
+	}
+	MaxCode[16] = 0x10000;
+
+	for (s32 i = 0; i < count; i++)
+	{
+		s32 s = lengths[i];
+		if (s == 0)
+			continue;
+		s32 c = next_code[s] - FirstCode[s] + FirstSymbol[s];
+		Symbol[c] = (u16)i;
+		if (s <= FAST_BITS)
+		{
+			// Deflate codes are stored starting with their most significant bit, so the
+			// table is indexed by the reversed code, for every value of the unused bits
+			u16 entry = (u16)((s << 9) | i);
+			for (u32 j = reverseBits(next_code[s], s); j < (1 << FAST_BITS); j += (1 << s))
+				Fast[j] = entry;
+		}
+		next_code[s]++;
+	}
+	return true;
+}
+
+Inflater::Inflater(IFile * source, s32 offset, s32 size, sys::Mutex * lock)
+	: mSource(source), mSourceLock(lock), mSourceOffset(offset), mSourceSize(size)
+{
+	mInput  = new u8[INPUT_SIZE];
+	mWindow = new u8[WINDOW_SIZE];
+	reset();
+}
+
+Inflater::~Inflater()
+{
+	delete [] mInput;
+	delete [] mWindow;
+}
+
+void Inflater::reset()
+{
+	mSourceRead   = 0;
+	mInputPos     = 0;
+	mInputSize    = 0;
+	mOverrun      = 0;
+	mBitBuffer    = 0;
+	mBitCount     = 0;
+	mState        = EIS_BLOCK_HEADER;
+	mLastBlock    = false;
+	mStoredLeft   = 0;
+	mCopyLength   = 0;
+	mCopyDistance = 0;
+	mWindowPos    = 0;
+}
+
+inline u32 Inflater::nextByte()
+{
+	if (mInputPos == mInputSize)
+	{
+		s32 size = mSourceSize - mSourceRead;
+		if (size > INPUT_SIZE)
+			size = INPUT_SIZE;
+		bool ok = size > 0;
+		if (ok)
+		{
+			if (mSourceLock != 0)
+				mSourceLock->lock();
+			ok = mSource->seek(EFSP_START, mSourceOffset + mSourceRead) &&
+				mSource->read(mInput, size);
+			if (mSourceLock != 0)
+				mSourceLock->unlock();
+		}
+		if (!ok)
+		{
+			// The bit buffer reads a few bytes ahead, so running out is only an error
+			// if those bytes end up being used
+			mOverrun++;
+			return 0;
+		}
+		mSourceRead += size;
+		mInputSize   = size;
+		mInputPos    = 0;
+	}
+	return mInput[mInputPos++];
+}
+
+s32 Inflater::decode(const huffman_t& h)
+{
+	if (mBitCount < 16)
+		fillBits();
+	u32 entry = h.Fast[mBitBuffer & ((1 << FAST_BITS) - 1)];
+	if (entry != 0)
+	{
+		s32 s = entry >> 9;
+		mBitBuffer >>= s;
+		mBitCount   -= s;
+		return entry & 511;
+	}
+
+	// Slow path: codes are compared left-justified, so reverse the next 16 bits
+	s32 k = reverseBits(mBitBuffer & 0xFFFF, 16);
+	s32 s;
+	for (s = FAST_BITS + 1; s < 16; s++)
+		if (k < h.MaxCode[s])
+			break;
+	if (s == 16)
+		return -1;
+	s32 c = (k >> (16 - s)) - h.FirstCode[s] + h.FirstSymbol[s];
+	if (c >= 288)
+		return -1;
+	mBitBuffer >>= s;
+	mBitCount   -= s;
+	return h.Symbol[c];
+}
+
+bool Inflater::buildFixedTables()
+{
+	u8 lengths[288];
+	s32 i = 0;
+	for (; i < 144; i++) lengths[i] = 8;
+	for (; i < 256; i++) lengths[i] = 9;
+	for (; i < 280; i++) lengths[i] = 7;
+	for (; i < 288; i++) lengths[i] = 8;
+	if (!mLiterals.build(lengths, 288))
+		return false;
+	for (i = 0; i < 30; i++)
+		lengths[i] = 5;
+	return mDistances.build(lengths, 30);
+}
+
+bool Inflater::readDynamicTables()
+{
+	u8 lengths[286+32];
+	u8 code_lengths[19];
+	s32 hlit  = getBits(5) + 257;
+	s32 hdist = getBits(5) + 1;
+	s32 hclen = getBits(4) + 4;
+	if (hlit > 286 || hdist > 30)
+		return false;
+
+	memset(code_lengths, 0, sizeof(code_lengths));
+	for (s32 i = 0; i < hclen; i++)
+		code_lengths[CODE_LENGTH_ORDER[i]] = (u8)getBits(3);
+	huffman_t code_length_code;
+	if (!code_length_code.build(code_lengths, 19))
+		return false;
+
+	s32 n = 0;
+	while (n < hlit + hdist)
+	{
+		s32 sym = decode(code_length_code);
+		if (sym < 0)
+			return false;
+		if (sym < 16)
+		{
+			lengths[n++] = (u8)sym;
+			continue;
+		}
+		u8 fill = 0;
+		s32 repeat;
+		if (sym == 16)
+		{
+			if (n == 0)
+				return false;
+			fill   = lengths[n-1];
+			repeat = getBits(2) + 3;
+		}
+		else if (sym == 17)
+			repeat = getBits(3) + 3;
+		else
+			repeat = getBits(7) + 11;
+		if (n + repeat > hlit + hdist)
+			return false;
+		memset(&lengths[n], fill, repeat);
+		n += repeat;
+	}
+	if (lengths[256] == 0)
+		return false; // no end of block code
+	return mLiterals.build(lengths, hlit) && mDistances.build(&lengths[hlit], hdist);
+}
+
+bool Inflater::readBlockHeader()
+{
+	mLastBlock = getBits(1) != 0;
+	switch (getBits(2))
+	{
+	case 0:
+		{
+			// Stored block: skip to the next byte boundary, then read LEN and NLEN
+			getBits(mBitCount & 7);
+			u32 len  = getBits(16);
+			u32 nlen = getBits(16);
+			if ((len ^ 0xFFFF) != nlen)
+				return false;
+			mStoredLeft = len;
+			mState      = EIS_STORED;
+		}
+		return true;
+	case 1:
+		mState = EIS_HUFFMAN;
+		return buildFixedTables();
+	case 2:
+		mState = EIS_HUFFMAN;
+		return readDynamicTables();
+	default:
+		return false;
+	}
+}
+
+s32 Inflater::inflate(void * out, s32 size)
+{
+	u8 * dst      = (u8 *)out;
+	s32  produced = 0;
+
+	while (produced < size)
+	{
+		if (mState == EIS_ERROR)
+			return produced;
+
+		// Finish any back-reference that did not fit in the previous call
+		if (mCopyLength > 0)
+		{
+			s32 n = size - produced;
+			if (n > mCopyLength)
+				n = mCopyLength;
+			mCopyLength -= n;
+			while (n-- > 0)
+			{
+				u8 c = mWindow[(mWindowPos - mCopyDistance) & (WINDOW_SIZE - 1)];
+				mWindow[mWindowPos++ & (WINDOW_SIZE - 1)] = c;
+				dst[produced++] = c;
+			}
+			continue;
+		}
+
+		switch (mState)
+		{
+		case EIS_BLOCK_HEADER:
+			if (mLastBlock)
+				mState = EIS_DONE;
+			else if (!readBlockHeader())
+				mState = EIS_ERROR;
+			break;
+
+		case EIS_STORED:
+			while (mStoredLeft > 0 && produced < size)
+			{
+				u8 c = (u8)getBits(8);
+				mWindow[mWindowPos++ & (WINDOW_SIZE - 1)] = c;
+				dst[produced++] = c;
+				mStoredLeft--;
+			}
+			if (mStoredLeft == 0)
+				mState = EIS_BLOCK_HEADER;
+			break;
+
+		case EIS_HUFFMAN:
+			{
+				s32 sym = decode(mLiterals);
+				if (sym < 256)
+				{
+					if (sym < 0)
+					{
+						mState = EIS_ERROR;
+						break;
+					}
+					mWindow[mWindowPos++ & (WINDOW_SIZE - 1)] = (u8)sym;
+					dst[produced++] = (u8)sym;
+				}
+				else if (sym == 256)
+					mState = EIS_BLOCK_HEADER;
+				else
+				{
+					sym -= 257;
+					if (sym >= 29)
+					{
+						mState = EIS_ERROR;
+						break;
+					}
+					s32 length = LENGTH_BASE[sym] + getBits(LENGTH_EXTRA[sym]);
+					sym = decode(mDistances);
+					if (sym < 0 || sym >= 30)
+					{
+						mState = EIS_ERROR;
+						break;
+					}
+					s32 distance = DISTANCE_BASE[sym] + getBits(DISTANCE_EXTRA[sym]);
+					if ((u32)distance > mWindowPos)
+					{
+						mState = EIS_ERROR;
+						break;
+					}
+					// Only a valid back-reference is left pending
+					mCopyLength   = length;
+					mCopyDistance = distance;
+				}
+			}
+			break;
+
+		case EIS_DONE:
+		case EIS_ERROR:
+			return produced;
+		}
+
+		// Only a few bytes of look-ahead may be read past the end of the data
+		if (mOverrun > 4)
+			mState = EIS_ERROR;
+	}
+	return produced;
+}
+
+} // namespace io
+} // namespace fire_engine
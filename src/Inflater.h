@@ -0,0 +1,153 @@
+/**
+ * FILE:    Inflater.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A streaming decompressor for DEFLATE (RFC 1951) data, as found in ZIP archives.
+**/
+
+#ifndef INFLATER_H_INCLUDED
+#define INFLATER_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+
+namespace fire_engine
+{
+namespace sys
+{
+class Mutex;
+}
+
+namespace io
+{
+
+class IFile;
+
+/** Decompresses raw DEFLATE data read from a region of an IFile. The data is
+ decompressed on demand, as much as is asked for by each call to inflate(), so an entry
+ never needs to be held in memory in its entirety. Only the last 32k of output are kept,
+ as required for back-references.
+ Huffman codes of up to FAST_BITS bits are decoded with a single table lookup; longer
+ codes, which are rare, fall back to a canonical decode. */
+class _FIRE_ENGINE_API_ Inflater
+{
+public:
+	/** Constructor.
+	 \param source The file to read the compressed data from. It is not owned by the
+	               Inflater, and is seeked before every read, so it can be shared.
+	 \param offset The position of the compressed data in source.
+	 \param size   The size in bytes of the compressed data.
+	 \param lock   A lock held around each seek and read of source, when it is shared
+	               with other threads. Can be 0. */
+	Inflater(IFile * source, s32 offset, s32 size, sys::Mutex * lock = 0);
+
+	/** Destructor. */
+	~Inflater();
+
+	/** Decompresses up to size bytes into out.
+	 \return The number of bytes written to out. It is smaller than size only once the end
+	         of the data has been reached, or if an error occurred. */
+	s32 inflate(void * out, s32 size);
+
+	/** Restarts decompression from the start of the compressed data. */
+	void reset();
+
+	/** Returns whether the end of the compressed data has been reached. */
+	inline bool isFinished() const
+	{
+		return mState == EIS_DONE;
+	}
+
+	/** Returns whether the compressed data was found to be corrupt. */
+	inline bool failed() const
+	{
+		return mState == EIS_ERROR;
+	}
+
+private:
+	enum { FAST_BITS = 9, WINDOW_SIZE = 32768, INPUT_SIZE = 4096 };
+
+	//! A Huffman code, with a lookup table for the short codes
+	struct huffman_t
+	{
+		//! (length << 9) | symbol for codes of FAST_BITS bits or less, 0 otherwise
+		u16 Fast[1 << FAST_BITS];
+		u16 FirstCode[16];
+		u16 FirstSymbol[16];
+		//! The first (left-justified, 16 bit) code that is longer than each length
+		s32 MaxCode[17];
+		u16 Symbol[288];
+
+		bool build(const u8 * lengths, s32 count);
+	};
+
+	enum EINFLATE_STATE
+	{
+		EIS_BLOCK_HEADER,
+		EIS_STORED,
+		EIS_HUFFMAN,
+		EIS_DONE,
+		EIS_ERROR
+	};
+
+	IFile *        mSource;
+	sys::Mutex *   mSourceLock;
+	s32            mSourceOffset;
+	s32            mSourceSize;
+	s32            mSourceRead;
+
+	u8 *           mInput;
+	s32            mInputPos;
+	s32            mInputSize;
+	s32            mOverrun;
+
+	u32            mBitBuffer;
+	s32            mBitCount;
+
+	EINFLATE_STATE mState;
+	bool           mLastBlock;
+	s32            mStoredLeft;
+	s32            mCopyLength;
+	s32            mCopyDistance;
+
+	huffman_t      mLiterals;
+	huffman_t      mDistances;
+
+	u8 *           mWindow;
+	//! The number of bytes output so far; the window position is this modulo WINDOW_SIZE
+	u32            mWindowPos;
+
+	inline u32 nextByte();
+
+	inline void fillBits()
+	{
+		while (mBitCount <= 24)
+		{
+			mBitBuffer |= nextByte() << mBitCount;
+			mBitCount += 8;
+		}
+	}
+
+	inline u32 getBits(s32 n)
+	{
+		if (mBitCount < n)
+			fillBits();
+		u32 bits = mBitBuffer & ((1 << n) - 1);
+		mBitBuffer >>= n;
+		mBitCount -= n;
+		return bits;
+	}
+
+	s32 decode(const huffman_t& h);
+
+	bool readBlockHeader();
+
+	bool readDynamicTables();
+
+	bool buildFixedTables();
+};
+
+} // namespace io
+} // namespace fire_engine
+
+#endif // INFLATER_H_INCLUDED
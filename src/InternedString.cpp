@@ -0,0 +1,91 @@
+/**
+ * FILE:    InternedString.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the InternedString class, and of the pool of interned strings.
+**/
+
+#include "InternedString.h"
+#include "HashTable.h"
+#include "Mutex.h"
+
+namespace fire_engine
+{
+
+struct InternedString::interned_entry_t
+{
+	String Str;
+	u32    Hash;
+};
+
+/** All the interned strings, created on first use. */
+static HashTable<String, const InternedString::interned_entry_t *> * s_pool = 0;
+
+/** Held while the pool is used, so that strings can be interned from several threads. */
+static sys::Mutex s_pool_lock;
+
+/** The String returned for the empty InternedString. */
+static const String s_empty;
+
+InternedString::InternedString()
+	: mEntry(0)
+{
+}
+
+InternedString::InternedString(const String& str)
+	: mEntry(Intern(str))
+{
+}
+
+InternedString::InternedString(const c8 * str)
+	: mEntry(Intern(String(str)))
+{
+}
+
+const String& InternedString::getString() const
+{
+	return mEntry != 0 ? mEntry->Str : s_empty;
+}
+
+u32 InternedString::getHash() const
+{
+	return mEntry != 0 ? mEntry->Hash : Hash<String>::hash_function(s_empty);
+}
+
+bool InternedString::Find(const String& str, InternedString& result)
+{
+	if (str.length() == 0)
+	{
+		result.mEntry = 0;
+		return true;
+	}
+	sys::MutexLock lock(s_pool_lock);
+	if (s_pool == 0)
+		return false;
+	const interned_entry_t ** entry = s_pool->find(str);
+	if (entry == 0)
+		return false;
+	result.mEntry = *entry;
+	return true;
+}
+
+const InternedString::interned_entry_t * InternedString::Intern(const String& str)
+{
+	if (str.length() == 0)
+		return 0;
+	sys::MutexLock lock(s_pool_lock);
+	if (s_pool == 0)
+		s_pool = new HashTable<String, const interned_entry_t *>(1024);
+
+	const interned_entry_t ** found = s_pool->find(str);
+	if (found != 0)
+		return *found;
+
+	interned_entry_t * entry = new interned_entry_t;
+	entry->Str  = str;
+	entry->Hash = Hash<String>::hash_function(str);
+	s_pool->insert(str, entry);
+	return entry;
+}
+
+} // namespace fire_engine
@@ -0,0 +1,81 @@
+/**
+ * FILE:    InternedString.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: An immutable String that is stored only once, so that equality tests reduce
+ *          to a pointer comparison and the hash is computed once.
+**/
+
+#ifndef INTERNEDSTRING_H_INCLUDED
+#define INTERNEDSTRING_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "String.h"
+
+namespace fire_engine
+{
+
+/** An InternedString refers to a single shared copy of some String. Every InternedString
+ created from equal strings refers to the same copy, so comparing two of them is a single
+ pointer comparison, and copying one never allocates. The hash of the String is computed
+ once when it is first interned.
+ Use it for names that are compared or looked up often, such as asset names and tag
+ names. Interned strings are never freed, and strings can be interned from several
+ threads at once. */
+class _FIRE_ENGINE_API_ InternedString
+{
+public:
+	/** Default constructor: the empty string. */
+	InternedString();
+
+	/** Intern a String. */
+	InternedString(const String& str);
+
+	/** Intern a null-terminated sequence of characters. */
+	InternedString(const c8 * str);
+
+	/** Returns the interned String. */
+	const String& getString() const;
+
+	/** Returns a pointer to the characters of the interned String. */
+	inline const c8 * c_str() const
+	{
+		return getString().c_str();
+	}
+
+	/** Returns the hash of the interned String, as computed by Hash<String>. */
+	u32 getHash() const;
+
+	/** Returns whether two interned strings are identical. */
+	inline bool operator==(const InternedString& other) const
+	{
+		return mEntry == other.mEntry;
+	}
+
+	/** Returns whether two interned strings are different. */
+	inline bool operator!=(const InternedString& other) const
+	{
+		return mEntry != other.mEntry;
+	}
+
+	/** Returns whether a String has already been interned, without interning it.
+	 \param str    The String to look for.
+	 \param result Set to the InternedString for str if it was found.
+	 \return       true if str has already been interned. */
+	static bool Find(const String& str, InternedString& result);
+
+	/** The shared storage for an interned String, defined in InternedString.cpp. */
+	struct interned_entry_t;
+
+private:
+	//! The shared entry, or 0 for the empty string
+	const interned_entry_t * mEntry;
+
+	/** Returns the entry for str, creating it if it doesn't exist. */
+	static const interned_entry_t * Intern(const String& str);
+};
+
+} // namespace fire_engine
+
+#endif // INTERNEDSTRING_H_INCLUDED
@@ -13,7 +13,7 @@ namespace fire_engine
 Light::Light(ELIGHT_TYPE type, vector3f position, vector3f direction, Color32 ambient,
 	Color32 diffuse, Color32 specular, f32 radiusDegrees)
 	: m_ltype(type), m_position(position), m_direction(direction), m_ambient(ambient),
-	  m_diffuse(diffuse), m_specular(specular), mRadiusDegrees(radiusDegrees)
+	  m_diffuse(diffuse), m_specular(specular), mRadiusDegrees(radiusDegrees), mRange(0.0f)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::Light");
@@ -22,7 +22,7 @@ Light::Light(ELIGHT_TYPE type, vector3f position, vector3f direction, Color32 am
 
 Light::Light(ELIGHT_TYPE type, vector3f direction, Color32 ambient, Color32 diffuse, Color32 specular)
 	: m_ltype(type), m_position(0.0f, 0.0f, 0.0f), m_direction(direction), m_ambient(ambient),
-	  m_diffuse(diffuse), m_specular(specular), mRadiusDegrees(0.0f)
+	  m_diffuse(diffuse), m_specular(specular), mRadiusDegrees(0.0f), mRange(0.0f)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::Light");
@@ -62,6 +62,8 @@ Light& Light::operator=(const Light& rhs)
 	m_specular  = rhs.getSpecular();
 	m_position  = rhs.getPosition();
 	m_direction = rhs.getDirection();
+	mRadiusDegrees = rhs.getRadius();
+	mRange         = rhs.getRange();
 	return *this;
 }
 
@@ -19,6 +19,10 @@ namespace fire_engine
 
 class IRenderer;
 
+/** How much a Light with a range has faded at its range: its intensity is divided by
+ 1+LIGHT_RANGE_ATTENUATION*(distance/range)^2. */
+#define LIGHT_RANGE_ATTENUATION 24.0f
+
 enum ELIGHT_TYPE
 {
 	/** ELT_DIRECTIONAL represents a light where all the components come from
@@ -74,6 +78,14 @@ public:
 
 	inline void setRadius(f32 radiusDegrees);
 
+	/** Returns the distance the Light reaches, or 0 if it reaches everywhere. */
+	inline f32 getRange() const;
+
+	/** Sets the distance that a point Light reaches. The Light fades with the square of the
+	 distance, down to a 25th of its intensity at its range, and nothing further away is lit
+	 by it. A range of 0, the default, makes the Light reach everywhere without fading. */
+	inline void setRange(f32 range);
+
 	/** Sets the type of Light contained. */
 	inline void setType(ELIGHT_TYPE type);
 
@@ -111,6 +123,7 @@ private:
 	Color32     m_diffuse;
 	Color32     m_specular;
 	f32         mRadiusDegrees;
+	f32         mRange;
 
 };
 
@@ -184,6 +197,16 @@ inline void Light::setRadius(f32 radiusDegrees)
 	mRadiusDegrees = radiusDegrees;
 }
 
+inline f32 Light::getRange() const
+{
+	return mRange;
+}
+
+inline void Light::setRange(f32 range)
+{
+	mRange = range;
+}
+
 }
 
 #endif // LIGHT_H_INCLUDED
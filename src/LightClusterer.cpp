@@ -0,0 +1,257 @@
+/**
+ * FILE:    LightClusterer.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the LightClusterer class.
+**/
+
+#include "LightClusterer.h"
+#include "Light.h"
+#include "CPUInfo.h"
+#include "Math.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef _FIRE_ENGINE_SSE_
+#	include <emmintrin.h>
+#endif
+
+namespace fire_engine
+{
+
+LightClusterer::LightClusterer()
+	: mNear(1.0f), mFar(1000.0f), mSliceScale(0.0f), mLightCount(0), mLightIndexCount(0)
+{
+	memset(mColumnX, 0, sizeof(mColumnX));
+	memset(mColumnZ, 0, sizeof(mColumnZ));
+	memset(mRowY, 0, sizeof(mRowY));
+	memset(mRowZ, 0, sizeof(mRowZ));
+	memset(mClusters, 0, sizeof(mClusters));
+}
+
+void LightClusterer::build(const matrix4f& view, const matrix4f& projection,
+	const Light * const * lights, s32 count)
+{
+	setupFrustum(projection);
+
+	// Which clusters each light touches
+	f32 columns[CLUSTERS_X+4];
+	f32 rows[CLUSTERS_Y+4];
+	mLightCount = 0;
+	for (s32 i = 0; i < count && mLightCount < MAX_LIGHTS; i++)
+	{
+		const Light * light = lights[i];
+		const f32     range = light->getRange();
+		if (light->getType() != ELT_POINT || range <= 0.0f)
+			continue;
+
+		const vector3f centre = view.applyTransformation(light->getPosition());
+		const f32 depth = -centre.getZ();
+		if (depth + range < mNear || depth - range > mFar)
+			continue;
+
+		light_bounds_t& bounds = mBounds[mLightCount];
+		GetPlaneDistances(mColumnX, mColumnZ, CLUSTERS_X+1, centre.getX(), centre.getZ(), columns);
+		GetPlaneDistances(mRowY, mRowZ, CLUSTERS_Y+1, centre.getY(), centre.getZ(), rows);
+		if (!GetTileRange(columns, CLUSTERS_X, range, bounds.X0, bounds.X1) ||
+			!GetTileRange(rows, CLUSTERS_Y, range, bounds.Y0, bounds.Y1))
+		{
+			continue;
+		}
+		bounds.Z0 = getSlice(depth - range);
+		bounds.Z1 = getSlice(depth + range);
+
+		clustered_light_t& clustered = mLights[mLightCount++];
+		clustered.Position[0] = centre.getX();
+		clustered.Position[1] = centre.getY();
+		clustered.Position[2] = centre.getZ();
+		clustered.Position[3] = range;
+		memcpy(clustered.Ambient, light->getAmbient().v(), 4*sizeof(f32));
+		memcpy(clustered.Diffuse, light->getDiffuse().v(), 4*sizeof(f32));
+		memcpy(clustered.Specular, light->getSpecular().v(), 4*sizeof(f32));
+
+		// The cone of spot lights, as the fixed function pipeline lights them
+		if (light->getRadius() < 180.0f)
+		{
+			vector3f direction = view.applyTransformation(light->getDirection()) -
+				view.applyTransformation(vector3f(0.0f, 0.0f, 0.0f));
+			if (direction.length() > 0.0f)
+				direction.normalize();
+			clustered.Spot[0] = direction.getX();
+			clustered.Spot[1] = direction.getY();
+			clustered.Spot[2] = direction.getZ();
+			clustered.Spot[3] = cosf(light->getRadius() * Math32::TO_RAD);
+		}
+		else
+		{
+			clustered.Spot[0] = clustered.Spot[1] = clustered.Spot[2] = 0.0f;
+			clustered.Spot[3] = -2.0f;
+		}
+	}
+
+	// Count the lights of each cluster, then give each cluster its part of the indices
+	memset(mCursors, 0, sizeof(mCursors));
+	for (s32 i = 0; i < mLightCount; i++)
+	{
+		const light_bounds_t& bounds = mBounds[i];
+		for (s32 z = bounds.Z0; z <= bounds.Z1; z++)
+			for (s32 y = bounds.Y0; y <= bounds.Y1; y++)
+				for (s32 x = bounds.X0; x <= bounds.X1; x++)
+					mCursors[(z*CLUSTERS_Y + y)*CLUSTERS_X + x]++;
+	}
+	s32 offset = 0;
+	for (s32 c = 0; c < CLUSTER_COUNT; c++)
+	{
+		// When there are too many, the last clusters lose lights
+		s32 lights = mCursors[c];
+		if (offset + lights > MAX_LIGHT_INDICES)
+			lights = MAX_LIGHT_INDICES - offset;
+		mClusters[4*c]   = (f32)offset;
+		mClusters[4*c+1] = (f32)lights;
+		mCursors[c]      = offset;
+		offset += lights;
+	}
+	mLightIndexCount = offset;
+
+	for (s32 i = 0; i < mLightCount; i++)
+	{
+		const light_bounds_t& bounds = mBounds[i];
+		for (s32 z = bounds.Z0; z <= bounds.Z1; z++)
+		{
+			for (s32 y = bounds.Y0; y <= bounds.Y1; y++)
+			{
+				for (s32 x = bounds.X0; x <= bounds.X1; x++)
+				{
+					const s32 c = (z*CLUSTERS_Y + y)*CLUSTERS_X + x;
+					if (mCursors[c] < (s32)(mClusters[4*c] + mClusters[4*c+1]))
+						mLightIndices[mCursors[c]++] = (f32)i;
+				}
+			}
+		}
+	}
+}
+
+s32 LightClusterer::getLightCount() const
+{
+	return mLightCount;
+}
+
+const LightClusterer::clustered_light_t * LightClusterer::getLights() const
+{
+	return mLights;
+}
+
+const f32 * LightClusterer::getClusters() const
+{
+	return mClusters;
+}
+
+s32 LightClusterer::getLightIndexCount() const
+{
+	return mLightIndexCount;
+}
+
+const f32 * LightClusterer::getLightIndices() const
+{
+	return mLightIndices;
+}
+
+f32 LightClusterer::getNear() const
+{
+	return mNear;
+}
+
+f32 LightClusterer::getFar() const
+{
+	return mFar;
+}
+
+s32 LightClusterer::getSlice(f32 depth) const
+{
+	if (depth <= mNear)
+		return 0;
+	const s32 slice = (s32)(logf(depth / mNear) * mSliceScale);
+	return slice < CLUSTERS_Z ? slice : CLUSTERS_Z - 1;
+}
+
+void LightClusterer::setupFrustum(const matrix4f& projection)
+{
+	// For a perspective projection, (2,2) is (f+n)/(n-f) and (2,3) is 2fn/(n-f)
+	mNear = projection(2, 3) / (projection(2, 2) - 1.0f);
+	mFar  = projection(2, 3) / (projection(2, 2) + 1.0f);
+	mSliceScale = CLUSTERS_Z / logf(mFar / mNear);
+
+	// A point at x and z (z < 0) is right of the boundary at b in normalised device
+	// coordinates when (0,0)*x + ((0,2)+b)*z >= 0
+	for (s32 i = 0; i <= CLUSTERS_X; i++)
+	{
+		const f32 b  = -1.0f + 2.0f * i / CLUSTERS_X;
+		const f32 nx = projection(0, 0);
+		const f32 nz = projection(0, 2) + b;
+		const f32 inv = 1.0f / Math32::Sqrt(nx*nx + nz*nz);
+		mColumnX[i] = nx * inv;
+		mColumnZ[i] = nz * inv;
+	}
+	for (s32 i = 0; i <= CLUSTERS_Y; i++)
+	{
+		const f32 b  = -1.0f + 2.0f * i / CLUSTERS_Y;
+		const f32 ny = projection(1, 1);
+		const f32 nz = projection(1, 2) + b;
+		const f32 inv = 1.0f / Math32::Sqrt(ny*ny + nz*nz);
+		mRowY[i] = ny * inv;
+		mRowZ[i] = nz * inv;
+	}
+}
+
+bool LightClusterer::GetTileRange(const f32 * distances, s32 count, f32 radius, s32& first, s32& last)
+{
+	// Tile i is between the planes i and i+1: the sphere touches it when it is not
+	// entirely left of plane i, nor entirely right of plane i+1
+	first = -1;
+	last  = -1;
+	for (s32 i = 0; i < count; i++)
+	{
+		if (distances[i] >= -radius && distances[i+1] <= radius)
+		{
+			if (first < 0)
+				first = i;
+			last = i;
+		}
+	}
+	return first >= 0;
+}
+
+#ifdef _FIRE_ENGINE_SSE_
+
+//! GetPlaneDistances(), 4 planes at a time
+static void GetPlaneDistancesSSE(const f32 * nx, const f32 * nz, s32 count, f32 x, f32 z,
+	f32 * distances)
+{
+	const __m128 px = _mm_set1_ps(x);
+	const __m128 pz = _mm_set1_ps(z);
+	for (s32 i = 0; i < count; i += 4)
+	{
+		const __m128 d = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(nx + i), px),
+			_mm_mul_ps(_mm_loadu_ps(nz + i), pz));
+		_mm_storeu_ps(distances + i, d);
+	}
+}
+
+#endif // _FIRE_ENGINE_SSE_
+
+void LightClusterer::GetPlaneDistances(const f32 * nx, const f32 * nz, s32 count, f32 x, f32 z,
+	f32 * distances)
+{
+	// The arrays are padded to a multiple of 4
+#ifdef _FIRE_ENGINE_SSE_
+	if (sys::CPUInfo::HasSSE2())
+	{
+		GetPlaneDistancesSSE(nx, nz, count, x, z, distances);
+		return;
+	}
+#endif
+	for (s32 i = 0; i < count; i++)
+		distances[i] = nx[i]*x + nz[i]*z;
+}
+
+} // namespace fire_engine
@@ -0,0 +1,141 @@
+/**
+ * FILE:    LightClusterer.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Sorts lights into clusters of the view frustum, for lighting each pixel with
+ *          the lights that reach it only.
+**/
+
+#ifndef LIGHTCLUSTERER_H_INCLUDED
+#define LIGHTCLUSTERER_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "matrix4.h"
+
+namespace fire_engine
+{
+
+class Light;
+
+/** Cuts the view frustum into clusters: tiles of the screen, each cut into slices of
+ depth, which are thinner close to the camera. Each light with a range is put in the
+ clusters that its sphere touches, so that a pixel shader only has to look at the
+ lights of the cluster of its pixel.
+ The planes between the tiles go through the camera, so which tiles a light touches does
+ not depend on its depth: the distances of a light to all these planes are worked out 4
+ at a time with SSE, when the processor has it. */
+class _FIRE_ENGINE_API_ LightClusterer
+{
+public:
+	enum
+	{
+		//! The number of tiles across the screen
+		CLUSTERS_X        = 16,
+		//! The number of tiles down the screen
+		CLUSTERS_Y        = 8,
+		//! The number of slices of depth
+		CLUSTERS_Z        = 16,
+		CLUSTER_COUNT     = CLUSTERS_X*CLUSTERS_Y*CLUSTERS_Z,
+		//! The most lights that can be clustered
+		MAX_LIGHTS        = 1024,
+		//! The most lights all the clusters can hold together
+		MAX_LIGHT_INDICES = 0x10000
+	};
+
+	//! A clustered light, as the shaders read it
+	struct clustered_light_t
+	{
+		//! The position in view space, and the range
+		f32 Position[4];
+		f32 Ambient[4];
+		f32 Diffuse[4];
+		f32 Specular[4];
+		//! The direction of a spot light in view space, and the cosine of its cutoff,
+		//! which is -2 for lights that shine all around
+		f32 Spot[4];
+	};
+
+	/** Constructor. */
+	LightClusterer();
+
+	/** Sorts lights into the clusters of a view. Only point lights with a range are
+	 clustered, spot lights included, and the other lights are ignored.
+	 \param view       The view matrix.
+	 \param projection A perspective projection matrix.
+	 \param lights     The lights, in world space.
+	 \param count      The number of lights. */
+	void build(const matrix4f& view, const matrix4f& projection, const Light * const * lights,
+		s32 count);
+
+	/** Returns the number of lights that touch at least one cluster. */
+	s32 getLightCount() const;
+
+	/** Returns the lights that touch at least one cluster. */
+	const clustered_light_t * getLights() const;
+
+	/** Returns the clusters, with 4 floats for each: where its lights start in the light
+	 indices, the number of lights, and two zeros. The clusters of the first slice come
+	 first, row after row. */
+	const f32 * getClusters() const;
+
+	/** Returns the number of light indices. */
+	s32 getLightIndexCount() const;
+
+	/** Returns the indices of the lights of all the clusters, as floats. */
+	const f32 * getLightIndices() const;
+
+	/** Returns the distance of the near plane of the last view. */
+	f32 getNear() const;
+
+	/** Returns the distance of the far plane of the last view. */
+	f32 getFar() const;
+
+	/** Returns the slice of depth that a distance from the camera is in. */
+	s32 getSlice(f32 depth) const;
+
+private:
+	//! The box of clusters a light touches
+	struct light_bounds_t
+	{
+		s32 X0, X1, Y0, Y1, Z0, Z1;
+	};
+
+	//! The planes between the tiles, through the camera: the x and z, or y and z,
+	//! components of their normals. Padded to a multiple of 4.
+	f32               mColumnX[CLUSTERS_X+4];
+	f32               mColumnZ[CLUSTERS_X+4];
+	f32               mRowY[CLUSTERS_Y+4];
+	f32               mRowZ[CLUSTERS_Y+4];
+
+	f32               mNear;
+	f32               mFar;
+	//! CLUSTERS_Z / log(far/near)
+	f32               mSliceScale;
+	s32               mLightCount;
+	s32               mLightIndexCount;
+	clustered_light_t mLights[MAX_LIGHTS];
+	light_bounds_t    mBounds[MAX_LIGHTS];
+	f32               mClusters[CLUSTER_COUNT*4];
+	s32               mCursors[CLUSTER_COUNT];
+	f32               mLightIndices[MAX_LIGHT_INDICES];
+
+	//! Works out the planes between the tiles, and the depth of the slices
+	void setupFrustum(const matrix4f& projection);
+
+	//! Works out the range of tiles touched by a sphere, from the distances of its centre
+	//! to the planes of the tiles
+	static bool GetTileRange(const f32 * distances, s32 count, f32 radius, s32& first, s32& last);
+
+	//! Works out the distances of a point to planes through the origin
+	static void GetPlaneDistances(const f32 * nx, const f32 * nz, s32 count, f32 x, f32 z,
+		f32 * distances);
+
+	// Copying is not supported
+	LightClusterer(const LightClusterer&);
+	LightClusterer& operator=(const LightClusterer&);
+};
+
+} // namespace fire_engine
+
+#endif // LIGHTCLUSTERER_H_INCLUDED
@@ -0,0 +1,216 @@
+/**
+ * FILE:    LightGrid.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the LightGrid class.
+**/
+
+#include "LightGrid.h"
+#include "Light.h"
+
+namespace fire_engine
+{
+
+//! Lights that would be put in more cells than this reach every object instead
+#define LIGHTGRID_MAX_CELLS_PER_LIGHT 64
+
+//! Boxes that cover more cells than this look at every light instead
+#define LIGHTGRID_MAX_CELLS_PER_QUERY 512
+
+//! The largest cell index, small enough for the extent of any range of cells to fit in an s32
+#define LIGHTGRID_MAX_CELL (1 << 29)
+
+LightGrid::LightGrid(f32 cellSize)
+	: mCellSize(cellSize), mLights(64), mStamps(64), mQuery(0), mGlobalLights(16),
+	  mCells(256), mNodes(256)
+{
+}
+
+void LightGrid::clear()
+{
+	mLights.clear();
+	mStamps.clear();
+	mGlobalLights.clear();
+	mCells.clear();
+	mNodes.clear();
+	mQuery = 0;
+}
+
+void LightGrid::addLight(const Light * light)
+{
+	const s32 index = mLights.size();
+	mLights.push_back(light);
+	mStamps.push_back(0);
+
+	const f32 range = light->getRange();
+	if (light->getType() == ELT_DIRECTIONAL || range <= 0.0f)
+	{
+		mGlobalLights.push_back(index);
+		return;
+	}
+
+	const vector3f& position = light->getPosition();
+	const s32 x0 = getCell(position.getX() - range), x1 = getCell(position.getX() + range);
+	const s32 y0 = getCell(position.getY() - range), y1 = getCell(position.getY() + range);
+	const s32 z0 = getCell(position.getZ() - range), z1 = getCell(position.getZ() + range);
+	if (CoversMoreThan(x0, x1, y0, y1, z0, z1, LIGHTGRID_MAX_CELLS_PER_LIGHT))
+	{
+		mGlobalLights.push_back(index);
+		return;
+	}
+
+	for (s32 z = z0; z <= z1; z++)
+	{
+		for (s32 y = y0; y <= y1; y++)
+		{
+			for (s32 x = x0; x <= x1; x++)
+			{
+				// The light goes first in the list of the cell
+				const u32 key     = GetCellKey(x, y, z);
+				const s32 * first = mCells.find(key);
+				cell_node_t node;
+				node.Light = index;
+				node.Next  = first != 0 ? *first : -1;
+				mCells[key] = mNodes.size();
+				mNodes.push_back(node);
+			}
+		}
+	}
+}
+
+s32 LightGrid::getLightCount() const
+{
+	return mLights.size();
+}
+
+s32 LightGrid::selectLights(const aabboxf& box, const Light ** lights, s32 max)
+{
+	f32 scores[64];
+	if (max > 64)
+		max = 64;
+	s32 count = 0;
+	mQuery++;
+
+	for (s32 i = 0; i < mGlobalLights.size(); i++)
+		considerLight(mGlobalLights[i], box, lights, scores, count, max);
+
+	const vector3f& bmin = box.getMinPoint();
+	const vector3f& bmax = box.getMaxPoint();
+	const s32 x0 = getCell(bmin.getX()), x1 = getCell(bmax.getX());
+	const s32 y0 = getCell(bmin.getY()), y1 = getCell(bmax.getY());
+	const s32 z0 = getCell(bmin.getZ()), z1 = getCell(bmax.getZ());
+	if (CoversMoreThan(x0, x1, y0, y1, z0, z1, LIGHTGRID_MAX_CELLS_PER_QUERY))
+	{
+		// Large boxes, like the level itself, are cheaper to test against every light
+		for (s32 i = 0; i < mLights.size(); i++)
+			considerLight(i, box, lights, scores, count, max);
+		return count;
+	}
+
+	for (s32 z = z0; z <= z1; z++)
+	{
+		for (s32 y = y0; y <= y1; y++)
+		{
+			for (s32 x = x0; x <= x1; x++)
+			{
+				const s32 * first = mCells.find(GetCellKey(x, y, z));
+				if (first == 0)
+					continue;
+				for (s32 n = *first; n >= 0; n = mNodes[n].Next)
+					considerLight(mNodes[n].Light, box, lights, scores, count, max);
+			}
+		}
+	}
+	return count;
+}
+
+void LightGrid::setCellSize(f32 cellSize)
+{
+	mCellSize = cellSize;
+	clear();
+}
+
+f32 LightGrid::getCellSize() const
+{
+	return mCellSize;
+}
+
+u32 LightGrid::GetCellKey(s32 x, s32 y, s32 z)
+{
+	// Cells 1024 cells apart share a key, which only adds lights to consider
+	return ((u32)(x & 0x3FF) << 20) | ((u32)(y & 0x3FF) << 10) | (u32)(z & 0x3FF);
+}
+
+s32 LightGrid::getCell(f32 v) const
+{
+	const f32 c = v / mCellSize;
+	// Clamp before the cast, which is undefined for values out of range, and NaN
+	if (!(c > -(f32)LIGHTGRID_MAX_CELL))
+		return -LIGHTGRID_MAX_CELL;
+	if (c > (f32)LIGHTGRID_MAX_CELL)
+		return LIGHTGRID_MAX_CELL;
+	const s32 i = (s32)c;
+	// Round towards minus infinity
+	return (c < 0.0f && (f32)i != c) ? i - 1 : i;
+}
+
+bool LightGrid::CoversMoreThan(s32 x0, s32 x1, s32 y0, s32 y1, s32 z0, s32 z1, s32 max)
+{
+	// Each extent is checked first, so that their product cannot overflow
+	const s32 x = x1 - x0 + 1, y = y1 - y0 + 1, z = z1 - z0 + 1;
+	if (x > max || y > max || z > max)
+		return true;
+	return x * y * z > max;
+}
+
+void LightGrid::considerLight(s32 index, const aabboxf& box, const Light ** lights, f32 * scores,
+	s32& count, s32 max)
+{
+	if (mStamps[index] == mQuery)
+		return;
+	mStamps[index] = mQuery;
+
+	const Light * light = mLights[index];
+	const Color32 diffuse = light->getDiffuse();
+	f32 score = 0.3f*diffuse.red() + 0.59f*diffuse.green() + 0.11f*diffuse.blue();
+
+	const f32 range = light->getRange();
+	if (light->getType() != ELT_DIRECTIONAL && range > 0.0f)
+	{
+		// The square of the distance between the light and the closest point of the box
+		const f32 p[3]  = { light->getPosition().getX(), light->getPosition().getY(), light->getPosition().getZ() };
+		const f32 lo[3] = { box.getMinPoint().getX(), box.getMinPoint().getY(), box.getMinPoint().getZ() };
+		const f32 hi[3] = { box.getMaxPoint().getX(), box.getMaxPoint().getY(), box.getMaxPoint().getZ() };
+		f32 distance = 0.0f;
+		for (s32 i = 0; i < 3; i++)
+		{
+			const f32 d = p[i] < lo[i] ? lo[i] - p[i] : (p[i] > hi[i] ? p[i] - hi[i] : 0.0f);
+			distance += d*d;
+		}
+		if (distance >= range*range)
+			return;
+		score /= 1.0f + LIGHT_RANGE_ATTENUATION*distance/(range*range);
+	}
+
+	// Insertion into the lights selected so far, the best first
+	s32 i = count;
+	if (i == max)
+	{
+		if (max == 0 || score <= scores[max-1])
+			return;
+		i--;
+	}
+	else
+	{
+		count++;
+	}
+	for (; i > 0 && scores[i-1] < score; i--)
+	{
+		scores[i] = scores[i-1];
+		lights[i] = lights[i-1];
+	}
+	scores[i] = score;
+	lights[i] = light;
+}
+
+} // namespace fire_engine
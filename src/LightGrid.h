@@ -0,0 +1,99 @@
+/**
+ * FILE:    LightGrid.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A uniform grid of the lights of a scene, to find the lights that matter most
+ *          to an object.
+**/
+
+#ifndef LIGHTGRID_H_INCLUDED
+#define LIGHTGRID_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "Array.h"
+#include "HashTable.h"
+#include "aabbox.h"
+
+namespace fire_engine
+{
+
+class Light;
+
+/** Sorts the lights of a scene into a uniform grid, so that the lights that reach an object
+ can be found without looking at every light. Only the cells that hold lights are stored.
+ Lights with a range (see Light::setRange()) are put in each cell that their sphere
+ touches. The others, and the lights too large for the grid, reach every object.
+ The grid is meant to be filled again every frame, after the lights have moved. */
+class _FIRE_ENGINE_API_ LightGrid
+{
+public:
+	/** Constructor.
+	 \param cellSize The size of the cells, which should be about the range of the lights. */
+	LightGrid(f32 cellSize = 256.0f);
+
+	/** Removes all the lights. */
+	void clear();
+
+	/** Adds a light, in world space. The light is not grabbed, and must exist until the grid
+	 is cleared. */
+	void addLight(const Light * light);
+
+	/** Returns the number of lights added since the grid was last cleared. */
+	s32 getLightCount() const;
+
+	/** Finds the lights that light a box the most. The influence of a light is the
+	 brightness of its diffuse colour, faded by the distance of the box as the renderer
+	 would fade it.
+	 \param box    A box, in world space.
+	 \param lights A place to store the lights, the most influential first.
+	 \param max    The most lights to store.
+	 \return The number of lights stored. */
+	s32 selectLights(const aabboxf& box, const Light ** lights, s32 max);
+
+	/** Sets the size of the cells. The grid is cleared. */
+	void setCellSize(f32 cellSize);
+
+	/** Returns the size of the cells. */
+	f32 getCellSize() const;
+
+private:
+	//! A light in the list of lights of a cell
+	struct cell_node_t
+	{
+		s32 Light;
+		s32 Next;
+	};
+
+	f32                      mCellSize;
+	Array<const Light *>     mLights;
+	//! The last query each light was considered by, so that it is only scored once
+	Array<u32>               mStamps;
+	u32                      mQuery;
+	//! The lights that reach every object
+	Array<s32>               mGlobalLights;
+	//! The first node of the list of each cell that holds lights
+	HashTable<u32, s32>      mCells;
+	Array<cell_node_t>       mNodes;
+
+	//! Returns the key of a cell
+	static u32 GetCellKey(s32 x, s32 y, s32 z);
+
+	//! Returns the cell a coordinate is in, clamped to +/- LIGHTGRID_MAX_CELL
+	s32 getCell(f32 v) const;
+
+	//! Returns whether a range of cells holds more than max cells
+	static bool CoversMoreThan(s32 x0, s32 x1, s32 y0, s32 y1, s32 z0, s32 z1, s32 max);
+
+	//! Scores a light, and inserts it into the lights selected so far if it is good enough
+	void considerLight(s32 index, const aabboxf& box, const Light ** lights, f32 * scores,
+		s32& count, s32 max);
+
+	// Copying is not supported
+	LightGrid(const LightGrid&);
+	LightGrid& operator=(const LightGrid&);
+};
+
+} // namespace fire_engine
+
+#endif // LIGHTGRID_H_INCLUDED
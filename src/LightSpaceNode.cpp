@@ -28,6 +28,21 @@ LightSpaceNode::~LightSpaceNode()
 		m_light->drop();
 }
 
+void LightSpaceNode::preRender(f64 time)
+{
+	ISpaceNode::preRender(time);
+	if (m_light)
+	{
+		mWorldLight = *m_light;
+		vector3f points[3] = { m_light->getPosition(), m_light->getDirection(),
+			vector3f(0.0f, 0.0f, 0.0f) };
+		mWorldTransform.transform(points, 3);
+		mWorldLight.setPosition(points[0]);
+		// Directions are only rotated
+		mWorldLight.setDirection(points[1] - points[2]);
+	}
+}
+
 s32 LightSpaceNode::render(IRenderer * rd)
 {
 	rd->setTransform(EMM_MODEL, mWorldTransform);
@@ -41,7 +56,7 @@ s32 LightSpaceNode::render(IRenderer * rd)
 		u32 index = 0;
 		rd->drawIndexedPrimitiveList(EPT_POINTS, 1, &vertex, &index);
 	}
-	rd->addDynamicLight(m_light);
+	// The light itself is given to the renderer by the SceneManager, for each model it reaches
 	ISpaceNode::render(rd);
 	return 0;
 }
@@ -69,4 +84,9 @@ const Light * LightSpaceNode::getLight() const
 	return m_light;
 }
 
+const Light& LightSpaceNode::getWorldLight() const
+{
+	return mWorldLight;
+}
+
 }
@@ -25,14 +25,21 @@ public:
 
 	virtual ~LightSpaceNode();
 
+	virtual void preRender(f64 time);
+
 	virtual s32 render(IRenderer * rd);
 
 	void attachLight(Light * light);
 	void detachLight();
 
 	const Light * getLight() const;
+
+	/** Returns the attached Light moved into world space by the transform of this node, as
+	 of the last call to preRender(). */
+	const Light& getWorldLight() const;
 private:
 	Light * m_light;
+	Light   mWorldLight;
 };
 
 }
@@ -33,62 +33,58 @@ public:
 	class iterator
 	{
 	public:
-		virtual ~iterator()
-		{
-		}
-
-		virtual iterator& operator++()
+		inline iterator& operator++()
 		{
 			m_current = m_current->next;
 			return *this;
 		}
 
-		virtual iterator operator++(s32)
+		inline iterator operator++(s32)
 		{
 			iterator tmp = *this;
 			m_current = m_current->next;
 			return tmp;
 		}
 
-		virtual iterator& operator--()
+		inline iterator& operator--()
 		{
 			m_current = m_current->prev;
 			return *this;
 		}
 
-		virtual iterator operator--(s32)
+		inline iterator operator--(s32)
 		{
 			iterator tmp = *this;
 			m_current = m_current->prev;
 			return tmp;
 		}
 
-		virtual T& operator*()
+		inline T& operator*()
 		{
 			return m_current->object;
 		}
 
-		virtual T& operator->()
+		inline T& operator->()
 		{
 			return m_current->object;
 		}
 
-		virtual T& operator()()
+		inline T& operator()()
 		{
 			return m_current->object;
 		}
 
-		virtual bool operator!=(const iterator& it)
+		inline bool operator!=(const iterator& it)
 		{
 			return m_current != it.m_current;
 		}
 
-		virtual bool operator==(const iterator& it)
+		inline bool operator==(const iterator& it)
 		{
 			return m_current == it.m_current;
 		}
 
-		virtual iterator& operator=(const iterator& other)
+		inline iterator& operator=(const iterator& other)
 		{
 			m_current = other.m_current;
 			return *this;
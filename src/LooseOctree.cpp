@@ -0,0 +1,377 @@
+/**
+ * FILE:    LooseOctree.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the LooseOctree class.
+**/
+
+#include "LooseOctree.h"
+#include "ViewFrustum.h"
+#include "Logger.h"
+
+namespace fire_engine
+{
+
+LooseOctree::LooseOctree(const vector3f& centre, f32 halfSize)
+	: mNodes(64), mEntries(256), mFreeNode(-1), mFreeEntry(-1)
+{
+	reset(centre, halfSize);
+}
+
+void LooseOctree::reset(const vector3f& centre, f32 halfSize)
+{
+	mNodes.clear();
+	mEntries.clear();
+	mFreeNode  = -1;
+	mFreeEntry = -1;
+
+	node_t root;
+	root.Centre   = centre;
+	root.HalfSize = halfSize;
+	root.Bounds.reset(centre - halfSize*2.0f, centre + halfSize*2.0f);
+	root.Depth    = 0;
+	root.Parent   = -1;
+	for (s32 i = 0; i < 8; i++)
+		root.Children[i] = -1;
+	root.First    = -1;
+	root.Count    = 0;
+	mNodes.push_back(root);
+}
+
+s32 LooseOctree::insert(IModel * model, const aabboxf& box)
+{
+	s32 handle = mFreeEntry;
+	if (handle != -1)
+	{
+		mFreeEntry = mEntries[handle].Next;
+	}
+	else
+	{
+		handle = mEntries.size();
+		mEntries.push_back(entry_t());
+	}
+
+	entry_t& entry = mEntries[handle];
+	entry.Model = model;
+	entry.Box   = box;
+	link(handle, findNode(box, true));
+#if defined(_FIRE_ENGINE_DEBUG_OCTREE_)
+	check();
+#endif
+	return handle;
+}
+
+void LooseOctree::update(s32 handle, const aabboxf& box)
+{
+	mEntries[handle].Box = box;
+
+	// A model stays in its node for as long as it fits in the loose bounds of the node,
+	// even once its centre has left the cell. The root also holds the models outside of
+	// the tree, so models in the root always look for a better node.
+	const s32 node = mEntries[handle].Node;
+	aabboxf& bounds = mNodes[node].Bounds;
+	if ((node != 0 && bounds.contains(box.getMinPoint()) && bounds.contains(box.getMaxPoint())) ||
+		findNode(box, false) == node)
+	{
+		return;
+	}
+
+	// The entry is taken out before looking for its new node, as the nodes it leaves empty
+	// are freed, and the new node may be one of them or below one of them
+	unlink(handle);
+	link(handle, findNode(box, true));
+#if defined(_FIRE_ENGINE_DEBUG_OCTREE_)
+	check();
+#endif
+}
+
+void LooseOctree::remove(s32 handle)
+{
+	unlink(handle);
+	entry_t& entry = mEntries[handle];
+	entry.Model = 0;
+	entry.Node  = -1;
+	entry.Next  = mFreeEntry;
+	mFreeEntry  = handle;
+#if defined(_FIRE_ENGINE_DEBUG_OCTREE_)
+	check();
+#endif
+}
+
+s32 LooseOctree::getCount() const
+{
+	return mNodes.const_pointer()[0].Count;
+}
+
+void LooseOctree::getVisible(const ViewFrustum& frustum, Array<IModel*>& models) const
+{
+	getVisible(0, frustum, models);
+}
+
+void LooseOctree::getIntersecting(const aabboxf& box, Array<IModel*>& models) const
+{
+	getIntersecting(0, box, models);
+}
+
+void LooseOctree::getInRange(const vector3f& point, f32 range, Array<IModel*>& models) const
+{
+	getInRange(0, point, range*range, models);
+}
+
+s32 LooseOctree::findNode(const aabboxf& box, bool create)
+{
+	const vector3f centre = box.getCenter();
+	const vector3f extent = box.getMaxPoint() - box.getMinPoint();
+	f32 size = extent.getX();
+	if (extent.getY() > size)
+		size = extent.getY();
+	if (extent.getZ() > size)
+		size = extent.getZ();
+
+	// Models whose centre is outside of the cell of the root are kept in the root
+	const node_t& root = mNodes[0];
+	const vector3f offset = centre - root.Centre;
+	if (offset.getX() < -root.HalfSize || offset.getX() > root.HalfSize ||
+		offset.getY() < -root.HalfSize || offset.getY() > root.HalfSize ||
+		offset.getZ() < -root.HalfSize || offset.getZ() > root.HalfSize)
+	{
+		return 0;
+	}
+
+	// A model fits in a child when it is no larger than the cell of the child, since its
+	// centre is in that cell and the bounds reach half a cell further
+	s32 node = 0;
+	while (mNodes[node].Depth < MAX_DEPTH && size <= mNodes[node].HalfSize)
+	{
+		const vector3f& nodeCentre = mNodes[node].Centre;
+		const s32 octant = (centre.getX() >= nodeCentre.getX() ? 1 : 0) |
+						   (centre.getY() >= nodeCentre.getY() ? 2 : 0) |
+						   (centre.getZ() >= nodeCentre.getZ() ? 4 : 0);
+		s32 child = mNodes[node].Children[octant];
+		if (child == -1)
+		{
+			if (!create)
+				return -1;
+			child = createNode(node, octant);
+			mNodes[node].Children[octant] = child;
+		}
+		node = child;
+	}
+	return node;
+}
+
+s32 LooseOctree::createNode(s32 parent, s32 octant)
+{
+	s32 index = mFreeNode;
+	if (index != -1)
+	{
+		mFreeNode = mNodes[index].First;
+	}
+	else
+	{
+		index = mNodes.size();
+		mNodes.push_back(node_t());
+	}
+
+	// The array may have moved, so the parent is looked up after adding the node
+	const node_t& up = mNodes[parent];
+	node_t& node = mNodes[index];
+	node.HalfSize = up.HalfSize*0.5f;
+	node.Centre   = vector3f(up.Centre.getX() + ((octant & 1) ? node.HalfSize : -node.HalfSize),
+							 up.Centre.getY() + ((octant & 2) ? node.HalfSize : -node.HalfSize),
+							 up.Centre.getZ() + ((octant & 4) ? node.HalfSize : -node.HalfSize));
+	node.Bounds.reset(node.Centre - node.HalfSize*2.0f, node.Centre + node.HalfSize*2.0f);
+	node.Depth    = up.Depth + 1;
+	node.Parent   = parent;
+	for (s32 i = 0; i < 8; i++)
+		node.Children[i] = -1;
+	node.First    = -1;
+	node.Count    = 0;
+	return index;
+}
+
+void LooseOctree::link(s32 entry, s32 node)
+{
+	entry_t& e = mEntries[entry];
+	e.Node     = node;
+	e.Previous = -1;
+	e.Next     = mNodes[node].First;
+	if (e.Next != -1)
+		mEntries[e.Next].Previous = entry;
+	mNodes[node].First = entry;
+
+	for (s32 n = node; n != -1; n = mNodes[n].Parent)
+		mNodes[n].Count++;
+}
+
+void LooseOctree::unlink(s32 entry)
+{
+	entry_t& e = mEntries[entry];
+	if (e.Previous != -1)
+		mEntries[e.Previous].Next = e.Next;
+	else
+		mNodes[e.Node].First = e.Next;
+	if (e.Next != -1)
+		mEntries[e.Next].Previous = e.Previous;
+
+	for (s32 n = e.Node; n != -1; n = mNodes[n].Parent)
+		mNodes[n].Count--;
+
+	// Free the nodes left without models, from the bottom up. Their children are all empty,
+	// so they were freed first.
+	s32 node = e.Node;
+	while (node != 0 && mNodes[node].Count == 0)
+	{
+		const s32 parent = mNodes[node].Parent;
+		for (s32 i = 0; i < 8; i++)
+		{
+			if (mNodes[parent].Children[i] == node)
+				mNodes[parent].Children[i] = -1;
+		}
+		mNodes[node].First = mFreeNode;
+		mFreeNode = node;
+		node = parent;
+	}
+}
+
+void LooseOctree::addAll(s32 node, Array<IModel*>& models) const
+{
+	const node_t& n = mNodes.const_pointer()[node];
+	for (s32 e = n.First; e != -1; e = mEntries.const_pointer()[e].Next)
+		models.push_back(mEntries.const_pointer()[e].Model);
+	for (s32 i = 0; i < 8; i++)
+	{
+		if (n.Children[i] != -1)
+			addAll(n.Children[i], models);
+	}
+}
+
+void LooseOctree::getVisible(s32 node, const ViewFrustum& frustum, Array<IModel*>& models) const
+{
+	const node_t& n = mNodes.const_pointer()[node];
+	if (n.Count == 0)
+		return;
+
+	// The root also holds the models outside of its bounds, so it is never culled whole
+	if (node != 0)
+	{
+		const EFRUSTUM_INTERSECTION_TYPE result = frustum.calculateIntersection(n.Bounds);
+		if (result == EFIT_OUTSIDE)
+			return;
+		if (result == EFIT_INSIDE)
+		{
+			addAll(node, models);
+			return;
+		}
+	}
+
+	for (s32 e = n.First; e != -1; e = mEntries.const_pointer()[e].Next)
+	{
+		const entry_t& entry = mEntries.const_pointer()[e];
+		if (frustum.calculateIntersection(entry.Box) != EFIT_OUTSIDE)
+			models.push_back(entry.Model);
+	}
+	for (s32 i = 0; i < 8; i++)
+	{
+		if (n.Children[i] != -1)
+			getVisible(n.Children[i], frustum, models);
+	}
+}
+
+void LooseOctree::getIntersecting(s32 node, const aabboxf& box, Array<IModel*>& models) const
+{
+	const node_t& n = mNodes.const_pointer()[node];
+	if (n.Count == 0 || (node != 0 && !n.Bounds.intersectsWith(box)))
+		return;
+
+	for (s32 e = n.First; e != -1; e = mEntries.const_pointer()[e].Next)
+	{
+		const entry_t& entry = mEntries.const_pointer()[e];
+		if (entry.Box.intersectsWith(box))
+			models.push_back(entry.Model);
+	}
+	for (s32 i = 0; i < 8; i++)
+	{
+		if (n.Children[i] != -1)
+			getIntersecting(n.Children[i], box, models);
+	}
+}
+
+void LooseOctree::getInRange(s32 node, const vector3f& point, f32 rangeSquared,
+	Array<IModel*>& models) const
+{
+	const node_t& n = mNodes.const_pointer()[node];
+	if (n.Count == 0 || (node != 0 && GetDistanceSquared(n.Bounds, point) > rangeSquared))
+		return;
+
+	for (s32 e = n.First; e != -1; e = mEntries.const_pointer()[e].Next)
+	{
+		const entry_t& entry = mEntries.const_pointer()[e];
+		if (GetDistanceSquared(entry.Box, point) <= rangeSquared)
+			models.push_back(entry.Model);
+	}
+	for (s32 i = 0; i < 8; i++)
+	{
+		if (n.Children[i] != -1)
+			getInRange(n.Children[i], point, rangeSquared, models);
+	}
+}
+
+f32 LooseOctree::GetDistanceSquared(const aabboxf& box, const vector3f& point)
+{
+	const f32 p[3]   = { point.getX(), point.getY(), point.getZ() };
+	const f32 min[3] = { box.getMinPoint().getX(), box.getMinPoint().getY(), box.getMinPoint().getZ() };
+	const f32 max[3] = { box.getMaxPoint().getX(), box.getMaxPoint().getY(), box.getMaxPoint().getZ() };
+	f32 distance = 0.0f;
+	for (s32 i = 0; i < 3; i++)
+	{
+		if (p[i] < min[i])
+			distance += (min[i] - p[i])*(min[i] - p[i]);
+		else if (p[i] > max[i])
+			distance += (p[i] - max[i])*(p[i] - max[i]);
+	}
+	return distance;
+}
+
+#if defined(_FIRE_ENGINE_DEBUG_OCTREE_)
+s32 LooseOctree::check(s32 node) const
+{
+	const node_t& n = mNodes.const_pointer()[node];
+	s32 count = 0;
+	for (s32 e = n.First; e != -1; e = mEntries.const_pointer()[e].Next)
+	{
+		if (mEntries.const_pointer()[e].Node != node)
+			Logger::Get()->log(ES_HIGH, "LooseOctree", "Entry %d is in node %d, but refers to node %d",
+				e, node, mEntries.const_pointer()[e].Node);
+		count++;
+	}
+	for (s32 i = 0; i < 8; i++)
+	{
+		if (n.Children[i] == -1)
+			continue;
+		if (mNodes.const_pointer()[n.Children[i]].Parent != node)
+			Logger::Get()->log(ES_HIGH, "LooseOctree", "Node %d is a child of node %d, but refers to node %d",
+				n.Children[i], node, mNodes.const_pointer()[n.Children[i]].Parent);
+		count += check(n.Children[i]);
+	}
+	if (count != n.Count || (node != 0 && count == 0))
+		Logger::Get()->log(ES_HIGH, "LooseOctree", "Node %d holds %d models, but counts %d",
+			node, count, n.Count);
+	return count;
+}
+
+void LooseOctree::check() const
+{
+	s32 count = 0;
+	for (s32 i = 0; i < mEntries.size(); i++)
+	{
+		if (mEntries.const_pointer()[i].Node != -1)
+			count++;
+	}
+	if (check(0) != count)
+		Logger::Get()->log(ES_HIGH, "LooseOctree", "The tree holds %d models, out of %d",
+			mNodes.const_pointer()[0].Count, count);
+}
+#endif
+
+} // namespace fire_engine
@@ -0,0 +1,139 @@
+/**
+ * FILE:    LooseOctree.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A loose octree of the models of a scene, to find the models in the view or
+ *          near a place without looking at every model.
+**/
+
+#ifndef LOOSEOCTREE_H_INCLUDED
+#define LOOSEOCTREE_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "Array.h"
+#include "aabbox.h"
+#include "vector3.h"
+
+namespace fire_engine
+{
+
+class IModel;
+class ViewFrustum;
+
+/** Sorts the models of a scene by their boxes in world space. Each node of the tree holds
+ the models whose centre is in its cell and which are no larger than the cell, and its
+ bounds are twice the size of the cell so that the models never stick out of them. A
+ model only moves to another node when its box leaves the loose bounds of its own, so
+ moving models are cheap to update, but a model may be kept in another node than the one
+ it would be inserted in. Models outside of the bounds of the tree are kept in the
+ root, and are always tested on their own. */
+class _FIRE_ENGINE_API_ LooseOctree
+{
+public:
+	enum
+	{
+		//! The deepest a node can be, the root being 0
+		MAX_DEPTH = 8
+	};
+
+	/** Constructor.
+	 \param centre   The centre of the cell of the root.
+	 \param halfSize Half the size of the cell of the root. */
+	LooseOctree(const vector3f& centre = vector3f(0.0f, 0.0f, 0.0f), f32 halfSize = 4096.0f);
+
+	/** Removes all the models, and changes the cell of the root. */
+	void reset(const vector3f& centre, f32 halfSize);
+
+	/** Adds a model. The model is not grabbed, and must be removed before it is deleted.
+	 \param model The model.
+	 \param box   Its box, in world space.
+	 \return A handle to give to update() and remove(). */
+	s32 insert(IModel * model, const aabboxf& box);
+
+	/** Changes the box of a model, after it has moved. */
+	void update(s32 handle, const aabboxf& box);
+
+	/** Removes a model. Its handle may be given to another model afterwards. */
+	void remove(s32 handle);
+
+	/** Returns the number of models. */
+	s32 getCount() const;
+
+	/** Adds the models whose box is in a frustum, or partly in it, to an array. The nodes
+	 entirely inside of the frustum add all their models without testing them. */
+	void getVisible(const ViewFrustum& frustum, Array<IModel*>& models) const;
+
+	/** Adds the models whose box intersects a box to an array. */
+	void getIntersecting(const aabboxf& box, Array<IModel*>& models) const;
+
+	/** Adds the models whose box is within a distance of a point to an array. */
+	void getInRange(const vector3f& point, f32 range, Array<IModel*>& models) const;
+
+private:
+	struct node_t
+	{
+		//! The cell, twice as large in each direction
+		aabboxf Bounds;
+		vector3f Centre;
+		f32      HalfSize;
+		s32      Depth;
+		s32      Parent;
+		//! -1 where there is no child
+		s32      Children[8];
+		//! The first entry of the node, or the next free node
+		s32      First;
+		//! The number of models in the node and its children
+		s32      Count;
+	};
+
+	struct entry_t
+	{
+		IModel * Model;
+		aabboxf  Box;
+		//! -1 when the entry is free
+		s32      Node;
+		s32      Previous;
+		//! The next entry of the node, or the next free entry
+		s32      Next;
+	};
+
+	Array<node_t>  mNodes;
+	Array<entry_t> mEntries;
+	s32            mFreeNode;
+	s32            mFreeEntry;
+
+	//! Returns the node a box belongs in, creating it if needed and create is true, or -1
+	s32 findNode(const aabboxf& box, bool create);
+
+	//! Returns a new node for a child of a node
+	s32 createNode(s32 parent, s32 octant);
+
+	//! Puts an entry in the list of a node
+	void link(s32 entry, s32 node);
+
+	//! Takes an entry out of the list of its node, and frees the nodes left empty
+	void unlink(s32 entry);
+
+	void addAll(s32 node, Array<IModel*>& models) const;
+	void getVisible(s32 node, const ViewFrustum& frustum, Array<IModel*>& models) const;
+	void getIntersecting(s32 node, const aabboxf& box, Array<IModel*>& models) const;
+	void getInRange(s32 node, const vector3f& point, f32 rangeSquared, Array<IModel*>& models) const;
+
+	//! Returns the squared distance from a point to a box, 0 inside of it
+	static f32 GetDistanceSquared(const aabboxf& box, const vector3f& point);
+
+#if defined(_FIRE_ENGINE_DEBUG_OCTREE_)
+	//! Logs where the nodes and entries do not agree, after each change
+	void check() const;
+	s32 check(s32 node) const;
+#endif
+
+	// Copying is not supported
+	LooseOctree(const LooseOctree&);
+	LooseOctree& operator=(const LooseOctree&);
+};
+
+} // namespace fire_engine
+
+#endif // LOOSEOCTREE_H_INCLUDED
@@ -0,0 +1,195 @@
+/**
+ * FILE:    MMapFile.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the MMapFile class.
+**/
+
+#include "MMapFile.h"
+#include "Object.h"
+#include <string.h>
+
+#ifdef _FIRE_ENGINE_WIN32_
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+namespace fire_engine
+{
+namespace io
+{
+
+MMapFile::MMapFile(const String& filename)
+	: mData(0), mSize(0), mPosition(0), mIsOpen(false), mOwner(0), mMapped(false)
+{
+	Filename     = filename;
+	ErrorOccured = false;
+
+#ifdef _FIRE_ENGINE_WIN32_
+	mMappingHandle = 0;
+	mFileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (mFileHandle == INVALID_HANDLE_VALUE)
+	{
+		mFileHandle = 0;
+		return;
+	}
+	mSize = (s32)GetFileSize(mFileHandle, 0);
+	mIsOpen = true;
+	// Empty files cannot be mapped, but are still valid files
+	if (mSize > 0)
+	{
+		mMappingHandle = CreateFileMappingA(mFileHandle, 0, PAGE_READONLY, 0, 0, 0);
+		if (mMappingHandle != 0)
+			mData = (const u8 *)MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+		mMapped = mData != 0;
+		mIsOpen = mMapped;
+	}
+#else
+	s32 fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+	struct stat status;
+	if (fstat(fd, &status) == 0)
+	{
+		mSize = (s32)status.st_size;
+		mIsOpen = true;
+		if (mSize > 0)
+		{
+			void * data = mmap(0, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+			mMapped = data != MAP_FAILED;
+			mData = mMapped ? (const u8 *)data : 0;
+			mIsOpen = mMapped;
+		}
+	}
+	// The mapping stays valid once the descriptor is closed
+	::close(fd);
+#endif
+}
+
+MMapFile::MMapFile(const String& name, const void * data, s32 size, Object * owner)
+	: mData((const u8 *)data), mSize(size), mPosition(0), mIsOpen(true), mOwner(owner),
+	mMapped(false)
+{
+	Filename     = name;
+	ErrorOccured = false;
+#ifdef _FIRE_ENGINE_WIN32_
+	mFileHandle    = 0;
+	mMappingHandle = 0;
+#endif
+	if (mOwner != 0)
+		mOwner->grab();
+}
+
+MMapFile::~MMapFile()
+{
+	close();
+}
+
+bool MMapFile::isOpen() const
+{
+	return mIsOpen;
+}
+
+bool MMapFile::read(void * out, s32 size)
+{
+	if (!mIsOpen || size < 0 || mPosition + size > mSize)
+	{
+		ErrorOccured = true;
+		return false;
+	}
+	memcpy(out, mData + mPosition, size);
+	mPosition += size;
+	return true;
+}
+
+bool MMapFile::write(const void * data, s32 size)
+{
+	ErrorOccured = true;
+	return false;
+}
+
+bool MMapFile::seek(EFILE_SEEK_POSITION from, s32 offset)
+{
+	s32 position;
+	switch (from)
+	{
+	case EFSP_START:
+		position = offset;
+		break;
+	case EFSP_CURRENT:
+		position = mPosition + offset;
+		break;
+	case EFSP_END:
+	default:
+		position = mSize - offset;
+		break;
+	}
+	if (position < 0 || position > mSize)
+	{
+		ErrorOccured = true;
+		return false;
+	}
+	mPosition = position;
+	return true;
+}
+
+s32 MMapFile::getCurrentPosition() const
+{
+	return mPosition;
+}
+
+const void * MMapFile::getData() const
+{
+	return mData;
+}
+
+s32 MMapFile::getSize() const
+{
+	return mSize;
+}
+
+bool MMapFile::remove()
+{
+	ErrorOccured = true;
+	return false;
+}
+
+bool MMapFile::close()
+{
+	const bool wasOpen = mIsOpen;
+#ifdef _FIRE_ENGINE_WIN32_
+	if (mMapped)
+		UnmapViewOfFile(mData);
+	if (mMappingHandle != 0)
+		CloseHandle(mMappingHandle);
+	if (mFileHandle != 0)
+		CloseHandle(mFileHandle);
+	mMappingHandle = 0;
+	mFileHandle    = 0;
+#else
+	if (mMapped)
+		munmap((void *)mData, mSize);
+#endif
+	if (mOwner != 0)
+	{
+		mOwner->drop();
+		mOwner = 0;
+	}
+	mData   = 0;
+	mMapped = false;
+	mIsOpen = false;
+	return wasOpen;
+}
+
+String MMapFile::toString() const
+{
+	return String("MMapFile[ \"") + Filename + "\" size = " + static_cast<f32>(mSize)/1024 + "kb ]";
+}
+
+} // namespace io
+} // namespace fire_engine
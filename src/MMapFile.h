@@ -0,0 +1,81 @@
+/**
+ * FILE:    MMapFile.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A read-only file that is mapped into memory.
+**/
+
+#ifndef MMAPFILE_H_INCLUDED
+#define MMAPFILE_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "IFile.h"
+
+namespace fire_engine
+{
+
+class Object;
+
+namespace io
+{
+
+/** A read-only file whose content is mapped into memory, so that it can be accessed with
+ getData() without being copied. read() is still available, and copies from the mapping.
+ An MMapFile can also be a view on part of the memory of another file, such as an entry
+ stored in a mapped .ZIP archive. */
+class _FIRE_ENGINE_API_ MMapFile : public IFile
+{
+public:
+	/** Maps a file from disk. Check isOpen() to see whether it succeeded. */
+	MMapFile(const String& filename);
+
+	/** Creates a view on memory that belongs to some other object.
+	 \param name  The name of the file.
+	 \param data  The content of the file.
+	 \param size  The size of the content.
+	 \param owner An object that owns data. It is grabbed for as long as this file exists,
+	              so that the data stays valid. Can be 0. */
+	MMapFile(const String& name, const void * data, s32 size, Object * owner);
+
+	virtual ~MMapFile();
+
+	virtual bool isOpen() const;
+
+	virtual bool read(void * out, s32 size);
+
+	virtual bool write(const void * data, s32 size);
+
+	virtual bool seek(EFILE_SEEK_POSITION from, s32 offset);
+
+	virtual s32 getCurrentPosition() const;
+
+	virtual const void * getData() const;
+
+	virtual s32 getSize() const;
+
+	virtual bool remove();
+
+	virtual bool close();
+
+	virtual String toString() const;
+
+private:
+	const u8 * mData;
+	s32        mSize;
+	s32        mPosition;
+	bool       mIsOpen;
+	//! The object that owns the data of a view, 0 if the file was mapped from disk
+	Object *   mOwner;
+	//! Whether the data was mapped by this file, and must be unmapped
+	bool       mMapped;
+#ifdef _FIRE_ENGINE_WIN32_
+	void *     mFileHandle;
+	void *     mMappingHandle;
+#endif
+};
+
+} // namespace io
+} // namespace fire_engine
+
+#endif // MMAPFILE_H_INCLUDED
@@ -0,0 +1,275 @@
+/**
+ * FILE:    MaterialRegistry.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the MaterialRegistry class.
+**/
+
+#include "MaterialRegistry.h"
+#include "HashTable.h"
+#include "Mutex.h"
+#include "CRC32.h"
+#include "Logger.h"
+#include "Atomic.h"
+#include <string.h>
+
+namespace fire_engine
+{
+
+struct MaterialRegistry::material_entry_t
+{
+	Material          Mat;
+	material_state_t  State;
+	//! The hash of the material
+	u32               Hash;
+	//! The number of handles held, or -1 when the entry is free
+	volatile s32      References;
+	//! The next material with the same hash, or the next free entry, or
+	//! MATERIAL_INVALID_HANDLE
+	material_handle_t Next;
+};
+
+//! Entries are allocated by pages, which never move, so that a material can be read
+//! while others are registered
+#define MATERIAL_PAGE_SIZE 0x100
+#define MATERIAL_PAGE_COUNT (MaterialRegistry::MAX_MATERIALS / MATERIAL_PAGE_SIZE)
+
+static MaterialRegistry::material_entry_t * s_pages[MATERIAL_PAGE_COUNT] = { 0 };
+
+//! The number of materials registered
+static u32 s_count = 0;
+
+//! The number of entries used so far, registered or free
+static u32 s_used = 0;
+
+//! The first free entry, or MATERIAL_INVALID_HANDLE
+static material_handle_t s_free = MATERIAL_INVALID_HANDLE;
+
+/** The first material registered with each hash, created on first use. */
+static HashTable<u32, material_handle_t> * s_by_hash = 0;
+
+/** Held while materials are registered, or cleared. */
+static sys::Mutex s_lock;
+
+//! Returns the hash of a material, without its name
+static u32 HashMaterial(const Material& material, u32 flags)
+{
+	u32 crc = CRC32::Compute(material.getAmbient().v(), 4*sizeof(f32));
+	crc = CRC32::Compute(material.getDiffuse().v(), 4*sizeof(f32), crc);
+	crc = CRC32::Compute(material.getSpecular().v(), 4*sizeof(f32), crc);
+	crc = CRC32::Compute(material.getEmissive().v(), 4*sizeof(f32), crc);
+	const f32 shininess = material.getShininess();
+	crc = CRC32::Compute(&shininess, sizeof(f32), crc);
+	crc = CRC32::Compute(&flags, sizeof(u32), crc);
+	for (s32 i = 0; i < MATERIAL_MAX_NUM_TEXTURES; i++)
+	{
+		const ITexture * texture = material.getTexture(i);
+		crc = CRC32::Compute(&texture, sizeof(texture), crc);
+	}
+	return crc;
+}
+
+//! Returns whether two materials render the same, whatever their name
+static bool EqualMaterials(const Material& a, const Material& b)
+{
+	if (a.getAmbient() != b.getAmbient() || a.getDiffuse() != b.getDiffuse() ||
+		a.getSpecular() != b.getSpecular() || a.getEmissive() != b.getEmissive() ||
+		a.getShininess() != b.getShininess())
+	{
+		return false;
+	}
+	for (s32 p = EMP_ALPHA_BLENDING; p <= EMP_WRITE_TO_Z_BUFFER; p++)
+	{
+		if (a.getMaterialProperty((EMATERIAL_PROPERTY)p) != b.getMaterialProperty((EMATERIAL_PROPERTY)p))
+			return false;
+	}
+	for (s32 i = 0; i < MATERIAL_MAX_NUM_TEXTURES; i++)
+	{
+		if (a.getTexture(i) != b.getTexture(i))
+			return false;
+	}
+	return true;
+}
+
+//! Returns the flags of the render state of a material
+static u32 GetStateFlags(const Material& material)
+{
+	u32 flags = 0;
+	if (material.getMaterialProperty(EMP_ALPHA_BLENDING))
+		flags |= material_state_t::EMS_ALPHA_BLENDING;
+	if (material.getMaterialProperty(EMP_LIGHTING))
+		flags |= material_state_t::EMS_LIGHTING;
+	if (material.getMaterialProperty(EMP_WIREFRAME))
+		flags |= material_state_t::EMS_WIREFRAME;
+	if (material.getMaterialProperty(EMP_WRITE_TO_Z_BUFFER))
+		flags |= material_state_t::EMS_WRITE_TO_Z_BUFFER;
+	return flags;
+}
+
+material_handle_t MaterialRegistry::Register(const Material& material)
+{
+	const u32 flags = GetStateFlags(material);
+	const u32 hash  = HashMaterial(material, flags);
+
+	sys::MutexLock lock(s_lock);
+	Create();
+	return Insert(material, flags, hash);
+}
+
+material_handle_t MaterialRegistry::Insert(const Material& material, u32 flags, u32 hash)
+{
+	material_handle_t * first = s_by_hash->find(hash);
+	if (first != 0)
+	{
+		for (material_handle_t h = *first; h != MATERIAL_INVALID_HANDLE; h = GetEntry(h)->Next)
+		{
+			material_entry_t * entry = GetEntry(h);
+			if (EqualMaterials(entry->Mat, material))
+			{
+				// Drop() checks the count again under the lock, so a material whose last
+				// handle is being dropped is kept
+				AtomicIncrementRelaxed(&entry->References);
+				return h;
+			}
+		}
+	}
+
+	material_handle_t handle = s_free;
+	if (handle != MATERIAL_INVALID_HANDLE)
+	{
+		s_free = GetEntry(handle)->Next;
+	}
+	else if (s_used < MAX_MATERIALS)
+	{
+		handle = s_used++;
+		material_entry_t *& page = s_pages[handle / MATERIAL_PAGE_SIZE];
+		if (page == 0)
+			page = new material_entry_t[MATERIAL_PAGE_SIZE];
+	}
+	else
+	{
+		Logger::Get()->log(ES_HIGH, "MaterialRegistry",
+			"%u materials are registered already, %s is replaced by the default material",
+			s_count, material.getName().c_str());
+		AtomicIncrementRelaxed(&GetEntry(DEFAULT_MATERIAL)->References);
+		return DEFAULT_MATERIAL;
+	}
+	material_entry_t * entry = GetEntry(handle);
+
+	entry->Mat  = material;
+	entry->Hash = hash;
+	material_state_t& state = entry->State;
+	memcpy(state.Ambient, material.getAmbient().v(), 4*sizeof(f32));
+	memcpy(state.Diffuse, material.getDiffuse().v(), 4*sizeof(f32));
+	memcpy(state.Specular, material.getSpecular().v(), 4*sizeof(f32));
+	memcpy(state.Emissive, material.getEmissive().v(), 4*sizeof(f32));
+	state.Shininess = material.getShininess();
+	state.Flags     = flags;
+	state.Texture   = entry->Mat.getTexture(0);
+	entry->References = 1;
+
+	// The new material goes first in the list of its hash
+	entry->Next = first != 0 ? *first : MATERIAL_INVALID_HANDLE;
+	(*s_by_hash)[hash] = handle;
+	s_count++;
+	return handle;
+}
+
+void MaterialRegistry::Grab(material_handle_t handle)
+{
+	AtomicIncrementRelaxed(&GetEntry(handle)->References);
+}
+
+void MaterialRegistry::Drop(material_handle_t handle)
+{
+	if (handle == MATERIAL_INVALID_HANDLE || s_pages[handle / MATERIAL_PAGE_SIZE] == 0)
+		return;
+	if (AtomicDecrementAcqRel(&GetEntry(handle)->References) != 0)
+		return;
+
+	sys::MutexLock lock(s_lock);
+	// Registered again, or released by another thread, since the count reached 0
+	if (s_pages[handle / MATERIAL_PAGE_SIZE] == 0 || AtomicLoadAcquire(&GetEntry(handle)->References) != 0)
+		return;
+	Release(handle);
+}
+
+const Material& MaterialRegistry::Get(material_handle_t handle)
+{
+	return GetEntry(handle)->Mat;
+}
+
+const material_state_t& MaterialRegistry::GetState(material_handle_t handle)
+{
+	return GetEntry(handle)->State;
+}
+
+u32 MaterialRegistry::GetCount()
+{
+	sys::MutexLock lock(s_lock);
+	return s_count;
+}
+
+void MaterialRegistry::Clear()
+{
+	sys::MutexLock lock(s_lock);
+	for (u32 i = 0; i < MATERIAL_PAGE_COUNT; i++)
+	{
+		delete [] s_pages[i];
+		s_pages[i] = 0;
+	}
+	delete s_by_hash;
+	s_by_hash = 0;
+	s_count   = 0;
+	s_used    = 0;
+	s_free    = MATERIAL_INVALID_HANDLE;
+}
+
+MaterialRegistry::material_entry_t * MaterialRegistry::GetEntry(material_handle_t handle)
+{
+	return &s_pages[handle / MATERIAL_PAGE_SIZE][handle % MATERIAL_PAGE_SIZE];
+}
+
+void MaterialRegistry::Create()
+{
+	if (s_by_hash != 0)
+		return;
+	s_by_hash = new HashTable<u32, material_handle_t>();
+
+	// The registry keeps the reference to the default material, so it is never released
+	const Material material;
+	const u32 flags = GetStateFlags(material);
+	Insert(material, flags, HashMaterial(material, flags));
+}
+
+void MaterialRegistry::Release(material_handle_t handle)
+{
+	material_entry_t * entry = GetEntry(handle);
+
+	// Taken out of the list of its hash
+	material_handle_t * first = s_by_hash->find(entry->Hash);
+	if (*first == handle)
+	{
+		if (entry->Next != MATERIAL_INVALID_HANDLE)
+			*first = entry->Next;
+		else
+			s_by_hash->remove(entry->Hash);
+	}
+	else
+	{
+		material_handle_t h = *first;
+		while (GetEntry(h)->Next != handle)
+			h = GetEntry(h)->Next;
+		GetEntry(h)->Next = entry->Next;
+	}
+
+	// The textures are dropped
+	entry->Mat = Material();
+	entry->State.Texture = nullptr;
+	entry->References = -1;
+	entry->Next = s_free;
+	s_free = handle;
+	s_count--;
+}
+
+} // namespace fire_engine
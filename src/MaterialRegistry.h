@@ -0,0 +1,114 @@
+/**
+ * FILE:    MaterialRegistry.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A registry of immutable, deduplicated materials, referred to by small handles.
+**/
+
+#ifndef MATERIALREGISTRY_H_INCLUDED
+#define MATERIALREGISTRY_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "Material.h"
+
+namespace fire_engine
+{
+
+class ITexture;
+
+//! Refers to a material of the MaterialRegistry
+typedef u32 material_handle_t;
+
+//! A handle that refers to no material
+#define MATERIAL_INVALID_HANDLE 0xFFFFFFFF
+
+/** The render state of a material, worked out once when the material is registered, so
+ that renderers can apply it without going through the Material. */
+struct material_state_t
+{
+	//! The flags of the render state
+	enum
+	{
+		EMS_ALPHA_BLENDING    = 0x01,
+		EMS_LIGHTING          = 0x02,
+		EMS_WIREFRAME         = 0x04,
+		EMS_WRITE_TO_Z_BUFFER = 0x08
+	};
+
+	f32              Ambient[4];
+	f32              Diffuse[4];
+	f32              Specular[4];
+	f32              Emissive[4];
+	f32              Shininess;
+	//! A combination of the EMS_ flags
+	u32              Flags;
+	//! The texture of the first unit, or nullptr
+	const ITexture * Texture;
+};
+
+/** Holds every material that is rendered, once. Registering a material returns a handle,
+ and registering an equal material again returns the same handle, so that comparing
+ two handles tells whether two draws use the same material. Materials that only differ
+ by name are equal. A registered material never changes: a modified material is
+ registered as a new one.
+ Handles are counted like references: each handle returned by Register(), or given to
+ Grab(), is given to Drop() once it is not used any more. A material is forgotten when
+ its last handle is dropped, so that its textures can be freed, and its handle may be
+ given to another material afterwards. Materials can be registered and dropped from
+ several threads at once. */
+class _FIRE_ENGINE_API_ MaterialRegistry
+{
+public:
+	//! The most materials that can be registered at once
+	enum { MAX_MATERIALS = 0x10000 };
+
+	//! The handle of the default Material, which is always registered
+	enum { DEFAULT_MATERIAL = 0 };
+
+	/** Registers a material, and returns its handle, which must be dropped. If an equal
+	 material is registered already, its handle is returned instead. When MAX_MATERIALS
+	 are registered, an error is logged and DEFAULT_MATERIAL is returned. */
+	static material_handle_t Register(const Material& material);
+
+	/** Adds a reference to a handle, which must then be dropped once more. */
+	static void Grab(material_handle_t handle);
+
+	/** Removes a reference to a handle, and forgets its material if it was the last one.
+	 MATERIAL_INVALID_HANDLE, and handles dropped after Clear(), are ignored. */
+	static void Drop(material_handle_t handle);
+
+	/** Returns a registered material. */
+	static const Material& Get(material_handle_t handle);
+
+	/** Returns the render state of a registered material. */
+	static const material_state_t& GetState(material_handle_t handle);
+
+	/** Returns the number of distinct materials registered. */
+	static u32 GetCount();
+
+	/** Forgets every material, however many handles are held, and drops their textures.
+	 Every handle becomes invalid, so this should only be called when nothing is
+	 rendered any more. */
+	static void Clear();
+
+	//! A registered material
+	struct material_entry_t;
+
+private:
+	//! Returns the entry of a handle, which must be valid
+	static material_entry_t * GetEntry(material_handle_t handle);
+
+	//! Creates the table of hashes and the default material, if they do not exist yet
+	static void Create();
+
+	//! Returns the handle of a material, registering it if needed, with the lock held
+	static material_handle_t Insert(const Material& material, u32 flags, u32 hash);
+
+	//! Forgets the material of an entry that has no references left
+	static void Release(material_handle_t handle);
+};
+
+} // namespace fire_engine
+
+#endif // MATERIALREGISTRY_H_INCLUDED
@@ -6,12 +6,19 @@
 **/
 
 #include "MediaManager.h"
+#include "Image.h"
+#include "AnimatedMeshMD2.h"
+#include "AnimatedMeshMD3.h"
+#include "Q3Map.h"
+#include "CompressedImage.h"
 #include "ImageLoaderBMP.h"
 #include "ImageLoaderTGA.h"
 #include "ImageLoaderPCX.h"
 #include "AnimatedMeshMD2Loader.h"
 #include "AnimatedMeshMD3Loader.h"
 #include "Q3MapLoader.h"
+#include "CompressedImageLoader.h"
+#include "AssetStreamer.h"
 
 namespace fire_engine
 {
@@ -19,6 +26,7 @@ namespace fire_engine
 MediaManager * MediaManager::mInstance = 0;
 
 MediaManager::MediaManager()
+	: mStreamer(nullptr), mStreamingThreads(2), mCookedCache(nullptr)
 {
 }
 
@@ -48,9 +56,58 @@ MediaManager * MediaManager::Get()
 
 MediaManager::~MediaManager()
 {
+	// Stop the worker threads before the loaders they use are deleted
+	delete mStreamer;
+	delete mCookedCache;
 	mInstance = nullptr;
 }
 
+void MediaManager::stream(IAsyncLoad * request)
+{
+	getStreamer()->stream(request);
+}
+
+AssetStreamer * MediaManager::getStreamer()
+{
+	if (mStreamer == nullptr)
+	{
+		mStreamer = new AssetStreamer(mStreamingThreads);
+	}
+	return mStreamer;
+}
+
+bool MediaManager::isStreaming() const
+{
+	return mStreamer != nullptr;
+}
+
+void MediaManager::setStreamingThreads(s32 threads)
+{
+	mStreamingThreads = threads;
+}
+
+void MediaManager::setCookedCacheDirectory(const String& directory)
+{
+	delete mCookedCache;
+	mCookedCache = directory.length() > 0 ? new CookedCache(directory) : nullptr;
+}
+
+CookedCache * MediaManager::getCookedCache() const
+{
+	return mCookedCache;
+}
+
+u32 MediaManager::GetResidentBytes(const Image * image)
+{
+	return sizeof(Image) + image->dim().getWidth() * image->dim().getHeight() *
+		image->getBytesPerPixel();
+}
+
+u32 MediaManager::GetResidentBytes(const CompressedImage * image)
+{
+	return sizeof(CompressedImage) + image->getSize();
+}
+
 void MediaManager::setDefaults()
 {
 	ImageLoaderBMP * ilbmp = new ImageLoaderBMP();
@@ -62,6 +119,10 @@ void MediaManager::setDefaults()
 	addLoader("md2", new AnimatedMeshMD2Loader());
 	addLoader("md3", new AnimatedMeshMD3Loader());
 	addLoader("bsp", new Q3MapLoader());
+	// Each extension has its own loader, as MediaHolder deletes every loader it has
+	addLoader("bmp", new CompressedImageLoader());
+	addLoader("tga", new CompressedImageLoader());
+	addLoader("pcx", new CompressedImageLoader());
 	addWriter("bmp", ilbmp);
 	addWriter("tga", iltga);
 	addWriter("pcx", ilpcx);
@@ -16,6 +16,9 @@
 #include "Logger.h"
 #include "Array.h"
 #include "FileUtils.h"
+#include "AsyncLoad.h"
+#include "AssetCache.h"
+#include "CookedCache.h"
 
 namespace fire_engine
 {
@@ -24,6 +27,8 @@ class Image;
 class AnimatedMeshMD2;
 class AnimatedMeshMD3;
 class Q3Map;
+class CompressedImage;
+class AssetStreamer;
 
 namespace io
 {
@@ -35,27 +40,30 @@ struct _FIRE_ENGINE_API_ MediaHolder
 {
 	HashTable<String, ILoader<T> *, StringHashIgnoreCase, StringHashIgnoreCase> m_loaders;
 	HashTable<String, IWriter<T> *, StringHashIgnoreCase, StringHashIgnoreCase> m_writers;
+	mutable AssetCache<T> m_cache;
 
 	virtual ~MediaHolder()
 	{
-		Array<ILoader<T>*> * loaders = m_loaders.values();
-		Array<IWriter<T>*> * writers = m_writers.values();
-		for (s32 i = 0; i < loaders->size(); i++)
-			delete loaders->at(i);
-//		for (s32 i = 0; i < writers->size(); i++)
-//			delete writers->at(i);
-		delete loaders;
-		delete writers;
+		typename HashTable<String, ILoader<T> *, StringHashIgnoreCase, StringHashIgnoreCase>::iterator it = m_loaders.begin();
+		for (; it != m_loaders.end(); ++it)
+			delete it.getValue();
 	}
 };
 
 /** The MediaManager provides an easy-to-use interface for loading Media from disk. It should
  be used whenever some type of media (image, 3d model) is to be loaded, instead of manually
- creating a loader and using it. A default set of loaders is provided. */
+ creating a loader and using it. A default set of loaders is provided.
+ Loaded media is kept in a cache for each type of media (see getCache()), so that loading
+ the same file twice returns the same object. If a CookedCache is set, media whose loader
+ has a cooked format is loaded from it when it can be, and saved in it otherwise.
+ Media can also be loaded in the background with loadAsync(), by the worker threads of an
+ AssetStreamer, which is created the first time it is needed. Those loads go through the
+ same caches. */
 class _FIRE_ENGINE_API_ MediaManager : public MediaHolder<Image>, 
 	                                   public MediaHolder<AnimatedMeshMD2>,
 	                                   public MediaHolder<AnimatedMeshMD3>, 
-									   public MediaHolder<Q3Map>
+									   public MediaHolder<Q3Map>,
+	                                   public MediaHolder<CompressedImage>
 {
 public:
 	static MediaManager * Create();
@@ -70,18 +78,41 @@ public:
 		MediaHolder<Object>::m_loaders.insert(extension, loader);
 	}
 
+	/** Returns the loader of a type of media for a file extension, to change its settings.
+	 \return The loader, or nullptr if there is none. */
+	template <class Object>
+	ILoader<Object> * getLoader(const String& extension) const
+	{
+		ILoader<Object> * const * loader = MediaHolder<Object>::m_loaders.find(extension);
+		return loader != 0 ? *loader : nullptr;
+	}
+
 	template <class Object>
 	void addWriter(const String& extension, IWriter<Object> * writer)
 	{
 		MediaHolder<Object>::m_writers.insert(extension, writer);
 	}
 
+	/** Loads a file, or returns the object loaded from it before if it is still cached.
+	 \return The object, which the caller must drop, or 0 if it could not be loaded. The
+	         object may be shared with other callers: it must not be modified. */
 	template <class Object>
 	Object * load(const String& filename, io::IFileProvider * fileProvider = nullptr) const
 	{
+		AssetCache<Object>& cache = MediaHolder<Object>::m_cache;
+		InternedString key = AssetCache<Object>::MakeKey(filename, fileProvider);
+		Object * cached = cache.find(key);
+		if (cached != 0)
+			return cached;
+
 		ILoader<Object> ** loader = MediaHolder<Object>::m_loaders.find(io::FileUtils::GetFileExtension(filename));
 		if (loader != 0)
-			return (*loader)->load(filename, fileProvider);
+		{
+			Object * object = loadUncached(filename, fileProvider, *loader);
+			if (object == 0)
+				return 0;
+			return cache.insert(key, object, GetResidentBytes(object));
+		}
 		else // No loader registered for that type
 		{
 			Logger::Get()->log(ES_DEBUG, "MediaManager", "Couldn't find a loader for file %s",
@@ -90,6 +121,64 @@ public:
 		}
 	}
 
+	/** Returns the cache of a type of media, to change its budget or read its
+	 statistics. */
+	template <class Object>
+	AssetCache<Object>& getCache()
+	{
+		return MediaHolder<Object>::m_cache;
+	}
+
+	/** Starts loading a file in the background.
+	 \return A request that the caller must drop, and which gives the object once it is
+	         ready, or 0 if there is no loader for the file. */
+	template <class Object>
+	AsyncLoad<Object> * loadAsync(const String& filename, io::IFileProvider * fileProvider = nullptr)
+	{
+		AsyncLoad<Object> * request = createAsyncLoad<Object>(filename, fileProvider);
+		if (request != 0)
+			stream(request);
+		return request;
+	}
+
+	/** Starts loading a file in the background, for an object at a given position: the
+	 closest objects to the viewer are loaded first.
+	 \return A request that the caller must drop, and which gives the object once it is
+	         ready, or 0 if there is no loader for the file. */
+	template <class Object>
+	AsyncLoad<Object> * loadAsync(const String& filename, const vector3f& position,
+		io::IFileProvider * fileProvider = nullptr)
+	{
+		AsyncLoad<Object> * request = createAsyncLoad<Object>(filename, fileProvider);
+		if (request != 0)
+		{
+			request->setPosition(position);
+			stream(request);
+		}
+		return request;
+	}
+
+	/** Queues a request to load something in the background. */
+	void stream(IAsyncLoad * request);
+
+	/** Returns the AssetStreamer used for background loading, creating it if needed. */
+	AssetStreamer * getStreamer();
+
+	/** Returns whether the AssetStreamer has been created. */
+	bool isStreaming() const;
+
+	/** Sets the number of worker threads of the AssetStreamer. This has no effect once
+	 the AssetStreamer has been created. */
+	void setStreamingThreads(s32 threads);
+
+	/** Sets the directory of the CookedCache. Call this before anything is loaded in the
+	 background.
+	 \param directory The directory, or an empty String to stop using the CookedCache. */
+	void setCookedCacheDirectory(const String& directory);
+
+	/** Returns the CookedCache, or nullptr if there is none. */
+	CookedCache * getCookedCache() const;
+
 	template <class Object>
 	bool write(const String& filename, const Object * object) const
 	{
@@ -104,8 +193,102 @@ public:
 
 private:
 	static MediaManager * mInstance;
+	AssetStreamer *       mStreamer;
+	s32                   mStreamingThreads;
+	CookedCache *         mCookedCache;
 
 	MediaManager();
+
+	/** Returns the memory used by an Image, for its cache. */
+	static u32 GetResidentBytes(const Image * image);
+
+	/** Returns the memory used by a compressed image, for its cache. */
+	static u32 GetResidentBytes(const CompressedImage * image);
+
+	/** Returns the memory used by meshes and maps, for their cache, as they count it. */
+	template <class Object>
+	static u32 GetResidentBytes(const Object * object)
+	{
+		return object->getResidentBytes();
+	}
+
+	/** Loads a file with a loader, from the CookedCache if it is there, and saves it in the
+	 CookedCache otherwise. The cache of loaded media is not used.
+	 \return The object, which the caller must drop, or 0 if it could not be loaded. */
+	template <class Object>
+	Object * loadUncached(const String& filename, io::IFileProvider * fileProvider,
+		const ILoader<Object> * loader) const
+	{
+		Object * object = 0;
+		io::file_stat_t source;
+		const bool cookable = mCookedCache != 0 && loader->getCookedVersion() != 0 &&
+			CookedCache::GetSourceStat(filename, fileProvider, source);
+		if (cookable)
+			object = mCookedCache->load(filename, source, loader);
+		if (object == 0)
+		{
+			object = loader->load(filename, fileProvider);
+			if (object != 0 && cookable)
+				mCookedCache->store(filename, source, loader, (const Object *)object);
+		}
+		return object;
+	}
+
+	/** A request to load a file in the background, as load() does. A worker thread looks
+	 the file up in the cache, and loads it if it is not there; the main thread adds what
+	 was loaded to the cache in finish(). */
+	template <class Object>
+	class CachedAsyncLoad : public AsyncLoad<Object>
+	{
+	public:
+		CachedAsyncLoad(const MediaManager * manager, const ILoader<Object> * loader,
+			const String& filename, io::IFileProvider * fileProvider)
+			: AsyncLoad<Object>(loader, filename, fileProvider), mManager(manager),
+			  mKey(AssetCache<Object>::MakeKey(filename, fileProvider)), mCached(false)
+		{
+		}
+
+		virtual bool load()
+		{
+			this->mResult = mManager->MediaHolder<Object>::m_cache.find(mKey);
+			mCached = this->mResult != 0;
+			if (!mCached)
+				this->mResult = mManager->loadUncached(this->getFilename(), this->mFileProvider,
+					this->mLoader);
+			return this->mResult != 0;
+		}
+
+		virtual bool finish()
+		{
+			if (!mCached)
+			{
+				this->mResult = mManager->MediaHolder<Object>::m_cache.insert(mKey, this->mResult,
+					GetResidentBytes(this->mResult));
+				mCached = true;
+			}
+			return true;
+		}
+
+	private:
+		const MediaManager * mManager;
+		InternedString       mKey;
+		//! Whether mResult came from the cache, or has been added to it
+		bool                 mCached;
+	};
+
+	/** Creates a request to load a file, without queueing it. */
+	template <class Object>
+	AsyncLoad<Object> * createAsyncLoad(const String& filename, io::IFileProvider * fileProvider) const
+	{
+		ILoader<Object> ** loader = MediaHolder<Object>::m_loaders.find(io::FileUtils::GetFileExtension(filename));
+		if (loader == 0)
+		{
+			Logger::Get()->log(ES_DEBUG, "MediaManager", "Couldn't find a loader for file %s",
+				filename.c_str());
+			return 0;
+		}
+		return new CachedAsyncLoad<Object>(this, *loader, filename, fileProvider);
+	}
 };
 
 }
@@ -87,6 +87,16 @@ s32 MemoryFile::getCurrentPosition() const
 	return mCurrentOffset;
 }
 
+const void * MemoryFile::getData() const
+{
+	return mData;
+}
+
+s32 MemoryFile::getSize() const
+{
+	return mDataSize;
+}
+
 bool MemoryFile::remove()
 {
 	ErrorOccured = true;
@@ -40,6 +40,10 @@ public:
 
 	virtual s32 getCurrentPosition() const;
 
+	virtual const void * getData() const;
+
+	virtual s32 getSize() const;
+
 	virtual bool remove();
 
 	virtual bool close();
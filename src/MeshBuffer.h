@@ -32,19 +32,19 @@ public:
 
 	virtual inline s32 getVertexCount() const;
 
-	virtual inline const Array<u32> * getIndices() const;
+	virtual inline const IndexBuffer * getIndices() const;
 
 	virtual inline const ITexture * getTexture() const ;
 
 	virtual void setTexture(ITexture * texture);
 
-	virtual inline Material getMaterial() const;
+	virtual inline material_handle_t getMaterialHandle() const;
 
 	virtual inline const AABoundingBoxf& getBoundingBox() const;
 
 private:
 	Vertex3 *      Vertices;
-	Array<u32> *   Indices;
+	IndexBuffer *  Indices;
 	EPOLYGON_TYPE  PolygonType;
 	ITexture *     Texture;
 	s32            VertexCount;
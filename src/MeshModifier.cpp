@@ -2,7 +2,7 @@
 #include "IMesh.h"
 #include "IMeshBuffer.h"
 #include "Vertex3.h"
-#include "vector3.h"
+#include "VertexTransform.h"
 
 
 namespace fire_engine
@@ -10,18 +10,11 @@ namespace fire_engine
 
 void MeshModifier::ApplyTransform(IMesh * mesh, const matrix4f& transform)
 {
-	IMeshBuffer * mb = 0;
-	Vertex3 * vertices = 0;
 	for (s32 i = 0; i < mesh->getMeshBufferCount(); i++)
 	{
-		mb = mesh->getMeshBuffer(i);
-		vertices = mb->_getOriginalVertices();
-		for (s32 j = 0; j < mb->_getOriginalVertexCount(); j++)
-		{
-			vertices[j].setPosition(transform.applyTransformation(vertices[j].getPosition()));
-			vertices[j].setNormal(transform.applyTransformation(vertices[j].getNormal()));
-			vertices[j].getNormal().normalize();
-		}
+		IMeshBuffer * mb = mesh->getMeshBuffer(i);
+		VertexTransform::TransformVertices(transform, mb->_getOriginalVertices(),
+			mb->_getOriginalVertexCount());
 	}
 }
 
@@ -16,7 +16,8 @@ class IMesh;
 class _FIRE_ENGINE_API_ MeshModifier
 {
 public:
-	/** Applies a given transform to all the vertices in the IMesh. */
+	/** Applies a given transform to all the vertices in the IMesh. Normals are transformed
+	 by the inverse of its transpose, and normalized. */
 	static void ApplyTransform(IMesh * mesh, const matrix4f& transform);
 
 };
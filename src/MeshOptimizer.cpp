@@ -0,0 +1,478 @@
+/**
+ * FILE:    MeshOptimizer.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the MeshOptimizer class.
+**/
+
+#include "MeshOptimizer.h"
+#include "Vertex3.h"
+#include "String.h"
+#include "Logger.h"
+#include "Math.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace fire_engine
+{
+
+//! The scores of Forsyth's algorithm: vertices used by the last triangle score a bit less
+//! than those just before them, so that strips are not favoured
+#define MESH_OPTIMIZER_LAST_TRIANGLE_SCORE 0.75f
+#define MESH_OPTIMIZER_CACHE_DECAY_POWER   1.5f
+#define MESH_OPTIMIZER_VALENCE_BOOST_SCALE 2.0f
+#define MESH_OPTIMIZER_VALENCE_BOOST_POWER 0.5f
+//! The number of triangles of a vertex whose valence score is kept in a table
+#define MESH_OPTIMIZER_VALENCE_TABLE_SIZE  64
+
+//! The scores of vertices, by their position in the cache and their triangles left
+class VertexScores
+{
+public:
+	VertexScores()
+	{
+		for (s32 i = 0; i < MeshOptimizer::CACHE_SIZE; i++)
+		{
+			if (i < 3)
+			{
+				mCache[i] = MESH_OPTIMIZER_LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				const f32 scale = 1.0f - (f32)(i - 3) / (MeshOptimizer::CACHE_SIZE - 3);
+				mCache[i] = Math32::Pow(scale, MESH_OPTIMIZER_CACHE_DECAY_POWER);
+			}
+		}
+		mValence[0] = 0.0f;
+		for (s32 i = 1; i < MESH_OPTIMIZER_VALENCE_TABLE_SIZE; i++)
+			mValence[i] = getValenceScore(i);
+	}
+
+	f32 get(s32 cachePosition, s32 remaining) const
+	{
+		// Vertices without any triangle left are never looked at again
+		if (remaining == 0)
+			return -1.0f;
+		f32 score = cachePosition >= 0 ? mCache[cachePosition] : 0.0f;
+		if (remaining < MESH_OPTIMIZER_VALENCE_TABLE_SIZE)
+			return score + mValence[remaining];
+		return score + getValenceScore(remaining);
+	}
+
+private:
+	f32 mCache[MeshOptimizer::CACHE_SIZE];
+	f32 mValence[MESH_OPTIMIZER_VALENCE_TABLE_SIZE];
+
+	//! Vertices with few triangles left score more, so that they are not left behind
+	static f32 getValenceScore(s32 remaining)
+	{
+		return MESH_OPTIMIZER_VALENCE_BOOST_SCALE *
+			Math32::Pow((f32)remaining, -MESH_OPTIMIZER_VALENCE_BOOST_POWER);
+	}
+};
+
+void MeshOptimizer::OptimizeVertexCache(u32 * indices, s32 indexCount, s32 vertexCount)
+{
+	const s32 triangleCount = indexCount / 3;
+	if (triangleCount <= 1)
+		return;
+
+	// The triangles of each vertex, those that are not drawn yet first
+	s32 * remaining = new s32[vertexCount];
+	s32 * first     = new s32[vertexCount];
+	s32 * triangles = new s32[3*triangleCount];
+	memset(remaining, 0, vertexCount*sizeof(s32));
+	for (s32 i = 0; i < 3*triangleCount; i++)
+		remaining[indices[i]]++;
+	s32 offset = 0;
+	for (s32 v = 0; v < vertexCount; v++)
+	{
+		first[v] = offset;
+		offset += remaining[v];
+		remaining[v] = 0;
+	}
+	for (s32 i = 0; i < 3*triangleCount; i++)
+	{
+		const u32 v = indices[i];
+		triangles[first[v] + remaining[v]++] = i / 3;
+	}
+
+	const VertexScores scores;
+	s32 * cachePositions = new s32[vertexCount];
+	f32 * vertexScores   = new f32[vertexCount];
+	for (s32 v = 0; v < vertexCount; v++)
+	{
+		cachePositions[v] = -1;
+		vertexScores[v]   = scores.get(-1, remaining[v]);
+	}
+
+	f32 *  triangleScores = new f32[triangleCount];
+	bool * drawn          = new bool[triangleCount];
+	s32    best           = 0;
+	for (s32 t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[3*t]] + vertexScores[indices[3*t+1]] +
+			vertexScores[indices[3*t+2]];
+		drawn[t] = false;
+		if (triangleScores[t] > triangleScores[best])
+			best = t;
+	}
+
+	u32 * result = new u32[3*triangleCount];
+	s32   cache[CACHE_SIZE+3];
+	s32   cacheCount = 0;
+	s32   nextUndrawn = 0;
+	for (s32 n = 0; n < triangleCount; n++)
+	{
+		if (best < 0)
+		{
+			// None of the vertices in the cache has a triangle left: start anywhere else
+			while (drawn[nextUndrawn])
+				nextUndrawn++;
+			best = nextUndrawn;
+		}
+		const u32 * triangle = &indices[3*best];
+		result[3*n]   = triangle[0];
+		result[3*n+1] = triangle[1];
+		result[3*n+2] = triangle[2];
+		drawn[best] = true;
+
+		// Its vertices have one triangle less left
+		for (s32 k = 0; k < 3; k++)
+		{
+			const u32 v = triangle[k];
+			s32 * list = &triangles[first[v]];
+			for (s32 j = 0; j < remaining[v]; j++)
+			{
+				if (list[j] == best)
+				{
+					list[j] = list[--remaining[v]];
+					break;
+				}
+			}
+		}
+
+		// Its vertices go to the front of the cache, and the last ones are pushed out
+		s32 newCache[CACHE_SIZE+3];
+		s32 newCount = 0;
+		for (s32 k = 0; k < 3; k++)
+		{
+			if (k == 0 || triangle[k] != triangle[0])
+			{
+				if (k < 2 || triangle[2] != triangle[1])
+					newCache[newCount++] = triangle[k];
+			}
+		}
+		for (s32 i = 0; i < cacheCount; i++)
+		{
+			const s32 v = cache[i];
+			if ((u32)v != triangle[0] && (u32)v != triangle[1] && (u32)v != triangle[2])
+				newCache[newCount++] = v;
+		}
+
+		// Their scores change, and those of their triangles
+		for (s32 i = 0; i < newCount; i++)
+		{
+			const s32 v = newCache[i];
+			cachePositions[v] = i < CACHE_SIZE ? i : -1;
+			const f32 score = scores.get(cachePositions[v], remaining[v]);
+			const f32 delta = score - vertexScores[v];
+			vertexScores[v] = score;
+			for (s32 j = 0; j < remaining[v]; j++)
+				triangleScores[triangles[first[v] + j]] += delta;
+		}
+		cacheCount = newCount < CACHE_SIZE ? newCount : CACHE_SIZE;
+		memcpy(cache, newCache, cacheCount*sizeof(s32));
+
+		// The next triangle is the best of those using the vertices in the cache
+		best = -1;
+		for (s32 i = 0; i < cacheCount; i++)
+		{
+			const s32 v = cache[i];
+			for (s32 j = 0; j < remaining[v]; j++)
+			{
+				const s32 t = triangles[first[v] + j];
+				if (best < 0 || triangleScores[t] > triangleScores[best])
+					best = t;
+			}
+		}
+	}
+	memcpy(indices, result, 3*triangleCount*sizeof(u32));
+
+	delete [] result;
+	delete [] drawn;
+	delete [] triangleScores;
+	delete [] vertexScores;
+	delete [] cachePositions;
+	delete [] triangles;
+	delete [] first;
+	delete [] remaining;
+}
+
+//! A FIFO cache of vertices, which counts the vertices it misses
+class FIFOCache
+{
+public:
+	FIFOCache(s32 vertexCount, s32 size)
+		: mTimes(new s32[vertexCount]), mTime(size+1), mSize(size)
+	{
+		memset(mTimes, 0, vertexCount*sizeof(s32));
+	}
+
+	~FIFOCache()
+	{
+		delete [] mTimes;
+	}
+
+	//! Empties the cache
+	void reset()
+	{
+		mTime += mSize+1;
+	}
+
+	//! Returns the number of vertices of a triangle that were not in the cache
+	s32 add(const u32 * triangle)
+	{
+		s32 misses = 0;
+		for (s32 k = 0; k < 3; k++)
+		{
+			if (mTime - mTimes[triangle[k]] >= mSize)
+			{
+				mTimes[triangle[k]] = ++mTime;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+private:
+	//! When each vertex was last added
+	s32 * mTimes;
+	s32   mTime;
+	s32   mSize;
+
+	// Copying is not supported
+	FIFOCache(const FIFOCache&);
+	FIFOCache& operator=(const FIFOCache&);
+};
+
+f32 MeshOptimizer::GetACMR(const u32 * indices, s32 indexCount, s32 vertexCount, s32 cacheSize)
+{
+	const s32 triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return 0.0f;
+	FIFOCache cache(vertexCount, cacheSize);
+	s32 misses = 0;
+	for (s32 t = 0; t < triangleCount; t++)
+		misses += cache.add(&indices[3*t]);
+	return (f32)misses / triangleCount;
+}
+
+//! A cluster of triangles, and how much it faces outwards
+typedef struct
+{
+	s32 First;
+	s32 Count;
+	f32 Key;
+} cluster_t;
+
+//! Sorts clusters facing outwards first, then in the order they were in
+static int CompareClusters(const void * a, const void * b)
+{
+	const cluster_t * ca = static_cast<const cluster_t *>(a);
+	const cluster_t * cb = static_cast<const cluster_t *>(b);
+	if (ca->Key != cb->Key)
+		return ca->Key > cb->Key ? -1 : 1;
+	return ca->First - cb->First;
+}
+
+void MeshOptimizer::OptimizeOverdraw(u32 * indices, s32 indexCount, const Vertex3 * vertices,
+	s32 vertexCount, f32 threshold)
+{
+	const s32 triangleCount = indexCount / 3;
+	if (triangleCount <= 1)
+		return;
+
+	// The ordered triangles go back to 3 misses where the cache ran out of triangles,
+	// which are the boundaries that can be moved without losing anything. The first part
+	// starts at the first triangle, whether it misses or not.
+	Array<s32> hard;
+	hard.push_back(0);
+	{
+		FIFOCache cache(vertexCount, ACMR_CACHE_SIZE);
+		for (s32 t = 0; t < triangleCount; t++)
+		{
+			if (cache.add(&indices[3*t]) == 3 && t != 0)
+				hard.push_back(t);
+		}
+	}
+	hard.push_back(triangleCount);
+
+	// Each part is then split where the ACMR from its last split is low enough
+	Array<cluster_t> clusters;
+	FIFOCache cache(vertexCount, ACMR_CACHE_SIZE);
+	for (s32 h = 0; h + 1 < hard.size(); h++)
+	{
+		const s32 start = hard[h];
+		const s32 end   = hard[h+1];
+		cache.reset();
+		s32 misses = 0;
+		for (s32 t = start; t < end; t++)
+			misses += cache.add(&indices[3*t]);
+		const f32 limit = threshold * misses / (end - start);
+
+		cache.reset();
+		cluster_t cluster;
+		cluster.First = start;
+		cluster.Key   = 0.0f;
+		misses = 0;
+		for (s32 t = start; t < end; t++)
+		{
+			misses += cache.add(&indices[3*t]);
+			const s32 count = t + 1 - cluster.First;
+			if (t + 1 == end || misses <= limit * count)
+			{
+				cluster.Count = count;
+				clusters.push_back(cluster);
+				cluster.First = t + 1;
+				misses = 0;
+				cache.reset();
+			}
+		}
+	}
+
+	// Clusters whose centre is ahead of their normal, from the centre of the mesh, face
+	// outwards
+	vector3f * centres = new vector3f[clusters.size()];
+	vector3f * normals = new vector3f[clusters.size()];
+	vector3f meshCentre(0.0f, 0.0f, 0.0f);
+	f32 meshArea = 0.0f;
+	for (s32 c = 0; c < clusters.size(); c++)
+	{
+		vector3f centre(0.0f, 0.0f, 0.0f);
+		vector3f normal(0.0f, 0.0f, 0.0f);
+		f32 area = 0.0f;
+		for (s32 t = clusters[c].First; t < clusters[c].First + clusters[c].Count; t++)
+		{
+			const vector3f a = vertices[indices[3*t]].getPosition();
+			const vector3f b = vertices[indices[3*t+1]].getPosition();
+			const vector3f d = vertices[indices[3*t+2]].getPosition();
+			const vector3f n = (b - a).cross(d - a);
+			const f32 triangleArea = n.length() * 0.5f;
+			centre += (a + b + d) * (triangleArea / 3.0f);
+			normal += n;
+			area += triangleArea;
+		}
+		meshCentre += centre;
+		meshArea += area;
+		centres[c] = area > 0.0f ? centre / area : centre;
+		normals[c] = normal;
+	}
+	if (meshArea > 0.0f)
+		meshCentre /= meshArea;
+	for (s32 c = 0; c < clusters.size(); c++)
+	{
+		const f32 length = normals[c].length();
+		if (length > 0.0f)
+			clusters[c].Key = (centres[c] - meshCentre).dot(normals[c]) / length;
+	}
+	delete [] normals;
+	delete [] centres;
+
+	clusters.sort(CompareClusters);
+	u32 * result = new u32[3*triangleCount];
+	u8 * copied = new u8[triangleCount];
+	memset(copied, 0, triangleCount);
+	s32 n = 0;
+	bool permutation = true;
+	for (s32 c = 0; c < clusters.size() && permutation; c++)
+	{
+		for (s32 t = clusters[c].First; t < clusters[c].First + clusters[c].Count; t++)
+		{
+			if (t >= triangleCount || copied[t] != 0)
+			{
+				permutation = false;
+				break;
+			}
+			copied[t] = 1;
+		}
+		if (permutation)
+		{
+			memcpy(&result[n], &indices[3*clusters[c].First], 3*clusters[c].Count*sizeof(u32));
+			n += 3*clusters[c].Count;
+		}
+	}
+
+	// The clusters must hold every triangle once, or the indices are left as they were
+	if (permutation && n == 3*triangleCount)
+		memcpy(indices, result, 3*triangleCount*sizeof(u32));
+	else
+		Logger::Get()->log(ES_HIGH, "MeshOptimizer",
+			"The clusters of a mesh do not hold all its triangles, they are not reordered");
+	delete [] copied;
+	delete [] result;
+}
+
+void MeshOptimizer::OptimizeVertexFetch(u32 * indices, s32 indexCount, s32 vertexCount, u32 * remap)
+{
+	const u32 unused = 0xFFFFFFFF;
+	for (s32 v = 0; v < vertexCount; v++)
+		remap[v] = unused;
+	u32 next = 0;
+	for (s32 i = 0; i < indexCount; i++)
+	{
+		if (remap[indices[i]] == unused)
+			remap[indices[i]] = next++;
+		indices[i] = remap[indices[i]];
+	}
+	for (s32 v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] == unused)
+			remap[v] = next++;
+	}
+}
+
+void MeshOptimizer::RemapVertices(Vertex3 * vertices, s32 vertexCount, s32 frameCount, const u32 * remap)
+{
+	Vertex3 * frame = new Vertex3[vertexCount];
+	for (s32 f = 0; f < frameCount; f++)
+	{
+		Vertex3 * frameVertices = &vertices[f*vertexCount];
+		for (s32 v = 0; v < vertexCount; v++)
+			frame[remap[v]] = frameVertices[v];
+		for (s32 v = 0; v < vertexCount; v++)
+			frameVertices[v] = frame[v];
+	}
+	delete [] frame;
+}
+
+void MeshOptimizer::Optimize(const String& name, Array<u32>& indices, Vertex3 * vertices,
+	s32 verticesPerFrame, s32 frameCount, bool overdraw)
+{
+	const s32 indexCount = indices.size() - indices.size() % 3;
+	u32 * data = indices.pointer();
+	for (s32 i = 0; i < indexCount; i++)
+	{
+		if (data[i] >= (u32)verticesPerFrame)
+		{
+			Logger::Get()->log(ES_MEDIUM, "MeshOptimizer",
+				"Mesh %s has an index out of range, it is not optimized", name.c_str());
+			return;
+		}
+	}
+	if (indexCount < 6)
+		return;
+
+	const f32 before = GetACMR(data, indexCount, verticesPerFrame);
+	OptimizeVertexCache(data, indexCount, verticesPerFrame);
+	if (overdraw)
+		OptimizeOverdraw(data, indexCount, vertices, verticesPerFrame, 1.05f);
+	u32 * remap = new u32[verticesPerFrame];
+	OptimizeVertexFetch(data, indexCount, verticesPerFrame, remap);
+	RemapVertices(vertices, verticesPerFrame, frameCount, remap);
+	delete [] remap;
+	Logger::Get()->log(ES_DEBUG, "MeshOptimizer", "Mesh %s: ACMR %.3f before, %.3f after",
+		name.c_str(), before, GetACMR(data, indexCount, verticesPerFrame));
+}
+
+} // namespace fire_engine
@@ -0,0 +1,87 @@
+/**
+ * FILE:    MeshOptimizer.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Reordering of triangle lists for the post-transform vertex cache of the GPU.
+**/
+
+#ifndef MESHOPTIMIZER_H_INCLUDED
+#define MESHOPTIMIZER_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "Array.h"
+
+namespace fire_engine
+{
+
+class Vertex3;
+class String;
+
+/** Reorders the triangles of triangle lists so that the GPU transforms fewer vertices,
+ and the vertices so that they are read in order. This is done when meshes are loaded.
+ The triangles are ordered with the algorithm of Tom Forsyth, "Linear-Speed Vertex Cache
+ Optimisation". They can then be reordered by clusters, so that the clusters facing
+ outwards are drawn first and hide more of the others. */
+class _FIRE_ENGINE_API_ MeshOptimizer
+{
+public:
+	enum
+	{
+		//! The size of the LRU cache that the triangles are ordered for
+		CACHE_SIZE      = 32,
+		//! The size of the FIFO cache that the ACMR is measured with
+		ACMR_CACHE_SIZE = 16
+	};
+
+	/** Reorders the triangles of a triangle list for the vertex cache.
+	 \param indices     The indices, 3 per triangle.
+	 \param indexCount  The number of indices.
+	 \param vertexCount The number of vertices the indices refer to. */
+	static void OptimizeVertexCache(u32 * indices, s32 indexCount, s32 vertexCount);
+
+	/** Reorders clusters of the triangles of a triangle list ordered by
+	 OptimizeVertexCache(), so that those facing outwards are drawn first. The clusters are
+	 as small as they can be without their ACMR getting over threshold times that of the
+	 triangles in the order they are in.
+	 \param indices     The indices, 3 per triangle.
+	 \param indexCount  The number of indices.
+	 \param vertices    The vertices, whose positions are used.
+	 \param vertexCount The number of vertices.
+	 \param threshold   How much worse the ACMR can get, such as 1.05. */
+	static void OptimizeOverdraw(u32 * indices, s32 indexCount, const Vertex3 * vertices,
+		s32 vertexCount, f32 threshold);
+
+	/** Renumbers the vertices in the order they are first used by the indices, and changes
+	 the indices to refer to them. The vertices that are not used are numbered last.
+	 \param indices     The indices.
+	 \param indexCount  The number of indices.
+	 \param vertexCount The number of vertices.
+	 \param remap       Where to store the new number of each vertex, vertexCount of them. */
+	static void OptimizeVertexFetch(u32 * indices, s32 indexCount, s32 vertexCount, u32 * remap);
+
+	/** Moves vertices to the places given by OptimizeVertexFetch(), in each of a number of
+	 frames of vertexCount vertices, one after the other. */
+	static void RemapVertices(Vertex3 * vertices, s32 vertexCount, s32 frameCount, const u32 * remap);
+
+	/** Returns the average number of vertices that a FIFO cache misses per triangle, the
+	 ACMR, when drawing a triangle list. It is between 0.5 and 3, lower being better. */
+	static f32 GetACMR(const u32 * indices, s32 indexCount, s32 vertexCount,
+		s32 cacheSize = ACMR_CACHE_SIZE);
+
+	/** Optimizes the triangle list of a mesh whose vertices are stored for a number of
+	 frames, and logs its ACMR before and after.
+	 \param name             The name of the mesh, for the log.
+	 \param indices          The indices, 3 per triangle.
+	 \param vertices         The vertices of all the frames.
+	 \param verticesPerFrame The number of vertices of a frame, which the indices refer to.
+	 \param frameCount       The number of frames.
+	 \param overdraw         Whether to reorder the clusters with OptimizeOverdraw(), with the
+	                         positions of the first frame. */
+	static void Optimize(const String& name, Array<u32>& indices, Vertex3 * vertices,
+		s32 verticesPerFrame, s32 frameCount, bool overdraw);
+};
+
+} // namespace fire_engine
+
+#endif // MESHOPTIMIZER_H_INCLUDED
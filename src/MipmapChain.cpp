@@ -0,0 +1,236 @@
+/**
+ * FILE:    MipmapChain.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the MipmapChain class.
+**/
+
+#include "MipmapChain.h"
+#include "CPUInfo.h"
+#include "Math.h"
+#include <string.h>
+
+#ifdef _FIRE_ENGINE_SSE_
+#	include <emmintrin.h>
+#endif
+
+namespace fire_engine
+{
+
+//! Tables to go from sRGB to linear colours and back. Linear colours have 16 bits, and
+//! are converted back to sRGB from their 12 most significant bits.
+struct srgb_tables_t
+{
+	u16 ToLinear[256];
+	u8  FromLinear[4096];
+
+	srgb_tables_t()
+	{
+		for (s32 i = 0; i < 256; i++)
+		{
+			const f32 c = i / 255.0f;
+			const f32 l = c <= 0.04045f ? c / 12.92f : Math32::Pow((c + 0.055f) / 1.055f, 2.4f);
+			ToLinear[i] = (u16)(l * 65535.0f + 0.5f);
+		}
+		for (s32 i = 0; i < 4096; i++)
+		{
+			// The middle of the range of linear colours that share the entry
+			const f32 l = (i * 16 + 8) / 65535.0f;
+			const f32 c = l <= 0.0031308f ? l * 12.92f : 1.055f * Math32::Pow(l, 1.0f / 2.4f) - 0.055f;
+			FromLinear[i] = (u8)(Math32::Clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const srgb_tables_t SRGBTables;
+
+//! The fields of the 16 bit formats, in place: the average of the 4 pixels is taken for
+//! each field separately, without shifting them down
+static const u32 A1R5G5B5Fields[4] = { 0x8000, 0x7C00, 0x03E0, 0x001F };
+static const u32 R5G6B5Fields[4]   = { 0xF800, 0x07E0, 0x001F, 0x0000 };
+
+//! Averages 2x2 pixels of two rows of 16 bit pixels. x1 is 0 when the source is 1 pixel
+//! wide, and 1 otherwise.
+static void Downsample16(const u16 * r0, const u16 * r1, u16 * out, s32 count, s32 x1,
+	const u32 * fields)
+{
+	for (s32 x = 0; x < count; x++, r0 += 2, r1 += 2)
+	{
+		u32 pixel = 0;
+		for (s32 f = 0; f < 4 && fields[f] != 0; f++)
+		{
+			const u32 mask = fields[f];
+			const u32 sum  = (r0[0] & mask) + (r0[x1] & mask) + (r1[0] & mask) + (r1[x1] & mask);
+			// Add half of the lowest bit of the field times 4 to round to the nearest
+			pixel |= ((sum + ((mask & (0 - mask)) << 1)) >> 2) & mask;
+		}
+		out[x] = (u16)pixel;
+	}
+}
+
+//! Averages 2x2 pixels of two rows of 24 or 32 bit pixels, byte by byte
+static void Downsample8(const u8 * r0, const u8 * r1, u8 * out, s32 count, s32 x1,
+	s32 texelsize)
+{
+	const s32 next = x1 * texelsize;
+	for (s32 x = 0; x < count; x++, r0 += 2*texelsize, r1 += 2*texelsize)
+	{
+		for (s32 c = 0; c < texelsize; c++)
+			*out++ = (u8)((r0[c] + r0[next+c] + r1[c] + r1[next+c] + 2) >> 2);
+	}
+}
+
+//! Same as Downsample8(), in linear space. The 4th byte of 32 bit pixels is alpha.
+static void Downsample8SRGB(const u8 * r0, const u8 * r1, u8 * out, s32 count, s32 x1,
+	s32 texelsize)
+{
+	const u16 * linear = SRGBTables.ToLinear;
+	const s32   next   = x1 * texelsize;
+	for (s32 x = 0; x < count; x++, r0 += 2*texelsize, r1 += 2*texelsize, out += texelsize)
+	{
+		for (s32 c = 0; c < 3; c++)
+		{
+			const u32 sum = linear[r0[c]] + linear[r0[next+c]] + linear[r1[c]] + linear[r1[next+c]];
+			out[c] = SRGBTables.FromLinear[((sum + 2) >> 2) >> 4];
+		}
+		if (texelsize == 4)
+			out[3] = (u8)((r0[3] + r0[next+3] + r1[3] + r1[next+3] + 2) >> 2);
+	}
+}
+
+#ifdef _FIRE_ENGINE_SSE_
+
+//! Downsample8() for 32 bit pixels and sources at least 2 pixels wide, 4 pixels at a time
+static void Downsample32SSE2(const u8 * r0, const u8 * r1, u8 * out, s32 count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i half = _mm_set1_epi16(2);
+	for (; count >= 4; count -= 4, r0 += 32, r1 += 32, out += 16)
+	{
+		const __m128i a0 = _mm_loadu_si128((const __m128i *)r0);
+		const __m128i a1 = _mm_loadu_si128((const __m128i *)(r0 + 16));
+		const __m128i b0 = _mm_loadu_si128((const __m128i *)r1);
+		const __m128i b1 = _mm_loadu_si128((const __m128i *)(r1 + 16));
+		// Add the two rows, in 16 bits: each register holds 2 pixels
+		const __m128i p01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+		const __m128i p23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+		const __m128i p45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+		const __m128i p67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+		// Then the pairs of columns
+		__m128i q0 = _mm_add_epi16(_mm_unpacklo_epi64(p01, p23), _mm_unpackhi_epi64(p01, p23));
+		__m128i q1 = _mm_add_epi16(_mm_unpacklo_epi64(p45, p67), _mm_unpackhi_epi64(p45, p67));
+		q0 = _mm_srli_epi16(_mm_add_epi16(q0, half), 2);
+		q1 = _mm_srli_epi16(_mm_add_epi16(q1, half), 2);
+		_mm_storeu_si128((__m128i *)out, _mm_packus_epi16(q0, q1));
+	}
+	Downsample8(r0, r1, out, count, 1, 4);
+}
+
+#endif // _FIRE_ENGINE_SSE_
+
+MipmapChain::MipmapChain(const Image& image, bool sRGB)
+	: mType(image.type()), mTexelSize(image.getBytesPerPixel()), mData(0)
+{
+#if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
+	setDebugName("fire_engine::MipmapChain");
+#endif
+	mLevelCount = GetLevelCount(image.dim());
+	mOffsets[0] = 0;
+	dimension2i dim = image.dim();
+	for (s32 i = 0; i < mLevelCount; i++)
+	{
+		mDimensions[i] = dim;
+		mOffsets[i+1]  = mOffsets[i] + dim.getWidth()*dim.getHeight()*mTexelSize;
+		dim = dimension2i(dim.getWidth() > 1 ? dim.getWidth() / 2 : 1,
+			dim.getHeight() > 1 ? dim.getHeight() / 2 : 1);
+	}
+
+	mData = new u8[mOffsets[mLevelCount]];
+	memcpy(mData, image.data(), mOffsets[1]);
+	// Only bytes can be converted to linear space
+	sRGB = sRGB && (mTexelSize == 3 || mTexelSize == 4);
+	for (s32 i = 1; i < mLevelCount; i++)
+		downsample(i, sRGB);
+}
+
+MipmapChain::~MipmapChain()
+{
+	delete [] mData;
+}
+
+Image::EIMAGE_DATA_TYPE MipmapChain::getType() const
+{
+	return mType;
+}
+
+s32 MipmapChain::getLevelCount() const
+{
+	return mLevelCount;
+}
+
+const dimension2i& MipmapChain::getLevelDimension(s32 level) const
+{
+	return mDimensions[level];
+}
+
+const void * MipmapChain::getLevelData(s32 level) const
+{
+	return mData + mOffsets[level];
+}
+
+u32 MipmapChain::getSize() const
+{
+	return mOffsets[mLevelCount];
+}
+
+s32 MipmapChain::GetLevelCount(const dimension2i& dim)
+{
+	s32 largest = dim.getWidth() > dim.getHeight() ? dim.getWidth() : dim.getHeight();
+	if (largest <= 0)
+		return 0;
+	s32 count = 1;
+	while ((largest >>= 1) > 0)
+		count++;
+	return count;
+}
+
+void MipmapChain::downsample(s32 level, bool sRGB)
+{
+	const dimension2i& source = mDimensions[level-1];
+	const dimension2i& dim    = mDimensions[level];
+	const u8 * in  = mData + mOffsets[level-1];
+	u8 *       out = mData + mOffsets[level];
+	// A source 1 pixel wide or high uses the same pixel, or row, twice
+	const s32 x1    = source.getWidth() > 1 ? 1 : 0;
+	const s32 pitch = source.getWidth()*mTexelSize;
+#ifdef _FIRE_ENGINE_SSE_
+	const bool sse2 = mTexelSize == 4 && !sRGB && x1 == 1 && sys::CPUInfo::HasSSE2();
+#endif
+
+	for (s32 y = 0; y < dim.getHeight(); y++, out += dim.getWidth()*mTexelSize)
+	{
+		const u8 * r0 = in + 2*y*pitch;
+		const u8 * r1 = source.getHeight() > 1 ? r0 + pitch : r0;
+		if (mTexelSize == 2)
+		{
+			Downsample16((const u16 *)r0, (const u16 *)r1, (u16 *)out, dim.getWidth(), x1,
+				mType == Image::EIDT_R5G6B5 ? R5G6B5Fields : A1R5G5B5Fields);
+		}
+		else if (sRGB)
+		{
+			Downsample8SRGB(r0, r1, out, dim.getWidth(), x1, mTexelSize);
+		}
+#ifdef _FIRE_ENGINE_SSE_
+		else if (sse2)
+		{
+			Downsample32SSE2(r0, r1, out, dim.getWidth());
+		}
+#endif
+		else
+		{
+			Downsample8(r0, r1, out, dim.getWidth(), x1, mTexelSize);
+		}
+	}
+}
+
+} // namespace fire_engine
@@ -0,0 +1,78 @@
+/**
+ * FILE:    MipmapChain.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: The mipmaps of an image, all kept in one block of memory.
+**/
+
+#ifndef MIPMAPCHAIN_H_INCLUDED
+#define MIPMAPCHAIN_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "dimension2.h"
+#include "Image.h"
+#include "Object.h"
+
+namespace fire_engine
+{
+
+/** The complete chain of mipmaps of an image, from the image itself down to 1x1 pixel.
+ Every level is half the size of the previous one in both directions (rounded down, and
+ at least 1), and each of its pixels is the average of the 2x2 pixels it covers in the
+ previous level: a box filter. All the levels are kept one after the other in a single
+ allocation, and each is built from the previous one in one pass.
+ Colours in sRGB are averaged in linear space, so that the mipmaps of a texture do not get
+ darker as they get smaller. Alpha is always linear. 16 bit images are averaged as is. */
+class _FIRE_ENGINE_API_ MipmapChain : public virtual Object
+{
+public:
+	//! Enough levels for a 2^31 pixel wide image
+	enum { MAX_LEVELS = 32 };
+
+	/** Builds the mipmaps of an image.
+	 \param image The image. It must be loaded.
+	 \param sRGB  Whether the colours of the image are in sRGB. Only used for 24 and 32 bit
+	              images. */
+	MipmapChain(const Image& image, bool sRGB = false);
+
+	virtual ~MipmapChain();
+
+	/** Returns the format of the pixels of every level. */
+	Image::EIMAGE_DATA_TYPE getType() const;
+
+	/** Returns the number of levels, including the image itself. */
+	s32 getLevelCount() const;
+
+	/** Returns the size of a level, in pixels. Level 0 is the image itself. */
+	const dimension2i& getLevelDimension(s32 level) const;
+
+	/** Returns the pixels of a level. Rows are not padded. */
+	const void * getLevelData(s32 level) const;
+
+	/** Returns the memory used by all the levels, in bytes. */
+	u32 getSize() const;
+
+	/** Returns the number of levels in the complete chain of an image of a given size. */
+	static s32 GetLevelCount(const dimension2i& dim);
+
+private:
+	Image::EIMAGE_DATA_TYPE mType;
+	s32                     mTexelSize;
+	s32                     mLevelCount;
+	dimension2i             mDimensions[MAX_LEVELS];
+	//! Where each level starts in mData
+	u32                     mOffsets[MAX_LEVELS+1];
+	u8 *                    mData;
+
+	/** Builds a level from the previous one. */
+	void downsample(s32 level, bool sRGB);
+
+	// Copying is not supported
+	MipmapChain(const MipmapChain&);
+	MipmapChain& operator=(const MipmapChain&);
+};
+
+} // namespace fire_engine
+
+#endif // MIPMAPCHAIN_H_INCLUDED
@@ -0,0 +1,64 @@
+/**
+ * FILE:    Mutex.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the Mutex class.
+**/
+
+#include "Mutex.h"
+
+#if defined(_FIRE_ENGINE_WIN32_)
+#	include <windows.h>
+#else
+#	include <pthread.h>
+#endif
+
+namespace fire_engine
+{
+namespace sys
+{
+
+Mutex::Mutex()
+{
+#if defined(_FIRE_ENGINE_WIN32_)
+	CRITICAL_SECTION * section = new CRITICAL_SECTION;
+	InitializeCriticalSection(section);
+	mHandle = section;
+#else
+	pthread_mutex_t * mutex = new pthread_mutex_t;
+	pthread_mutex_init(mutex, 0);
+	mHandle = mutex;
+#endif
+}
+
+Mutex::~Mutex()
+{
+#if defined(_FIRE_ENGINE_WIN32_)
+	DeleteCriticalSection((CRITICAL_SECTION *)mHandle);
+	delete (CRITICAL_SECTION *)mHandle;
+#else
+	pthread_mutex_destroy((pthread_mutex_t *)mHandle);
+	delete (pthread_mutex_t *)mHandle;
+#endif
+}
+
+void Mutex::lock()
+{
+#if defined(_FIRE_ENGINE_WIN32_)
+	EnterCriticalSection((CRITICAL_SECTION *)mHandle);
+#else
+	pthread_mutex_lock((pthread_mutex_t *)mHandle);
+#endif
+}
+
+void Mutex::unlock()
+{
+#if defined(_FIRE_ENGINE_WIN32_)
+	LeaveCriticalSection((CRITICAL_SECTION *)mHandle);
+#else
+	pthread_mutex_unlock((pthread_mutex_t *)mHandle);
+#endif
+}
+
+} // namespace sys
+} // namespace fire_engine
@@ -0,0 +1,74 @@
+/**
+ * FILE:    Mutex.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A system independent mutual exclusion lock.
+**/
+
+#ifndef MUTEX_H_INCLUDED
+#define MUTEX_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+
+namespace fire_engine
+{
+namespace sys
+{
+
+/** A lock that only one thread can hold at a time. The lock is recursive on Windows but
+ not on other systems, so a thread must not lock a Mutex it already holds. */
+class _FIRE_ENGINE_API_ Mutex
+{
+public:
+	/** Constructor. */
+	Mutex();
+
+	/** Destructor. The Mutex must not be held. */
+	~Mutex();
+
+	/** Waits until the Mutex is free, and takes it. */
+	void lock();
+
+	/** Releases the Mutex. */
+	void unlock();
+
+private:
+	//! The system lock
+	void * mHandle;
+
+	// Copying is not supported
+	Mutex(const Mutex&);
+	Mutex& operator=(const Mutex&);
+};
+
+/** Holds a Mutex for as long as it exists: the Mutex is locked by the constructor, and
+ unlocked by the destructor. */
+class _FIRE_ENGINE_API_ MutexLock
+{
+public:
+	/** Locks a Mutex. */
+	explicit MutexLock(Mutex& mutex)
+		: mMutex(mutex)
+	{
+		mMutex.lock();
+	}
+
+	/** Unlocks the Mutex. */
+	~MutexLock()
+	{
+		mMutex.unlock();
+	}
+
+private:
+	Mutex& mMutex;
+
+	// Copying is not supported
+	MutexLock(const MutexLock&);
+	MutexLock& operator=(const MutexLock&);
+};
+
+} // namespace sys
+} // namespace fire_engine
+
+#endif // MUTEX_H_INCLUDED
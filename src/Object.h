@@ -12,7 +12,7 @@
 #include "CompileConfig.h"
 #include "Types.h"
 #include "String.h"
-#include "Counter.h"
+#include "ReferenceCount.h"
 #include "Array.h"
 #include <stdio.h>
 
@@ -27,8 +27,10 @@ namespace fire_engine
  The grab() method should be called whenever a new pointer/reference to a
  class deriving Object is made.
  drop() is to be used instead of delete, and it will take care of deleting
- the Object, if there are exactly zero references to it. */
-class _FIRE_ENGINE_API_ Object : public virtual Counter
+ the Object, if there are exactly zero references to it.
+ Unless _FIRE_ENGINE_SINGLE_THREADED_ is defined, the reference count is atomic, so an
+ Object can be grabbed and dropped from several threads at once. */
+class _FIRE_ENGINE_API_ Object
 {
 public:
 	/** Constructor: initialize the reference count, and set the debug name if
@@ -38,7 +40,11 @@ public:
 		: m_debug_name("")
 #endif
 	{
-		this->incrementCount();
+#if defined(_FIRE_ENGINE_DEBUG_REFCOUNT_)
+		m_reference_history_next = 0;
+		for (s32 i = 0; i < REFERENCE_HISTORY_SIZE; i++)
+			m_reference_history[i].File = 0;
+#endif
 	}
 
 	/** Destructor */
@@ -53,7 +59,7 @@ public:
 	 matched by a similar call to drop(), otherwise it could lead to memory leaks */
 	inline void grab()
 	{
-		this->incrementCount();
+		m_reference_count.increment();
 	}
 
 	/** Drop the object, ie. decrease the reference count. Deletes the object if
@@ -62,8 +68,34 @@ public:
 	         destroyed, false otherwise */
 	inline bool drop()
 	{
-		this->decrementCount();
-		if (this->getCount() == 0)
+		if (m_reference_count.decrement() == 0)
+		{
+			delete this;
+			return true;
+		}
+		return false;
+	}
+
+	/** Returns the number of references to the Object. When other threads hold references,
+	 the value may already be out of date when it is returned. */
+	inline s32 getReferenceCount() const
+	{
+		return m_reference_count.get();
+	}
+
+#if defined(_FIRE_ENGINE_DEBUG_REFCOUNT_)
+	/** grab(), recording the call site. Called through the grab() macro below. */
+	inline void _grab(const c8 * file, s32 line)
+	{
+		recordReferenceSite(file, line, m_reference_count.increment(), true);
+	}
+
+	/** drop(), recording the call site. Called through the drop() macro below. */
+	inline bool _drop(const c8 * file, s32 line)
+	{
+		s32 count = m_reference_count.decrement();
+		recordReferenceSite(file, line, count, false);
+		if (count == 0)
 		{
 			delete this;
 			return true;
@@ -71,6 +103,22 @@ public:
 		return false;
 	}
 
+	/** Prints the last grab() and drop() calls made on the Object, oldest first. */
+	void printReferenceHistory() const
+	{
+		printf("Reference history for %p (%d references):\n", (const void *)this,
+			getReferenceCount());
+		s32 next = m_reference_history_next;
+		for (s32 i = 0; i < REFERENCE_HISTORY_SIZE; i++)
+		{
+			const reference_site_t& site = m_reference_history[(next + i) % REFERENCE_HISTORY_SIZE];
+			if (site.File != 0)
+				printf("  %s %s:%d -> %d\n", site.Grab ? "grab" : "drop", site.File,
+					site.Line, site.Count);
+		}
+	}
+#endif
+
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	/** Set the debug name for the Object */
 	inline void setDebugName(String debug_name)
@@ -91,11 +139,46 @@ public:
 	}
 
 private:
+	ObjectReferenceCount m_reference_count;
+
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	String m_debug_name;
 #endif
+
+#if defined(_FIRE_ENGINE_DEBUG_REFCOUNT_)
+	enum { REFERENCE_HISTORY_SIZE = 16 };
+
+	//! A call to grab() or drop()
+	struct reference_site_t
+	{
+		const c8 * File;
+		s32        Line;
+		s32        Count;
+		bool       Grab;
+	};
+
+	reference_site_t m_reference_history[REFERENCE_HISTORY_SIZE];
+	volatile s32     m_reference_history_next;
+
+	inline void recordReferenceSite(const c8 * file, s32 line, s32 count, bool grab)
+	{
+		s32 i = AtomicFetchAdd(&m_reference_history_next, 1) % REFERENCE_HISTORY_SIZE;
+		if (i < 0)
+			i += REFERENCE_HISTORY_SIZE;
+		m_reference_history[i].File  = file;
+		m_reference_history[i].Line  = line;
+		m_reference_history[i].Count = count;
+		m_reference_history[i].Grab  = grab;
+	}
+#endif
 };
 
 }
 
+#if defined(_FIRE_ENGINE_DEBUG_REFCOUNT_)
+// Record the call site of every grab() and drop() made outside of this file
+#	define grab() _grab(__FILE__, __LINE__)
+#	define drop() _drop(__FILE__, __LINE__)
+#endif
+
 #endif // IOBJECT_H_INCLUDED
@@ -234,7 +234,15 @@ protected:
 					{
 						IMeshBuffer * mb = tree->Mesh->getMeshBuffer(i);
 						const Vertex3 * meshVertices = mb->getVertices();
-						const Array<u32> * nodeMBIndices = (indices != nullptr) ? indices[i] : mb->getIndices();
+						const Array<u32> * nodeMBIndices = (indices != nullptr) ? indices[i] : nullptr;
+						Array<u32> meshIndices;
+						if (indices == nullptr && mb->getIndices() != nullptr)
+						{
+							const IndexBuffer * buffer = mb->getIndices();
+							for (s32 k = 0; k < buffer->getCount(); k++)
+								meshIndices.push_back(buffer->at(k));
+							nodeMBIndices = &meshIndices;
+						}
 						Array<u32> * childIndices = nullptr;
 						if (nodeMBIndices != nullptr)
 						{
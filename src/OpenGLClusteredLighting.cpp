@@ -0,0 +1,349 @@
+/**
+ * FILE:    OpenGLClusteredLighting.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the OpenGLClusteredLighting class.
+**/
+
+#include "OpenGLClusteredLighting.h"
+#include "Light.h"
+#include "Logger.h"
+#include <math.h>
+#include <stdio.h>
+
+namespace fire_engine
+{
+
+// The OpenGL 2.0 functions, loaded by LoadFunctions()
+static PFNGLCREATESHADERPROC       s_CreateShader       = nullptr;
+static PFNGLSHADERSOURCEPROC       s_ShaderSource       = nullptr;
+static PFNGLCOMPILESHADERPROC      s_CompileShader      = nullptr;
+static PFNGLGETSHADERIVPROC        s_GetShaderiv        = nullptr;
+static PFNGLGETSHADERINFOLOGPROC   s_GetShaderInfoLog   = nullptr;
+static PFNGLDELETESHADERPROC       s_DeleteShader       = nullptr;
+static PFNGLCREATEPROGRAMPROC      s_CreateProgram      = nullptr;
+static PFNGLATTACHSHADERPROC       s_AttachShader       = nullptr;
+static PFNGLLINKPROGRAMPROC        s_LinkProgram        = nullptr;
+static PFNGLGETPROGRAMIVPROC       s_GetProgramiv       = nullptr;
+static PFNGLGETPROGRAMINFOLOGPROC  s_GetProgramInfoLog  = nullptr;
+static PFNGLDELETEPROGRAMPROC      s_DeleteProgram      = nullptr;
+static PFNGLUSEPROGRAMPROC         s_UseProgram         = nullptr;
+static PFNGLGETUNIFORMLOCATIONPROC s_GetUniformLocation = nullptr;
+static PFNGLUNIFORM1IPROC          s_Uniform1i          = nullptr;
+static PFNGLUNIFORM4FPROC          s_Uniform4f          = nullptr;
+static PFNGLACTIVETEXTUREPROC      s_ActiveTexture      = nullptr;
+
+static bool s_supported = false;
+
+//! The texture units of the clusters, the light indices and the lights
+#define CLUSTERED_FIRST_TEXTURE_UNIT 1
+
+static const c8 * s_vertexShader =
+	"varying vec3 EyePosition;\n"
+	"varying vec3 EyeNormal;\n"
+	"void main()\n"
+	"{\n"
+	"	EyePosition    = (gl_ModelViewMatrix * gl_Vertex).xyz;\n"
+	"	EyeNormal      = gl_NormalMatrix * gl_Normal;\n"
+	"	gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+	"	gl_Position    = ftransform();\n"
+	"}\n";
+
+// Lights as fixed function OpenGL does, with separate specular colour, but by pixel
+static const c8 * s_fragmentShader =
+	"uniform sampler2D DiffuseTexture;\n"
+	"uniform sampler2D ClusterTexture;\n"
+	"uniform sampler2D IndexTexture;\n"
+	"uniform sampler2D LightTexture;\n"
+	"uniform bool      UseTexture;\n"
+	"uniform int       GlobalLightCount;\n"
+	"// Tiles by pixel across and down, slices by log of depth, near plane\n"
+	"uniform vec4      ClusterScale;\n"
+	"varying vec3      EyePosition;\n"
+	"varying vec3      EyeNormal;\n"
+	"\n"
+	"void addLight(vec3 L, float attenuation, vec4 ambient, vec4 diffuse, vec4 specular,\n"
+	"	vec3 N, vec3 V, inout vec4 colour, inout vec4 highlight)\n"
+	"{\n"
+	"	float NdotL = max(dot(N, L), 0.0);\n"
+	"	colour += attenuation * (ambient * gl_FrontMaterial.ambient +\n"
+	"		NdotL * diffuse * gl_FrontMaterial.diffuse);\n"
+	"	if (NdotL > 0.0)\n"
+	"	{\n"
+	"		float NdotH = max(dot(N, normalize(L + V)), 0.0);\n"
+	"		highlight += attenuation * pow(NdotH, gl_FrontMaterial.shininess) *\n"
+	"			specular * gl_FrontMaterial.specular;\n"
+	"	}\n"
+	"}\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	vec3 N = normalize(EyeNormal);\n"
+	"	vec3 V = normalize(-EyePosition);\n"
+	"	vec4 colour    = gl_FrontMaterial.emission + gl_LightModel.ambient * gl_FrontMaterial.ambient;\n"
+	"	vec4 highlight = vec4(0.0);\n"
+	"\n"
+	"	// The lights without a range, set in the OpenGL lights\n"
+	"	for (int i = 0; i < GlobalLightCount; i++)\n"
+	"	{\n"
+	"		vec3  L = gl_LightSource[i].position.xyz;\n"
+	"		float attenuation = 1.0;\n"
+	"		if (gl_LightSource[i].position.w != 0.0)\n"
+	"		{\n"
+	"			L -= EyePosition;\n"
+	"			attenuation = 1.0 / (1.0 + gl_LightSource[i].quadraticAttenuation * dot(L, L));\n"
+	"			// Spot lights only light their cone\n"
+	"			if (gl_LightSource[i].spotCutoff != 180.0)\n"
+	"			{\n"
+	"				float spot = dot(-normalize(L), normalize(gl_LightSource[i].spotDirection));\n"
+	"				if (spot < gl_LightSource[i].spotCosCutoff)\n"
+	"					continue;\n"
+	"				attenuation *= pow(spot, gl_LightSource[i].spotExponent);\n"
+	"			}\n"
+	"		}\n"
+	"		addLight(normalize(L), attenuation, gl_LightSource[i].ambient,\n"
+	"			gl_LightSource[i].diffuse, gl_LightSource[i].specular, N, V, colour, highlight);\n"
+	"	}\n"
+	"\n"
+	"	// The lights of the cluster of the pixel\n"
+	"	vec2  tile    = min(floor(gl_FragCoord.xy * ClusterScale.xy), vec2(CLUSTERS_X - 1.0, CLUSTERS_Y - 1.0));\n"
+	"	float slice   = clamp(floor(log(-EyePosition.z / ClusterScale.w) * ClusterScale.z), 0.0, CLUSTERS_Z - 1.0);\n"
+	"	float cluster = (slice * CLUSTERS_Y + tile.y) * CLUSTERS_X + tile.x;\n"
+	"	vec2  lights  = texture2D(ClusterTexture, (vec2(mod(cluster, CLUSTERS_X * CLUSTERS_Y),\n"
+	"		floor(cluster / (CLUSTERS_X * CLUSTERS_Y))) + 0.5) / vec2(CLUSTERS_X * CLUSTERS_Y, CLUSTERS_Z)).xy;\n"
+	"	for (float i = lights.x; i < lights.x + lights.y; i += 1.0)\n"
+	"	{\n"
+	"		float index = texture2D(IndexTexture, (vec2(mod(i, INDEX_WIDTH), floor(i / INDEX_WIDTH)) + 0.5) /\n"
+	"			vec2(INDEX_WIDTH, INDEX_HEIGHT)).r;\n"
+	"		float v     = (index + 0.5) / MAX_LIGHTS;\n"
+	"		vec4  light = texture2D(LightTexture, vec2(0.1, v));\n"
+	"		vec4  spot  = texture2D(LightTexture, vec2(0.9, v));\n"
+	"		vec3  L     = light.xyz - EyePosition;\n"
+	"		float d     = dot(L, L) / (light.w * light.w);\n"
+	"		if (d < 1.0 && dot(-normalize(L), spot.xyz) >= spot.w)\n"
+	"		{\n"
+	"			addLight(normalize(L), 1.0 / (1.0 + RANGE_ATTENUATION * d),\n"
+	"				texture2D(LightTexture, vec2(0.3, v)), texture2D(LightTexture, vec2(0.5, v)),\n"
+	"				texture2D(LightTexture, vec2(0.7, v)), N, V, colour, highlight);\n"
+	"		}\n"
+	"	}\n"
+	"\n"
+	"	vec4 texel = UseTexture ? texture2D(DiffuseTexture, gl_TexCoord[0].st) : vec4(1.0);\n"
+	"	gl_FragColor = vec4(colour.rgb * texel.rgb + highlight.rgb, gl_FrontMaterial.diffuse.a * texel.a);\n"
+	"}\n";
+
+bool OpenGLClusteredLighting::LoadFunctions()
+{
+	s_CreateShader       = (PFNGLCREATESHADERPROC) wglGetProcAddress("glCreateShader");
+	s_ShaderSource       = (PFNGLSHADERSOURCEPROC) wglGetProcAddress("glShaderSource");
+	s_CompileShader      = (PFNGLCOMPILESHADERPROC) wglGetProcAddress("glCompileShader");
+	s_GetShaderiv        = (PFNGLGETSHADERIVPROC) wglGetProcAddress("glGetShaderiv");
+	s_GetShaderInfoLog   = (PFNGLGETSHADERINFOLOGPROC) wglGetProcAddress("glGetShaderInfoLog");
+	s_DeleteShader       = (PFNGLDELETESHADERPROC) wglGetProcAddress("glDeleteShader");
+	s_CreateProgram      = (PFNGLCREATEPROGRAMPROC) wglGetProcAddress("glCreateProgram");
+	s_AttachShader       = (PFNGLATTACHSHADERPROC) wglGetProcAddress("glAttachShader");
+	s_LinkProgram        = (PFNGLLINKPROGRAMPROC) wglGetProcAddress("glLinkProgram");
+	s_GetProgramiv       = (PFNGLGETPROGRAMIVPROC) wglGetProcAddress("glGetProgramiv");
+	s_GetProgramInfoLog  = (PFNGLGETPROGRAMINFOLOGPROC) wglGetProcAddress("glGetProgramInfoLog");
+	s_DeleteProgram      = (PFNGLDELETEPROGRAMPROC) wglGetProcAddress("glDeleteProgram");
+	s_UseProgram         = (PFNGLUSEPROGRAMPROC) wglGetProcAddress("glUseProgram");
+	s_GetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC) wglGetProcAddress("glGetUniformLocation");
+	s_Uniform1i          = (PFNGLUNIFORM1IPROC) wglGetProcAddress("glUniform1i");
+	s_Uniform4f          = (PFNGLUNIFORM4FPROC) wglGetProcAddress("glUniform4f");
+	s_ActiveTexture      = (PFNGLACTIVETEXTUREPROC) wglGetProcAddress("glActiveTexture");
+
+	s_supported = s_CreateShader != nullptr && s_ShaderSource != nullptr &&
+		s_CompileShader != nullptr && s_GetShaderiv != nullptr && s_GetShaderInfoLog != nullptr &&
+		s_DeleteShader != nullptr && s_CreateProgram != nullptr && s_AttachShader != nullptr &&
+		s_LinkProgram != nullptr && s_GetProgramiv != nullptr && s_GetProgramInfoLog != nullptr &&
+		s_DeleteProgram != nullptr && s_UseProgram != nullptr && s_GetUniformLocation != nullptr &&
+		s_Uniform1i != nullptr && s_Uniform4f != nullptr && s_ActiveTexture != nullptr;
+	return s_supported;
+}
+
+bool OpenGLClusteredLighting::IsSupported()
+{
+	return s_supported;
+}
+
+OpenGLClusteredLighting::OpenGLClusteredLighting()
+	: mProgram(0), mUseTextureLocation(-1), mGlobalLightCountLocation(-1),
+	  mClusterScaleLocation(-1), mLit(false), mTextured(false)
+{
+	mTextures[0] = mTextures[1] = mTextures[2] = 0;
+}
+
+OpenGLClusteredLighting::~OpenGLClusteredLighting()
+{
+	if (mLit)
+		s_UseProgram(0);
+	if (mProgram != 0)
+		s_DeleteProgram(mProgram);
+	glDeleteTextures(3, mTextures);
+}
+
+bool OpenGLClusteredLighting::init()
+{
+	c8 definitions[256];
+	sprintf(definitions,
+		"#version 120\n"
+		"#define CLUSTERS_X %d.0\n"
+		"#define CLUSTERS_Y %d.0\n"
+		"#define CLUSTERS_Z %d.0\n"
+		"#define INDEX_WIDTH %d.0\n"
+		"#define INDEX_HEIGHT %d.0\n"
+		"#define MAX_LIGHTS %d.0\n"
+		"#define RANGE_ATTENUATION %f\n",
+		LightClusterer::CLUSTERS_X, LightClusterer::CLUSTERS_Y, LightClusterer::CLUSTERS_Z,
+		INDEX_TEXTURE_WIDTH, LightClusterer::MAX_LIGHT_INDICES / INDEX_TEXTURE_WIDTH,
+		LightClusterer::MAX_LIGHTS, LIGHT_RANGE_ATTENUATION);
+
+	const GLuint vertex   = CompileShader(GL_VERTEX_SHADER, definitions, s_vertexShader);
+	const GLuint fragment = CompileShader(GL_FRAGMENT_SHADER, definitions, s_fragmentShader);
+	if (vertex == 0 || fragment == 0)
+	{
+		if (vertex != 0)
+			s_DeleteShader(vertex);
+		if (fragment != 0)
+			s_DeleteShader(fragment);
+		return false;
+	}
+
+	// The shaders are deleted with the program
+	mProgram = s_CreateProgram();
+	s_AttachShader(mProgram, vertex);
+	s_AttachShader(mProgram, fragment);
+	s_DeleteShader(vertex);
+	s_DeleteShader(fragment);
+	s_LinkProgram(mProgram);
+
+	GLint linked = GL_FALSE;
+	s_GetProgramiv(mProgram, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)
+	{
+		c8 log[1024];
+		s_GetProgramInfoLog(mProgram, sizeof(log), nullptr, log);
+		Logger::Get()->log(ES_HIGH, "OpenGLClusteredLighting", "Could not link the program: %s", log);
+		s_DeleteProgram(mProgram);
+		mProgram = 0;
+		return false;
+	}
+
+	mUseTextureLocation       = s_GetUniformLocation(mProgram, "UseTexture");
+	mGlobalLightCountLocation = s_GetUniformLocation(mProgram, "GlobalLightCount");
+	mClusterScaleLocation     = s_GetUniformLocation(mProgram, "ClusterScale");
+	s_UseProgram(mProgram);
+	s_Uniform1i(s_GetUniformLocation(mProgram, "DiffuseTexture"), 0);
+	s_Uniform1i(s_GetUniformLocation(mProgram, "ClusterTexture"), CLUSTERED_FIRST_TEXTURE_UNIT);
+	s_Uniform1i(s_GetUniformLocation(mProgram, "IndexTexture"), CLUSTERED_FIRST_TEXTURE_UNIT+1);
+	s_Uniform1i(s_GetUniformLocation(mProgram, "LightTexture"), CLUSTERED_FIRST_TEXTURE_UNIT+2);
+	s_Uniform1i(mUseTextureLocation, 0);
+	s_UseProgram(0);
+	mLit      = false;
+	mTextured = false;
+
+	// A texel for each cluster, for each light index, and five for each light
+	mTextures[0] = CreateTexture(GL_RGBA32F_ARB, GL_RGBA,
+		LightClusterer::CLUSTERS_X * LightClusterer::CLUSTERS_Y, LightClusterer::CLUSTERS_Z);
+	mTextures[1] = CreateTexture(GL_LUMINANCE32F_ARB, GL_LUMINANCE,
+		INDEX_TEXTURE_WIDTH, LightClusterer::MAX_LIGHT_INDICES / INDEX_TEXTURE_WIDTH);
+	mTextures[2] = CreateTexture(GL_RGBA32F_ARB, GL_RGBA, 5, LightClusterer::MAX_LIGHTS);
+	return true;
+}
+
+LightClusterer& OpenGLClusteredLighting::getClusterer()
+{
+	return mClusterer;
+}
+
+void OpenGLClusteredLighting::update(s32 globalLights, const dimension2i& viewport)
+{
+	for (s32 i = 0; i < 3; i++)
+	{
+		s_ActiveTexture(GL_TEXTURE0 + CLUSTERED_FIRST_TEXTURE_UNIT + i);
+		glBindTexture(GL_TEXTURE_2D, mTextures[i]);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	s_ActiveTexture(GL_TEXTURE0 + CLUSTERED_FIRST_TEXTURE_UNIT);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, LightClusterer::CLUSTERS_X * LightClusterer::CLUSTERS_Y,
+		LightClusterer::CLUSTERS_Z, GL_RGBA, GL_FLOAT, mClusterer.getClusters());
+
+	// Only the rows that are used
+	const s32 rows = (mClusterer.getLightIndexCount() + INDEX_TEXTURE_WIDTH - 1) / INDEX_TEXTURE_WIDTH;
+	if (rows > 0)
+	{
+		s_ActiveTexture(GL_TEXTURE0 + CLUSTERED_FIRST_TEXTURE_UNIT + 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, INDEX_TEXTURE_WIDTH, rows, GL_LUMINANCE, GL_FLOAT,
+			mClusterer.getLightIndices());
+	}
+	if (mClusterer.getLightCount() > 0)
+	{
+		s_ActiveTexture(GL_TEXTURE0 + CLUSTERED_FIRST_TEXTURE_UNIT + 2);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 5, mClusterer.getLightCount(), GL_RGBA, GL_FLOAT,
+			mClusterer.getLights());
+	}
+	// The renderer binds the textures of the materials on the unit 0 only
+	s_ActiveTexture(GL_TEXTURE0);
+
+	s_UseProgram(mProgram);
+	s_Uniform1i(mGlobalLightCountLocation, globalLights);
+	s_Uniform4f(mClusterScaleLocation,
+		(f32)LightClusterer::CLUSTERS_X / viewport.getWidth(),
+		(f32)LightClusterer::CLUSTERS_Y / viewport.getHeight(),
+		LightClusterer::CLUSTERS_Z / logf(mClusterer.getFar() / mClusterer.getNear()),
+		mClusterer.getNear());
+	if (!mLit)
+		s_UseProgram(0);
+}
+
+void OpenGLClusteredLighting::use(bool lit, bool textured)
+{
+	if (lit != mLit)
+	{
+		s_UseProgram(lit ? mProgram : 0);
+		mLit = lit;
+	}
+	if (lit && textured != mTextured)
+	{
+		s_Uniform1i(mUseTextureLocation, textured ? 1 : 0);
+		mTextured = textured;
+	}
+}
+
+GLuint OpenGLClusteredLighting::CompileShader(GLenum type, const c8 * definitions, const c8 * source)
+{
+	const GLchar * sources[2] = { definitions, source };
+	GLuint shader = s_CreateShader(type);
+	s_ShaderSource(shader, 2, sources, nullptr);
+	s_CompileShader(shader);
+
+	GLint compiled = GL_FALSE;
+	s_GetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (compiled != GL_TRUE)
+	{
+		c8 log[1024];
+		s_GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+		Logger::Get()->log(ES_HIGH, "OpenGLClusteredLighting", "Could not compile the %s shader: %s",
+			type == GL_VERTEX_SHADER ? "vertex" : "fragment", log);
+		s_DeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+GLuint OpenGLClusteredLighting::CreateTexture(GLint internalFormat, GLenum format, s32 width, s32 height)
+{
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_FLOAT, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+} // namespace fire_engine
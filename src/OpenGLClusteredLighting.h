@@ -0,0 +1,98 @@
+/**
+ * FILE:    OpenGLClusteredLighting.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Lighting by pixel with the lights of clusters of the view frustum, for the OpenGL
+ *          renderer.
+**/
+
+#ifndef OPENGLCLUSTEREDLIGHTING_H_INCLUDED
+#define OPENGLCLUSTEREDLIGHTING_H_INCLUDED
+
+#include "CompileConfig.h"
+
+#ifdef _FIRE_ENGINE_WIN32_
+#	include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include "Types.h"
+#include "dimension2.h"
+#include "LightClusterer.h"
+
+namespace fire_engine
+{
+
+/** The shaders and textures of the ELM_CLUSTERED lighting mode of the OpenGL renderer.
+ Once a frame, the lights sorted by a LightClusterer are uploaded into float textures,
+ and the lit materials are then drawn with a program that looks up the lights of the
+ cluster of each pixel. The lights without a range are still set in the OpenGL lights,
+ which the program also reads.
+ The textures are bound on the texture units 1 to 3, so that the unit 0 is left to the
+ texture of the materials. */
+class _FIRE_ENGINE_API_ OpenGLClusteredLighting
+{
+public:
+	enum
+	{
+		//! The width of the texture of the light indices
+		INDEX_TEXTURE_WIDTH = 1024
+	};
+
+	/** Loads the OpenGL 2.0 functions that are needed, and returns whether they all are
+	 available. This is done by the OpenGLRenderer, and must be done before creating an
+	 OpenGLClusteredLighting. */
+	static bool LoadFunctions();
+
+	/** Returns whether the functions that are needed have been loaded. */
+	static bool IsSupported();
+
+	/** Constructor. Nothing is created until init() is called. */
+	OpenGLClusteredLighting();
+
+	/** Destructor. Deletes the program and the textures. */
+	~OpenGLClusteredLighting();
+
+	/** Compiles the program and creates the textures. Errors are logged.
+	 \return Whether the lighting can be used. */
+	bool init();
+
+	/** Returns the clusterer whose lights are uploaded by update(). */
+	LightClusterer& getClusterer();
+
+	/** Uploads the lights of the clusterer, and binds the textures.
+	 \param globalLights The number of OpenGL lights that are set, from GL_LIGHT0.
+	 \param viewport     The size of the viewport. */
+	void update(s32 globalLights, const dimension2i& viewport);
+
+	/** Sets whether what is drawn next is lit by the program, or by fixed function OpenGL.
+	 \param lit      Whether to use the program.
+	 \param textured Whether to multiply the lighting by the texture of the unit 0. */
+	void use(bool lit, bool textured);
+
+private:
+	LightClusterer mClusterer;
+	GLuint         mProgram;
+	//! The textures of the clusters, the light indices and the lights
+	GLuint         mTextures[3];
+	GLint          mUseTextureLocation;
+	GLint          mGlobalLightCountLocation;
+	GLint          mClusterScaleLocation;
+	bool           mLit;
+	bool           mTextured;
+
+	//! Compiles a shader, with the definitions of the cluster sizes before its source, or
+	//! logs why it could not be
+	static GLuint CompileShader(GLenum type, const c8 * definitions, const c8 * source);
+
+	//! Creates a float texture, for reading texels as they are
+	static GLuint CreateTexture(GLint internalFormat, GLenum format, s32 width, s32 height);
+
+	// Copying is not supported
+	OpenGLClusteredLighting(const OpenGLClusteredLighting&);
+	OpenGLClusteredLighting& operator=(const OpenGLClusteredLighting&);
+};
+
+} // namespace fire_engine
+
+#endif // OPENGLCLUSTEREDLIGHTING_H_INCLUDED
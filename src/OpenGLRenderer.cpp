@@ -8,21 +8,30 @@
 #include "OpenGLRenderer.h"
 #include "Logger.h"
 #include "Image.h"
-#include "Material.h"
+#include "MaterialRegistry.h"
 #include "OpenGLTexture.h"
+#include "OpenGLClusteredLighting.h"
 #include "Vertex3.h"
 #include "Light.h"
 #include "Device.h"
 #include "IWindowManager.h"
 #include "MediaManager.h"
+#include "CompressedImage.h"
 
-#define OPENGL_MAX_LIGHTS 0x08
+#ifndef GL_HALF_FLOAT_ARB
+#	define GL_HALF_FLOAT_ARB 0x140B
+#endif
+#ifndef GL_INT_2_10_10_10_REV
+#	define GL_INT_2_10_10_10_REV 0x8D9F
+#endif
 
 namespace fire_engine
 {
 
 OpenGLRenderer::OpenGLRenderer()
-	: glWindowPos2iARB(0), glActiveTextureARB(0)
+	: glWindowPos2iARB(0), glActiveTextureARB(0), mCompressTextures(true),
+	  mHalfFloatVertices(false), mPackedNormals(false), mMaterial(MATERIAL_INVALID_HANDLE), mLightingMode(ELM_FIXED_FUNCTION),
+	  mClusteredLighting(nullptr)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::OpenGLRenderer");
@@ -31,6 +40,8 @@ OpenGLRenderer::OpenGLRenderer()
 
 OpenGLRenderer::~OpenGLRenderer()
 {
+	forgetMaterial();
+	delete mClusteredLighting;
 }
 
 bool OpenGLRenderer::isExtensionSupported(const c8 * name)
@@ -66,7 +77,7 @@ void OpenGLRenderer::init()
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glLightModeli(GL_LIGHT_MODEL_COLOR_CONTROL, GL_SEPARATE_SPECULAR_COLOR);
-	mLightInfo.next_light = 0;
+	memset(mLightInfo.bound, 0, sizeof(mLightInfo.bound));
 }
 
 void OpenGLRenderer::loadExtensions()
@@ -93,6 +104,35 @@ void OpenGLRenderer::loadExtensions()
 		else
 			Logger::Get()->log(ES_MEDIUM, "OpenGLRenderer",
 				"Could not load glActivateTextureARB extension");
+#endif
+	}
+	if (isExtensionSupported("GL_ARB_texture_compression") &&
+		isExtensionSupported("GL_EXT_texture_compression_s3tc"))
+	{
+		OpenGLTexture::CompressedTexImage2D = (PFNGLCOMPRESSEDTEXIMAGE2DARBPROC)
+			wglGetProcAddress("glCompressedTexImage2DARB");
+#ifdef _FIRE_ENGINE_DEBUG_OPENGL_
+		if (OpenGLTexture::CompressedTexImage2D != 0)
+			Logger::Get()->log(ES_DEBUG, "OpenGLRenderer",
+				"glCompressedTexImage2DARB extension loaded");
+		else
+			Logger::Get()->log(ES_MEDIUM, "OpenGLRenderer",
+				"Could not load glCompressedTexImage2DARB extension");
+#endif
+	}
+	mHalfFloatVertices = isExtensionSupported("GL_ARB_half_float_vertex");
+	mPackedNormals     = isExtensionSupported("GL_ARB_vertex_type_2_10_10_10_rev");
+	if (isExtensionSupported("GL_ARB_shading_language_100") &&
+		isExtensionSupported("GL_ARB_texture_float"))
+	{
+		const bool loaded = OpenGLClusteredLighting::LoadFunctions();
+#ifdef _FIRE_ENGINE_DEBUG_OPENGL_
+		if (loaded)
+			Logger::Get()->log(ES_DEBUG, "OpenGLRenderer",
+				"OpenGL 2.0 shader functions loaded");
+		else
+			Logger::Get()->log(ES_MEDIUM, "OpenGLRenderer",
+				"Could not load OpenGL 2.0 shader functions");
 #endif
 	}
 }
@@ -120,10 +160,23 @@ void OpenGLRenderer::endScene()
 
 void OpenGLRenderer::setTexture(s32 unit, const ITexture * texture)
 {
+	if (unit == 0)
+	{
+		// The texture of the current material is not bound any more, and what is drawn
+		// next is not drawn with a material
+		forgetMaterial();
+		if (mClusteredLighting != nullptr)
+			mClusteredLighting->use(false, false);
+	}
 	if (texture != nullptr)
 	{
 		const OpenGLTexture * ogl_texture = dynamic_cast<const OpenGLTexture *>(texture);
 		glActiveTextureARB(GL_TEXTURE0_ARB + unit);
+		if (!ogl_texture->isUploaded())
+		{
+			// Created by a worker thread, and not uploaded by uploadPendingTextures() yet
+			const_cast<OpenGLTexture *>(ogl_texture)->upload();
+		}
 		glBindTexture(GL_TEXTURE_2D, ogl_texture->getTextureName());
 	}
 	else
@@ -148,6 +201,13 @@ void OpenGLRenderer::showImage(const Image& image, const dimension2i& pos, const
 	//TODO: Is there a better way to do this?
 	blending = (glIsEnabled(GL_BLEND) == GL_TRUE) ? true : false;
 
+	// The pixels are not lit
+	if (mClusteredLighting != nullptr)
+	{
+		mClusteredLighting->use(false, false);
+		forgetMaterial();
+	}
+
 	glPushAttrib(GL_LIGHTING_BIT);
 
 	if (blending)
@@ -259,6 +319,7 @@ void OpenGLRenderer::drawaabbox(const aabboxf& box, const Color32& color)
 {
 	vector3f min = box.getMinPoint();
 	vector3f max = box.getMaxPoint();
+	setTexture(0, nullptr);
 	// turn off lighting
 	glPushAttrib(GL_LIGHTING);
 	glDisable(GL_LIGHTING);
@@ -289,64 +350,112 @@ IRenderer * OpenGLRenderer::Create()
 void OpenGLRenderer::drawIndexedPrimitiveList(EPOLYGON_TYPE primitiveType,
 	s32 numIndices, const Vertex3 * vertices, const u32 * indices)
 {
-	glEnableClientState(GL_COLOR_ARRAY);
-	glEnableClientState(GL_VERTEX_ARRAY);
-	if (primitiveType != EPT_POINTS)
-	{
-		glEnableClientState(GL_NORMAL_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-	}
+	drawIndexedPrimitiveList(primitiveType, numIndices, vertices, Vertex3::GetFormat(), indices,
+		EIT_32BIT);
+}
 
-	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex3), (const void*)vertices->getColor().v());
-	glVertexPointer(3, GL_FLOAT, sizeof(Vertex3), (const void*)vertices->getPosition().v());
-	if (primitiveType != EPT_POINTS)
+void OpenGLRenderer::drawIndexedPrimitiveList(EPOLYGON_TYPE primitiveType, s32 numIndices,
+	const void * vertices, const VertexFormat& format, const void * indices, EINDEX_TYPE indexType)
+{
+	// Points are drawn with just their positions and colors
+	const s32 attributeCount = (primitiveType == EPT_POINTS) ? EVA_NORMAL : EVA_COUNT;
+	const u8 * data = static_cast<const u8 *>(vertices);
+	bool set[EVA_COUNT];
+	for (s32 i = 0; i < attributeCount; i++)
 	{
-		glNormalPointer(GL_FLOAT, sizeof(Vertex3), (const void*)vertices->getNormal().v());
-		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex3),
-			(const void*)vertices->getTextureCoordinates().v());
+		const EVERTEX_ATTRIBUTE attribute = (EVERTEX_ATTRIBUTE)i;
+		set[i] = setVertexArray(attribute, format.getType(attribute), format.getStride(),
+			data + format.getOffset(attribute));
 	}
 
+	const GLenum type = indexType == EIT_16BIT ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 	switch (primitiveType)
 	{
 	case EPT_LINES:
-		glDrawElements(GL_LINES, numIndices, GL_UNSIGNED_INT, (const void*)indices);
+		glDrawElements(GL_LINES, numIndices, type, indices);
 		break;
 	case EPT_POINTS:
 		glDrawArrays(GL_POINTS, 0, numIndices);
 		break;
 	case EPT_TRIANGLES:
-		glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, (const void*)indices);
+		glDrawElements(GL_TRIANGLES, numIndices, type, indices);
 		break;
 	case EPT_QUADS:
-		glDrawElements(GL_QUADS, numIndices, GL_UNSIGNED_INT, (const void*)indices);
+		glDrawElements(GL_QUADS, numIndices, type, indices);
 		break;
 	case EPT_TRIANGLE_STRIP:
-		glDrawElements(GL_TRIANGLE_STRIP, numIndices, GL_UNSIGNED_INT, (const void*)indices);
+		glDrawElements(GL_TRIANGLE_STRIP, numIndices, type, indices);
 		break;
 	case EPT_TRIANGLE_FAN:
-		glDrawElements(GL_TRIANGLE_FAN, numIndices, GL_UNSIGNED_INT, (const void*)indices);
+		glDrawElements(GL_TRIANGLE_FAN, numIndices, type, indices);
 		break;
 	}
 
-	glDisableClientState(GL_COLOR_ARRAY);
-	glDisableClientState(GL_VERTEX_ARRAY);
-	if (primitiveType != EPT_POINTS)
+	static const GLenum arrays[EVA_COUNT] =
+		{GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_NORMAL_ARRAY, GL_TEXTURE_COORD_ARRAY};
+	for (s32 i = 0; i < attributeCount; i++)
 	{
-		glDisableClientState(GL_NORMAL_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		if (set[i])
+			glDisableClientState(arrays[i]);
 	}
 }
 
-void OpenGLRenderer::drawMeshBuffer(const IMeshBuffer * mb)
+bool OpenGLRenderer::setVertexArray(EVERTEX_ATTRIBUTE attribute, EVERTEX_ATTRIBUTE_TYPE type,
+	GLsizei stride, const void * data)
 {
-	setMaterial(mb->getMaterial());
-	/*if (mb->getTexture() != nullptr)
+	switch (attribute)
 	{
-		setTexture(0, mb->getTexture());
-	}*/
-	drawIndexedPrimitiveList(mb->getPolygonType(), mb->getIndices()->getCount(), 
-		mb->getVertices(), mb->getIndices()->const_pointer());
-	setTexture(0, nullptr);
+	case EVA_POSITION:
+		if (type != EVAT_F32X2 && type != EVAT_F32X3)
+			return false;
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glVertexPointer(type == EVAT_F32X2 ? 2 : 3, GL_FLOAT, stride, data);
+		return true;
+	case EVA_COLOR:
+		if (type != EVAT_U8X4)
+			return false;
+		glEnableClientState(GL_COLOR_ARRAY);
+		glColorPointer(4, GL_UNSIGNED_BYTE, stride, data);
+		return true;
+	case EVA_NORMAL:
+		// Byte normals are mapped to [-1, 1] by OpenGL 1.1 already
+		if (type == EVAT_F32X3)
+			glNormalPointer(GL_FLOAT, stride, data);
+		else if (type == EVAT_S8X4)
+			glNormalPointer(GL_BYTE, stride, data);
+		else if (type == EVAT_S10X3 && mPackedNormals)
+			glNormalPointer(GL_INT_2_10_10_10_REV, stride, data);
+		else
+			return false;
+		glEnableClientState(GL_NORMAL_ARRAY);
+		return true;
+	case EVA_TEXTURE_COORDINATES:
+		if (type == EVAT_F32X2)
+			glTexCoordPointer(2, GL_FLOAT, stride, data);
+		else if (type == EVAT_F16X2 && mHalfFloatVertices)
+			glTexCoordPointer(2, GL_HALF_FLOAT_ARB, stride, data);
+		else
+			return false;
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		return true;
+	default:
+		return false;
+	}
+}
+
+void OpenGLRenderer::drawMeshBuffer(const IMeshBuffer * mb)
+{
+	drawMeshBuffer(mb, mb->getMaterialHandle());
+}
+
+void OpenGLRenderer::drawMeshBuffer(const IMeshBuffer * mb, material_handle_t material)
+{
+	// The texture of the material stays bound, so that the next mesh buffer with the same
+	// material does not change any state
+	setMaterial(material);
+	const IndexBuffer * indices = mb->getIndices();
+	drawIndexedPrimitiveList(mb->getPolygonType(), indices->getCount(), mb->getVertexData(),
+		mb->getVertexFormat(), indices->getData(), indices->getType());
 }
 
 Image * OpenGLRenderer::screenshot(void) const
@@ -360,9 +469,151 @@ Image * OpenGLRenderer::screenshot(void) const
 void OpenGLRenderer::addDynamicLight(Light * light)
 {
 	// Can only have a certain number of lights
-	if (mLightInfo.next_light >= OPENGL_MAX_LIGHTS)
+	for (s32 i = 0; i < OPENGL_MAX_LIGHTS; i++)
+	{
+		if (mLightInfo.bound[i] == nullptr)
+		{
+			bindLight(i, light);
+			return;
+		}
+	}
+}
+
+void OpenGLRenderer::removeAllDynamicLights()
+{
+	for (s32 i = 0; i < OPENGL_MAX_LIGHTS; i++)
+	{
+		if (mLightInfo.bound[i] != nullptr)
+		{
+			glDisable(GL_LIGHT0+i);
+			mLightInfo.bound[i] = nullptr;
+		}
+	}
+}
+
+void OpenGLRenderer::setDynamicLights(const Light * const * lights, s32 count)
+{
+	if (mLightingMode == ELM_CLUSTERED)
+	{
+		// The lights of the scene light everything
+		return;
+	}
+	if (count > OPENGL_MAX_LIGHTS)
+		count = OPENGL_MAX_LIGHTS;
+
+	// Lights that are set already keep their OpenGL light
+	bool kept[OPENGL_MAX_LIGHTS];
+	bool placed[OPENGL_MAX_LIGHTS];
+	bool changed = false;
+	for (s32 s = 0; s < OPENGL_MAX_LIGHTS; s++)
+		kept[s] = false;
+	for (s32 i = 0; i < count; i++)
+	{
+		placed[i] = false;
+		for (s32 s = 0; s < OPENGL_MAX_LIGHTS && !placed[i]; s++)
+		{
+			if (mLightInfo.bound[s] == lights[i])
+				kept[s] = placed[i] = true;
+		}
+		changed = changed || !placed[i];
+	}
+	for (s32 s = 0; s < OPENGL_MAX_LIGHTS; s++)
+	{
+		if (!kept[s] && mLightInfo.bound[s] != nullptr)
+		{
+			glDisable(GL_LIGHT0+s);
+			mLightInfo.bound[s] = nullptr;
+		}
+	}
+	if (!changed)
+		return;
+
+	// The lights are in world space: they are set with the view matrix alone
+	GLfloat glmat[16];
+	makeGLMatrix(mMatrices[EMM_VIEW], glmat);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadMatrixf(glmat);
+	s32 slot = 0;
+	for (s32 i = 0; i < count; i++)
+	{
+		if (placed[i])
+			continue;
+		while (mLightInfo.bound[slot] != nullptr)
+			slot++;
+		bindLight(slot, lights[i]);
+	}
+	glPopMatrix();
+}
+
+s32 OpenGLRenderer::getMaxDynamicLights() const
+{
+	return OPENGL_MAX_LIGHTS;
+}
+
+void OpenGLRenderer::setSceneLights(const Light * const * lights, s32 count)
+{
+	if (mLightingMode != ELM_CLUSTERED)
+	{
 		return;
-	GLenum  id = GL_LIGHT0+mLightInfo.next_light++;
+	}
+
+	// The lights that reach everything are OpenGL lights, set with the view matrix alone
+	removeAllDynamicLights();
+	GLfloat glmat[16];
+	makeGLMatrix(mMatrices[EMM_VIEW], glmat);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadMatrixf(glmat);
+	s32 global = 0;
+	for (s32 i = 0; i < count && global < OPENGL_MAX_LIGHTS; i++)
+	{
+		if (lights[i]->getType() != ELT_POINT || lights[i]->getRange() <= 0.0f)
+			bindLight(global++, lights[i]);
+	}
+	glPopMatrix();
+
+	mClusteredLighting->getClusterer().build(mMatrices[EMM_VIEW], mMatrices[EMM_PROJECTION],
+		lights, count);
+	mClusteredLighting->update(global, mViewport);
+}
+
+bool OpenGLRenderer::setLightingMode(ELIGHTING_MODE mode)
+{
+	if (mode == ELM_CLUSTERED && mClusteredLighting == nullptr)
+	{
+		if (!OpenGLClusteredLighting::IsSupported())
+		{
+			Logger::Get()->log(ES_MEDIUM, "OpenGLRenderer",
+				"Clustered lighting needs OpenGL 2.0 and float textures");
+			return false;
+		}
+		mClusteredLighting = new OpenGLClusteredLighting();
+		if (!mClusteredLighting->init())
+		{
+			delete mClusteredLighting;
+			mClusteredLighting = nullptr;
+			return false;
+		}
+	}
+
+	// The lights and the material are set again for the new mode
+	if (mClusteredLighting != nullptr)
+		mClusteredLighting->use(false, false);
+	removeAllDynamicLights();
+	forgetMaterial();
+	mLightingMode = mode;
+	return true;
+}
+
+ELIGHTING_MODE OpenGLRenderer::getLightingMode() const
+{
+	return mLightingMode;
+}
+
+void OpenGLRenderer::bindLight(s32 slot, const Light * light)
+{
+	GLenum  id = GL_LIGHT0+slot;
 	GLfloat position[4];
 	glLightfv(id, GL_AMBIENT, light->getAmbient().v());
 	glLightfv(id, GL_DIFFUSE, light->getDiffuse().v());
@@ -382,15 +633,14 @@ void OpenGLRenderer::addDynamicLight(Light * light)
 		glLightfv(id, GL_POSITION, position);
 		break;
 	}
+	// The OpenGL lights are shared by all the lights, so the attenuation is always set. Every
+	// light with a position and a range fades, spot lights included, as LightGrid expects.
+	const f32 range = (light->getType() != ELT_DIRECTIONAL) ? light->getRange() : 0.0f;
+	glLightf(id, GL_QUADRATIC_ATTENUATION,
+		range > 0.0f ? LIGHT_RANGE_ATTENUATION/(range*range) : 0.0f);
 
 	glEnable(id);
-}
-
-void OpenGLRenderer::removeAllDynamicLights()
-{
-	for (s32 i = 0; i < mLightInfo.next_light; i++)
-		glDisable(GL_LIGHT0+i);
-	mLightInfo.next_light = 0;
+	mLightInfo.bound[slot] = light;
 }
 
 void OpenGLRenderer::setAmbientLight(Color32 ambient)
@@ -438,50 +688,129 @@ matrix4f OpenGLRenderer::getTransform(EMATRIX_MODE mmode) const
 
 void OpenGLRenderer::setMaterial(const Material& mat)
 {
-	mMaterial = mat;
-
-	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, mMaterial.getAmbient().v());
-	glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, mMaterial.getDiffuse().v());
-	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, mMaterial.getSpecular().v());
-	glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, mMaterial.getEmissive().v());
-	glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, mMaterial.getShininess());
+	const material_handle_t material = MaterialRegistry::Register(mat);
+	setMaterial(material);
+	MaterialRegistry::Drop(material);
+}
 
-	if (mMaterial.getMaterialProperty(EMP_LIGHTING))
-	{
-		glEnable(GL_LIGHTING);
-	}
-	else
+void OpenGLRenderer::setMaterial(material_handle_t material)
+{
+	if (material == mMaterial)
 	{
-		glDisable(GL_LIGHTING);
+		return;
 	}
 
-	if (mMaterial.getMaterialProperty(EMP_WIREFRAME))
+	// Only the state that differs from the current material is changed
+	const material_state_t& state = MaterialRegistry::GetState(material);
+	const material_state_t * last = (mMaterial != MATERIAL_INVALID_HANDLE) ?
+		&MaterialRegistry::GetState(mMaterial) : nullptr;
+	const u32 changed = (last != nullptr) ? (last->Flags ^ state.Flags) : 0xFFFFFFFF;
+
+	if (last == nullptr || memcmp(last->Ambient, state.Ambient, 4*sizeof(f32)) != 0)
+		glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, state.Ambient);
+	if (last == nullptr || memcmp(last->Diffuse, state.Diffuse, 4*sizeof(f32)) != 0)
+		glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, state.Diffuse);
+	if (last == nullptr || memcmp(last->Specular, state.Specular, 4*sizeof(f32)) != 0)
+		glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, state.Specular);
+	if (last == nullptr || memcmp(last->Emissive, state.Emissive, 4*sizeof(f32)) != 0)
+		glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, state.Emissive);
+	if (last == nullptr || last->Shininess != state.Shininess)
+		glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, state.Shininess);
+
+	if (changed & material_state_t::EMS_LIGHTING)
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		if (state.Flags & material_state_t::EMS_LIGHTING)
+			glEnable(GL_LIGHTING);
+		else
+			glDisable(GL_LIGHTING);
 	}
-	else
+
+	if (changed & material_state_t::EMS_WIREFRAME)
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		glPolygonMode(GL_FRONT_AND_BACK,
+			(state.Flags & material_state_t::EMS_WIREFRAME) ? GL_LINE : GL_FILL);
 	}
 
-	if (mMaterial.getMaterialProperty(EMP_WRITE_TO_Z_BUFFER))
+	if (changed & material_state_t::EMS_WRITE_TO_Z_BUFFER)
 	{
-		glEnable(GL_DEPTH_TEST);
-		glDepthFunc(GL_LEQUAL);
+		if (state.Flags & material_state_t::EMS_WRITE_TO_Z_BUFFER)
+		{
+			glEnable(GL_DEPTH_TEST);
+			glDepthFunc(GL_LEQUAL);
+		}
+		else
+		{
+			glDisable(GL_DEPTH_TEST);
+		}
 	}
-	else
+
+	// setTexture() forgets the current material, so it is set last
+	setTexture(0, state.Texture);
+	if (mLightingMode == ELM_CLUSTERED)
 	{
-		glDisable(GL_DEPTH_TEST);
+		mClusteredLighting->use((state.Flags & material_state_t::EMS_LIGHTING) != 0,
+			state.Texture != nullptr);
 	}
+	MaterialRegistry::Grab(material);
+	mMaterial = material;
+}
+
+void OpenGLRenderer::forgetMaterial()
+{
+	MaterialRegistry::Drop(mMaterial);
+	mMaterial = MATERIAL_INVALID_HANDLE;
 }
 
 ITexture * OpenGLRenderer::createTexture(const String& filename, io::IFileProvider * fileProvider) const
 {
+	InternedString key = AssetCache<ITexture>::MakeKey(filename, fileProvider);
+	ITexture * texture = mTextureCache.find(key);
+	if (texture != nullptr)
+	{
+		return texture;
+	}
+
+	if (getTextureCompression())
+	{
+		CompressedImage * compressed = MediaManager::Get()->load<CompressedImage>(filename, fileProvider);
+		if (compressed != nullptr)
+		{
+			u32 bytes = compressed->getSize();
+			ITexture * created = new OpenGLTexture(compressed);
+			compressed->drop();
+			return mTextureCache.insert(key, created, bytes);
+		}
+	}
+
 	Image * im = MediaManager::Get()->load<Image>(filename, fileProvider);
 	if (im != nullptr)
 	{
-		return new OpenGLTexture(im);
+		// The texture is uploaded as RGBA, and its mipmaps add a third
+		u32 bytes = im->dim().getWidth() * im->dim().getHeight() * 4 * 4 / 3;
+		ITexture * created = new OpenGLTexture(im, ETCF_AUTO_GENERATE_MIPMAPS | ETCF_SRGB);
+		im->drop();
+		return mTextureCache.insert(key, created, bytes);
 	}
 	return nullptr;
 }
+
+AssetCache<ITexture>& OpenGLRenderer::getTextureCache()
+{
+	return mTextureCache;
+}
+
+void OpenGLRenderer::setTextureCompression(bool compress)
+{
+	mCompressTextures = compress;
+}
+
+bool OpenGLRenderer::getTextureCompression(void) const
+{
+	return mCompressTextures && OpenGLTexture::CompressedTexImage2D != nullptr;
+}
+
+void OpenGLRenderer::uploadPendingTextures(f64 budget)
+{
+	OpenGLTexture::UploadPending(budget);
+}
 } // namespace fire_engine
@@ -23,7 +23,13 @@
 #include "IRenderer.h"
 #include "Object.h"
 #include "matrix4.h"
-#include "Material.h"
+#include "MaterialRegistry.h"
+#include "AssetCache.h"
+#include "ITexture.h"
+#include "VertexFormat.h"
+
+//! The number of lights of fixed function OpenGL
+#define OPENGL_MAX_LIGHTS 0x08
 
 namespace fire_engine
 {
@@ -32,6 +38,7 @@ namespace fire_engine
 class Image;
 class Light;
 class Device;
+class OpenGLClusteredLighting;
 
 namespace io
 {
@@ -82,14 +89,30 @@ public:
 	virtual void drawIndexedPrimitiveList(EPOLYGON_TYPE primitiveType,
 		s32 numIndices, const Vertex3 * vertices, const u32 * indices);
 
+	virtual void drawIndexedPrimitiveList(EPOLYGON_TYPE primitiveType, s32 numIndices,
+		const void * vertices, const VertexFormat& format, const void * indices,
+		EINDEX_TYPE indexType);
+
 	virtual void drawMeshBuffer(const IMeshBuffer * mb);
 
+	virtual void drawMeshBuffer(const IMeshBuffer * mb, material_handle_t material);
+
 	virtual Image * screenshot() const;
 
 	virtual void addDynamicLight(Light * light);
 
 	virtual void removeAllDynamicLights();
 
+	virtual void setDynamicLights(const Light * const * lights, s32 count);
+
+	virtual s32 getMaxDynamicLights() const;
+
+	virtual void setSceneLights(const Light * const * lights, s32 count);
+
+	virtual bool setLightingMode(ELIGHTING_MODE mode);
+
+	virtual ELIGHTING_MODE getLightingMode() const;
+
 	virtual void setAmbientLight(Color32 ambient);
 
 	virtual void setTransform(EMATRIX_MODE mmode, const matrix4f& mat);
@@ -98,28 +121,72 @@ public:
 
 	virtual void setMaterial(const Material& mat);
 
+	virtual void setMaterial(material_handle_t material);
+
 	virtual ITexture * createTexture(const String& filename, io::IFileProvider * fileProvider) const;
 
+	virtual AssetCache<ITexture>& getTextureCache();
+
+	virtual void uploadPendingTextures(f64 budget);
+
+	/** Sets whether textures created from now on are compressed in DXT1 or DXT5, when the
+	 OpenGL implementation supports it. They are by default. The quality of the compression
+	 is a setting of the CompressedImageLoader of each image extension (see
+	 MediaManager::getLoader()). */
+	void setTextureCompression(bool compress);
+
+	/** Returns whether textures are compressed: set, and supported. */
+	bool getTextureCompression(void) const;
+
 private:
 	/** A list of extensions that are used. */
 	PFNGLWINDOWPOS2IARBPROC   glWindowPos2iARB;
 	PFNGLACTIVETEXTUREARBPROC glActiveTextureARB;
 
+	bool mCompressTextures;
+
+	//! Whether vertex attributes can be EVAT_F16X2, and normals EVAT_S10X3
+	bool mHalfFloatVertices;
+	bool mPackedNormals;
+
 	/** The diverse transformations that we need to keep track of:
 	 EMM_VIEW       The 'view' matrix (does not exist in OpenGL, but we emulate it.
 	 EMM_MODELVIEW  A transformation applied every primitive drawn.
 	 EMM_PROJECTION Defines what volume of 3D space is visible. */
 	matrix4f mMatrices[EMM_MATRIX_MODE_COUNT];
 
-	Material mMaterial;
+	//! The material whose state is set, or MATERIAL_INVALID_HANDLE when the state has
+	//! been changed since. Its handle is grabbed, so that it is not given to another
+	//! material while it is set.
+	material_handle_t mMaterial;
+
+	//! Drops the current material, after its state has been changed
+	void forgetMaterial();
 
 	typedef struct
 	{
-		s32 next_light;
+		//! The light set in each of the OpenGL lights, or nullptr
+		const Light * bound[OPENGL_MAX_LIGHTS];
 	} light_info_t;
 
 	light_info_t mLightInfo;
 
+	ELIGHTING_MODE mLightingMode;
+
+	//! The lighting of the ELM_CLUSTERED mode, created when it is first set
+	OpenGLClusteredLighting * mClusteredLighting;
+
+	/** Sets the array of an attribute of vertices, and enables it.
+	 \return Whether it was set: whether the vertices have it, with a supported type. */
+	bool setVertexArray(EVERTEX_ATTRIBUTE attribute, EVERTEX_ATTRIBUTE_TYPE type,
+		GLsizei stride, const void * data);
+
+	/** Sets one of the OpenGL lights, with the current modelview matrix. */
+	void bindLight(s32 slot, const Light * light);
+
+	//! The textures created with createTexture()
+	mutable AssetCache<ITexture> mTextureCache;
+
 	/** Constructor - made private to ensure only a singleton instance is created. */
 	OpenGLRenderer();
 
@@ -6,12 +6,24 @@
 **/
 
 #include "OpenGLTexture.h"
+#include "Array.h"
+#include "MipmapChain.h"
+#include "CompressedImage.h"
+#include "Mutex.h"
+#include "Thread.h"
+#include "HighResolutionTimer.h"
 #include <stdio.h>
 namespace fire_engine
 {
 
+//! The textures created by worker threads, waiting to be uploaded
+static Array<OpenGLTexture*> PendingUploads;
+static sys::Mutex            PendingUploadsLock;
+
+PFNGLCOMPRESSEDTEXIMAGE2DARBPROC OpenGLTexture::CompressedTexImage2D = nullptr;
+
 OpenGLTexture::OpenGLTexture(Image * image, u32 creation_flags)
-	: mGLTextureName(0)
+	: mGLTextureName(0), mIsUploaded(false), mMipmaps(nullptr), mCompressed(nullptr)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::OpenGLTexture");
@@ -24,25 +36,140 @@ OpenGLTexture::OpenGLTexture(Image * image, u32 creation_flags)
 		mImage->grab();
 		mDimension = image->dim();
 		setDataFormat();
-
-		glGenTextures(1, &mGLTextureName);
-		glBindTexture(GL_TEXTURE_2D, mGLTextureName);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mDimension.getWidth(), mDimension.getHeight(),
-			0, mGLFormat, mGLType, mImage->data());
+		if ((mCreationFlags & ETCF_AUTO_GENERATE_MIPMAPS) != 0)
+		{
+			mMipmaps = new MipmapChain(*mImage, (mCreationFlags & ETCF_SRGB) != 0);
+		}
+		scheduleUpload();
 	}
 }
 
+OpenGLTexture::OpenGLTexture(CompressedImage * image)
+	: mGLTextureName(0), mIsUploaded(false), mMipmaps(nullptr), mCompressed(image)
+{
+#if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
+	setDebugName("fire_engine::OpenGLTexture");
+#endif
+	mImage         = nullptr;
+	mCreationFlags = image->getLevelCount() > 1 ? ETCF_HAS_MIPMAPS : 0x00;
+	mDimension     = image->getLevelDimension(0);
+	mCompressed->grab();
+	scheduleUpload();
+}
+
 OpenGLTexture::~OpenGLTexture(void)
 {
-	glDeleteTextures(1, &mGLTextureName);
+	if (mGLTextureName != 0)
+	{
+		glDeleteTextures(1, &mGLTextureName);
+	}
 	if (mImage != nullptr)
 	{
 		mImage->drop();
 	}
+	if (mMipmaps != nullptr)
+	{
+		mMipmaps->drop();
+	}
+	if (mCompressed != nullptr)
+	{
+		mCompressed->drop();
+	}
+}
+
+void OpenGLTexture::scheduleUpload(void)
+{
+	if (sys::Thread::GetCurrent() == nullptr)
+	{
+		upload();
+	}
+	else
+	{
+		// No OpenGL context on this thread: leave the upload to the main thread
+		grab();
+		sys::MutexLock lock(PendingUploadsLock);
+		PendingUploads.push_back(this);
+	}
+}
+
+void OpenGLTexture::upload(void)
+{
+	if (mIsUploaded || (mImage == nullptr && mCompressed == nullptr))
+		return;
+	mIsUploaded = true;
+
+	glGenTextures(1, &mGLTextureName);
+	glBindTexture(GL_TEXTURE_2D, mGLTextureName);
+	if (mCompressed != nullptr)
+	{
+		uploadCompressed();
+		return;
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+		mMipmaps != nullptr ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	// Rows of images are not padded, and 24 bit or small mipmap rows are not 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (mMipmaps == nullptr)
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mDimension.getWidth(), mDimension.getHeight(),
+			0, mGLFormat, mGLType, mImage->data());
+		return;
+	}
+
+	for (s32 i = 0; i < mMipmaps->getLevelCount(); i++)
+	{
+		const dimension2i& dim = mMipmaps->getLevelDimension(i);
+		glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, dim.getWidth(), dim.getHeight(),
+			0, mGLFormat, mGLType, mMipmaps->getLevelData(i));
+	}
+	// OpenGL has its own copy now
+	mMipmaps->drop();
+	mMipmaps = nullptr;
+}
+
+void OpenGLTexture::uploadCompressed(void)
+{
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+		mCompressed->getLevelCount() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	const GLenum format = mCompressed->getFormat() == BlockCompressor::EBF_DXT1 ?
+		GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	for (s32 i = 0; i < mCompressed->getLevelCount(); i++)
+	{
+		const dimension2i& dim = mCompressed->getLevelDimension(i);
+		CompressedTexImage2D(GL_TEXTURE_2D, i, format, dim.getWidth(), dim.getHeight(), 0,
+			mCompressed->getLevelSize(i), mCompressed->getLevelData(i));
+	}
+	// OpenGL has its own copy now, and the MediaManager may keep one in its cache
+	mCompressed->drop();
+	mCompressed = nullptr;
+}
+
+void OpenGLTexture::UploadPending(f64 budget)
+{
+	sys::HighResolutionTimer timer;
+	timer.start();
+	for (;;)
+	{
+		OpenGLTexture * texture;
+		{
+			sys::MutexLock lock(PendingUploadsLock);
+			if (PendingUploads.size() == 0)
+				return;
+			texture = PendingUploads.last();
+			PendingUploads.remove(PendingUploads.size() - 1);
+		}
+		// The texture may already have been uploaded when it was bound
+		texture->upload();
+		texture->drop();
+		if (timer.getElapsedTimeSeconds() >= budget)
+			return;
+	}
 }
 
 void OpenGLTexture::update(const dimension2i &dim)
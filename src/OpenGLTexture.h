@@ -26,13 +26,24 @@ namespace fire_engine
 {
 
 class Image;
+class MipmapChain;
+class CompressedImage;
 
-/** Implementation of a texture used in an OpenGL context. */
+/** Implementation of a texture used in an OpenGL context.
+ With ETCF_AUTO_GENERATE_MIPMAPS, the mipmaps of the image are built when the texture is
+ created, on the thread creating it, and all of them are uploaded with the image.
+ OpenGL can only be used from the main thread, so a texture created by a worker thread (a
+ sys::Thread) is not uploaded straight away: it is queued, and uploaded by UploadPending(),
+ or when it is first bound, whichever comes first. */
 class _FIRE_ENGINE_API_ OpenGLTexture : public ITexture, public virtual Object
 {
 public:
 	OpenGLTexture(Image * image = 0, u32 creation_flags = 0x00);
 
+	/** Creates a texture from a block compressed image, with all its levels. Only use this
+	 when CompressedTexImage2D is set. */
+	OpenGLTexture(CompressedImage * image);
+
 	virtual ~OpenGLTexture(void);
 
 	virtual void update(const dimension2i& dim);
@@ -40,10 +51,36 @@ public:
 	//! Get the internal texture name, as assigned by OpenGL glGenTextures
 	inline GLuint getTextureName(void) const;
 
+	//! Returns whether the image has been uploaded to OpenGL yet
+	inline bool isUploaded(void) const;
+
+	//! Uploads the image to OpenGL, if it has not been already. Main thread only.
+	void upload(void);
+
+	/** Uploads the textures created by worker threads. Main thread only.
+	 \param budget The time to spend, in seconds. At least one texture is uploaded if any
+	               are waiting. */
+	static void UploadPending(f64 budget);
+
+	/** glCompressedTexImage2DARB, set by the OpenGLRenderer when the OpenGL implementation
+	 supports DXT compressed textures, nullptr otherwise. */
+	static PFNGLCOMPRESSEDTEXIMAGE2DARBPROC CompressedTexImage2D;
+
 private:
 	GLuint mGLTextureName;
 	GLenum mGLFormat;
 	GLenum mGLType;
+	bool   mIsUploaded;
+	//! The mipmaps to upload, if any. Released once uploaded.
+	MipmapChain * mMipmaps;
+	//! The compressed image to upload, if the texture is compressed. Released once uploaded.
+	CompressedImage * mCompressed;
+
+	//! Queues the texture to be uploaded by the main thread, or uploads it if this is it
+	void scheduleUpload(void);
+
+	//! Uploads the levels of mCompressed
+	void uploadCompressed(void);
 
 	//! Set the internal format and type of the pixel data, as used by OpenGL
 	void setDataFormat(void);
@@ -54,6 +91,11 @@ inline GLuint OpenGLTexture::getTextureName(void) const
 	return mGLTextureName;
 }
 
+inline bool OpenGLTexture::isUploaded(void) const
+{
+	return mIsUploaded;
+}
+
 }
 
 #endif // OPENGLTEXTURE_H_INCLUDED
@@ -23,6 +23,32 @@ Q3Map::Q3Map(const String& name, Array<Q3Vertex3> * vertices, Array<q3::bsp_face
 	{
 		mBoundingBox.addInternalPoint(mVertices->at(i).getPosition());
 	}
+
+	// The arrays without a size are as long as the largest index into them
+	s32 meshVertexCount = 0;
+	for (s32 i = 0; i < mFaces->size(); i++)
+	{
+		const q3::bsp_face_t& face = (*mFaces)[i];
+		if (face.mesh_vert_index + face.mesh_vert_count > meshVertexCount)
+			meshVertexCount = face.mesh_vert_index + face.mesh_vert_count;
+	}
+	s32 planeCount = 0, leafCount = 0;
+	for (s32 i = 0; i < mNodes->size(); i++)
+	{
+		const q3::bsp_node_t& node = (*mNodes)[i];
+		if (node.plane_index + 1 > planeCount)
+			planeCount = node.plane_index + 1;
+		for (s32 c = 0; c < 2; c++)
+		{
+			// Leaves are numbered from -1 downwards
+			if (node.child_indices[c] < 0 && -node.child_indices[c] > leafCount)
+				leafCount = -node.child_indices[c];
+		}
+	}
+	mResidentBytes = sizeof(Q3Map) + mVertices->size()*sizeof(Q3Vertex3) +
+		mFaces->size()*sizeof(q3::bsp_face_t) + mModels->size()*sizeof(q3::bsp_model_t) +
+		meshVertexCount*sizeof(q3::bsp_mesh_vertex_t) + planeCount*sizeof(plane3f) +
+		mNodes->size()*sizeof(q3::bsp_node_t) + leafCount*sizeof(q3::bsp_leaf_t);
 }
 
 Q3Map::~Q3Map()
@@ -54,4 +80,9 @@ const aabboxf& Q3Map::getBoundingBox() const
 {
 	return mBoundingBox;
 }
+
+u32 Q3Map::getResidentBytes() const
+{
+	return mResidentBytes;
+}
 }
@@ -92,6 +92,9 @@ public:
 	virtual s32 getMeshBufferCount() const;
 	virtual const aabboxf& getBoundingBox() const;
 
+	/** Returns the memory used by the map, worked out when it is created. */
+	u32 getResidentBytes() const;
+
 private:
 	Array<Q3Vertex3> * mVertices;
 	Array<q3::bsp_face_t> * mFaces;
@@ -101,6 +104,7 @@ private:
 	Array<q3::bsp_node_t> * mNodes;
 	q3::bsp_leaf_t * mLeafs;
 	aabboxf mBoundingBox;
+	u32 mResidentBytes;
 };
 
 }
@@ -9,6 +9,7 @@
 #include "Device.h"
 #include "FileSystem.h"
 #include "FileUtils.h"
+#include "HashTable.h"
 #include "IFile.h"
 #include "IRenderer.h"
 #include "ITexture.h"
@@ -48,7 +49,8 @@ Q3Map * Q3MapLoader::load(const String& filename, io::IFileProvider * fileProvid
 	q3::bsp_lightmap_t * lightmaps = nullptr;
 	q3::bsp_light_volume_t * light_volumes = nullptr;
 	q3::bsp_visibility_data_t visibility_data;
-	io::IFile * file = io::FileSystem::Get()->openReadFile(filename, false, io::EFOF_READ|io::EFOF_BINARY, fileProvider);
+	io::IFile * file = io::FileSystem::Get()->openReadFile(filename, false,
+		io::EFOF_READ|io::EFOF_BINARY|io::EFOF_MAP, fileProvider);
 
 	if (file == nullptr)
 	{
@@ -375,16 +377,32 @@ ITexture ** Q3MapLoader::loadTextures(const q3::bsp_texture_t *q3textures, s32 n
 {
 	ITexture ** textures = new ITexture*[num_textures];
 	IRenderer * renderer = Device::Get()->getRenderer();
+	// Several shaders often use the same texture: only look each texture up once
+	HashTable<String, s32> first(num_textures);
 	for (s32 i = 0; i < num_textures; i++)
 	{
 		String filename = io::FileUtils::StripExtension(q3textures[i].name);
-		if (io::FileSystem::Get()->exists(filename + ".jpg"))
+		String key = io::FileUtils::MakeLookupKey(filename);
+		s32 * found_before = first.find(key);
+		if (found_before != nullptr)
 		{
-			textures[i] = renderer->createTexture(filename + ".jpg", fileProvider);
+			textures[i] = textures[*found_before];
+			if (textures[i] != nullptr)
+			{
+				textures[i]->grab();
+			}
+			continue;
 		}
-		else if (io::FileSystem::Get()->exists(filename + ".tga"))
+		first.insert(key, i);
+
+		String candidates[2];
+		candidates[0] = filename + ".jpg";
+		candidates[1] = filename + ".tga";
+		s32 found = io::FileSystem::Get()->resolve(candidates, 2);
+		textures[i] = nullptr;
+		if (found >= 0)
 		{
-			textures[i] = renderer->createTexture(filename + ".tga", fileProvider);
+			textures[i] = renderer->createTexture(candidates[found], fileProvider);
 		}
 		if (textures[i] == nullptr)
 		{
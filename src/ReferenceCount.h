@@ -0,0 +1,95 @@
+/**
+ * FILE:    ReferenceCount.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Reference counting policies used by Object: a plain counter for single-threaded
+ *          builds, and an atomic one that can be shared between threads.
+**/
+
+#ifndef REFERENCECOUNT_H_INCLUDED
+#define REFERENCECOUNT_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "Atomic.h"
+
+namespace fire_engine
+{
+
+/** A reference count that must only ever be touched by a single thread. */
+class _FIRE_ENGINE_API_ SingleThreadedReferenceCount
+{
+public:
+	//! Constructor: counts the reference held by the creator
+	SingleThreadedReferenceCount()
+		: mCount(1)
+	{
+	}
+
+	//! Adds a reference, and returns the new count
+	inline s32 increment()
+	{
+		return ++mCount;
+	}
+
+	//! Removes a reference, and returns the new count
+	inline s32 decrement()
+	{
+		return --mCount;
+	}
+
+	//! Returns the current count
+	inline s32 get() const
+	{
+		return mCount;
+	}
+
+private:
+	s32 mCount;
+};
+
+/** A reference count that can be grabbed and dropped from several threads at once.
+ Adding a reference needs no ordering, as the thread doing it already holds one. Removing
+ a reference releases the writes made through it, and the thread that drops the last
+ reference acquires them all before destroying the object. */
+class _FIRE_ENGINE_API_ AtomicReferenceCount
+{
+public:
+	//! Constructor: counts the reference held by the creator
+	AtomicReferenceCount()
+		: mCount(1)
+	{
+	}
+
+	//! Adds a reference, and returns the new count
+	inline s32 increment()
+	{
+		return AtomicIncrementRelaxed(&mCount);
+	}
+
+	//! Removes a reference, and returns the new count
+	inline s32 decrement()
+	{
+		return AtomicDecrementAcqRel(&mCount);
+	}
+
+	//! Returns the current count
+	inline s32 get() const
+	{
+		return AtomicLoadAcquire(&mCount);
+	}
+
+private:
+	volatile s32 mCount;
+};
+
+/** The reference count used by Object, selected by _FIRE_ENGINE_SINGLE_THREADED_. */
+#if defined(_FIRE_ENGINE_SINGLE_THREADED_)
+typedef SingleThreadedReferenceCount ObjectReferenceCount;
+#else
+typedef AtomicReferenceCount ObjectReferenceCount;
+#endif
+
+} // namespace fire_engine
+
+#endif // REFERENCECOUNT_H_INCLUDED
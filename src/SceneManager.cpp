@@ -18,6 +18,7 @@
 #include "Light.h"
 #include "LightSpaceNode.h"
 #include "MediaManager.h"
+#include "AssetStreamer.h"
 #include "FPSCalculator.h"
 #include "Camera.h"
 #include "CameraFPS.h"
@@ -25,6 +26,9 @@
 #include "SkyBox.h"
 #include "IModel.h"
 
+//! The most lights given to the renderer for each model
+#define SCENEMANAGER_MAX_LIGHTS_PER_MODEL 0x10
+
 namespace fire_engine
 {
 
@@ -67,6 +71,17 @@ SceneManager * SceneManager::Get()
 void SceneManager::draw()
 {
 	s32 polys = 0;
+
+	// Finish what was streamed in the background, closest to the camera first
+	if (MediaManager::Get() != nullptr && MediaManager::Get()->isStreaming())
+	{
+		AssetStreamer * streamer = MediaManager::Get()->getStreamer();
+		if (mActiveCamera)
+			streamer->setViewPosition(mActiveCamera->getWorldTransform().applyTransformation(
+				vector3f(0.0f, 0.0f, 0.0f)));
+		streamer->update();
+	}
+
 	mSpaceRoot->preRender(mTimer.getElapsedTimeSeconds());
 
 	mRenderer->setTransform(EMM_VIEW, matrix4f::IDENTITY_MATRIX);
@@ -80,13 +95,52 @@ void SceneManager::draw()
 		polys += mSkyBox->render(mRenderer);
 
 	mRenderer->setAmbientLight(mAmbientLight);
+	mLightGrid.clear();
+	mSceneLights.clear();
 	for (s32 i = 0; i < mLights.size(); i++)
+	{
 		if (mLights.at(i)->isVisible())
+		{
 			mLights.at(i)->render(mRenderer);
+			if (mLights.at(i)->getLight() != nullptr)
+				mSceneLights.push_back(&mLights.at(i)->getWorldLight());
+		}
+	}
+	mRenderer->setSceneLights(mSceneLights.const_pointer(), mSceneLights.size());
 
-	for (s32 i = 0; i < mSolidNodes.size(); i++)
-		if (mSolidNodes.at(i)->isVisible())
-			polys += mSolidNodes.at(i)->render(mRenderer);
+	cullModels();
+
+	if (mRenderer->getLightingMode() == ELM_CLUSTERED)
+	{
+		// Each pixel is lit by the lights that reach it
+		for (s32 i = 0; i < mVisibleNodes.size(); i++)
+		{
+			AnimatedModel * model = dynamic_cast<AnimatedModel*>(mVisibleNodes[i]);
+			if (model != nullptr && model->isVisible())
+				polys += model->render(mRenderer);
+		}
+	}
+	else
+	{
+		// Each model is lit by the lights that matter the most to it
+		for (s32 i = 0; i < mSceneLights.size(); i++)
+			mLightGrid.addLight(mSceneLights[i]);
+		const Light * lights[SCENEMANAGER_MAX_LIGHTS_PER_MODEL];
+		s32 maxLights = mRenderer->getMaxDynamicLights();
+		if (maxLights > SCENEMANAGER_MAX_LIGHTS_PER_MODEL)
+			maxLights = SCENEMANAGER_MAX_LIGHTS_PER_MODEL;
+		for (s32 i = 0; i < mVisibleNodes.size(); i++)
+		{
+			AnimatedModel * model = dynamic_cast<AnimatedModel*>(mVisibleNodes[i]);
+			if (model != nullptr && model->isVisible())
+			{
+				const s32 count = mLightGrid.selectLights(model->getTransformedBoundingVolume(),
+					lights, maxLights);
+				mRenderer->setDynamicLights(lights, count);
+				polys += model->render(mRenderer);
+			}
+		}
+	}
 
 	// Take a screenshot if one has been requested
 	if (mScreenshotInfo.mWantScreenshot)
@@ -114,14 +168,55 @@ AnimatedModel * SceneManager::addAnimatedMesh(IAnimatedMesh * mesh)
 		break;
 	}
 
+	if (model == 0)
+		return 0;
+
+	// The model is put in the tree when the scene is next drawn, if it is not attached
 	mSolidNodes.push_back(model);
+	mSolidNodeHandles.push_back(-1);
 	return model;
 }
 
+void SceneManager::cullModels()
+{
+	// Only the models at the top of each hierarchy are in the tree, with the box of the
+	// whole hierarchy, so that the models attached to them are culled with them
+	for (s32 i = 0; i < mSolidNodes.size(); i++)
+	{
+		bool attached = false;
+		for (INode * node = mSolidNodes[i]->getParent(); node != 0 && !attached; node = node->getParent())
+			attached = (dynamic_cast<AnimatedModel*>(node) != nullptr);
+
+		s32& handle = mSolidNodeHandles[i];
+		aabboxf box;
+		if (!attached && mSolidNodes[i]->getSubtreeBoundingVolume(box))
+		{
+			if (handle == -1)
+				handle = mModelTree.insert(mSolidNodes[i], box);
+			else
+				mModelTree.update(handle, box);
+		}
+		else if (handle != -1)
+		{
+			mModelTree.remove(handle);
+			handle = -1;
+		}
+	}
+
+	// The models attached to a hierarchy in view are only tested if it is partly in view
+	mVisibleRoots.clear();
+	mVisibleNodes.clear();
+	if (mActiveCamera)
+	{
+		mModelTree.getVisible(*mActiveCamera, mVisibleRoots);
+		for (s32 i = 0; i < mVisibleRoots.size(); i++)
+			mVisibleRoots[i]->getVisibleNodes(*mActiveCamera, mVisibleNodes);
+	}
+}
+
 LightSpaceNode * SceneManager::addDynamicLight(Light * light)
 {
 	LightSpaceNode * lsn = new LightSpaceNode(light);
-	mRenderer->addDynamicLight(light);
 	lsn->setParent(mSpaceRoot);
 	mLights.push_back(lsn);
 	return lsn;
@@ -170,4 +265,14 @@ ISpaceNode * SceneManager::getRoot()
 	return mSpaceRoot;
 }
 
+LightGrid& SceneManager::getLightGrid()
+{
+	return mLightGrid;
+}
+
+const LooseOctree& SceneManager::getModelTree() const
+{
+	return mModelTree;
+}
+
 } // namespace fire_engine
@@ -21,6 +21,8 @@
 #include "Color.h"
 #include "vector3.h"
 #include "HighResolutionTimer.h"
+#include "LightGrid.h"
+#include "LooseOctree.h"
 
 namespace fire_engine
 {
@@ -50,9 +52,22 @@ class _FIRE_ENGINE_API_ SceneManager : public virtual Object
 		/** Add an AnimatedMesh to the scene, and return the SpaceNode created. */
 		AnimatedModel * addAnimatedMesh(IAnimatedMesh * mesh);
 
-		/** Add a Light to the scene, and return the SpaceNode created. */
+		/** Add a Light to the scene, and return the SpaceNode created. Each model is lit
+		 by the lights that light it the most, up to IRenderer::getMaxDynamicLights(), so
+		 any number of lights can be added. Give the lights a range (see Light::setRange())
+		 so that far away models are not lit by them. */
 		LightSpaceNode * addDynamicLight(Light * light);
 
+		/** Returns the grid the lights are sorted into, to find the lights of each model. */
+		LightGrid& getLightGrid();
+
+		/** Returns the tree the models are sorted into by their box in world space. It holds
+		 the model at the top of each hierarchy of models (see AnimatedModelMD3::attach()),
+		 with the box of the whole hierarchy (see ISpaceNode::getSubtreeBoundingVolume()).
+		 It is updated before the models are culled at each frame, and can be used to find
+		 the models near a place (see LooseOctree::getInRange()). */
+		const LooseOctree& getModelTree() const;
+
 		/** Adds a Camera to the scene. */
 		Camera * addCamera(const vector3f& position, const vector3f& target);
 
@@ -81,8 +96,18 @@ class _FIRE_ENGINE_API_ SceneManager : public virtual Object
 		static SceneManager *    mInstance;
 		IRenderer *              mRenderer;
 		ISpaceNode *             mSpaceRoot;
-		Array<ISpaceNode*>       mLights;
+		Array<LightSpaceNode*>   mLights;
+		LightGrid                mLightGrid;
+		//! The visible lights of the frame, in world space
+		Array<const Light*>      mSceneLights;
 		Array<IModel*>           mSolidNodes;
+		//! The handle of each model in mModelTree, or -1 when it is attached to another
+		Array<s32>               mSolidNodeHandles;
+		LooseOctree              mModelTree;
+		//! The hierarchies of models in the view of the camera in the frame
+		Array<IModel*>           mVisibleRoots;
+		//! The nodes of those hierarchies in the view of the camera
+		Array<ISpaceNode*>       mVisibleNodes;
 		Color32                  mAmbientLight;
 		Camera *                 mActiveCamera;
 		sys::HighResolutionTimer mTimer;
@@ -95,6 +120,9 @@ class _FIRE_ENGINE_API_ SceneManager : public virtual Object
 		} screenshot_demand_t;
 
 		screenshot_demand_t mScreenshotInfo;
+
+		//! Sorts the hierarchies of models into mModelTree, and finds the models in view
+		void cullModels();
 		/**
 		 *	Construct a SceneManager with a Renderer
 		 *	@param	rd	The renderer to use
@@ -0,0 +1,84 @@
+/**
+ * FILE:    Semaphore.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the Semaphore class.
+**/
+
+#include "Semaphore.h"
+
+#if defined(_FIRE_ENGINE_WIN32_)
+#	include <windows.h>
+#else
+#	include <pthread.h>
+#endif
+
+namespace fire_engine
+{
+namespace sys
+{
+
+#if !defined(_FIRE_ENGINE_WIN32_)
+//! Unnamed POSIX semaphores are not available everywhere, so use a condition instead
+struct semaphore_t
+{
+	pthread_mutex_t Mutex;
+	pthread_cond_t  Condition;
+	s32             Count;
+};
+#endif
+
+Semaphore::Semaphore(s32 count)
+{
+#if defined(_FIRE_ENGINE_WIN32_)
+	mHandle = CreateSemaphore(0, count, 0x7fffffff, 0);
+#else
+	semaphore_t * semaphore = new semaphore_t;
+	pthread_mutex_init(&semaphore->Mutex, 0);
+	pthread_cond_init(&semaphore->Condition, 0);
+	semaphore->Count = count;
+	mHandle = semaphore;
+#endif
+}
+
+Semaphore::~Semaphore()
+{
+#if defined(_FIRE_ENGINE_WIN32_)
+	CloseHandle((HANDLE)mHandle);
+#else
+	semaphore_t * semaphore = (semaphore_t *)mHandle;
+	pthread_cond_destroy(&semaphore->Condition);
+	pthread_mutex_destroy(&semaphore->Mutex);
+	delete semaphore;
+#endif
+}
+
+void Semaphore::post()
+{
+#if defined(_FIRE_ENGINE_WIN32_)
+	ReleaseSemaphore((HANDLE)mHandle, 1, 0);
+#else
+	semaphore_t * semaphore = (semaphore_t *)mHandle;
+	pthread_mutex_lock(&semaphore->Mutex);
+	semaphore->Count++;
+	pthread_cond_signal(&semaphore->Condition);
+	pthread_mutex_unlock(&semaphore->Mutex);
+#endif
+}
+
+void Semaphore::wait()
+{
+#if defined(_FIRE_ENGINE_WIN32_)
+	WaitForSingleObject((HANDLE)mHandle, INFINITE);
+#else
+	semaphore_t * semaphore = (semaphore_t *)mHandle;
+	pthread_mutex_lock(&semaphore->Mutex);
+	while (semaphore->Count == 0)
+		pthread_cond_wait(&semaphore->Condition, &semaphore->Mutex);
+	semaphore->Count--;
+	pthread_mutex_unlock(&semaphore->Mutex);
+#endif
+}
+
+} // namespace sys
+} // namespace fire_engine
@@ -0,0 +1,49 @@
+/**
+ * FILE:    Semaphore.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A system independent counting semaphore.
+**/
+
+#ifndef SEMAPHORE_H_INCLUDED
+#define SEMAPHORE_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+
+namespace fire_engine
+{
+namespace sys
+{
+
+/** A counting semaphore, used to make threads wait for some work. Each call to post()
+ lets one call to wait() return. */
+class _FIRE_ENGINE_API_ Semaphore
+{
+public:
+	/** Constructor.
+	 \param count The initial count of the semaphore. */
+	Semaphore(s32 count = 0);
+
+	/** Destructor. No thread may be waiting on the semaphore. */
+	~Semaphore();
+
+	/** Increments the count, waking up a waiting thread if there is one. */
+	void post();
+
+	/** Waits until the count is above 0, then decrements it. */
+	void wait();
+
+private:
+	//! The system semaphore
+	void * mHandle;
+
+	// Copying is not supported
+	Semaphore(const Semaphore&);
+	Semaphore& operator=(const Semaphore&);
+};
+
+} // namespace sys
+} // namespace fire_engine
+
+#endif // SEMAPHORE_H_INCLUDED
@@ -15,8 +15,17 @@
 namespace fire_engine
 {
 
+//! Registers the material of sky boxes, which are not lit and are behind everything
+static material_handle_t RegisterSkyBoxMaterial()
+{
+	Material material;
+	material.setMaterialProperty(EMP_LIGHTING, false);
+	material.setMaterialProperty(EMP_WRITE_TO_Z_BUFFER, false);
+	return MaterialRegistry::Register(material);
+}
+
 SkyBox::SkyBox()
-	: mTextures(0), mTexturesLoaded(false), mVertices(0), mIndices(0)
+	: mMaterial(RegisterSkyBoxMaterial()), mTextures(0), mTexturesLoaded(false), mVertices(0), mIndices(0)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::SkyBox");
@@ -25,7 +34,7 @@ SkyBox::SkyBox()
 
 SkyBox::SkyBox(const IRenderer * renderer, const String& ft, const String& bk, const String& up,
 	const String& dn, const String& lt, const String& rt)
-	: mTexturesLoaded(true)
+	: mMaterial(RegisterSkyBoxMaterial()), mTexturesLoaded(true)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::SkyBox");
@@ -104,9 +113,6 @@ SkyBox::SkyBox(const IRenderer * renderer, const String& ft, const String& bk, c
 		mIndices[2] = 2;
 		mIndices[3] = 3;
 	}
-
-	mMaterial.setMaterialProperty(EMP_LIGHTING, false);
-	mMaterial.setMaterialProperty(EMP_WRITE_TO_Z_BUFFER, false);
 }
 
 SkyBox::~SkyBox()
@@ -126,6 +132,7 @@ SkyBox::~SkyBox()
 		delete [] mVertices;
 	if (mIndices != 0)
 		delete [] mIndices;
+	MaterialRegistry::Drop(mMaterial);
 }
 
 s32 SkyBox::render(IRenderer * renderer)
@@ -13,7 +13,7 @@
 #include "ISpaceNode.h"
 #include "aabbox.h"
 #include "Vertex3.h"
-#include "Material.h"
+#include "MaterialRegistry.h"
 #include "SceneManager.h"
 
 namespace fire_engine
@@ -42,11 +42,12 @@ public:
 	virtual s32 render(IRenderer * renderer);
 
 private:
-	Material    mMaterial;
-	ITexture ** mTextures;
-	bool        mTexturesLoaded;
-	Vertex3 *   mVertices;
-	u32 *       mIndices;
+	//! Registered once, as the material of every sky box is the same
+	material_handle_t mMaterial;
+	ITexture **       mTextures;
+	bool              mTexturesLoaded;
+	Vertex3 *         mVertices;
+	u32 *             mIndices;
 };
 
 }
@@ -0,0 +1,150 @@
+/**
+ * FILE:    SmallArray.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A contiguous array that stores its first few elements inline, and only
+ *          allocates when it grows past them.
+**/
+
+#ifndef SMALLARRAY_H_INCLUDED
+#define SMALLARRAY_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include <string.h>
+
+namespace fire_engine
+{
+
+/** A contiguous array of plain types (such as pointers), with room for N elements inside
+ the object itself. Only arrays that grow past N elements allocate memory. Elements are
+ moved with memcpy, so T must not depend on its own address.
+ Iterators are plain pointers, so walking the array costs no more than walking a C array. */
+template <class T, s32 N>
+class _FIRE_ENGINE_API_ SmallArray
+{
+public:
+	typedef T *       iterator;
+	typedef const T * const_iterator;
+
+	/** Constructor. */
+	SmallArray()
+		: mArray(mInline), mCount(0), mSize(N)
+	{
+	}
+
+	/** Destructor. */
+	~SmallArray()
+	{
+		if (mArray != mInline)
+			delete [] mArray;
+	}
+
+	/** Insert an element at the back of the array. */
+	inline void push_back(const T& elem)
+	{
+		if (mCount == mSize)
+			grow();
+		mArray[mCount++] = elem;
+	}
+
+	/** Returns whether the array contains a given element. */
+	bool contains(const T& elem) const
+	{
+		for (s32 i = 0; i < mCount; i++)
+			if (mArray[i] == elem)
+				return true;
+		return false;
+	}
+
+	/** Removes the first occurence of an element, keeping the order of the others.
+	 \return true if the element was found and removed. */
+	bool removeElement(const T& elem)
+	{
+		for (s32 i = 0; i < mCount; i++)
+		{
+			if (mArray[i] == elem)
+			{
+				memmove((void*)&mArray[i], (const void*)&mArray[i+1], (mCount-i-1)*sizeof(T));
+				mCount--;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** Removes all the elements, keeping the allocated storage. */
+	inline void clear()
+	{
+		mCount = 0;
+	}
+
+	/** Returns the number of elements in the array. */
+	inline s32 size() const
+	{
+		return mCount;
+	}
+
+	/** Returns whether the array is empty. */
+	inline bool isEmpty() const
+	{
+		return mCount == 0;
+	}
+
+	inline iterator begin()
+	{
+		return mArray;
+	}
+
+	inline const_iterator begin() const
+	{
+		return mArray;
+	}
+
+	inline iterator end()
+	{
+		return mArray + mCount;
+	}
+
+	inline const_iterator end() const
+	{
+		return mArray + mCount;
+	}
+
+	/** Access the element at position index in the array. */
+	inline T& operator[](s32 index)
+	{
+		return mArray[index];
+	}
+
+	/** Access the element at position index in the array. */
+	inline const T& operator[](s32 index) const
+	{
+		return mArray[index];
+	}
+
+private:
+	T *  mArray;
+	s32  mCount;
+	s32  mSize;
+	T    mInline[N];
+
+	/** Doubles the storage, moving out of the inline storage if needed. */
+	void grow()
+	{
+		T * tmp = new T[mSize * 2];
+		memcpy((void*)tmp, (const void*)mArray, mCount * sizeof(T));
+		if (mArray != mInline)
+			delete [] mArray;
+		mArray = tmp;
+		mSize *= 2;
+	}
+
+	// Copying is not supported
+	SmallArray(const SmallArray&);
+	SmallArray& operator=(const SmallArray&);
+};
+
+} // namespace fire_engine
+
+#endif // SMALLARRAY_H_INCLUDED
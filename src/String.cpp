@@ -18,70 +18,101 @@ namespace fire_engine
 {
 
 String::String()
-	: mContent(0), mLength(0)
+	: mLength(0)
 {
+	mBuffer[0] = '\0';
 }
 
 String::String(const c8 * str)
+	: mLength(0)
 {
-	mLength  = strlen(str);
-	mContent = new c8[mLength+1];
-#if defined(_MSC_VER)
-	strcpy_s(mContent, mLength+1, str);
-#else
-	strncpy(mContent, str, mLength);
-	mContent[mLength] = '\0';
-#endif
+	mBuffer[0] = '\0';
+	if (str != 0)
+		assign(str, strlen(str));
 }
 
 String::String(const String& str)
+	: mLength(0)
 {
-	mLength = str.length();
-	mContent = new c8[mLength+1];
-#if defined(_MSC_VER)
-	strcpy_s(mContent, mLength+1, str.c_str());
-#else
-	strncpy(mContent, str.c_str(), mLength);
-	mContent[mLength] = '\0';
-#endif
+	assign(str.c_str(), str.length());
 }
 
 String::String(const c8 * str, s32 pre_calculated_length)
+	: mLength(0)
 {
-	mLength = pre_calculated_length;
-	mContent = new c8[mLength+1];
-#if defined(_MSC_VER)
-	strcpy_s(mContent, mLength+1, str);
-#else
-	strncpy(mContent, str, mLength);
-	mContent[mLength] = '\0';
-#endif
+	assign(str, pre_calculated_length);
 }
 
 String::String(c8 * str, bool keep_string)
+	: mLength(0)
 {
-	if (keep_string)
+	s32 length = strlen(str);
+	if (keep_string && length > SSO_LENGTH)
 	{
-		mContent = str;
-		mLength = strlen(str);
+		mHeap   = str;
+		mLength = length;
 	}
 	else
 	{
-		mLength = strlen(str);
-		mContent = new c8[mLength+1];
-#if defined(_MSC_VER)
-		strcpy_s(mContent, mLength+1, str);
-#else
-		strncpy(mContent, str, mLength);
-		mContent[mLength] = '\0';
-#endif
+		assign(str, length);
+		if (keep_string)
+			delete [] str;
 	}
 }
 
 String::~String()
 {
-	if (mContent != 0)
-		delete [] mContent;
+	release();
+}
+
+void String::assign(const c8 * str, s32 length)
+{
+	if (length <= SSO_LENGTH)
+	{
+		// str may point into the current content, so copy it out before releasing
+		c8 tmp[SSO_LENGTH+1];
+		memcpy(tmp, str, length);
+		release();
+		memcpy(mBuffer, tmp, length);
+		mBuffer[length] = '\0';
+	}
+	else
+	{
+		c8 * content = new c8[length+1];
+		memcpy(content, str, length);
+		content[length] = '\0';
+		release();
+		mHeap = content;
+	}
+	mLength = length;
+}
+
+void String::append(const c8 * str, s32 length)
+{
+	s32 total = mLength + length;
+	if (total <= SSO_LENGTH)
+	{
+		memmove(&mBuffer[mLength], str, length);
+		mBuffer[total] = '\0';
+	}
+	else
+	{
+		c8 * content = new c8[total+1];
+		memcpy(content, c_str(), mLength);
+		memcpy(&content[mLength], str, length);
+		content[total] = '\0';
+		release();
+		mHeap = content;
+	}
+	mLength = total;
+}
+
+void String::release()
+{
+	if (!isShort())
+		delete [] mHeap;
+	mLength = 0;
+	mBuffer[0] = '\0';
 }
 
 s32 String::length(void) const
@@ -93,54 +124,54 @@ c8 String::at(s32 i) const
 {
 	if (i >= mLength)
 		return (-1);
-	return mContent[i];
+	return c_str()[i];
 }
 
 s32 String::cmp(const String& other) const
 {
-	return strcmp(mContent, other.c_str());
+	return strcmp(c_str(), other.c_str());
 }
 
 s32 String::cmp(const c8 * other) const
 {
-	return strcmp(mContent, other);
+	return strcmp(c_str(), other);
 }
 
 const c8 * String::c_str(void) const
 {
-	return mContent;
+	return isShort() ? mBuffer : mHeap;
 }
 
 const String& String::append(const String& other)
 {
-	*this += other;
+	append(other.c_str(), other.length());
 	return *this;
 }
 
 const String& String::append(const c8 * other)
 {
-	*this += other;
+	append(other, strlen(other));
 	return *this;
 }
 
 bool String::isSubstring(const String& str) const
 {
-	return strstr(mContent, str.c_str()) != NULL;
+	return strstr(c_str(), str.c_str()) != NULL;
 }
 
 bool String::isSubstring(const c8 * str) const
 {
-	return strstr(mContent, str) != NULL;
+	return strstr(c_str(), str) != NULL;
 }
 
 const c8 * String::substring(const c8 * str) const
 {
-	return strstr(mContent, str);
+	return strstr(c_str(), str);
 }
 
 void String::replaceAll(c8 charA, c8 charB)
 {
-	c8 * buf = mContent;
+	c8 * buf = data();
 	while (*buf != '\0')
 	{
 		if (*buf == charA)
@@ -153,16 +184,19 @@ void String::replaceAll(c8 charA, c8 charB)
 
 void String::makeLower()
 {
+	c8 * buf = data();
 	for (s32 i = 0; i < mLength; i++)
-		mContent[i] = tolower(mContent[i]);
+		buf[i] = tolower(buf[i]);
 }
 
 bool String::equalsIgnoreCase(const String& str) const
 {
 	if (mLength != str.length())
 		return false;
+	const c8 * a = c_str();
+	const c8 * b = str.c_str();
 	for (s32 i = 0; i < mLength; i++)
-		if (tolower(mContent[i]) != tolower(str.c_str()[i]))
+		if (tolower(a[i]) != tolower(b[i]))
 			return false;
 	return true;
 }
@@ -179,37 +213,20 @@ bool String::equalsIgnoreCase(const String& l, const String& r)
 
 const String& String::operator=(const String& other)
 {
-	if (mContent != 0)
-		delete [] mContent;
-	mLength = other.length();
-	mContent = new c8[mLength+1];
-#if defined(_MSC_VER)
-	strcpy_s(mContent, mLength+1, other.c_str());
-#else
-	strncpy(mContent, other.c_str(), mLength);
-	mContent[mLength] = '\0';
-#endif
+	if (this != &other)
+		assign(other.c_str(), other.length());
 	return *this;
 }
 
 const String& String::operator=(const c8 * other)
 {
-	if (mContent != 0)
-		delete [] mContent;
-	mLength = strlen(other);
-	mContent = new c8[mLength+1];
-#if defined(_MSC_VER)
-	strcpy_s(mContent, mLength+1, other);
-#else
-	strncpy(mContent, other, mLength);
-	mContent[mLength] = '\0';
-#endif
+	assign(other, strlen(other));
 	return *this;
 }
 
 bool String::operator==(const String& other) const
 {
-	return this->cmp(other) == 0;
+	return mLength == other.length() && memcmp(c_str(), other.c_str(), mLength) == 0;
 }
 
 bool String::operator==(const c8 * other) const
@@ -219,7 +236,7 @@ bool String::operator==(const c8 * other) const
 
 bool String::operator!=(const String& other) const
 {
-	return this->cmp(other) != 0;
+	return !(*this == other);
 }
 
 bool String::operator!=(const c8 * other) const
@@ -269,22 +286,16 @@ bool String::operator>=(const c8 * other) const
 
 String String::operator+(const String& other) const
 {
-	return *this + other.c_str();
+	String result(*this);
+	result.append(other.c_str(), other.length());
+	return result;
 }
 
 String String::operator+(const c8 * other) const
 {
-	s32 strlen_other = strlen(other);
-	c8 * tmp = new c8[mLength+strlen_other+1];
-	for (s32 i = 0; i < mLength; i++)
-		tmp[i] = mContent[i];
-#if defined(_MSC_VER)
-	strcpy_s(&tmp[mLength], strlen_other+1, other);
-#else
-	strncpy(&tmp[mLength], other, strlen_other);
-	tmp[mLength+strlen_other] = '\0';
-#endif
-	return String(tmp, true);
+	String result(*this);
+	result.append(other, strlen(other));
+	return result;
 }
 
 String String::operator+(s32 num) const
@@ -354,55 +365,74 @@ String String::operator+(bool b) const
 
 const String& String::operator+=(const String& other)
 {
-	*this = *this + other;
+	append(other.c_str(), other.length());
 	return *this;
 }
 
 const String& String::operator+=(const c8 * other)
 {
-	*this = *this + other;
+	append(other, strlen(other));
 	return *this;
 }
 
 const String& String::operator+=(s32 num)
 {
-	*this = *this + num;
-	return *this;
+	c8 tmp[20];
+#if defined(_MSC_VER)
+	sprintf_s(tmp, 20, "%d", num);
+#else
+	snprintf(tmp, 20, "%d", num);
+#endif
+	return *this += tmp;
 }
 
 const String& String::operator+=(f32 flt)
 {
-	*this = *this + flt;
-	return *this;
+	c8 tmp[20];
+#if defined(_MSC_VER)
+	sprintf_s(tmp, 20, "%.4f", flt);
+#else
+	snprintf(tmp, 20, "%.4f", flt);
+#endif
+	return *this += tmp;
 }
 
 const String& String::operator+=(f64 flt)
 {
-	*this = *this + flt;
-	return *this;
+	c8 tmp[20];
+#if defined(_MSC_VER)
+	sprintf_s(tmp, 20, "%.4f", flt);
+#else
+	snprintf(tmp, 20, "%.4f", flt);
+#endif
+	return *this += tmp;
 }
 
 const String& String::operator+=(u32 num)
 {
-	*this = *this + num;
-	return *this;
+	c8 tmp[20];
+#if defined(_MSC_VER)
+	sprintf_s(tmp, 20, "%u", num);
+#else
+	snprintf(tmp, 20, "%u", num);
+#endif
+	return *this += tmp;
 }
 
 const String& String::operator+=(c8 c)
 {
-	*this = *this + c;
+	append(&c, 1);
 	return *this;
 }
 
 const String& String::operator+=(bool b)
 {
-	*this = *this + (b ? "true" : "false");
-	return *this;
+	return *this += (b ? "true" : "false");
 }
 
 c8& String::operator[](s32 index)
 {
-	return mContent[index];
+	return data()[index];
 }
 } // namespace fire_engine
 
@@ -17,10 +17,15 @@ namespace fire_engine
 
 /** A class to easily represent a C-style null-terminated String. It makes operations
  like appending and comparison much easier by providing an easy-to-use interface with
- intuitive operations, like + for appending and >, <, >=, <=, == and != for comparison. */
+ intuitive operations, like + for appending and >, <, >=, <=, == and != for comparison.
+ Strings of up to SSO_LENGTH characters are stored inside the String itself, and only
+ longer ones are allocated on the heap. */
 class _FIRE_ENGINE_API_ String
 {
   public:
+	/** The maximum length of a String that is stored without a heap allocation. */
+	enum { SSO_LENGTH = 22 };
+
 	/** Default constructor.*/
     String();
 
@@ -196,8 +201,36 @@ class _FIRE_ENGINE_API_ String
     c8& operator[](s32 index);
 
   private:
-    c8 *  mContent;
+	union
+	{
+		//! The content of a String longer than SSO_LENGTH
+		c8 *  mHeap;
+		//! The content of a String of at most SSO_LENGTH characters
+		c8    mBuffer[SSO_LENGTH+1];
+	};
     s32   mLength;
+
+	/** Returns whether the content is stored in mBuffer. */
+	inline bool isShort() const
+	{
+		return mLength <= SSO_LENGTH;
+	}
+
+	/** Returns a pointer to the content, wherever it is stored. */
+	inline c8 * data()
+	{
+		return isShort() ? mBuffer : mHeap;
+	}
+
+	/** Replaces the content with length characters from str, which may point into
+	 the current content. */
+	void assign(const c8 * str, s32 length);
+
+	/** Appends length characters from str onto the content. */
+	void append(const c8 * str, s32 length);
+
+	/** Frees the content if it was allocated on the heap. */
+	void release();
 };
 } // namespace fire_engine
 
@@ -0,0 +1,98 @@
+/**
+ * FILE:    Thread.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the Thread class.
+**/
+
+#include "Thread.h"
+
+#if defined(_FIRE_ENGINE_WIN32_)
+#	include <windows.h>
+#	include <process.h>
+#	define THREAD_LOCAL __declspec(thread)
+#else
+#	include <pthread.h>
+#	define THREAD_LOCAL __thread
+#endif
+
+namespace fire_engine
+{
+namespace sys
+{
+
+//! The Thread running in the current thread
+static THREAD_LOCAL Thread * CurrentThread = 0;
+
+#if defined(_FIRE_ENGINE_WIN32_)
+static unsigned __stdcall ThreadEntry(void * thread)
+{
+	Thread::_Execute((Thread *)thread);
+	return 0;
+}
+#else
+static void * ThreadEntry(void * thread)
+{
+	Thread::_Execute((Thread *)thread);
+	return 0;
+}
+#endif
+
+Thread::Thread()
+	: mHandle(0)
+{
+}
+
+Thread::~Thread()
+{
+}
+
+bool Thread::start()
+{
+	if (mHandle != 0)
+		return false;
+#if defined(_FIRE_ENGINE_WIN32_)
+	// _beginthreadex rather than CreateThread, so that the C runtime is set up for the thread
+	mHandle = (void *)_beginthreadex(0, 0, ThreadEntry, this, 0, 0);
+#else
+	pthread_t * thread = new pthread_t;
+	if (pthread_create(thread, 0, ThreadEntry, this) == 0)
+	{
+		mHandle = thread;
+	}
+	else
+	{
+		delete thread;
+	}
+#endif
+	return mHandle != 0;
+}
+
+void Thread::join()
+{
+	if (mHandle == 0)
+		return;
+#if defined(_FIRE_ENGINE_WIN32_)
+	WaitForSingleObject((HANDLE)mHandle, INFINITE);
+	CloseHandle((HANDLE)mHandle);
+#else
+	pthread_join(*(pthread_t *)mHandle, 0);
+	delete (pthread_t *)mHandle;
+#endif
+	mHandle = 0;
+}
+
+Thread * Thread::GetCurrent()
+{
+	return CurrentThread;
+}
+
+void Thread::_Execute(Thread * thread)
+{
+	CurrentThread = thread;
+	thread->run();
+	CurrentThread = 0;
+}
+
+} // namespace sys
+} // namespace fire_engine
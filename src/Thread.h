@@ -0,0 +1,60 @@
+/**
+ * FILE:    Thread.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A system independent thread of execution.
+**/
+
+#ifndef THREAD_H_INCLUDED
+#define THREAD_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+
+namespace fire_engine
+{
+namespace sys
+{
+
+/** A thread of execution. Derived classes implement run(), which is called in the new
+ thread once start() has been called. A Thread must be joined before it is destroyed. */
+class _FIRE_ENGINE_API_ Thread
+{
+public:
+	/** Constructor. The thread is not started. */
+	Thread();
+
+	/** Destructor. */
+	virtual ~Thread();
+
+	/** Starts the thread.
+	 \return true if the thread was started, false otherwise. */
+	bool start();
+
+	/** Waits until run() has returned. */
+	void join();
+
+	/** Returns the Thread that the caller is running in, or 0 if it is running in a thread
+	 that was not created by a Thread, such as the main thread of the program. */
+	static Thread * GetCurrent();
+
+	/** Runs a Thread. Internal function, called by the new thread - do not use. */
+	static void _Execute(Thread * thread);
+
+protected:
+	/** The work done by the thread. */
+	virtual void run() = 0;
+
+private:
+	//! The system thread, 0 if the thread is not started
+	void * mHandle;
+
+	// Copying is not supported
+	Thread(const Thread&);
+	Thread& operator=(const Thread&);
+};
+
+} // namespace sys
+} // namespace fire_engine
+
+#endif // THREAD_H_INCLUDED
@@ -0,0 +1,37 @@
+/**
+ * FILE:    Vertex3.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the Vertex3 class.
+**/
+
+#include "Vertex3.h"
+
+namespace fire_engine
+{
+
+VertexFormat Vertex3::BuildFormat()
+{
+	VertexFormat format;
+	const Vertex3 vertex;
+	const u8 * start = reinterpret_cast<const u8 *>(&vertex);
+	format.setStride(sizeof(Vertex3));
+	format.setAttribute(EVA_POSITION, EVAT_F32X3,
+		(s32)(reinterpret_cast<const u8 *>(vertex.m_position) - start));
+	format.setAttribute(EVA_NORMAL, EVAT_S8X4,
+		(s32)(reinterpret_cast<const u8 *>(vertex.m_normal) - start));
+	format.setAttribute(EVA_COLOR, EVAT_U8X4,
+		(s32)(reinterpret_cast<const u8 *>(&vertex.m_color) - start));
+	format.setAttribute(EVA_TEXTURE_COORDINATES, EVAT_F32X2,
+		(s32)(reinterpret_cast<const u8 *>(vertex.m_tex_coordinates) - start));
+	return format;
+}
+
+const VertexFormat Vertex3::Format = Vertex3::BuildFormat();
+
+const VertexFormat& Vertex3::GetFormat()
+{
+	return Format;
+}
+
+} // namespace fire_engine
@@ -14,10 +14,14 @@
 #include "vector3.h"
 #include "vector2.h"
 #include "Color.h"
+#include "VertexFormat.h"
 
 namespace fire_engine
 {
 
+/** A vertex: its position in space, its normal, its color and its texture coordinates.
+ The normal is stored in 4 bytes, so that a vertex takes 28 bytes, which the renderer
+ reads through the VertexFormat returned by GetFormat(). */
 class _FIRE_ENGINE_API_ Vertex3
 {
 public:
@@ -28,18 +32,22 @@ public:
 		    const Color8& color = Color8(0xFF, 0xFF, 0xFF, 0xFF), // default Color is all 0xFF, so that a model
 		                                                   // that doesn't specify the Color still actually appears
 		    const vector2f& tex_coordinates = vector2f(0.0f, 0.0f))
-		    : m_position(position), m_normal(normal), m_color(color),
-		      m_tex_coordinates(tex_coordinates)
+		    : m_color(color)
 	{
+		setPosition(position);
+		setNormal(normal);
+		setTextureCoordinates(tex_coordinates);
 	}
 
 	Vertex3(f32 x, f32 y, f32 z,
             f32 nx, f32 ny, f32 nz,
             u8 r, u8 g, u8 b, u8 a,
             f32 s, f32 t)
-            : m_position(x, y, z), m_normal(nx, ny, nz),
-              m_color(r, g, b, a), m_tex_coordinates(s, t)
+            : m_color(r, g, b, a)
 	{
+		setPosition(x, y, z);
+		setNormal(nx, ny, nz);
+		setTextureCoordinates(s, t);
 	}
 
 	/** Destructor - does nothing */
@@ -47,84 +55,73 @@ public:
 	{
 	}
 
-	/** Getters and Setters for the various components of Vertex3 objects */
-	inline void setPosition(const vector3f position);
+	/** Getters and Setters for the various components of Vertex3 objects. The normal
+	 is returned as it was stored, to about 1/127 of each component. */
+	inline void setPosition(const vector3f& position);
 	inline void setPosition(f32 x, f32 y, f32 z);
-	inline const vector3f& getPosition() const;
-	inline vector3f& getPosition();
+	inline vector3f getPosition() const;
 
-	inline void setNormal(const vector3f position);
+	inline void setNormal(const vector3f& normal);
 	inline void setNormal(f32 nx, f32 ny, f32 nz);
-	inline const vector3f& getNormal() const;
-	inline vector3f& getNormal();
+	inline vector3f getNormal() const;
 
-	inline void setColor(const Color8 color);
+	inline void setColor(const Color8& color);
 	inline void setColor(u8 r, u8 g, u8 b, u8 a);
 	inline const Color8& getColor() const;
-	inline Color8& getColor();
 
-	inline void setTextureCoordinates(const vector2f tex_coordinates);
+	inline void setTextureCoordinates(const vector2f& tex_coordinates);
 	inline void setTextureCoordinates(f32 s, f32 t);
-	inline const vector2f& getTextureCoordinates() const;
-	inline vector2f& getTextureCoordinates();
+	inline vector2f getTextureCoordinates() const;
 
-	const Vertex3& operator=(const Vertex3& rhs)
-	{
-		m_position = rhs.getPosition();
-		m_normal = rhs.getNormal();
-		m_color = rhs.getColor();
-		m_tex_coordinates = rhs.getTextureCoordinates();
-		return *this;
-	}
+	/** Returns the layout of Vertex3 objects: f32x3 positions, s8x4 normals, u8x4 colors,
+	 and f32x2 texture coordinates. */
+	static const VertexFormat& GetFormat();
 
 private:
-	vector3f   m_position;
-	vector3f   m_normal;
+	f32        m_position[3];
+	s8         m_normal[4];
 	Color8     m_color;
-	vector2f   m_tex_coordinates;
+	f32        m_tex_coordinates[2];
+
+	//! The layout above, built when the program starts so that loader threads only read it
+	static const VertexFormat Format;
+
+	static VertexFormat BuildFormat();
 };
 
-inline void Vertex3::setPosition(const vector3f position)
+inline void Vertex3::setPosition(const vector3f& position)
 {
-	m_position = position;
+	setPosition(position.getX(), position.getY(), position.getZ());
 }
 
 inline void Vertex3::setPosition(f32 x, f32 y, f32 z)
 {
-	m_position.set(x, y, z);
+	m_position[0] = x;
+	m_position[1] = y;
+	m_position[2] = z;
 }
 
-inline vector3f& Vertex3::getPosition()
+inline vector3f Vertex3::getPosition() const
 {
-	return m_position;
+	return vector3f(m_position[0], m_position[1], m_position[2]);
 }
 
-inline const vector3f& Vertex3::getPosition() const
+inline void Vertex3::setNormal(const vector3f& normal)
 {
-	return m_position;
-}
-
-inline void Vertex3::setNormal(const vector3f normal)
-{
-	m_normal = normal;
+	VertexFormat::PackByteNormal(normal, m_normal);
 }
 
 inline void Vertex3::setNormal(f32 nx, f32 ny, f32 nz)
 {
-	m_normal.set(nx, ny, nz);
+	VertexFormat::PackByteNormal(vector3f(nx, ny, nz), m_normal);
 }
 
-inline vector3f& Vertex3::getNormal()
+inline vector3f Vertex3::getNormal() const
 {
-	return m_normal;
+	return VertexFormat::UnpackByteNormal(m_normal);
 }
 
-inline const vector3f& Vertex3::getNormal() const
-{
-	return m_normal;
-}
-
-inline void Vertex3::setColor(const Color8 color)
+inline void Vertex3::setColor(const Color8& color)
 {
 	m_color = color;
 }
@@ -134,34 +131,25 @@ inline void Vertex3::setColor(u8 r, u8 g, u8 b, u8 a)
 	m_color.set(r, g, b, a);
 }
 
-inline Color8& Vertex3::getColor()
-{
-	return m_color;
-}
-
 inline const Color8& Vertex3::getColor() const
 {
 	return m_color;
 }
 
-inline void Vertex3::setTextureCoordinates(const vector2f tex_coordinates)
+inline void Vertex3::setTextureCoordinates(const vector2f& tex_coordinates)
 {
-	m_tex_coordinates = tex_coordinates;
+	setTextureCoordinates(tex_coordinates.getX(), tex_coordinates.getY());
 }
 
 inline void Vertex3::setTextureCoordinates(f32 s, f32 t)
 {
-	m_tex_coordinates.set(s, t);
-}
-
-inline vector2f& Vertex3::getTextureCoordinates()
-{
-	return m_tex_coordinates;
+	m_tex_coordinates[0] = s;
+	m_tex_coordinates[1] = t;
 }
 
-inline const vector2f& Vertex3::getTextureCoordinates() const
+inline vector2f Vertex3::getTextureCoordinates() const
 {
-	return m_tex_coordinates;
+	return vector2f(m_tex_coordinates[0], m_tex_coordinates[1]);
 }
 
 }
@@ -0,0 +1,68 @@
+/**
+ * FILE:    VertexFormat.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the VertexFormat class.
+**/
+
+#include "VertexFormat.h"
+
+namespace fire_engine
+{
+
+VertexFormat::VertexFormat(s32 stride)
+	: mStride(stride)
+{
+	for (s32 i = 0; i < EVA_COUNT; i++)
+	{
+		mAttributes[i].Type   = EVAT_NONE;
+		mAttributes[i].Offset = 0;
+	}
+}
+
+void VertexFormat::setAttribute(EVERTEX_ATTRIBUTE attribute, EVERTEX_ATTRIBUTE_TYPE type, s32 offset)
+{
+	mAttributes[attribute].Type   = type;
+	mAttributes[attribute].Offset = offset;
+}
+
+EVERTEX_ATTRIBUTE_TYPE VertexFormat::getType(EVERTEX_ATTRIBUTE attribute) const
+{
+	return mAttributes[attribute].Type;
+}
+
+s32 VertexFormat::getOffset(EVERTEX_ATTRIBUTE attribute) const
+{
+	return mAttributes[attribute].Offset;
+}
+
+void VertexFormat::setStride(s32 stride)
+{
+	mStride = stride;
+}
+
+s32 VertexFormat::getStride() const
+{
+	return mStride;
+}
+
+s32 VertexFormat::GetSize(EVERTEX_ATTRIBUTE_TYPE type)
+{
+	switch (type)
+	{
+	case EVAT_F32X2:
+		return 2*sizeof(f32);
+	case EVAT_F32X3:
+		return 3*sizeof(f32);
+	case EVAT_F16X2:
+		return 2*sizeof(u16);
+	case EVAT_U8X4:
+	case EVAT_S8X4:
+	case EVAT_S10X3:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+} // namespace fire_engine
@@ -0,0 +1,210 @@
+/**
+ * FILE:    VertexFormat.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: A description of how the attributes of a vertex are laid out in memory.
+**/
+
+#ifndef VERTEXFORMAT_H_INCLUDED
+#define VERTEXFORMAT_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "vector3.h"
+#include "Math.h"
+
+namespace fire_engine
+{
+
+/** The attributes a vertex can have. Points are drawn with just the first two. */
+enum EVERTEX_ATTRIBUTE
+{
+	EVA_POSITION = 0,
+	EVA_COLOR,
+	EVA_NORMAL,
+	EVA_TEXTURE_COORDINATES,
+	EVA_COUNT
+};
+
+/** How an attribute is stored. */
+enum EVERTEX_ATTRIBUTE_TYPE
+{
+	/** The vertices do not have the attribute. */
+	EVAT_NONE = 0,
+	/** 2 floats. */
+	EVAT_F32X2,
+	/** 3 floats. */
+	EVAT_F32X3,
+	/** 2 half floats, as made by PackHalf(). Needs GL_ARB_half_float_vertex. */
+	EVAT_F16X2,
+	/** 4 unsigned bytes, mapped to [0, 1], for colors. */
+	EVAT_U8X4,
+	/** 4 signed bytes, mapped to [-1, 1], the fourth unused, as made by PackByteNormal(). */
+	EVAT_S8X4,
+	/** 3 signed 10 bits values mapped to [-1, 1] and 2 unused bits in a u32, as made by
+	 PackNormal(). Needs GL_ARB_vertex_type_2_10_10_10_rev. */
+	EVAT_S10X3
+};
+
+/** Describes the layout of vertices: the type and the offset of each of their attributes,
+ and the distance between two vertices. Mesh buffers declare it, so that the renderer
+ can draw vertices of any layout it supports. */
+class _FIRE_ENGINE_API_ VertexFormat
+{
+public:
+	/** Constructor. The format does not have any attribute.
+	 \param stride The size of a vertex, in bytes. */
+	VertexFormat(s32 stride = 0);
+
+	/** Sets how an attribute is stored.
+	 \param attribute The attribute.
+	 \param type      Its type, or EVAT_NONE to remove it.
+	 \param offset    Where it is from the start of a vertex, in bytes. */
+	void setAttribute(EVERTEX_ATTRIBUTE attribute, EVERTEX_ATTRIBUTE_TYPE type, s32 offset);
+
+	/** Returns how an attribute is stored, or EVAT_NONE when the vertices do not have it. */
+	EVERTEX_ATTRIBUTE_TYPE getType(EVERTEX_ATTRIBUTE attribute) const;
+
+	/** Returns where an attribute is from the start of a vertex, in bytes. */
+	s32 getOffset(EVERTEX_ATTRIBUTE attribute) const;
+
+	/** Sets the size of a vertex, in bytes. */
+	void setStride(s32 stride);
+
+	/** Returns the size of a vertex, in bytes. */
+	s32 getStride() const;
+
+	/** Returns the size of an attribute of a type, in bytes. */
+	static s32 GetSize(EVERTEX_ATTRIBUTE_TYPE type);
+
+	/** Returns a float as a half float: 1 sign bit, 5 exponent bits and 10 mantissa bits.
+	 The value is rounded to the nearest half float, ties to even. Values too small for a
+	 normal half float become denormal, or 0, and values too large become infinite. */
+	static inline u16 PackHalf(f32 value);
+
+	/** Returns a half float as a float. */
+	static inline f32 UnpackHalf(u16 half);
+
+	/** Stores a normal in 4 signed bytes, for EVAT_S8X4. */
+	static inline void PackByteNormal(const vector3f& normal, s8 * packed);
+
+	/** Returns a normal stored by PackByteNormal(). */
+	static inline vector3f UnpackByteNormal(const s8 * packed);
+
+	/** Returns a normal stored in 10 bits per component, for EVAT_S10X3. */
+	static inline u32 PackNormal(const vector3f& normal);
+
+	/** Returns a normal stored by PackNormal(). */
+	static inline vector3f UnpackNormal(u32 packed);
+
+private:
+	typedef struct
+	{
+		EVERTEX_ATTRIBUTE_TYPE Type;
+		s32                    Offset;
+	} attribute_t;
+
+	attribute_t mAttributes[EVA_COUNT];
+	s32         mStride;
+
+	//! Returns the nearest integer to a component of a normal, scaled to [-scale, scale]
+	static inline s32 Quantize(f32 value, f32 scale);
+};
+
+inline u16 VertexFormat::PackHalf(f32 value)
+{
+	union { f32 f; u32 i; } bits;
+	bits.f = value;
+	const u32 sign      = (bits.i >> 16) & 0x8000;
+	const u32 magnitude = bits.i & 0x7FFFFFFF;
+	// NaNs stay NaNs, and values from 65520 up round to infinity
+	if (magnitude > 0x7F800000)
+		return (u16)(sign | 0x7E00);
+	if (magnitude >= 0x477FF000)
+		return (u16)(sign | 0x7C00);
+
+	u32 half, rest, halfway;
+	if (magnitude >= 0x38800000)
+	{
+		// Normal: the exponent is re-biased, and 13 bits of the mantissa are dropped
+		half    = (magnitude >> 13) - (112 << 10);
+		rest    = magnitude & 0x1FFF;
+		halfway = 0x1000;
+	}
+	else
+	{
+		// Below 2^-14, denormal: the mantissa and its implicit bit are shifted down to a
+		// multiple of 2^-24. Values up to 2^-25 round to 0.
+		if (magnitude <= 0x33000000)
+			return (u16)sign;
+		const u32 shift    = 126 - (magnitude >> 23);
+		const u32 mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+		half    = mantissa >> shift;
+		rest    = mantissa & ((1 << shift) - 1);
+		halfway = 1 << (shift - 1);
+	}
+	// A carry out of the mantissa correctly moves on to the next exponent
+	if (rest > halfway || (rest == halfway && (half & 1) != 0))
+		half++;
+	return (u16)(sign | half);
+}
+
+inline f32 VertexFormat::UnpackHalf(u16 half)
+{
+	union { f32 f; u32 i; } bits;
+	const u32 sign     = (u32)(half & 0x8000) << 16;
+	const u32 exponent = (half >> 10) & 0x1F;
+	const u32 mantissa = half & 0x3FF;
+	if (exponent == 0)
+	{
+		// Denormal, or 0: a multiple of 2^-24
+		const f32 value = (f32)mantissa * (1.0f / 16777216.0f);
+		return sign != 0 ? -value : value;
+	}
+	else if (exponent == 31)
+		bits.i = sign | 0x7F800000 | (mantissa << 13);
+	else
+		bits.i = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	return bits.f;
+}
+
+inline s32 VertexFormat::Quantize(f32 value, f32 scale)
+{
+	const f32 scaled = Math32::Clamp(value, -1.0f, 1.0f) * scale;
+	return (s32)(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+}
+
+inline void VertexFormat::PackByteNormal(const vector3f& normal, s8 * packed)
+{
+	packed[0] = (s8)Quantize(normal.getX(), 127.0f);
+	packed[1] = (s8)Quantize(normal.getY(), 127.0f);
+	packed[2] = (s8)Quantize(normal.getZ(), 127.0f);
+	packed[3] = 0;
+}
+
+inline vector3f VertexFormat::UnpackByteNormal(const s8 * packed)
+{
+	const f32 scale = 1.0f / 127.0f;
+	return vector3f(packed[0]*scale, packed[1]*scale, packed[2]*scale);
+}
+
+inline u32 VertexFormat::PackNormal(const vector3f& normal)
+{
+	return ((u32)Quantize(normal.getX(), 511.0f) & 0x3FF) |
+		(((u32)Quantize(normal.getY(), 511.0f) & 0x3FF) << 10) |
+		(((u32)Quantize(normal.getZ(), 511.0f) & 0x3FF) << 20);
+}
+
+inline vector3f VertexFormat::UnpackNormal(u32 packed)
+{
+	const f32 scale = 1.0f / 511.0f;
+	// Shifting left then right extends the sign of each component
+	const s32 x = (s32)(packed << 22) >> 22;
+	const s32 y = (s32)(packed << 12) >> 22;
+	const s32 z = (s32)(packed << 2) >> 22;
+	return vector3f(x*scale, y*scale, z*scale);
+}
+
+} // namespace fire_engine
+
+#endif // VERTEXFORMAT_H_INCLUDED
@@ -0,0 +1,217 @@
+/**
+ * FILE:    VertexTransform.cpp
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Implementation of the VertexTransform class.
+**/
+
+#include "VertexTransform.h"
+#include "Vertex3.h"
+#include "Thread.h"
+#include "Math.h"
+
+#ifdef _FIRE_ENGINE_SSE_
+#	include <emmintrin.h>
+#endif
+
+namespace fire_engine
+{
+
+//! A thread doing part of a job
+class VertexTransform::Worker : public sys::Thread
+{
+public:
+	Worker(const job_t& job)
+		: mJob(job)
+	{
+	}
+
+protected:
+	virtual void run()
+	{
+		VertexTransform::Execute(mJob);
+	}
+
+private:
+	job_t mJob;
+};
+
+//! Fills a job with the columns of a matrix
+static void SetColumns(const matrix4f& m, f32 columns[4][4])
+{
+	for (s32 j = 0; j < 4; j++)
+		for (s32 i = 0; i < 4; i++)
+			columns[j][i] = m(i, j);
+}
+
+void VertexTransform::TransformPoints(const matrix4f& transform, const f32 * src, f32 * dst,
+	s32 count, s32 stride)
+{
+	job_t job;
+	SetColumns(transform, job.Columns);
+	job.Src     = reinterpret_cast<const u8 *>(src);
+	job.Dst     = reinterpret_cast<u8 *>(dst);
+	job.Count   = count;
+	job.Stride  = stride;
+	job.Normals = false;
+	Run(job);
+}
+
+void VertexTransform::TransformNormals(const matrix4f& transform, const f32 * src, f32 * dst,
+	s32 count, s32 stride)
+{
+	job_t job;
+	SetColumns(GetNormalMatrix(transform), job.Columns);
+	job.Src     = reinterpret_cast<const u8 *>(src);
+	job.Dst     = reinterpret_cast<u8 *>(dst);
+	job.Count   = count;
+	job.Stride  = stride;
+	job.Normals = true;
+	Run(job);
+}
+
+void VertexTransform::TransformVertices(const matrix4f& transform, Vertex3 * vertices, s32 count)
+{
+	if (count <= 0)
+		return;
+	const VertexFormat& format = Vertex3::GetFormat();
+	u8 * data = reinterpret_cast<u8 *>(vertices);
+	f32 * positions = reinterpret_cast<f32 *>(data + format.getOffset(EVA_POSITION));
+	TransformPoints(transform, positions, positions, count, format.getStride());
+
+	// The normals are packed, so they are transformed as floats then packed again
+	f32 * normals = new f32[3*count];
+	for (s32 i = 0; i < count; i++)
+	{
+		const vector3f normal = vertices[i].getNormal();
+		normals[3*i]   = normal.getX();
+		normals[3*i+1] = normal.getY();
+		normals[3*i+2] = normal.getZ();
+	}
+	TransformNormals(transform, normals, normals, count, 3*sizeof(f32));
+	for (s32 i = 0; i < count; i++)
+		vertices[i].setNormal(normals[3*i], normals[3*i+1], normals[3*i+2]);
+	delete [] normals;
+}
+
+matrix4f VertexTransform::GetNormalMatrix(const matrix4f& transform)
+{
+	// The translation does not move normals
+	matrix4f linear = transform;
+	linear.setTranslation(vector3f(0.0f, 0.0f, 0.0f));
+	linear(3, 0) = linear(3, 1) = linear(3, 2) = 0.0f;
+	linear(3, 3) = 1.0f;
+
+	matrix4f inverse;
+	if (!linear.getAffineInverse(inverse))
+		return linear;
+	return inverse.getTranspose();
+}
+
+void VertexTransform::Run(const job_t& job)
+{
+	s32 threads = job.Count / MIN_VECTORS_PER_THREAD;
+	if (threads > MAX_THREADS)
+		threads = MAX_THREADS;
+	if (threads <= 1)
+	{
+		Execute(job);
+		return;
+	}
+
+	// The calling thread does the first part
+	Worker * workers[MAX_THREADS];
+	const s32 part = job.Count / threads;
+	for (s32 i = 1; i < threads; i++)
+	{
+		job_t sub = job;
+		sub.Src   = job.Src + (s64)i * part * job.Stride;
+		sub.Dst   = job.Dst + (s64)i * part * job.Stride;
+		sub.Count = (i == threads-1) ? job.Count - i*part : part;
+		workers[i] = new Worker(sub);
+		if (!workers[i]->start())
+		{
+			// Done here instead
+			delete workers[i];
+			workers[i] = 0;
+			Execute(sub);
+		}
+	}
+	job_t first = job;
+	first.Count = part;
+	Execute(first);
+	for (s32 i = 1; i < threads; i++)
+	{
+		if (workers[i] != 0)
+		{
+			workers[i]->join();
+			delete workers[i];
+		}
+	}
+}
+
+#ifdef _FIRE_ENGINE_SSE_
+
+void VertexTransform::Execute(const job_t& job)
+{
+	const __m128 c0 = _mm_loadu_ps(job.Columns[0]);
+	const __m128 c1 = _mm_loadu_ps(job.Columns[1]);
+	const __m128 c2 = _mm_loadu_ps(job.Columns[2]);
+	// Normals are not translated
+	const __m128 c3 = job.Normals ? _mm_setzero_ps() : _mm_loadu_ps(job.Columns[3]);
+	const u8 * src = job.Src;
+	u8 *       dst = job.Dst;
+	for (s32 i = 0; i < job.Count; i++, src += job.Stride, dst += job.Stride)
+	{
+		const f32 * in = reinterpret_cast<const f32 *>(src);
+		__m128 r = _mm_add_ps(c3, _mm_mul_ps(c0, _mm_load1_ps(in)));
+		r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_load1_ps(in+1)));
+		r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_load1_ps(in+2)));
+		if (job.Normals)
+		{
+			// The fourth component is 0, so it does not change the length
+			__m128 length = _mm_mul_ps(r, r);
+			length = _mm_add_ps(length, _mm_shuffle_ps(length, length, _MM_SHUFFLE(2, 3, 0, 1)));
+			length = _mm_add_ps(length, _mm_shuffle_ps(length, length, _MM_SHUFFLE(1, 0, 3, 2)));
+			const __m128 nonzero = _mm_cmpgt_ps(length, _mm_setzero_ps());
+			r = _mm_and_ps(nonzero, _mm_div_ps(r, _mm_sqrt_ps(length)));
+		}
+
+		// Only x, y and z are stored, whatever follows them
+		f32 * out = reinterpret_cast<f32 *>(dst);
+		_mm_storel_pi(reinterpret_cast<__m64 *>(out), r);
+		_mm_store_ss(out+2, _mm_movehl_ps(r, r));
+	}
+}
+
+#else
+
+void VertexTransform::Execute(const job_t& job)
+{
+	const f32 (*c)[4] = job.Columns;
+	const u8 * src = job.Src;
+	u8 *       dst = job.Dst;
+	for (s32 i = 0; i < job.Count; i++, src += job.Stride, dst += job.Stride)
+	{
+		const f32 * in = reinterpret_cast<const f32 *>(src);
+		f32 r[3];
+		for (s32 k = 0; k < 3; k++)
+			r[k] = c[0][k]*in[0] + c[1][k]*in[1] + c[2][k]*in[2] + (job.Normals ? 0.0f : c[3][k]);
+		if (job.Normals)
+		{
+			const f32 length = r[0]*r[0] + r[1]*r[1] + r[2]*r[2];
+			const f32 inv    = length > 0.0f ? 1.0f / Math32::Sqrt(length) : 0.0f;
+			r[0] *= inv;
+			r[1] *= inv;
+			r[2] *= inv;
+		}
+		f32 * out = reinterpret_cast<f32 *>(dst);
+		out[0] = r[0];
+		out[1] = r[1];
+		out[2] = r[2];
+	}
+}
+
+#endif // _FIRE_ENGINE_SSE_
+
+} // namespace fire_engine
@@ -0,0 +1,90 @@
+/**
+ * FILE:    VertexTransform.h
+ * AUTHOR:  Joseph Paterson ( joseph dot paterson at gmail dot com )
+ * RCS ID:  $Id$
+ * PURPOSE: Transformation of arrays of points and normals, such as those of vertices.
+**/
+
+#ifndef VERTEXTRANSFORM_H_INCLUDED
+#define VERTEXTRANSFORM_H_INCLUDED
+
+#include "Types.h"
+#include "CompileConfig.h"
+#include "matrix4.h"
+
+namespace fire_engine
+{
+
+class Vertex3;
+
+/** Transforms arrays of points and normals by a matrix, for modifying meshes and for
+ skinning. The arrays are strided, so that the positions or normals of an array of
+ vertices can be transformed in place. They are transformed with SSE, and large arrays are
+ split between a few threads. */
+class _FIRE_ENGINE_API_ VertexTransform
+{
+public:
+	enum
+	{
+		//! Arrays are split between threads when each gets at least this many vectors
+		MIN_VECTORS_PER_THREAD = 0x8000,
+		//! The most threads an array is split between, including the calling thread
+		MAX_THREADS            = 4
+	};
+
+	/** Transforms points: their x, y and z, as 3 floats.
+	 \param transform The matrix to transform them by.
+	 \param src       The first point.
+	 \param dst       A place to store the first transformed point, which may be src.
+	 \param count     The number of points.
+	 \param stride    The distance between two points, in bytes, in both src and dst. */
+	static void TransformPoints(const matrix4f& transform, const f32 * src, f32 * dst,
+		s32 count, s32 stride);
+
+	/** Transforms normals, by the inverse of the transpose of the matrix, so that they stay
+	 perpendicular to the surfaces when the matrix scales more along some axes. They are
+	 then normalized, and normals of length 0 stay 0.
+	 \param transform The matrix to transform them by, as the points.
+	 \param src       The first normal.
+	 \param dst       A place to store the first transformed normal, which may be src.
+	 \param count     The number of normals.
+	 \param stride    The distance between two normals, in bytes, in both src and dst. */
+	static void TransformNormals(const matrix4f& transform, const f32 * src, f32 * dst,
+		s32 count, s32 stride);
+
+	/** Transforms the positions and normals of vertices, in place. The normals are
+	 unpacked into a temporary array to be transformed.
+	 \param transform The matrix to transform them by.
+	 \param vertices  The vertices.
+	 \param count     The number of vertices. */
+	static void TransformVertices(const matrix4f& transform, Vertex3 * vertices, s32 count);
+
+	/** Returns the matrix that normals are transformed by, the inverse of the transpose of
+	 the 3x3 part of a matrix. When the matrix cannot be inverted, this is the matrix. */
+	static matrix4f GetNormalMatrix(const matrix4f& transform);
+
+private:
+	class Worker;
+
+	//! The work of a call, in the calling thread or another
+	struct job_t
+	{
+		//! The columns of the matrix, the translation last
+		f32        Columns[4][4];
+		const u8 * Src;
+		u8 *       Dst;
+		s32        Count;
+		s32        Stride;
+		bool       Normals;
+	};
+
+	//! Splits a job between threads
+	static void Run(const job_t& job);
+
+	//! Does a job, in the current thread
+	static void Execute(const job_t& job);
+};
+
+} // namespace fire_engine
+
+#endif // VERTEXTRANSFORM_H_INCLUDED
@@ -7,13 +7,21 @@
 #include "ZipFileReader.h"
 #include "ByteConverter.h"
 #include "MemoryFile.h"
+#include "MMapFile.h"
 #include "Logger.h"
 #include "FileSystem.h"
 #include "FileUtils.h"
+#include "Inflater.h"
+#include "InflateFile.h"
+#include "CRC32.h"
 #include <ctype.h>
 
-#define ZIP_LOCAL_FILE_HEADER_SIG 0x04034b50
-#define ZIP_DATA_DESCRIPTOR_FLAG  0x0008
+#define ZIP_LOCAL_FILE_HEADER_SIG   0x04034b50
+#define ZIP_CENTRAL_FILE_HEADER_SIG 0x02014b50
+#define ZIP_END_OF_CENTRAL_DIR_SIG  0x06054b50
+#define ZIP_MAX_COMMENT_LEN         0xffff
+#define ZIP_METHOD_STORED           0
+#define ZIP_METHOD_DEFLATED         8
 
 namespace fire_engine
 {
@@ -21,7 +29,7 @@ namespace io
 {
 
 ZipFileReader::ZipFileReader()
-	: ZipArchive(0)
+	: ZipArchive(0), StreamingThreshold(-1)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::io::ZipFileReader");
@@ -29,22 +37,22 @@ ZipFileReader::ZipFileReader()
 }
 
 ZipFileReader::ZipFileReader(const String& filename)
+	: StreamingThreshold(-1)
 {
 #if defined(_FIRE_ENGINE_DEBUG_OBJECT_)
 	setDebugName("fire_engine::io::ZipFileReader");
 #endif
-	ZipArchive = FileSystem::Get()->openReadFile(filename, false, io::EFOF_READ|io::EFOF_BINARY);
+	ZipArchive = FileSystem::Get()->openReadFile(filename, false,
+		io::EFOF_READ|io::EFOF_BINARY|io::EFOF_MAP);
 	if (ZipArchive == nullptr)
 	{
         Logger::Get()->log(ES_HIGH, "io::ZipFileReader", "Could not open %s for reading",
                            filename.c_str());
 	}
-	else
+	else if (!readCentralDirectory())
 	{
-	    while (scanLocalFileHeader())
-		{
-			;
-		}
+		Logger::Get()->log(ES_HIGH, "io::ZipFileReader", "Could not read the central directory of %s",
+			filename.c_str());
 	}
 }
 
@@ -77,66 +85,183 @@ bool ZipFileReader::contains(const String& filename, bool ignoreCase)
 	return indexOf(filename, ignoreCase, false) != -1;
 }
 
+s32 ZipFileReader::getEntryCount() const
+{
+	return FileEntries.size();
+}
+
+const String& ZipFileReader::getEntryName(s32 entry) const
+{
+	return FileEntries.const_pointer()[entry].FullName;
+}
+
+IFile * ZipFileReader::openEntry(s32 entry, u32 flags)
+{
+	return getFile(entry);
+}
+
+bool ZipFileReader::getFileStat(const String& filename, bool ignoreCase, file_stat_t& status)
+{
+	return getEntryStat(indexOf(filename, ignoreCase, false), status);
+}
+
+bool ZipFileReader::getEntryStat(s32 entry, file_stat_t& status)
+{
+	if (entry < 0 || entry >= FileEntries.size())
+	{
+		return false;
+	}
+	// The local file header may be being read into the entry
+	sys::MutexLock lock(ArchiveLock);
+	const zip_local_file_header_t& header = FileEntries[entry].ZipHeader;
+	status.Size             = header.Descriptor.UncompressedSize;
+	status.ModificationTime = ((u32)(u16)header.LastModDate << 16) | (u16)header.LastModTime;
+	return true;
+}
+
 IFile * ZipFileReader::getFile(s32 index)
 {
-	u8 * data;
+	const u8 * data;
+	u8 * buffer;
 	IFile * retval;
 	if (index < 0 || index >= FileEntries.size())
 	{
 		return nullptr;
 	}
 
-	switch (FileEntries[index].ZipHeader.CompressionMethod)
+	ZipFileEntry& entry = FileEntries[index];
 	{
-	case 0x00:
-		data = new u8[FileEntries[index].ZipHeader.Descriptor.CompressedSize];
-		ZipArchive->seek(EFSP_START, FileEntries[index].Offset);
-		ZipArchive->read(data, FileEntries[index].ZipHeader.Descriptor.CompressedSize);
-		retval = new MemoryFile(data, FileEntries[index].ZipHeader.Descriptor.CompressedSize, true);
+		sys::MutexLock lock(ArchiveLock);
+		if (entry.Offset < 0 && !readLocalFileHeader(entry))
+		{
+			Logger::Get()->log(ES_HIGH, "io::ZipFileReader", "Bad local file header for %s",
+				entry.FullName.c_str());
+			return nullptr;
+		}
+	}
+
+	const zip_data_descriptor_t& descriptor = entry.ZipHeader.Descriptor;
+	switch (entry.ZipHeader.CompressionMethod)
+	{
+	case ZIP_METHOD_STORED:
+		if (ZipArchive->getData() != nullptr)
+		{
+			// The archive is mapped: return a view on the entry rather than a copy
+			if (entry.Offset + descriptor.CompressedSize > ZipArchive->getSize())
+			{
+				Logger::Get()->log(ES_HIGH, "io::ZipFileReader", "Truncated data for %s",
+					entry.FullName.c_str());
+				return nullptr;
+			}
+			data = (const u8 *)ZipArchive->getData() + entry.Offset;
+			retval = new MMapFile(entry.FullName, data, descriptor.CompressedSize, this);
+		}
+		else
+		{
+			buffer = new u8[descriptor.CompressedSize];
+			{
+				sys::MutexLock lock(ArchiveLock);
+				ZipArchive->seek(EFSP_START, entry.Offset);
+				ZipArchive->read(buffer, descriptor.CompressedSize);
+			}
+			data = buffer;
+			retval = new MemoryFile(buffer, descriptor.CompressedSize, true);
+		}
+		break;
+
+	case ZIP_METHOD_DEFLATED:
+		if (StreamingThreshold >= 0 && descriptor.UncompressedSize > StreamingThreshold)
+		{
+			return new InflateFile(entry.FullName, ZipArchive, this, entry.Offset,
+				descriptor.CompressedSize, descriptor.UncompressedSize, descriptor.CRC32,
+				&ArchiveLock);
+		}
+		else
+		{
+			s32 inflated;
+			buffer = new u8[descriptor.UncompressedSize];
+			if (ZipArchive->getData() != nullptr)
+			{
+				// Read the mapped archive through a view of its own, so that several
+				// threads can decompress at once
+				MMapFile source(entry.FullName, ZipArchive->getData(), ZipArchive->getSize(), 0);
+				Inflater inflater(&source, entry.Offset, descriptor.CompressedSize);
+				inflated = inflater.inflate(buffer, descriptor.UncompressedSize);
+			}
+			else
+			{
+				sys::MutexLock lock(ArchiveLock);
+				Inflater inflater(ZipArchive, entry.Offset, descriptor.CompressedSize);
+				inflated = inflater.inflate(buffer, descriptor.UncompressedSize);
+			}
+			if (inflated != descriptor.UncompressedSize)
+			{
+				Logger::Get()->log(ES_HIGH, "io::ZipFileReader", "Corrupt compressed data in %s",
+					entry.FullName.c_str());
+				delete [] buffer;
+				return nullptr;
+			}
+			data = buffer;
+			retval = new MemoryFile(buffer, descriptor.UncompressedSize, true);
+		}
 		break;
 
 	default:
 		Logger::Get()->log(ES_HIGH, "io::ZipFileReader",
-			"Compression method %d not supported in %s", FileEntries[index].ZipHeader.CompressionMethod,
-			FileEntries[index].Name.c_str());
-		retval = nullptr;
-		break;
+			"Compression method %d not supported in %s", entry.ZipHeader.CompressionMethod,
+			entry.Name.c_str());
+		return nullptr;
+	}
+
+	if (CRC32::Compute(data, descriptor.UncompressedSize) != (u32)descriptor.CRC32)
+	{
+		Logger::Get()->log(ES_HIGH, "io::ZipFileReader", "CRC mismatch in %s",
+			entry.FullName.c_str());
+		delete retval;
+		return nullptr;
 	}
 	return retval;
 }
 
+void ZipFileReader::setStreamingThreshold(s32 size)
+{
+	StreamingThreshold = size;
+}
+
 s32 ZipFileReader::indexOf(const String& filename, bool ignore_case, bool ignore_dirs)
 {
-	s32 index = -1;
-	bool (*equals)(const String&, const String&) = String::equals;
-	if (ignore_case)
-	{
-		equals = String::equalsIgnoreCase;
-	}
+	s32 * found;
+	String name;
 	if (ignore_dirs)
 	{
-		String filename_dirsIgnored = FileUtils::StripDirectory(filename);
-		for (s32 i = 0; i < FileEntries.size(); i++)
-		{
-			if (equals(filename_dirsIgnored, FileEntries[i].Name))
-			{
-				index = i;
-				break;
-			}
-		}
+		name = FileUtils::StripDirectory(filename);
+		found = NameIndex.find(FileUtils::MakeLookupKey(name));
 	}
 	else
 	{
-		for (s32 i = 0; i < FileEntries.size(); i++)
+		name = filename;
+		FileUtils::ConvertPath(name);
+		found = PathIndex.find(FileUtils::MakeLookupKey(name));
+	}
+	if (found == nullptr)
+	{
+		return -1;
+	}
+	if (ignore_case)
+	{
+		return *found;
+	}
+
+	// The indices ignore case: look for the name among the files that have the same key
+	for (s32 i = *found; i != -1;
+		i = ignore_dirs ? FileEntries[i].NextSameName : FileEntries[i].NextSamePath)
+	{
+		if (String::equals(name, ignore_dirs ? FileEntries[i].Name : FileEntries[i].FullName))
 		{
-			if (equals(filename, FileEntries[i].FullName))
-			{
-				index = i;
-				break;
-			}
+			return i;
 		}
 	}
-	return index;
+	return -1;
 }
 
 bool ZipFileReader::contains(const String& filename, bool ignore_case, bool ignore_dirs)
@@ -149,55 +274,178 @@ const Array<ZipFileReader::ZipFileEntry> * ZipFileReader::getEntries() const
 	return &FileEntries;
 }
 
-bool ZipFileReader::scanLocalFileHeader()
+bool ZipFileReader::readCentralDirectory()
 {
-	ZipFileEntry entry;
-	ZipArchive->read(&entry.ZipHeader, sizeof(zip_local_file_header_t));
-	c8 * name = nullptr;
-	c8 * simple_name = nullptr;
+	zip_end_of_central_dir_t eocd;
+	s32 archive_size, tail_size, i;
+	u8 * tail;
+	u8 * directory;
+
+	// The end of central directory record is at the end of the archive, followed by a
+	// comment of up to 64kb: read all of that at once and look for the signature backwards.
+	if (!ZipArchive->seek(EFSP_END, 0))
+		return false;
+	archive_size = ZipArchive->getCurrentPosition();
+	if (archive_size < (s32)sizeof(zip_end_of_central_dir_t))
+		return false;
+	tail_size = archive_size;
+	if (tail_size > ZIP_MAX_COMMENT_LEN + (s32)sizeof(zip_end_of_central_dir_t))
+		tail_size = ZIP_MAX_COMMENT_LEN + (s32)sizeof(zip_end_of_central_dir_t);
+
+	tail = new u8[tail_size];
+	ZipArchive->seek(EFSP_START, archive_size - tail_size);
+	if (!ZipArchive->read(tail, tail_size))
+	{
+		delete [] tail;
+		return false;
+	}
+	for (i = tail_size - (s32)sizeof(zip_end_of_central_dir_t); i >= 0; i--)
+	{
+		if (tail[i] == 0x50 && tail[i+1] == 0x4b && tail[i+2] == 0x05 && tail[i+3] == 0x06)
+			break;
+	}
+	if (i < 0)
+	{
+		delete [] tail;
+		return false;
+	}
+	memcpy(&eocd, tail + i, sizeof(zip_end_of_central_dir_t));
+	delete [] tail;
 
 #if defined(_FIRE_ENGINE_BIG_ENDIAN_)
-	entry.ZipHeader.Signature = ByteConverter::ByteSwap(entry.ZipHeader.Signature);
-	entry.ZipHeader.VersionRequired = ByteConverter::ByteSwap(entry.ZipHeader.VersionRequired);
-	entry.ZipHeader.Flags = ByteConverter::ByteSwap(entry.ZipHeader.Flags);
-	entry.ZipHeader.CompressionMethod = ByteConverter::ByteSwap(entry.ZipHeader.CompressionMethod);
-	entry.ZipHeader.LastModTime = ByteConverter::ByteSwap(entry.ZipHeader.LastModTime);
-	entry.ZipHeader.LastModDate = ByteConverter::ByteSwap(entry.ZipHeader.LastModDate);
-	entry.ZipHeader.Descriptor.CRC32 = ByteConverter::ByteSwap(entry.ZipHeader.Descriptor.CRC32);
-	entry.ZipHeader.Descriptor.CompressedSize = ByteConverter::ByteSwap(entry.ZipHeader.Descriptor.CompressedSize;
-	entry.ZipHeader.Descriptor.UncompressedSize = ByteConverter::ByteSwap(entry.ZipHeader.Descriptor.UncompressedSize);
-	entry.ZipHeader.FilenameLen = ByteConverter::ByteSwap(entry.ZipHeader.FilenameLen);
-	entry.ZipHeader.ExtraFieldLen = ByteConverter::ByteSwap(entry.ZipHeader.ExtraFieldLen);
+	eocd.TotalEntries = ByteConverter::ByteSwap(eocd.TotalEntries);
+	eocd.CentralDirSize = ByteConverter::ByteSwap(eocd.CentralDirSize);
+	eocd.CentralDirOffset = ByteConverter::ByteSwap(eocd.CentralDirOffset);
 #endif
 
-	if (entry.ZipHeader.Signature != ZIP_LOCAL_FILE_HEADER_SIG)
+	const s32 count = (u16)eocd.TotalEntries;
+	const s32 directory_size = eocd.CentralDirSize;
+	if (directory_size < 0 || eocd.CentralDirOffset < 0 ||
+		eocd.CentralDirOffset + directory_size > archive_size)
 		return false;
 
-	// Extract the name
-	name = new c8[entry.ZipHeader.FilenameLen+1];
-	name[entry.ZipHeader.FilenameLen] = '\0';
-	ZipArchive->read(name, entry.ZipHeader.FilenameLen);
-	entry.FullName = String(name);
-	FileUtils::ConvertPath(entry.FullName);
-	entry.Name = FileUtils::StripDirectory(entry.FullName);
-	delete [] name;
-
-	ZipArchive->seek(EFSP_CURRENT, entry.ZipHeader.ExtraFieldLen);
-	if ((entry.ZipHeader.Flags & ZIP_DATA_DESCRIPTOR_FLAG) != 0)
+	// Read the whole central directory in one go
+	directory = new u8[directory_size];
+	ZipArchive->seek(EFSP_START, eocd.CentralDirOffset);
+	if (!ZipArchive->read(directory, directory_size))
 	{
-		ZipArchive->read(&entry.ZipHeader.Descriptor, sizeof(zip_data_descriptor_t));
+		delete [] directory;
+		return false;
 	}
 
-	entry.Offset = ZipArchive->getCurrentPosition();
+	// The number of entries is known up front, so the array never has to grow
+	FileEntries.resize(count > 0 ? count : 1);
+
+	s32 position = 0;
+	for (i = 0; i < count; i++)
+	{
+		zip_central_file_header_t header;
+		if (position + (s32)sizeof(zip_central_file_header_t) > directory_size)
+			break;
+		memcpy(&header, directory + position, sizeof(zip_central_file_header_t));
+
+#if defined(_FIRE_ENGINE_BIG_ENDIAN_)
+		header.Signature = ByteConverter::ByteSwap(header.Signature);
+		header.VersionRequired = ByteConverter::ByteSwap(header.VersionRequired);
+		header.Flags = ByteConverter::ByteSwap(header.Flags);
+		header.CompressionMethod = ByteConverter::ByteSwap(header.CompressionMethod);
+		header.LastModTime = ByteConverter::ByteSwap(header.LastModTime);
+		header.LastModDate = ByteConverter::ByteSwap(header.LastModDate);
+		header.Descriptor.CRC32 = ByteConverter::ByteSwap(header.Descriptor.CRC32);
+		header.Descriptor.CompressedSize = ByteConverter::ByteSwap(header.Descriptor.CompressedSize);
+		header.Descriptor.UncompressedSize = ByteConverter::ByteSwap(header.Descriptor.UncompressedSize);
+		header.FilenameLen = ByteConverter::ByteSwap(header.FilenameLen);
+		header.ExtraFieldLen = ByteConverter::ByteSwap(header.ExtraFieldLen);
+		header.CommentLen = ByteConverter::ByteSwap(header.CommentLen);
+		header.LocalHeaderOffset = ByteConverter::ByteSwap(header.LocalHeaderOffset);
+#endif
+
+		if (header.Signature != ZIP_CENTRAL_FILE_HEADER_SIG)
+			break;
+		const s32 name_len = (u16)header.FilenameLen;
+		if (position + (s32)sizeof(zip_central_file_header_t) + name_len > directory_size)
+			break;
+
+		ZipFileEntry entry;
+		entry.ZipHeader.Signature = ZIP_LOCAL_FILE_HEADER_SIG;
+		entry.ZipHeader.VersionRequired = header.VersionRequired;
+		entry.ZipHeader.Flags = header.Flags;
+		entry.ZipHeader.CompressionMethod = header.CompressionMethod;
+		entry.ZipHeader.LastModTime = header.LastModTime;
+		entry.ZipHeader.LastModDate = header.LastModDate;
+		entry.ZipHeader.Descriptor = header.Descriptor;
+		entry.ZipHeader.FilenameLen = header.FilenameLen;
+		entry.ZipHeader.ExtraFieldLen = 0;
+		entry.LocalHeaderOffset = header.LocalHeaderOffset;
+		entry.Offset = -1;
+
+		entry.FullName = String((const c8 *)directory + position + sizeof(zip_central_file_header_t),
+			name_len);
+		FileUtils::ConvertPath(entry.FullName);
+		entry.Name = FileUtils::StripDirectory(entry.FullName);
+
+		position += (s32)sizeof(zip_central_file_header_t) + name_len +
+			(u16)header.ExtraFieldLen + (u16)header.CommentLen;
 
 #if defined(_FIRE_ENGINE_DEBUG_ZIP_)
-    Logger::Get()->log(ES_DEBUG, "io::ZipFileReader", "%s entry read", entry.FullName.c_str());
+		Logger::Get()->log(ES_DEBUG, "io::ZipFileReader", "%s entry read", entry.FullName.c_str());
 #endif
 
-	// Seek to the next possible local file header
-	ZipArchive->seek(EFSP_CURRENT, entry.ZipHeader.Descriptor.CompressedSize);
+		const s32 index = FileEntries.size();
+		entry.NextSamePath = -1;
+		entry.NextSameName = -1;
+		FileEntries.push_back(entry);
+		const String path_key = FileUtils::MakeLookupKey(entry.FullName);
+		if (!PathIndex.insert(path_key, index))
+		{
+			s32 last = *PathIndex.find(path_key);
+			while (FileEntries[last].NextSamePath != -1)
+				last = FileEntries[last].NextSamePath;
+			FileEntries[last].NextSamePath = index;
+		}
+		if (entry.Name.length() > 0)
+		{
+			const String name_key = FileUtils::MakeLookupKey(entry.Name);
+			if (!NameIndex.insert(name_key, index))
+			{
+				s32 last = *NameIndex.find(name_key);
+				while (FileEntries[last].NextSameName != -1)
+					last = FileEntries[last].NextSameName;
+				FileEntries[last].NextSameName = index;
+			}
+		}
+	}
+	delete [] directory;
+
+	if (i != count)
+	{
+		Logger::Get()->log(ES_HIGH, "io::ZipFileReader", "Central directory is corrupt after %d entries",
+			i);
+	}
+	return true;
+}
+
+bool ZipFileReader::readLocalFileHeader(ZipFileEntry& entry)
+{
+	zip_local_file_header_t header;
+	if (!ZipArchive->seek(EFSP_START, entry.LocalHeaderOffset) ||
+		!ZipArchive->read(&header, sizeof(zip_local_file_header_t)))
+		return false;
+
+#if defined(_FIRE_ENGINE_BIG_ENDIAN_)
+	header.Signature = ByteConverter::ByteSwap(header.Signature);
+	header.FilenameLen = ByteConverter::ByteSwap(header.FilenameLen);
+	header.ExtraFieldLen = ByteConverter::ByteSwap(header.ExtraFieldLen);
+#endif
+
+	if (header.Signature != ZIP_LOCAL_FILE_HEADER_SIG)
+		return false;
 
-	FileEntries.push_back(entry);
+	// The sizes and CRC come from the central directory, as the local header does not have
+	// them when a data descriptor is used. Only the length of the extra field may differ.
+	entry.ZipHeader.ExtraFieldLen = header.ExtraFieldLen;
+	entry.Offset = entry.LocalHeaderOffset + (s32)sizeof(zip_local_file_header_t) +
+		(u16)header.FilenameLen + (u16)header.ExtraFieldLen;
 	return true;
 }
 
@@ -10,6 +10,8 @@
 #include "Types.h"
 #include "CompileConfig.h"
 #include "Array.h"
+#include "HashTable.h"
+#include "Mutex.h"
 #include "IFileProvider.h"
 
 namespace fire_engine
@@ -22,8 +24,20 @@ namespace io
 
 class IFile;
 
-/** A simple class for loading and exploring .ZIP files. For now, only files
- that are "stored" (ie. not compressed) are supported.
+/** A simple class for loading and exploring .ZIP files. Files that are "stored"
+ (ie. not compressed) and files compressed with DEFLATE are supported, and their CRC-32
+ is checked when they are read.
+ Compressed files are decompressed into memory when they are opened, unless they are
+ larger than the streaming threshold, in which case they are decompressed as they are
+ read (see setStreamingThreshold()).
+ When the archive can be mapped into memory, stored files are returned as views on the
+ mapping, with no copy: see IFile::getData().
+ The archive is indexed from its central directory, which is read in a single block when
+ the archive is opened, so looking up a file by name does not depend on the number of files
+ in the archive.
+ Files can be opened and read from several threads at once. Streamed files read from
+ the archive each time they are read, under the same lock as the other readers of the
+ archive.
  For access to some file in the ZIP archive, see the comments on the openFile()
  method. */
 class _FIRE_ENGINE_API_ ZipFileReader : public IFileProvider
@@ -49,6 +63,37 @@ public:
 		s16 FilenameLen;
 		s16 ExtraFieldLen;
 	} zip_local_file_header_t;
+
+	typedef struct
+	{
+		s32 Signature;
+		s16 VersionMadeBy;
+		s16 VersionRequired;
+		s16 Flags;
+		s16 CompressionMethod;
+		s16 LastModTime;
+		s16 LastModDate;
+		zip_data_descriptor_t Descriptor;
+		s16 FilenameLen;
+		s16 ExtraFieldLen;
+		s16 CommentLen;
+		s16 DiskNumberStart;
+		s16 InternalAttributes;
+		s32 ExternalAttributes;
+		s32 LocalHeaderOffset;
+	} zip_central_file_header_t;
+
+	typedef struct
+	{
+		s32 Signature;
+		s16 DiskNumber;
+		s16 CentralDirDisk;
+		s16 EntriesOnDisk;
+		s16 TotalEntries;
+		s32 CentralDirSize;
+		s32 CentralDirOffset;
+		s16 CommentLen;
+	} zip_end_of_central_dir_t;
 #pragma pack(pop)
 
 public:
@@ -56,7 +101,14 @@ public:
 	{
 		String Name;
 		String FullName;
+		//! Offset of the file data, or -1 until the local header has been read
 		s32    Offset;
+		//! Offset of the local file header
+		s32    LocalHeaderOffset;
+		//! The next file whose full name has the same lower case form, or -1
+		s32    NextSamePath;
+		//! The next file whose name has the same lower case form, or -1
+		s32    NextSameName;
 		zip_local_file_header_t ZipHeader;
 	};
 
@@ -77,6 +129,12 @@ public:
 	/** Returns a pointer to file at position index in the list of files. */
 	IFile * getFile(s32 index);
 
+	/** Sets the size above which compressed files are decompressed as they are read,
+	 instead of all at once when they are opened. Streamed files use little memory, but
+	 seeking backwards in them is slow.
+	 \param size The size in bytes, or -1 (the default) to never stream files. */
+	void setStreamingThreshold(s32 size);
+
 	/** Returns the index of the file if it is in the archive, or -1 if it's not there. 
 	 \param filename    The name of the file to look for.
 	 \param ignore_case Whether to perform a case-insensitive search for the file or not.
@@ -99,13 +157,41 @@ public:
 
 	virtual bool isReady() const;
 
+	virtual s32 getEntryCount() const;
+
+	virtual const String& getEntryName(s32 entry) const;
+
+	virtual IFile * openEntry(s32 entry, u32 flags);
+
+	virtual bool getFileStat(const String& filename, bool ignoreCase, file_stat_t& status);
+
+	/** Returns the uncompressed size of a file, and its DOS date and time of
+	 modification. */
+	virtual bool getEntryStat(s32 entry, file_stat_t& status);
+
 private:
 	IFile *             ZipArchive;
 	Array<ZipFileEntry> FileEntries;
-
-	/** Look for the next local file header, read it, and insert it into the list of files.
-	 \return true if a local file header was found, false otherwise. */
-	bool scanLocalFileHeader();
+	s32                 StreamingThreshold;
+	//! Held while the position of ZipArchive is used
+	sys::Mutex          ArchiveLock;
+	//! Index of the files, keyed by their normalised lower case full name. When several
+	//! files have the same key, the first one in the archive is indexed, and the others
+	//! are chained to it by NextSamePath.
+	HashTable<String, s32> PathIndex;
+	//! Index of the files, keyed by their lower case name without directory. When several
+	//! files have the same key, the first one in the archive is indexed, and the others
+	//! are chained to it by NextSameName.
+	HashTable<String, s32> NameIndex;
+
+	/** Find the end of central directory record, then read the whole central directory and
+	 insert every file it lists into the list of files and the indices.
+	 \return true if the central directory was read, false otherwise. */
+	bool readCentralDirectory();
+
+	/** Reads the local file header of an entry, to find where its data starts.
+	 \return true if the local file header was read, false otherwise. */
+	bool readLocalFileHeader(ZipFileEntry& entry);
 };
 
 }
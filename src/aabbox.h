@@ -178,6 +178,14 @@ private:
 	vector3<Real> mMaxPoint;
 };
 
+template <class Real>
+bool aabbox<Real>::intersectsWith(const aabbox<Real>& box) const
+{
+	return mMinPoint.getX() <= box.mMaxPoint.getX() && mMaxPoint.getX() >= box.mMinPoint.getX() &&
+		   mMinPoint.getY() <= box.mMaxPoint.getY() && mMaxPoint.getY() >= box.mMinPoint.getY() &&
+		   mMinPoint.getZ() <= box.mMaxPoint.getZ() && mMaxPoint.getZ() >= box.mMinPoint.getZ();
+}
+
 typedef aabbox<f32> aabboxf;
 typedef aabbox<f64> aabboxd;
 
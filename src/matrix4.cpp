@@ -1,5 +1,9 @@
 #include "matrix4.h"
 
+#ifdef _FIRE_ENGINE_SSE_
+#	include <emmintrin.h>
+#endif
+
 namespace fire_engine
 {
 template <>
@@ -12,4 +16,149 @@ const matrix4<f64> matrix4<f64>::IDENTITY_MATRIX = matrix4<f64>(1.0, 0.0, 0.0, 0
 	                                                            0.0, 1.0, 0.0, 0.0,
 	                                                            0.0, 0.0, 1.0, 0.0,
 	                                                            0.0, 0.0, 0.0, 1.0);
+
+#ifdef _FIRE_ENGINE_SSE_
+
+//! Loads the x, y and z of a vector, with 0 as the fourth component
+static inline __m128 LoadVector3(const f32 * v)
+{
+	return _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd((const f64 *)v)), _mm_load_ss(v+2));
 }
+
+//! Returns the cross product of two vectors, with 0 as the fourth component
+static inline __m128 Cross(__m128 a, __m128 b)
+{
+	const __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	const __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	const __m128 c     = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+//! Loads the columns of a row-major matrix
+static inline void LoadColumns(const f32 * m, __m128 * columns)
+{
+	columns[0] = _mm_loadu_ps(m);
+	columns[1] = _mm_loadu_ps(m+4);
+	columns[2] = _mm_loadu_ps(m+8);
+	columns[3] = _mm_loadu_ps(m+12);
+	_MM_TRANSPOSE4_PS(columns[0], columns[1], columns[2], columns[3]);
+}
+
+/** Transforms a box by the columns of a matrix, and their absolute values. The centre is
+ transformed, and the transformed half extents are the sum of the half extents along each
+ axis, weighted by the absolute values of the matrix. This gives the same box as
+ transforming the 8 corners. */
+static inline void TransformBox(const __m128 * columns, const __m128 * absColumns, aabbox<f32>& box)
+{
+	const __m128 half   = _mm_set1_ps(0.5f);
+	const __m128 lo     = LoadVector3(box.getMinPoint().v());
+	const __m128 hi     = LoadVector3(box.getMaxPoint().v());
+	const __m128 centre = _mm_mul_ps(_mm_add_ps(lo, hi), half);
+	const __m128 extent = _mm_mul_ps(_mm_sub_ps(hi, lo), half);
+
+	__m128 c = _mm_add_ps(columns[3], _mm_mul_ps(columns[0], _mm_shuffle_ps(centre, centre, _MM_SHUFFLE(0, 0, 0, 0))));
+	c = _mm_add_ps(c, _mm_mul_ps(columns[1], _mm_shuffle_ps(centre, centre, _MM_SHUFFLE(1, 1, 1, 1))));
+	c = _mm_add_ps(c, _mm_mul_ps(columns[2], _mm_shuffle_ps(centre, centre, _MM_SHUFFLE(2, 2, 2, 2))));
+	__m128 e = _mm_mul_ps(absColumns[0], _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(0, 0, 0, 0)));
+	e = _mm_add_ps(e, _mm_mul_ps(absColumns[1], _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(1, 1, 1, 1))));
+	e = _mm_add_ps(e, _mm_mul_ps(absColumns[2], _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(2, 2, 2, 2))));
+
+	f32 bmin[4], bmax[4];
+	_mm_storeu_ps(bmin, _mm_sub_ps(c, e));
+	_mm_storeu_ps(bmax, _mm_add_ps(c, e));
+	box.reset(vector3<f32>(bmin), vector3<f32>(bmax));
+}
+
+template <>
+matrix4<f32> matrix4<f32>::operator*(const matrix4<f32>& rhs) const
+{
+	// Each row of the result is the sum of the rows of rhs, weighted by a row of this matrix
+	const __m128 b0 = _mm_loadu_ps(rhs.mMatrix);
+	const __m128 b1 = _mm_loadu_ps(rhs.mMatrix+4);
+	const __m128 b2 = _mm_loadu_ps(rhs.mMatrix+8);
+	const __m128 b3 = _mm_loadu_ps(rhs.mMatrix+12);
+	f32 r[16];
+	for (s32 i = 0; i < 16; i += 4)
+	{
+		__m128 row = _mm_mul_ps(_mm_set1_ps(mMatrix[i]), b0);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(mMatrix[i+1]), b1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(mMatrix[i+2]), b2));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(mMatrix[i+3]), b3));
+		_mm_storeu_ps(r+i, row);
+	}
+	return matrix4<f32>(r);
+}
+
+template <>
+bool matrix4<f32>::getAffineInverse(matrix4<f32>& s) const
+{
+	const __m128 r0 = LoadVector3(mMatrix);
+	const __m128 r1 = LoadVector3(mMatrix+4);
+	const __m128 r2 = LoadVector3(mMatrix+8);
+
+	// The columns of the inverse of the 3x3 part, before dividing by the determinant
+	__m128 c0 = Cross(r1, r2);
+	__m128 c1 = Cross(r2, r0);
+	__m128 c2 = Cross(r0, r1);
+
+	f32 d[4];
+	_mm_storeu_ps(d, _mm_mul_ps(r0, c0));
+	const f32 det = d[0] + d[1] + d[2];
+	if (det == 0.0f)
+		return false;
+	const __m128 inv = _mm_set1_ps(1.0f / det);
+	c0 = _mm_mul_ps(c0, inv);
+	c1 = _mm_mul_ps(c1, inv);
+	c2 = _mm_mul_ps(c2, inv);
+
+	// The translation is undone after the rest
+	__m128 c3 = _mm_mul_ps(c0, _mm_set1_ps(mMatrix[3]));
+	c3 = _mm_add_ps(c3, _mm_mul_ps(c1, _mm_set1_ps(mMatrix[7])));
+	c3 = _mm_add_ps(c3, _mm_mul_ps(c2, _mm_set1_ps(mMatrix[11])));
+	c3 = _mm_sub_ps(_mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f), c3);
+
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	_mm_storeu_ps(s.mMatrix, c0);
+	_mm_storeu_ps(s.mMatrix+4, c1);
+	_mm_storeu_ps(s.mMatrix+8, c2);
+	_mm_storeu_ps(s.mMatrix+12, c3);
+	return true;
+}
+
+template <>
+void matrix4<f32>::transform(aabbox<f32>& in) const
+{
+	transform(&in, 1);
+}
+
+template <>
+void matrix4<f32>::transform(vector3<f32> * points, s32 count) const
+{
+	__m128 columns[4];
+	LoadColumns(mMatrix, columns);
+	f32 p[4];
+	for (s32 i = 0; i < count; i++)
+	{
+		__m128 r = _mm_add_ps(columns[3], _mm_mul_ps(columns[0], _mm_set1_ps(points[i].getX())));
+		r = _mm_add_ps(r, _mm_mul_ps(columns[1], _mm_set1_ps(points[i].getY())));
+		r = _mm_add_ps(r, _mm_mul_ps(columns[2], _mm_set1_ps(points[i].getZ())));
+		_mm_storeu_ps(p, r);
+		points[i].set(p[0], p[1], p[2]);
+	}
+}
+
+template <>
+void matrix4<f32>::transform(aabbox<f32> * boxes, s32 count) const
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 columns[4], absColumns[3];
+	LoadColumns(mMatrix, columns);
+	for (s32 i = 0; i < 3; i++)
+		absColumns[i] = _mm_andnot_ps(sign, columns[i]);
+	for (s32 i = 0; i < count; i++)
+		TransformBox(columns, absColumns, boxes[i]);
+}
+
+#endif // _FIRE_ENGINE_SSE_
+
+} // namespace fire_engine
@@ -217,6 +217,10 @@ public:
 	 \return  Whether the inverse could be calculated or not. */
 	bool getInverse(matrix4& s) const
 	{
+		// Most matrices are transformations of space, which are inverted much faster
+		if (mMatrix[12] == 0 && mMatrix[13] == 0 && mMatrix[14] == 0 && mMatrix[15] == 1)
+			return getAffineInverse(s);
+
 		Real d = determinant();
 		if (d == 0)
 			return (false);
@@ -306,6 +310,40 @@ public:
 		return true;
 	}
 
+	/** Calculates the inverse of the matrix, when its last row is (0, 0, 0, 1), as that of
+	 any combination of rotations, scalings and translations is.
+	 \param s A place to store the calculated inverse.
+	 \return  Whether the inverse could be calculated or not. */
+	bool getAffineInverse(matrix4& s) const
+	{
+		// The inverse of the 3x3 part has the cofactors of its rows as columns, which are
+		// cross products of the other rows
+		Real c[3][3];
+		for (s32 j = 0; j < 3; j++)
+		{
+			const Real * a = _mMatrix[(j+1)%3];
+			const Real * b = _mMatrix[(j+2)%3];
+			c[j][0] = a[1]*b[2] - a[2]*b[1];
+			c[j][1] = a[2]*b[0] - a[0]*b[2];
+			c[j][2] = a[0]*b[1] - a[1]*b[0];
+		}
+		Real d = _mMatrix[0][0]*c[0][0] + _mMatrix[0][1]*c[0][1] + _mMatrix[0][2]*c[0][2];
+		if (d == 0)
+			return false;
+		d = 1 / d;
+
+		for (s32 i = 0; i < 3; i++)
+		{
+			s(i, 0) = c[0][i] * d;
+			s(i, 1) = c[1][i] * d;
+			s(i, 2) = c[2][i] * d;
+			s(i, 3) = -(s(i, 0)*_mMatrix[0][3] + s(i, 1)*_mMatrix[1][3] + s(i, 2)*_mMatrix[2][3]);
+		}
+		s(3, 0) = s(3, 1) = s(3, 2) = 0;
+		s(3, 3) = 1;
+		return true;
+	}
+
 	/** Invert the current matrix.
 	 \return Whether the matrix could be inverted (non-singular), or not
 	         (singular). */
@@ -493,9 +531,16 @@ public:
 	/** Transform a given vector. */
 	inline void transform(vector3<Real>& in) const
 	{
-		in.setX(in.getX()*_mMatrix[0][0]+in.getY()*_mMatrix[0][1]+in.getZ()*_mMatrix[0][2]+_mMatrix[0][3]);
-		in.setY(in.getX()*_mMatrix[1][0]+in.getY()*_mMatrix[1][1]+in.getZ()*_mMatrix[1][2]+_mMatrix[1][3]);
-		in.setZ(in.getX()*_mMatrix[2][0]+in.getY()*_mMatrix[2][1]+in.getZ()*_mMatrix[2][2]+_mMatrix[2][3]);
+		in = applyTransformation(in);
+	}
+
+	/** Transforms an array of points.
+	 \param points The points to transform.
+	 \param count  The number of points. */
+	void transform(vector3<Real> * points, s32 count) const
+	{
+		for (s32 i = 0; i < count; i++)
+			points[i] = applyTransformation(points[i]);
 	}
 
 	/** Returns the transform of a given bounding box. */
@@ -545,6 +590,15 @@ public:
 		in.reset(vector3<Real>(BMin), vector3<Real>(BMax));
 	}
 
+	/** Transforms an array of bounding boxes.
+	 \param boxes The boxes to transform.
+	 \param count The number of boxes. */
+	void transform(aabbox<Real> * boxes, s32 count) const
+	{
+		for (s32 i = 0; i < count; i++)
+			transform(boxes[i]);
+	}
+
 	/** Returns a pointer to the values in the matrix, in row-major form. */
 	inline const Real * v() const
 	{
@@ -820,6 +874,15 @@ private:
 typedef matrix4<f32> matrix4f;
 typedef matrix4<f64> matrix4d;
 
+#ifdef _FIRE_ENGINE_SSE_
+// The most used operations on f32 matrices are done with SSE, in matrix4.cpp
+template <> matrix4<f32> matrix4<f32>::operator*(const matrix4<f32>& rhs) const;
+template <> bool matrix4<f32>::getAffineInverse(matrix4<f32>& s) const;
+template <> void matrix4<f32>::transform(aabbox<f32>& in) const;
+template <> void matrix4<f32>::transform(vector3<f32> * points, s32 count) const;
+template <> void matrix4<f32>::transform(aabbox<f32> * boxes, s32 count) const;
+#endif
+
 template class _FIRE_ENGINE_API_ matrix4<f32>;
 template class _FIRE_ENGINE_API_ matrix4<f64>;
 
@@ -1,9 +1,110 @@
 #include "quaternion.h"
 
+#ifdef _FIRE_ENGINE_SSE_
+#	include <emmintrin.h>
+#endif
+
 namespace fire_engine
 {
 template <> const quaternionf quaternionf::IDENTITY_QUATERNION = quaternionf(1.0f, 0.0f, 0.0f, 0.0f);
 template <> const quaterniond quaterniond::IDENTITY_QUATERNION = quaterniond(1.0, 0.0, 0.0, 0.0);
 template <> const quaternionf quaternionf::ZERO_QUATERNION = quaternionf(0.0f, 0.0f, 0.0f, 0.0f);
 template <> const quaterniond quaterniond::ZERO_QUATERNION = quaterniond(0.0, 0.0, 0.0, 0.0);
+
+#ifdef _FIRE_ENGINE_SSE_
+
+/** The number of terms of the polynomials of the weights of slerp. They are those of the
+ series of sin(t*theta)/sin(theta) in cos(theta) - 1, with the last term scaled by
+ 1.85298109240830 to make up for the ones that are left out (David Eberly, "A Fast and
+ Accurate Algorithm for Computing SLERP"). */
+#define QUATERNION_SLERP_TERMS 8
+
+//! 1/((i+1)(2i+3)) for each term i
+static const f32 s_slerpU[QUATERNION_SLERP_TERMS] =
+{
+	1.0f/3.0f, 1.0f/10.0f, 1.0f/21.0f, 1.0f/36.0f, 1.0f/55.0f, 1.0f/78.0f, 1.0f/105.0f,
+	1.85298109240830f/136.0f
+};
+
+//! (i+1)/(2i+3) for each term i
+static const f32 s_slerpV[QUATERNION_SLERP_TERMS] =
+{
+	1.0f/3.0f, 2.0f/5.0f, 3.0f/7.0f, 4.0f/9.0f, 5.0f/11.0f, 6.0f/13.0f, 7.0f/15.0f,
+	1.85298109240830f*8.0f/17.0f
+};
+
+//! Returns the weight of the quaternion interpolated to, for a time and (cos(theta) - 1)
+static inline __m128 SlerpWeight(__m128 time, __m128 cosm1)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 t2  = _mm_mul_ps(time, time);
+	__m128 w = one;
+	for (s32 i = QUATERNION_SLERP_TERMS-1; i >= 0; i--)
+	{
+		const __m128 b = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(s_slerpU[i]), t2),
+			_mm_set1_ps(s_slerpV[i])), cosm1);
+		w = _mm_add_ps(one, _mm_mul_ps(b, w));
+	}
+	return _mm_mul_ps(time, w);
+}
+
+template <>
+void quaternion<f32>::Slerp(const quaternion<f32> * from, const quaternion<f32> * to, f32 time,
+	quaternion<f32> * out, s32 count)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 t    = _mm_set1_ps(time);
+	const __m128 one  = _mm_set1_ps(1.0f);
+	for (s32 i = 0; i < count; i += 4)
+	{
+		// The last pairs are padded with identities
+		quaternion<f32> pa[4], pb[4];
+		const s32 n = (count - i < 4) ? count - i : 4;
+		const quaternion<f32> * a = from + i;
+		const quaternion<f32> * b = to + i;
+		if (n < 4)
+		{
+			for (s32 j = 0; j < n; j++)
+			{
+				pa[j] = a[j];
+				pb[j] = b[j];
+			}
+			a = pa;
+			b = pb;
+		}
+
+		// One component of the 4 quaternions in each register
+		__m128 aw = _mm_loadu_ps(a[0].m_points), ax = _mm_loadu_ps(a[1].m_points);
+		__m128 ay = _mm_loadu_ps(a[2].m_points), az = _mm_loadu_ps(a[3].m_points);
+		__m128 bw = _mm_loadu_ps(b[0].m_points), bx = _mm_loadu_ps(b[1].m_points);
+		__m128 by = _mm_loadu_ps(b[2].m_points), bz = _mm_loadu_ps(b[3].m_points);
+		_MM_TRANSPOSE4_PS(aw, ax, ay, az);
+		_MM_TRANSPOSE4_PS(bw, bx, by, bz);
+
+		// Going the short way round: to the opposite of b when the dot product is negative
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, bw), _mm_mul_ps(ax, bx)),
+			_mm_add_ps(_mm_mul_ps(ay, by), _mm_mul_ps(az, bz)));
+		const __m128 flip = _mm_and_ps(dot, sign);
+		dot = _mm_xor_ps(dot, flip);
+		dot = _mm_min_ps(dot, one);
+
+		const __m128 cosm1 = _mm_sub_ps(dot, one);
+		const __m128 wa    = SlerpWeight(_mm_sub_ps(one, t), cosm1);
+		const __m128 wb    = _mm_xor_ps(SlerpWeight(t, cosm1), flip);
+		__m128 rw = _mm_add_ps(_mm_mul_ps(aw, wa), _mm_mul_ps(bw, wb));
+		__m128 rx = _mm_add_ps(_mm_mul_ps(ax, wa), _mm_mul_ps(bx, wb));
+		__m128 ry = _mm_add_ps(_mm_mul_ps(ay, wa), _mm_mul_ps(by, wb));
+		__m128 rz = _mm_add_ps(_mm_mul_ps(az, wa), _mm_mul_ps(bz, wb));
+		_MM_TRANSPOSE4_PS(rw, rx, ry, rz);
+		quaternion<f32> * r = (n < 4) ? pa : out + i;
+		_mm_storeu_ps(r[0].m_points, rw);
+		_mm_storeu_ps(r[1].m_points, rx);
+		_mm_storeu_ps(r[2].m_points, ry);
+		_mm_storeu_ps(r[3].m_points, rz);
+		for (s32 j = 0; r == pa && j < n; j++)
+			out[i+j] = pa[j];
+	}
+}
+
+#endif // _FIRE_ENGINE_SSE_
 }
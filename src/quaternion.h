@@ -164,6 +164,22 @@ public:
 		}
 	}
 
+	/** Interpolates pairs of quaternions, as slerp() does. For f32 quaternions, this is
+	 done 4 pairs at a time with SSE, with a polynomial approximation of the weights of
+	 the quaternions that needs no trigonometry. Each weight is within 2e-5 of its exact
+	 value, and each component of the result within 3e-5 (2.9e-5 was measured).
+	 \param from  The quaternions to interpolate from.
+	 \param to    The quaternions to interpolate to.
+	 \param time  The time between them, from 0 to 1.
+	 \param out   A place to store the interpolated quaternions, which may be from or to.
+	 \param count The number of pairs. */
+	static void Slerp(const quaternion<Real> * from, const quaternion<Real> * to, Real time,
+		quaternion<Real> * out, s32 count)
+	{
+		for (s32 i = 0; i < count; i++)
+			out[i] = from[i].slerp(to[i], time);
+	}
+
 	/** Returns the W component of this quaternion. */
 	inline Real getW(void) const
 	{
@@ -355,6 +371,12 @@ private:
 typedef quaternion<f32> quaternionf;
 typedef quaternion<f64> quaterniond;
 
+#ifdef _FIRE_ENGINE_SSE_
+// In quaternion.cpp
+template <> void quaternion<f32>::Slerp(const quaternion<f32> * from, const quaternion<f32> * to,
+	f32 time, quaternion<f32> * out, s32 count);
+#endif
+
 template class _FIRE_ENGINE_API_ quaternion<f32>;
 template class _FIRE_ENGINE_API_ quaternion<f64>;
 
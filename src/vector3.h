@@ -84,6 +84,7 @@ public:
 	inline void set(const Real * points)
 	{
 		memcpy(m_points, points, 3*sizeof(Real));
+		m_is_normalized = false;
 	}
 
 	/** Sets a new vector for this vector. */
@@ -114,18 +115,21 @@ public:
 	inline void setX(Real x)
 	{
 		mX = x;
+		m_is_normalized = false;
 	}
 
 	/** Sets the Y value for this vector. */
 	inline void setY(Real y)
 	{
 		mY = y;
+		m_is_normalized = false;
 	}
 
 	/** Sets the Z value for this vector. */
 	inline void setZ(Real z)
 	{
 		mZ = z;
+		m_is_normalized = false;
 	}
 
 	/** Normalize the vector.
@@ -274,6 +278,7 @@ public:
 			mZ = Math<Real>::Clamp(mZ, min, max);
 			break;
 		}
+		m_is_normalized = false;
 	}
 
 	/** Returns whether two vectors are equa. */
@@ -344,6 +349,7 @@ public:
 		mX *= invval;
 		mY *= invval;
 		mZ *= invval;
+		m_is_normalized = false;
 		return *this;
 	}
 
@@ -353,6 +359,7 @@ public:
 		mX += val;
 		mY += val;
 		mZ += val;
+		m_is_normalized = false;
 		return *this;
 	}
 
@@ -362,6 +369,7 @@ public:
 		mX += v.getX();
 		mY += v.getY();
 		mZ += v.getZ();
+		m_is_normalized = false;
 		return *this;
 	}
 
@@ -371,6 +379,7 @@ public:
 		mX -= val;
 		mY -= val;
 		mZ -= val;
+		m_is_normalized = false;
 		return *this;
 	}
 
@@ -380,6 +389,7 @@ public:
 		mX -= v.getX();
 		mY -= v.getY();
 		mZ -= v.getZ();
+		m_is_normalized = false;
 		return *this;
 	}
 
@@ -389,13 +399,16 @@ public:
 		mX *= val;
 		mY *= val;
 		mZ *= val;
+		m_is_normalized = false;
 		return *this;
 	}
 
-	/** Sets the coordinates of this vector to those of another vector. */
+	/** Sets the coordinates of this vector to those of another vector, and whether it is
+	 known to be normalized. */
 	const vector3<Real>& operator=(const vector3<Real> other)
 	{
 		memcpy(m_points, other.v(), 3*sizeof(Real));
+		m_is_normalized = other.m_is_normalized;
 		return *this;
 	}
 